@@ -111,3 +111,17 @@ void unloadLibrary(void* moduleHandle)
 #endif
 	}
 }
+
+// Retrieve another entry point of the library
+void* getLibrarySymbol(void* moduleHandle, const char* name)
+{
+	if (!moduleHandle) return NULL;
+
+#if defined(HAVE_LOADLIBRARY)
+	return (void*) GetProcAddress((HMODULE) moduleHandle, _T(name));
+#elif defined(HAVE_DLOPEN)
+	return dlsym(moduleHandle, name);
+#else
+	return NULL;
+#endif
+}
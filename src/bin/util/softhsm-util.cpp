@@ -35,6 +35,7 @@
 #include "softhsm-util.h"
 #include "getpw.h"
 #include "library.h"
+#include "softhsm_statistics.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -60,6 +61,8 @@ void usage()
 	printf("                    Use with --slot, --label, --so-pin, and --pin.\n");
 	printf("                    WARNING: Any content in token token will be erased.\n");
 	printf("  --show-slots      Display all the available slots.\n");
+	printf("  --statistics      Display the call statistics of the library\n");
+	printf("                    after the other actions have been performed.\n");
 	printf("  -v                Show version info.\n");
 	printf("  --version         Show version info.\n");
 	printf("Options:\n");
@@ -91,6 +94,7 @@ enum {
 	OPT_SHOW_SLOTS,
 	OPT_SLOT,
 	OPT_SO_PIN,
+	OPT_STATISTICS,
 	OPT_VERSION
 };
 
@@ -109,6 +113,7 @@ static const struct option long_options[] = {
 	{ "show-slots",      0, NULL, OPT_SHOW_SLOTS },
 	{ "slot",            1, NULL, OPT_SLOT },
 	{ "so-pin",          1, NULL, OPT_SO_PIN },
+	{ "statistics",      0, NULL, OPT_STATISTICS },
 	{ "version",         0, NULL, OPT_VERSION },
 	{ NULL,              0, NULL, 0 }
 };
@@ -136,6 +141,7 @@ int main(int argc, char* argv[])
 	int doInitToken = 0;
 	int doShowSlots = 0;
 	int doImport = 0;
+	int doStatistics = 0;
 	//int doExport = 0;
 	int action = 0;
 	int rv = 0;
@@ -155,6 +161,10 @@ int main(int argc, char* argv[])
 				doInitToken = 1;
 				action++;
 				break;
+			case OPT_STATISTICS:
+				doStatistics = 1;
+				action++;
+				break;
 			case OPT_IMPORT:
 				doImport = 1;
 				action++;
@@ -247,6 +257,12 @@ int main(int argc, char* argv[])
 					forceExec, noPublicKey);
 	}
 
+	// Show the statistics of the calls made above
+	if (doStatistics)
+	{
+		rv = showStatistics();
+	}
+
 	// Finalize the library
 	if (action)
 	{
@@ -449,6 +465,77 @@ int showSlots()
 	return 0;
 }
 
+// Get the upper limit in microseconds of the latency bucket that contains
+// the given fraction of the calls
+static double latencyLimit(CK_STATISTICS_PTR entry, double fraction)
+{
+	CK_ULONG seen = 0;
+	int bucket;
+
+	for (bucket = 0; bucket < CK_STATISTICS_BUCKETS - 1; bucket++)
+	{
+		seen += entry->buckets[bucket];
+
+		if (seen >= fraction * entry->calls) break;
+	}
+
+	return (double) (1ULL << (bucket + 1)) / 1000.0;
+}
+
+// Show the call statistics of the library
+int showStatistics()
+{
+	CK_C_GetStatistics pGetStatistics = (CK_C_GetStatistics) getLibrarySymbol(moduleHandle, "C_GetStatistics");
+	if (!pGetStatistics)
+	{
+		fprintf(stderr, "ERROR: The library does not keep statistics.\n");
+		return 1;
+	}
+
+	CK_ULONG ulCount;
+	CK_RV rv = pGetStatistics(NULL_PTR, &ulCount);
+	if (rv != CKR_OK)
+	{
+		fprintf(stderr, "ERROR: Could not get the number of statistics.\n");
+		return 1;
+	}
+
+	CK_STATISTICS_PTR pStatistics = (CK_STATISTICS_PTR) malloc(ulCount*sizeof(CK_STATISTICS));
+	if (!pStatistics)
+	{
+		fprintf(stderr, "ERROR: Could not allocate memory.\n");
+		return 1;
+	}
+
+	rv = pGetStatistics(pStatistics, &ulCount);
+	if (rv != CKR_OK)
+	{
+		fprintf(stderr, "ERROR: Could not get the statistics.\n");
+		free(pStatistics);
+		return 1;
+	}
+
+	// The percentiles are the upper limits of the latency buckets
+	printf("%-24s %10s %8s %12s %12s %12s\n", "Name", "Calls", "Errors",
+		"Mean (us)", "p50 (us) <", "p99 (us) <");
+
+	for (CK_ULONG i = 0; i < ulCount; i++)
+	{
+		CK_STATISTICS_PTR entry = &pStatistics[i];
+
+		if (entry->calls == 0) continue;
+
+		printf("%-24s %10lu %8lu %12.1f %12.1f %12.1f\n",
+			(char*) entry->name, entry->calls, entry->errors,
+			(double) entry->totalMicroseconds / entry->calls,
+			latencyLimit(entry, 0.50), latencyLimit(entry, 0.99));
+	}
+
+	free(pStatistics);
+
+	return 0;
+}
+
 // Import a key pair from given path
 int importKeyPair
 (
@@ -37,9 +37,8 @@
 #include <stdlib.h>
 
 // Constructor
-P11Attribute::P11Attribute(OSObject* osobject)
+P11Attribute::P11Attribute()
 {
-	this->osobject = osobject;
 	type = CKA_VENDOR_DEFINED;
 	size = (CK_ULONG)-1;
 	checks = 0;
@@ -50,7 +49,7 @@ P11Attribute::~P11Attribute()
 {
 }
 
-CK_RV P11Attribute::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11Attribute::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	ByteString value;
 	if (isPrivate)
@@ -66,7 +65,7 @@ CK_RV P11Attribute::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue,
 	return CKR_OK;
 }
 
-bool P11Attribute::isModifiable()
+bool P11Attribute::isModifiable(OSObject* osobject)
 {
 	// Get the CKA_MODIFIABLE attribute, when the attribute is
 	// not present return the default value which is CK_TRUE.
@@ -74,7 +73,7 @@ bool P11Attribute::isModifiable()
 	return attr == NULL || attr->getBooleanValue();
 }
 
-bool P11Attribute::isSensitive()
+bool P11Attribute::isSensitive(OSObject* osobject)
 {
 	// Get the CKA_SENSITIVE attribute, when the attribute is not present
 	// assume the object is not sensitive.
@@ -82,7 +81,7 @@ bool P11Attribute::isSensitive()
 	return attr != NULL && attr->getBooleanValue();
 }
 
-bool P11Attribute::isExtractable()
+bool P11Attribute::isExtractable(OSObject* osobject)
 {
 	// Get the CKA_EXTRACTABLE attribute, when the attribute is
 	// not present assume the object allows extraction.
@@ -90,7 +89,7 @@ bool P11Attribute::isExtractable()
 	return attr == NULL || attr->getBooleanValue();
 }
 
-bool P11Attribute::isTrusted()
+bool P11Attribute::isTrusted(OSObject* osobject)
 {
 	// Get the CKA_TRUSTED attribute, when the attribute is
 	// not present assume the object is not trusted.
@@ -99,27 +98,27 @@ bool P11Attribute::isTrusted()
 }
 
 // Initialize the attribute
-bool P11Attribute::init()
+bool P11Attribute::init(OSObject* osobject) const
 {
 	if (osobject == NULL) return false;
 
 	// Create a default value if the attribute does not exist
 	if (osobject->attributeExists(type) == false)
 	{
-		return setDefault();
+		return setDefault(osobject);
 	}
 
 	return true;
 }
 
 // Return the attribute type
-CK_ATTRIBUTE_TYPE P11Attribute::getType()
+CK_ATTRIBUTE_TYPE P11Attribute::getType() const
 {
 	return type;
 }
 
 // Retrieve the value if allowed
-CK_RV P11Attribute::retrieve(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG_PTR pulValueLen)
+CK_RV P11Attribute::retrieve(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG_PTR pulValueLen) const
 {
 
 	if (osobject == NULL) {
@@ -142,7 +141,7 @@ CK_RV P11Attribute::retrieve(Token *token, bool isPrivate, CK_VOID_PTR pValue, C
 	// [PKCS#11 v2.3 pg. 62 table 15]
 	//  7  Cannot be revealed if object has its CKA_SENSITIVE attribute
 	//     set to CK_TRUE or its CKA_EXTRACTABLE attribute set to CK_FALSE.
-	if ((checks & ck7) == ck7 && (isSensitive() || !isExtractable())) {
+	if ((checks & ck7) == ck7 && (isSensitive(osobject) || !isExtractable(osobject))) {
 		*pulValueLen = (CK_ULONG)-1;
 		return CKR_ATTRIBUTE_SENSITIVE;
 	}
@@ -256,7 +255,7 @@ CK_RV P11Attribute::retrieve(Token *token, bool isPrivate, CK_VOID_PTR pValue, C
 }
 
 // Update the value if allowed
-CK_RV P11Attribute::update(Token* token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11Attribute::update(Token* token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	if (osobject == NULL) {
 		ERROR_MSG("Internal error: osobject field contains NULL_PTR");
@@ -292,13 +291,13 @@ CK_RV P11Attribute::update(Token* token, bool isPrivate, CK_VOID_PTR pValue, CK_
 
 
 	// Attributes cannot be changed if CKA_MODIFIABLE is set to false
-	if (!isModifiable()) {
+	if (!isModifiable(osobject)) {
 		ERROR_MSG("An object is with CKA_MODIFIABLE set to false is not modifiable");
 		return CKR_ATTRIBUTE_READ_ONLY;
 	}
 
 	// Attributes cannot be modified if CKA_TRUSTED is true on a certificate object.
-	if (isTrusted()) {
+	if (isTrusted(osobject)) {
 		OSAttribute* attrClass = osobject->getAttribute(CKA_CLASS);
 		if (attrClass != NULL && attrClass->getUnsignedLongValue() == CKO_CERTIFICATE)
 		{
@@ -345,7 +344,7 @@ CK_RV P11Attribute::update(Token* token, bool isPrivate, CK_VOID_PTR pValue, CK_
 	{
 		if (OBJECT_OP_SET==op || OBJECT_OP_COPY==op)
 		{
-			return updateAttr(token, isPrivate, pValue, ulValueLen, op);
+			return updateAttr(token, osobject, isPrivate, pValue, ulValueLen, op);
 		}
 	}
 
@@ -354,7 +353,7 @@ CK_RV P11Attribute::update(Token* token, bool isPrivate, CK_VOID_PTR pValue, CK_
 	{
 		if (OBJECT_OP_COPY==op)
 		{
-			return updateAttr(token, isPrivate, pValue, ulValueLen, op);
+			return updateAttr(token, osobject, isPrivate, pValue, ulValueLen, op);
 		}
 	}
 
@@ -362,7 +361,7 @@ CK_RV P11Attribute::update(Token* token, bool isPrivate, CK_VOID_PTR pValue, CK_
 	// during create/derive/generate/unwrap, we allow them to be modified.
 	if (OBJECT_OP_CREATE==op || OBJECT_OP_DERIVE==op || OBJECT_OP_GENERATE==op || OBJECT_OP_UNWRAP==op)
 	{
-		return updateAttr(token, isPrivate, pValue, ulValueLen, op);
+		return updateAttr(token, osobject, isPrivate, pValue, ulValueLen, op);
 	}
 
 	return CKR_ATTRIBUTE_READ_ONLY;
@@ -373,14 +372,14 @@ CK_RV P11Attribute::update(Token* token, bool isPrivate, CK_VOID_PTR pValue, CK_
  *****************************************/
 
 // Set default value
-bool P11AttrClass::setDefault()
+bool P11AttrClass::setDefault(OSObject* osobject) const
 {
 	OSAttribute attrClass((unsigned long)CKO_VENDOR_DEFINED);
 	return osobject->setAttribute(type, attrClass);
 }
 
 // Update the value if allowed
-CK_RV P11AttrClass::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrClass::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute* attr = NULL;
 
@@ -415,14 +414,14 @@ CK_RV P11AttrClass::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue,
  *****************************************/
 
 // Set default value
-bool P11AttrKeyType::setDefault()
+bool P11AttrKeyType::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr((unsigned long)CKK_VENDOR_DEFINED);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrKeyType::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrKeyType::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute* attr = NULL;
 
@@ -459,14 +458,14 @@ CK_RV P11AttrKeyType::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValu
  *****************************************/
 
 // Set default value
-bool P11AttrCertificateType::setDefault()
+bool P11AttrCertificateType::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr((unsigned long)CKC_VENDOR_DEFINED);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrCertificateType::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrCertificateType::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute* attr = NULL;
 
@@ -501,14 +500,14 @@ CK_RV P11AttrCertificateType::updateAttr(Token *token, bool isPrivate, CK_VOID_P
  *****************************************/
 
 // Set default value
-bool P11AttrToken::setDefault()
+bool P11AttrToken::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(false);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrToken::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrToken::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -544,14 +543,14 @@ CK_RV P11AttrToken::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue,
  *****************************************/
 
 // Set default value
-bool P11AttrPrivate::setDefault()
+bool P11AttrPrivate::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrPrivate::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrPrivate::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -587,14 +586,14 @@ CK_RV P11AttrPrivate::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValu
  *****************************************/
 
 // Set default value
-bool P11AttrModifiable::setDefault()
+bool P11AttrModifiable::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrModifiable::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrModifiable::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -630,7 +629,7 @@ CK_RV P11AttrModifiable::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pV
  *****************************************/
 
 // Set default value
-bool P11AttrLabel::setDefault()
+bool P11AttrLabel::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -641,14 +640,14 @@ bool P11AttrLabel::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrCopyable::setDefault()
+bool P11AttrCopyable::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrCopyable::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrCopyable::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -687,7 +686,7 @@ CK_RV P11AttrCopyable::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pVal
  *****************************************/
 
 // Set default value
-bool P11AttrApplication::setDefault()
+bool P11AttrApplication::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -698,7 +697,7 @@ bool P11AttrApplication::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrObjectID::setDefault()
+bool P11AttrObjectID::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -709,7 +708,7 @@ bool P11AttrObjectID::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrCheckValue::setDefault()
+bool P11AttrCheckValue::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -720,7 +719,7 @@ bool P11AttrCheckValue::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrID::setDefault()
+bool P11AttrID::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -731,7 +730,7 @@ bool P11AttrID::setDefault()
   *****************************************/
 
 // Set default value
-bool P11AttrValue::setDefault()
+bool P11AttrValue::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -742,7 +741,7 @@ bool P11AttrValue::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrSubject::setDefault()
+bool P11AttrSubject::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -753,7 +752,7 @@ bool P11AttrSubject::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrIssuer::setDefault()
+bool P11AttrIssuer::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -764,14 +763,14 @@ bool P11AttrIssuer::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrTrusted::setDefault()
+bool P11AttrTrusted::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(false);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrTrusted::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrTrusted::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -807,14 +806,14 @@ CK_RV P11AttrTrusted::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValu
  *****************************************/
 
 // Set default value
-bool P11AttrCertificateCategory::setDefault()
+bool P11AttrCertificateCategory::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr((unsigned long)0);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrCertificateCategory::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrCertificateCategory::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	// Attribute specific checks
 
@@ -839,14 +838,14 @@ CK_RV P11AttrCertificateCategory::updateAttr(Token *token, bool isPrivate, CK_VO
  *****************************************/
 
 // Set default value
-bool P11AttrStartDate::setDefault()
+bool P11AttrStartDate::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrStartDate::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrStartDate::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	// Attribute specific checks
 
@@ -866,14 +865,14 @@ CK_RV P11AttrStartDate::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pVa
  *****************************************/
 
 // Set default value
-bool P11AttrEndDate::setDefault()
+bool P11AttrEndDate::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrEndDate::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrEndDate::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	// Attribute specific checks
 
@@ -893,7 +892,7 @@ CK_RV P11AttrEndDate::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValu
  *****************************************/
 
 // Set default value
-bool P11AttrSerialNumber::setDefault()
+bool P11AttrSerialNumber::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -904,7 +903,7 @@ bool P11AttrSerialNumber::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrURL::setDefault()
+bool P11AttrURL::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -915,7 +914,7 @@ bool P11AttrURL::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrHashOfSubjectPublicKey::setDefault()
+bool P11AttrHashOfSubjectPublicKey::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -926,7 +925,7 @@ bool P11AttrHashOfSubjectPublicKey::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrHashOfIssuerPublicKey::setDefault()
+bool P11AttrHashOfIssuerPublicKey::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -937,14 +936,14 @@ bool P11AttrHashOfIssuerPublicKey::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrJavaMidpSecurityDomain::setDefault()
+bool P11AttrJavaMidpSecurityDomain::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr((unsigned long)0);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrJavaMidpSecurityDomain::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrJavaMidpSecurityDomain::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	// Attribute specific checks
 
@@ -969,14 +968,14 @@ CK_RV P11AttrJavaMidpSecurityDomain::updateAttr(Token *token, bool isPrivate, CK
  *****************************************/
 
 // Set default value
-bool P11AttrNameHashAlgorithm::setDefault()
+bool P11AttrNameHashAlgorithm::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr((unsigned long)CKM_SHA_1);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrNameHashAlgorithm::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrNameHashAlgorithm::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	// Attribute specific checks
 
@@ -1001,14 +1000,14 @@ CK_RV P11AttrNameHashAlgorithm::updateAttr(Token *token, bool isPrivate, CK_VOID
  *****************************************/
 
 // Set default value
-bool P11AttrDerive::setDefault()
+bool P11AttrDerive::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(false);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrDerive::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrDerive::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1039,14 +1038,14 @@ CK_RV P11AttrDerive::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue
  *****************************************/
 
 // Set default value
-bool P11AttrEncrypt::setDefault()
+bool P11AttrEncrypt::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrEncrypt::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrEncrypt::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1077,14 +1076,14 @@ CK_RV P11AttrEncrypt::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValu
  *****************************************/
 
 // Set default value
-bool P11AttrVerify::setDefault()
+bool P11AttrVerify::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrVerify::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrVerify::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1115,14 +1114,14 @@ CK_RV P11AttrVerify::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue
  *****************************************/
 
 // Set default value
-bool P11AttrVerifyRecover::setDefault()
+bool P11AttrVerifyRecover::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrVerifyRecover::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrVerifyRecover::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1153,14 +1152,14 @@ CK_RV P11AttrVerifyRecover::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR
  *****************************************/
 
 // Set default value
-bool P11AttrWrap::setDefault()
+bool P11AttrWrap::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrWrap::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrWrap::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1191,14 +1190,14 @@ CK_RV P11AttrWrap::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue,
  *****************************************/
 
 // Set default value
-bool P11AttrDecrypt::setDefault()
+bool P11AttrDecrypt::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrDecrypt::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrDecrypt::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1229,14 +1228,14 @@ CK_RV P11AttrDecrypt::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValu
  *****************************************/
 
 // Set default value
-bool P11AttrSign::setDefault()
+bool P11AttrSign::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrSign::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrSign::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1267,14 +1266,14 @@ CK_RV P11AttrSign::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue,
  *****************************************/
 
 // Set default value
-bool P11AttrSignRecover::setDefault()
+bool P11AttrSignRecover::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrSignRecover::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrSignRecover::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1305,14 +1304,14 @@ CK_RV P11AttrSignRecover::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR p
  *****************************************/
 
 // Set default value
-bool P11AttrUnwrap::setDefault()
+bool P11AttrUnwrap::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrUnwrap::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrUnwrap::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1343,14 +1342,14 @@ CK_RV P11AttrUnwrap::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue
  *****************************************/
 
 // Set default value
-bool P11AttrLocal::setDefault()
+bool P11AttrLocal::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(false);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrLocal::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrLocal::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	return CKR_ATTRIBUTE_READ_ONLY;
 }
@@ -1360,14 +1359,14 @@ CK_RV P11AttrLocal::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue,
  *****************************************/
 
 // Set default value
-bool P11AttrKeyGenMechanism::setDefault()
+bool P11AttrKeyGenMechanism::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr((unsigned long)CK_UNAVAILABLE_INFORMATION);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrKeyGenMechanism::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrKeyGenMechanism::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	return CKR_ATTRIBUTE_READ_ONLY;
 }
@@ -1377,14 +1376,14 @@ CK_RV P11AttrKeyGenMechanism::updateAttr(Token *token, bool isPrivate, CK_VOID_P
  *****************************************/
 
 // Set default value
-bool P11AttrAlwaysSensitive::setDefault()
+bool P11AttrAlwaysSensitive::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(false);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrAlwaysSensitive::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrAlwaysSensitive::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	return CKR_ATTRIBUTE_READ_ONLY;
 }
@@ -1394,14 +1393,14 @@ CK_RV P11AttrAlwaysSensitive::updateAttr(Token *token, bool isPrivate, CK_VOID_P
  *****************************************/
 
 // Set default value
-bool P11AttrNeverExtractable::setDefault()
+bool P11AttrNeverExtractable::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(true);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrNeverExtractable::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrNeverExtractable::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	return CKR_ATTRIBUTE_READ_ONLY;
 }
@@ -1411,7 +1410,7 @@ CK_RV P11AttrNeverExtractable::updateAttr(Token *token, bool isPrivate, CK_VOID_
  *****************************************/
 
 // Set default value
-bool P11AttrSensitive::setDefault()
+bool P11AttrSensitive::setDefault(OSObject* osobject) const
 {
 	// We default to false because we want to handle the secret keys in a correct way
 	OSAttribute attr(false);
@@ -1419,7 +1418,7 @@ bool P11AttrSensitive::setDefault()
 }
 
 // Update the value if allowed
-CK_RV P11AttrSensitive::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrSensitive::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1465,14 +1464,14 @@ CK_RV P11AttrSensitive::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pVa
  *****************************************/
 
 // Set default value
-bool P11AttrExtractable::setDefault()
+bool P11AttrExtractable::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(false);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrExtractable::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrExtractable::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1512,14 +1511,14 @@ CK_RV P11AttrExtractable::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR p
  *****************************************/
 
 // Set default value
-bool P11AttrWrapWithTrusted::setDefault()
+bool P11AttrWrapWithTrusted::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(false);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrWrapWithTrusted::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrWrapWithTrusted::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1558,14 +1557,14 @@ CK_RV P11AttrWrapWithTrusted::updateAttr(Token *token, bool isPrivate, CK_VOID_P
  *****************************************/
 
 // Set default value
-bool P11AttrAlwaysAuthenticate::setDefault()
+bool P11AttrAlwaysAuthenticate::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(false);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrAlwaysAuthenticate::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrAlwaysAuthenticate::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	OSAttribute attrTrue(true);
 	OSAttribute attrFalse(false);
@@ -1601,14 +1600,14 @@ CK_RV P11AttrAlwaysAuthenticate::updateAttr(Token *token, bool isPrivate, CK_VOI
  *****************************************/
 
 // Set default value
-bool P11AttrModulus::setDefault()
+bool P11AttrModulus::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrModulus::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrModulus::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	ByteString plaintext((unsigned char*)pValue, ulValueLen);
 	ByteString value;
@@ -1647,7 +1646,7 @@ CK_RV P11AttrModulus::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValu
  *****************************************/
 
 // Set default value
-bool P11AttrPublicExponent::setDefault()
+bool P11AttrPublicExponent::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1658,7 +1657,7 @@ bool P11AttrPublicExponent::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrPrivateExponent::setDefault()
+bool P11AttrPrivateExponent::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1669,7 +1668,7 @@ bool P11AttrPrivateExponent::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrPrime1::setDefault()
+bool P11AttrPrime1::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1680,7 +1679,7 @@ bool P11AttrPrime1::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrPrime2::setDefault()
+bool P11AttrPrime2::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1691,7 +1690,7 @@ bool P11AttrPrime2::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrExponent1::setDefault()
+bool P11AttrExponent1::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1702,7 +1701,7 @@ bool P11AttrExponent1::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrExponent2::setDefault()
+bool P11AttrExponent2::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1713,7 +1712,7 @@ bool P11AttrExponent2::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrCoefficient::setDefault()
+bool P11AttrCoefficient::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1724,14 +1723,14 @@ bool P11AttrCoefficient::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrModulusBits::setDefault()
+bool P11AttrModulusBits::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr((unsigned long)0);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrModulusBits::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrModulusBits::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	// Attribute specific checks
 
@@ -1757,7 +1756,7 @@ CK_RV P11AttrModulusBits::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR p
  *****************************************/
 
 // Set default value
-bool P11AttrPrime::setDefault()
+bool P11AttrPrime::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1768,7 +1767,7 @@ bool P11AttrPrime::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrSubPrime::setDefault()
+bool P11AttrSubPrime::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1779,7 +1778,7 @@ bool P11AttrSubPrime::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrBase::setDefault()
+bool P11AttrBase::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1790,14 +1789,14 @@ bool P11AttrBase::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrPrimeBits::setDefault()
+bool P11AttrPrimeBits::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr((unsigned long)0);
 	return osobject->setAttribute(type, attr);
 }
 
 // Update the value if allowed
-CK_RV P11AttrPrimeBits::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op)
+CK_RV P11AttrPrimeBits::updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const
 {
 	// Attribute specific checks
 
@@ -1823,7 +1822,7 @@ CK_RV P11AttrPrimeBits::updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pVa
  *****************************************/
 
 // Set default value
-bool P11AttrEcParams::setDefault()
+bool P11AttrEcParams::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1834,7 +1833,7 @@ bool P11AttrEcParams::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrEcPoint::setDefault()
+bool P11AttrEcPoint::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1845,7 +1844,7 @@ bool P11AttrEcPoint::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrGostR3410Params::setDefault()
+bool P11AttrGostR3410Params::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1856,7 +1855,7 @@ bool P11AttrGostR3410Params::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrGostR3411Params::setDefault()
+bool P11AttrGostR3411Params::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
@@ -1867,7 +1866,7 @@ bool P11AttrGostR3411Params::setDefault()
  *****************************************/
 
 // Set default value
-bool P11AttrGost28147Params::setDefault()
+bool P11AttrGost28147Params::setDefault(OSObject* osobject) const
 {
 	OSAttribute attr(ByteString(""));
 	return osobject->setAttribute(type, attr);
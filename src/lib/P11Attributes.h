@@ -52,17 +52,17 @@ public:
 	// Destructor
 	virtual ~P11Attribute();
 
-	// Initialize the attribute
-	bool init();
+	// Initialize the attribute of the object
+	bool init(OSObject* osobject) const;
 
 	// Return the attribute type
-	CK_ATTRIBUTE_TYPE getType();
+	CK_ATTRIBUTE_TYPE getType() const;
 
 	// Retrieve the value if allowed
-	CK_RV retrieve(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG_PTR pulValueLen);
+	CK_RV retrieve(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG_PTR pulValueLen) const;
 
 	// Update the value if allowed
-	CK_RV update(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	CK_RV update(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 
 	// Checks are determined by footnotes from table 15 on page 62 in the PKCS#11 v2.3 spec.
 	// Table 15 contains common footnotes for object attribute tables that determine the checks to perform on attributes.
@@ -99,10 +99,7 @@ public:
 	};
 protected:
 	// Constructor
-	P11Attribute(OSObject* osobject);
-
-	// The object
-	OSObject* osobject;
+	P11Attribute();
 
 	// The attribute type
 	CK_ATTRIBUTE_TYPE type;
@@ -114,16 +111,16 @@ protected:
 	CK_ULONG size;
 
 	// Set the default value of the attribute
-	virtual bool setDefault() = 0;
+	virtual bool setDefault(OSObject* osobject) const = 0;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 
 	// Helper functions
-	bool isModifiable();
-	bool isSensitive();
-	bool isExtractable();
-	bool isTrusted();
+	static bool isModifiable(OSObject* osobject);
+	static bool isSensitive(OSObject* osobject);
+	static bool isExtractable(OSObject* osobject);
+	static bool isTrusted(OSObject* osobject);
 };
 
 /*****************************************
@@ -134,14 +131,14 @@ class P11AttrClass : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrClass(OSObject* osobject) : P11Attribute(osobject) { type = CKA_CLASS; size = sizeof(CK_OBJECT_CLASS); checks = ck1; }
+	P11AttrClass() : P11Attribute() { type = CKA_CLASS; size = sizeof(CK_OBJECT_CLASS); checks = ck1; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -152,14 +149,14 @@ class P11AttrKeyType : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrKeyType(OSObject* osobject) : P11Attribute(osobject) { type = CKA_KEY_TYPE; size = sizeof(CK_KEY_TYPE); checks = ck1|ck5; }
+	P11AttrKeyType() : P11Attribute() { type = CKA_KEY_TYPE; size = sizeof(CK_KEY_TYPE); checks = ck1|ck5; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -170,14 +167,14 @@ class P11AttrCertificateType : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrCertificateType(OSObject* osobject) : P11Attribute(osobject) { type = CKA_CERTIFICATE_TYPE; size = sizeof(CK_CERTIFICATE_TYPE); checks = ck1; }
+	P11AttrCertificateType() : P11Attribute() { type = CKA_CERTIFICATE_TYPE; size = sizeof(CK_CERTIFICATE_TYPE); checks = ck1; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -188,14 +185,14 @@ class P11AttrToken : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrToken(OSObject* osobject) : P11Attribute(osobject) { type = CKA_TOKEN; size = sizeof(CK_BBOOL); checks = ck17; }
+	P11AttrToken() : P11Attribute() { type = CKA_TOKEN; size = sizeof(CK_BBOOL); checks = ck17; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -206,14 +203,14 @@ class P11AttrPrivate : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrPrivate(OSObject* osobject) : P11Attribute(osobject) { type = CKA_PRIVATE; size = sizeof(CK_BBOOL); checks = ck17; }
+	P11AttrPrivate() : P11Attribute() { type = CKA_PRIVATE; size = sizeof(CK_BBOOL); checks = ck17; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -224,14 +221,14 @@ class P11AttrModifiable : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrModifiable(OSObject* osobject) : P11Attribute(osobject) { type = CKA_MODIFIABLE; size = sizeof(CK_BBOOL); checks = ck17; }
+	P11AttrModifiable() : P11Attribute() { type = CKA_MODIFIABLE; size = sizeof(CK_BBOOL); checks = ck17; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -242,11 +239,11 @@ class P11AttrLabel : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrLabel(OSObject* osobject) : P11Attribute(osobject) { type = CKA_LABEL;  checks = ck8; }
+	P11AttrLabel() : P11Attribute() { type = CKA_LABEL;  checks = ck8; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -257,14 +254,14 @@ class P11AttrCopyable : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrCopyable(OSObject* osobject) : P11Attribute(osobject) { type = CKA_COPYABLE; size = sizeof(CK_BBOOL); checks = ck12; }
+	P11AttrCopyable() : P11Attribute() { type = CKA_COPYABLE; size = sizeof(CK_BBOOL); checks = ck12; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -275,11 +272,11 @@ class P11AttrApplication : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrApplication(OSObject* osobject) : P11Attribute(osobject) { type = CKA_APPLICATION; checks = 0; }
+	P11AttrApplication() : P11Attribute() { type = CKA_APPLICATION; checks = 0; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -290,11 +287,11 @@ class P11AttrObjectID : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrObjectID(OSObject* osobject) : P11Attribute(osobject) { type = CKA_OBJECT_ID; checks = 0; }
+	P11AttrObjectID() : P11Attribute() { type = CKA_OBJECT_ID; checks = 0; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -305,11 +302,11 @@ class P11AttrCheckValue : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrCheckValue(OSObject* osobject) : P11Attribute(osobject) { type = CKA_CHECK_VALUE; checks = 0; }
+	P11AttrCheckValue() : P11Attribute() { type = CKA_CHECK_VALUE; checks = 0; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -320,11 +317,11 @@ class P11AttrID : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrID(OSObject* osobject) : P11Attribute(osobject) { type = CKA_ID; checks = ck8; }
+	P11AttrID() : P11Attribute() { type = CKA_ID; checks = ck8; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -335,11 +332,11 @@ class P11AttrValue : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrValue(OSObject* osobject, CK_ULONG inchecks) : P11Attribute(osobject) { type = CKA_VALUE; checks = inchecks; }
+	P11AttrValue(CK_ULONG inchecks) : P11Attribute() { type = CKA_VALUE; checks = inchecks; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -350,11 +347,11 @@ class P11AttrSubject : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrSubject(OSObject* osobject, CK_ULONG inchecks) : P11Attribute(osobject) { type = CKA_SUBJECT; checks = inchecks; }
+	P11AttrSubject(CK_ULONG inchecks) : P11Attribute() { type = CKA_SUBJECT; checks = inchecks; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -365,11 +362,11 @@ class P11AttrIssuer : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrIssuer(OSObject* osobject) : P11Attribute(osobject) { type = CKA_ISSUER; checks = ck8; }
+	P11AttrIssuer() : P11Attribute() { type = CKA_ISSUER; checks = ck8; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -380,14 +377,14 @@ class P11AttrTrusted : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrTrusted(OSObject* osobject) : P11Attribute(osobject) { type = CKA_TRUSTED; size = sizeof(CK_BBOOL); checks = ck10; }
+	P11AttrTrusted() : P11Attribute() { type = CKA_TRUSTED; size = sizeof(CK_BBOOL); checks = ck10; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -398,14 +395,14 @@ class P11AttrCertificateCategory : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrCertificateCategory(OSObject* osobject) : P11Attribute(osobject) { type = CKA_CERTIFICATE_CATEGORY; size = sizeof(CK_ULONG); checks = 0; }
+	P11AttrCertificateCategory() : P11Attribute() { type = CKA_CERTIFICATE_CATEGORY; size = sizeof(CK_ULONG); checks = 0; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -424,14 +421,14 @@ class P11AttrStartDate : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrStartDate(OSObject* osobject) : P11Attribute(osobject) { type = CKA_START_DATE; checks = 0; }
+	P11AttrStartDate() : P11Attribute() { type = CKA_START_DATE; checks = 0; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -450,14 +447,14 @@ class P11AttrEndDate : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrEndDate(OSObject* osobject) : P11Attribute(osobject) { type = CKA_END_DATE; checks = 0; }
+	P11AttrEndDate() : P11Attribute() { type = CKA_END_DATE; checks = 0; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -468,11 +465,11 @@ class P11AttrSerialNumber : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrSerialNumber(OSObject* osobject) : P11Attribute(osobject) { type = CKA_SERIAL_NUMBER; checks = ck8; }
+	P11AttrSerialNumber() : P11Attribute() { type = CKA_SERIAL_NUMBER; checks = ck8; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -483,11 +480,11 @@ class P11AttrURL : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrURL(OSObject* osobject) : P11Attribute(osobject) { type = CKA_URL; checks = ck15; }
+	P11AttrURL() : P11Attribute() { type = CKA_URL; checks = ck15; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -498,11 +495,11 @@ class P11AttrHashOfSubjectPublicKey : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrHashOfSubjectPublicKey(OSObject* osobject) : P11Attribute(osobject) { type = CKA_HASH_OF_SUBJECT_PUBLIC_KEY; checks = ck16; }
+	P11AttrHashOfSubjectPublicKey() : P11Attribute() { type = CKA_HASH_OF_SUBJECT_PUBLIC_KEY; checks = ck16; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -513,11 +510,11 @@ class P11AttrHashOfIssuerPublicKey : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrHashOfIssuerPublicKey(OSObject* osobject) : P11Attribute(osobject) { type = CKA_HASH_OF_ISSUER_PUBLIC_KEY; checks = ck16; }
+	P11AttrHashOfIssuerPublicKey() : P11Attribute() { type = CKA_HASH_OF_ISSUER_PUBLIC_KEY; checks = ck16; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -528,14 +525,14 @@ class P11AttrJavaMidpSecurityDomain : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrJavaMidpSecurityDomain(OSObject* osobject) : P11Attribute(osobject) { type = CKA_JAVA_MIDP_SECURITY_DOMAIN; size = sizeof(CK_ULONG); checks = 0; }
+	P11AttrJavaMidpSecurityDomain() : P11Attribute() { type = CKA_JAVA_MIDP_SECURITY_DOMAIN; size = sizeof(CK_ULONG); checks = 0; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -546,14 +543,14 @@ class P11AttrNameHashAlgorithm : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrNameHashAlgorithm(OSObject* osobject) : P11Attribute(osobject) { type = CKA_NAME_HASH_ALGORITHM; size = sizeof(CK_MECHANISM_TYPE); checks = 0; }
+	P11AttrNameHashAlgorithm() : P11Attribute() { type = CKA_NAME_HASH_ALGORITHM; size = sizeof(CK_MECHANISM_TYPE); checks = 0; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -564,14 +561,14 @@ class P11AttrDerive : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrDerive(OSObject* osobject) : P11Attribute(osobject) { type = CKA_DERIVE; size = sizeof(CK_BBOOL); checks = ck8;}
+	P11AttrDerive() : P11Attribute() { type = CKA_DERIVE; size = sizeof(CK_BBOOL); checks = ck8;}
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -582,14 +579,14 @@ class P11AttrEncrypt : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrEncrypt(OSObject* osobject) : P11Attribute(osobject) { type = CKA_ENCRYPT; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
+	P11AttrEncrypt() : P11Attribute() { type = CKA_ENCRYPT; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -600,14 +597,14 @@ class P11AttrVerify : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrVerify(OSObject* osobject) : P11Attribute(osobject) { type = CKA_VERIFY; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
+	P11AttrVerify() : P11Attribute() { type = CKA_VERIFY; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -618,14 +615,14 @@ class P11AttrVerifyRecover : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrVerifyRecover(OSObject* osobject) : P11Attribute(osobject) { type = CKA_VERIFY_RECOVER; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
+	P11AttrVerifyRecover() : P11Attribute() { type = CKA_VERIFY_RECOVER; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -636,14 +633,14 @@ class P11AttrWrap : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrWrap(OSObject* osobject) : P11Attribute(osobject) { type = CKA_WRAP; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
+	P11AttrWrap() : P11Attribute() { type = CKA_WRAP; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -654,14 +651,14 @@ class P11AttrDecrypt : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrDecrypt(OSObject* osobject) : P11Attribute(osobject) { type = CKA_DECRYPT; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
+	P11AttrDecrypt() : P11Attribute() { type = CKA_DECRYPT; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -672,14 +669,14 @@ class P11AttrSign : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrSign(OSObject* osobject) : P11Attribute(osobject) { type = CKA_SIGN; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
+	P11AttrSign() : P11Attribute() { type = CKA_SIGN; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -690,14 +687,14 @@ class P11AttrSignRecover : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrSignRecover(OSObject* osobject) : P11Attribute(osobject) { type = CKA_SIGN_RECOVER; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
+	P11AttrSignRecover() : P11Attribute() { type = CKA_SIGN_RECOVER; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -708,14 +705,14 @@ class P11AttrUnwrap : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrUnwrap(OSObject* osobject) : P11Attribute(osobject) { type = CKA_UNWRAP; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
+	P11AttrUnwrap() : P11Attribute() { type = CKA_UNWRAP; size = sizeof(CK_BBOOL); checks = ck8|ck9; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -726,14 +723,14 @@ class P11AttrLocal : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrLocal(OSObject* osobject) : P11Attribute(osobject) { type = CKA_LOCAL; size = sizeof(CK_BBOOL); checks = ck2|ck4|ck6; }
+	P11AttrLocal() : P11Attribute() { type = CKA_LOCAL; size = sizeof(CK_BBOOL); checks = ck2|ck4|ck6; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -744,14 +741,14 @@ class P11AttrKeyGenMechanism : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrKeyGenMechanism(OSObject* osobject) : P11Attribute(osobject) { type = CKA_KEY_GEN_MECHANISM; size = sizeof(CK_MECHANISM_TYPE); checks = ck2|ck4|ck6; }
+	P11AttrKeyGenMechanism() : P11Attribute() { type = CKA_KEY_GEN_MECHANISM; size = sizeof(CK_MECHANISM_TYPE); checks = ck2|ck4|ck6; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -762,14 +759,14 @@ class P11AttrAlwaysSensitive : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrAlwaysSensitive(OSObject* osobject) : P11Attribute(osobject) { type = CKA_ALWAYS_SENSITIVE; size = sizeof(CK_BBOOL); checks = ck2|ck4|ck6; }
+	P11AttrAlwaysSensitive() : P11Attribute() { type = CKA_ALWAYS_SENSITIVE; size = sizeof(CK_BBOOL); checks = ck2|ck4|ck6; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -780,14 +777,14 @@ class P11AttrNeverExtractable : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrNeverExtractable(OSObject* osobject) : P11Attribute(osobject) { type = CKA_NEVER_EXTRACTABLE; size = sizeof(CK_BBOOL); checks = ck2|ck4; }
+	P11AttrNeverExtractable() : P11Attribute() { type = CKA_NEVER_EXTRACTABLE; size = sizeof(CK_BBOOL); checks = ck2|ck4; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -798,14 +795,14 @@ class P11AttrSensitive : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrSensitive(OSObject* osobject) : P11Attribute(osobject) { type = CKA_SENSITIVE; size = sizeof(CK_BBOOL); checks = ck8|ck9|ck11; }
+	P11AttrSensitive() : P11Attribute() { type = CKA_SENSITIVE; size = sizeof(CK_BBOOL); checks = ck8|ck9|ck11; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -816,14 +813,14 @@ class P11AttrExtractable : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrExtractable(OSObject* osobject) : P11Attribute(osobject) { type = CKA_EXTRACTABLE; size = sizeof(CK_BBOOL); checks = ck8|ck9|ck12; }
+	P11AttrExtractable() : P11Attribute() { type = CKA_EXTRACTABLE; size = sizeof(CK_BBOOL); checks = ck8|ck9|ck12; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -834,14 +831,14 @@ class P11AttrWrapWithTrusted : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrWrapWithTrusted(OSObject* osobject) : P11Attribute(osobject) { type = CKA_WRAP_WITH_TRUSTED; size = sizeof(CK_BBOOL); checks = ck11; }
+	P11AttrWrapWithTrusted() : P11Attribute() { type = CKA_WRAP_WITH_TRUSTED; size = sizeof(CK_BBOOL); checks = ck11; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -852,14 +849,14 @@ class P11AttrAlwaysAuthenticate : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrAlwaysAuthenticate(OSObject* osobject) : P11Attribute(osobject) { type = CKA_ALWAYS_AUTHENTICATE; size = sizeof(CK_BBOOL); checks = 0; }
+	P11AttrAlwaysAuthenticate() : P11Attribute() { type = CKA_ALWAYS_AUTHENTICATE; size = sizeof(CK_BBOOL); checks = 0; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -870,14 +867,14 @@ class P11AttrModulus : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrModulus(OSObject* osobject) : P11Attribute(osobject) { type = CKA_MODULUS; checks = ck1|ck4|ck6; }
+	P11AttrModulus() : P11Attribute() { type = CKA_MODULUS; checks = ck1|ck4|ck6; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -888,11 +885,11 @@ class P11AttrPublicExponent : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrPublicExponent(OSObject* osobject, CK_ULONG inchecks) : P11Attribute(osobject) { type = CKA_PUBLIC_EXPONENT; checks = inchecks; }
+	P11AttrPublicExponent(CK_ULONG inchecks) : P11Attribute() { type = CKA_PUBLIC_EXPONENT; checks = inchecks; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -903,11 +900,11 @@ class P11AttrPrivateExponent : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrPrivateExponent(OSObject* osobject) : P11Attribute(osobject) { type = CKA_PRIVATE_EXPONENT; checks = ck1|ck4|ck6|ck7; }
+	P11AttrPrivateExponent() : P11Attribute() { type = CKA_PRIVATE_EXPONENT; checks = ck1|ck4|ck6|ck7; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -918,11 +915,11 @@ class P11AttrPrime1 : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrPrime1(OSObject* osobject) : P11Attribute(osobject) { type = CKA_PRIME_1; checks = ck4|ck6|ck7; }
+	P11AttrPrime1() : P11Attribute() { type = CKA_PRIME_1; checks = ck4|ck6|ck7; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -933,11 +930,11 @@ class P11AttrPrime2 : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrPrime2(OSObject* osobject) : P11Attribute(osobject) { type = CKA_PRIME_2; checks = ck4|ck6|ck7; }
+	P11AttrPrime2() : P11Attribute() { type = CKA_PRIME_2; checks = ck4|ck6|ck7; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -948,11 +945,11 @@ class P11AttrExponent1 : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrExponent1(OSObject* osobject) : P11Attribute(osobject) { type = CKA_EXPONENT_1; checks = ck4|ck6|ck7; }
+	P11AttrExponent1() : P11Attribute() { type = CKA_EXPONENT_1; checks = ck4|ck6|ck7; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -963,11 +960,11 @@ class P11AttrExponent2 : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrExponent2(OSObject* osobject) : P11Attribute(osobject) { type = CKA_EXPONENT_2; checks = ck4|ck6|ck7; }
+	P11AttrExponent2() : P11Attribute() { type = CKA_EXPONENT_2; checks = ck4|ck6|ck7; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -978,11 +975,11 @@ class P11AttrCoefficient : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrCoefficient(OSObject* osobject) : P11Attribute(osobject) { type = CKA_COEFFICIENT; checks = ck4|ck6|ck7; }
+	P11AttrCoefficient() : P11Attribute() { type = CKA_COEFFICIENT; checks = ck4|ck6|ck7; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -993,14 +990,14 @@ class P11AttrModulusBits : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrModulusBits(OSObject* osobject) : P11Attribute(osobject) { type = CKA_MODULUS_BITS; size = sizeof(CK_ULONG); checks = ck2|ck3;}
+	P11AttrModulusBits() : P11Attribute() { type = CKA_MODULUS_BITS; size = sizeof(CK_ULONG); checks = ck2|ck3;}
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -1011,11 +1008,11 @@ class P11AttrPrime : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrPrime(OSObject* osobject, CK_ULONG inchecks = 0) : P11Attribute(osobject) { type = CKA_PRIME; checks = ck1|inchecks; }
+	P11AttrPrime(CK_ULONG inchecks = 0) : P11Attribute() { type = CKA_PRIME; checks = ck1|inchecks; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -1026,11 +1023,11 @@ class P11AttrSubPrime : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrSubPrime(OSObject* osobject, CK_ULONG inchecks = 0) : P11Attribute(osobject) { type = CKA_SUBPRIME; checks = ck1|inchecks; }
+	P11AttrSubPrime(CK_ULONG inchecks = 0) : P11Attribute() { type = CKA_SUBPRIME; checks = ck1|inchecks; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -1041,11 +1038,11 @@ class P11AttrBase : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrBase(OSObject* osobject, CK_ULONG inchecks = 0) : P11Attribute(osobject) { type = CKA_BASE; checks = ck1|inchecks; }
+	P11AttrBase(CK_ULONG inchecks = 0) : P11Attribute() { type = CKA_BASE; checks = ck1|inchecks; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -1056,14 +1053,14 @@ class P11AttrPrimeBits : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrPrimeBits(OSObject* osobject) : P11Attribute(osobject) { type = CKA_PRIME_BITS; size = sizeof(CK_ULONG); checks = ck2|ck3;}
+	P11AttrPrimeBits() : P11Attribute() { type = CKA_PRIME_BITS; size = sizeof(CK_ULONG); checks = ck2|ck3;}
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 
 	// Update the value if allowed
-	virtual CK_RV updateAttr(Token *token, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op);
+	virtual CK_RV updateAttr(Token *token, OSObject* osobject, bool isPrivate, CK_VOID_PTR pValue, CK_ULONG ulValueLen, int op) const;
 };
 
 /*****************************************
@@ -1074,11 +1071,11 @@ class P11AttrEcParams : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrEcParams(OSObject* osobject, CK_ULONG inchecks = 0) : P11Attribute(osobject) { type = CKA_EC_PARAMS; checks = ck1|inchecks; }
+	P11AttrEcParams(CK_ULONG inchecks = 0) : P11Attribute() { type = CKA_EC_PARAMS; checks = ck1|inchecks; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -1089,11 +1086,11 @@ class P11AttrEcPoint : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrEcPoint(OSObject* osobject) : P11Attribute(osobject) { type = CKA_EC_POINT; checks = ck1|ck4; }
+	P11AttrEcPoint() : P11Attribute() { type = CKA_EC_POINT; checks = ck1|ck4; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -1104,14 +1101,14 @@ class P11AttrGostR3410Params : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrGostR3410Params(OSObject* osobject, CK_ULONG inchecks = 0) : P11Attribute(osobject) { type = CKA_GOSTR3410_PARAMS; checks = ck1|inchecks; }
+	P11AttrGostR3410Params(CK_ULONG inchecks = 0) : P11Attribute() { type = CKA_GOSTR3410_PARAMS; checks = ck1|inchecks; }
 
 // id-GostR3410-2001-CryptoPro-A-ParamSet 1.2.643.2.2.35.1
 #define GostR3419_A_ParamSet	"06072a850302022301"
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -1122,14 +1119,14 @@ class P11AttrGostR3411Params : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrGostR3411Params(OSObject* osobject, CK_ULONG inchecks = 0) : P11Attribute(osobject) { type = CKA_GOSTR3411_PARAMS; checks = ck1|ck8|inchecks; }
+	P11AttrGostR3411Params(CK_ULONG inchecks = 0) : P11Attribute() { type = CKA_GOSTR3411_PARAMS; checks = ck1|ck8|inchecks; }
 
 // id-GostR3411-94-CryptoProParamSet 1.2.643.2.2.30.1
 #define GostR3411_ParamSet	"06072a850302021e01"
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 /*****************************************
@@ -1140,11 +1137,11 @@ class P11AttrGost28147Params : public P11Attribute
 {
 public:
 	// Constructor
-	P11AttrGost28147Params(OSObject* osobject, CK_ULONG inchecks = 0) : P11Attribute(osobject) { type = CKA_GOST28147_PARAMS; checks = ck8|inchecks; }
+	P11AttrGost28147Params(CK_ULONG inchecks = 0) : P11Attribute() { type = CKA_GOST28147_PARAMS; checks = ck8|inchecks; }
 
 protected:
 	// Set the default value of the attribute
-	virtual bool setDefault();
+	virtual bool setDefault(OSObject* osobject) const;
 };
 
 #endif // !_SOFTHSM_V2_P11ATTRIBUTES_H
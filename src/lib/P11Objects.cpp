@@ -34,76 +34,147 @@
 #include "P11Objects.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
+
+/*****************************************************************************
+ P11Schema
+ *****************************************************************************/
+
+// Sort attributes by type
+static bool compareType(const P11Attribute* a, const P11Attribute* b)
+{
+	return a->getType() < b->getType();
+}
 
 // Constructor
-P11Object::P11Object()
+P11Schema::P11Schema(void (*addAttributes)(P11Schema& schema))
 {
-	initialized = false;
+	addAttributes(*this);
+
+	index = attributes;
+	std::sort(index.begin(), index.end(), compareType);
 }
 
 // Destructor
-P11Object::~P11Object()
+P11Schema::~P11Schema()
 {
-	std::map<CK_ATTRIBUTE_TYPE, P11Attribute*> cleanUp = attributes;
-	attributes.clear();
+	for (std::vector<P11Attribute*>::iterator i = attributes.begin(); i != attributes.end(); i++)
+	{
+		delete *i;
+	}
+}
 
-	for (std::map<CK_ATTRIBUTE_TYPE, P11Attribute*>::iterator i = cleanUp.begin(); i != cleanUp.end(); i++)
+// Add an attribute; it replaces an attribute of the same type that was
+// added by a parent class
+void P11Schema::add(P11Attribute* attribute)
+{
+	for (std::vector<P11Attribute*>::iterator i = attributes.begin(); i != attributes.end(); i++)
 	{
-		if (i->second == NULL)
+		if ((*i)->getType() == attribute->getType())
 		{
-			continue;
+			delete *i;
+			*i = attribute;
+
+			return;
 		}
+	}
+
+	attributes.push_back(attribute);
+}
+
+// Find the attribute of the given type
+const P11Attribute* P11Schema::find(CK_ATTRIBUTE_TYPE type) const
+{
+	size_t low = 0;
+	size_t high = index.size();
+
+	while (low < high)
+	{
+		size_t mid = (low + high) / 2;
+		CK_ATTRIBUTE_TYPE midType = index[mid]->getType();
 
-		delete i->second;
-		i->second = NULL;
+		if (midType == type) return index[mid];
+
+		if (midType < type)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
 	}
+
+	return NULL;
+}
+
+// The number of attributes
+size_t P11Schema::size() const
+{
+	return attributes.size();
+}
+
+// The attributes in the order in which they were added
+const P11Attribute* P11Schema::at(size_t i) const
+{
+	return attributes[i];
+}
+
+/*****************************************************************************
+ P11Object
+ *****************************************************************************/
+
+// Constructor
+P11Object::P11Object()
+{
+	initialized = false;
+	osobject = NULL;
+	schema = NULL;
+}
+
+// Destructor
+P11Object::~P11Object()
+{
+}
+
+// Add the attributes to the schema
+void P11Object::addAttributes(P11Schema& schema)
+{
+	schema.add(new P11AttrClass());
+	schema.add(new P11AttrToken());
+	schema.add(new P11AttrPrivate());
+	schema.add(new P11AttrModifiable());
+	schema.add(new P11AttrLabel());
+	schema.add(new P11AttrCopyable());
 }
 
 // Add attributes
 bool P11Object::init(OSObject *osobject)
 {
 	if (initialized) return true;
-	if (osobject == NULL) return false;
+	if (osobject == NULL || schema == NULL) return false;
 
 	this->osobject = osobject;
 
-	// Create attributes
-	P11Attribute* attrClass = new P11AttrClass(osobject);
-	P11Attribute* attrToken = new P11AttrToken(osobject);
-	P11Attribute* attrPrivate = new P11AttrPrivate(osobject);
-	P11Attribute* attrModifiable = new P11AttrModifiable(osobject);
-	P11Attribute* attrLabel = new P11AttrLabel(osobject);
-	P11Attribute* attrCopyable = new P11AttrCopyable(osobject);
-
-	// Initialize the attributes
-	if
-	(
-		!attrClass->init() ||
-		!attrToken->init() ||
-		!attrPrivate->init() ||
-		!attrModifiable->init() ||
-		!attrLabel->init() ||
-		!attrCopyable->init()
-	)
+	// Create default values for the attributes that are not present yet
+	for (size_t i = 0; i < schema->size(); i++)
 	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
+		if (!schema->at(i)->init(osobject))
+		{
+			ERROR_MSG("Could not initialize the attribute");
+			return false;
+		}
 	}
 
-	// Add them to the map
-	attributes[attrClass->getType()] = attrClass;
-	attributes[attrToken->getType()] = attrToken;
-	attributes[attrPrivate->getType()] = attrPrivate;
-	attributes[attrModifiable->getType()] = attrModifiable;
-	attributes[attrLabel->getType()] = attrLabel;
-	attributes[attrCopyable->getType()] = attrCopyable;
-
 	initialized = true;
 	return true;
 }
 
 CK_RV P11Object::loadTemplate(Token *token, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulAttributeCount)
 {
+	if (osobject == NULL)
+		return CKR_GENERAL_ERROR;
+
 	bool isPrivate = this->isPrivate();
 
 	// [PKCS#11 v2.3 pg.131]
@@ -132,7 +203,7 @@ CK_RV P11Object::loadTemplate(Token *token, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG
 	// If case 3 or 4 applies to all the requested attributes, then the call will return CKR_OK.
 	for (CK_ULONG i = 0; i < ulAttributeCount; ++i)
 	{
-		P11Attribute* attr = attributes[pTemplate[i].type];
+		const P11Attribute* attr = schema->find(pTemplate[i].type);
 
 		// case 2 of the attribute checks
 		if (attr == NULL) {
@@ -143,7 +214,7 @@ CK_RV P11Object::loadTemplate(Token *token, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG
 		}
 
 		// case 1,3,4 and 5 of the attribute checks are done while retrieving the attribute itself.
-		CK_RV retrieve_rv = attr->retrieve(token, isPrivate, pTemplate[i].pValue, &pTemplate[i].ulValueLen);
+		CK_RV retrieve_rv = attr->retrieve(token, osobject, isPrivate, pTemplate[i].pValue, &pTemplate[i].ulValueLen);
 		if (retrieve_rv != CKR_OK) {
 			// If case 1 applies to any of the requested attributes, then the call should
 			// return the value CKR_ATTRIBUTE_SENSITIVE.
@@ -187,7 +258,7 @@ CK_RV P11Object::saveTemplate(Token *token, bool isPrivate, CK_ATTRIBUTE_PTR pTe
 		//    should fail with the error code CKR_ATTRIBUTE_TYPE_INVALID. An attribute
 		//    is valid if it is either one of the attributes described in the Cryptoki specification or an
 		//    additional vendor-specific attribute supported by the library and token.
-		P11Attribute* attr = attributes[pTemplate[i].type];
+		const P11Attribute* attr = schema->find(pTemplate[i].type);
 		if (attr == NULL)
 		{
 			osobject->abortTransaction();
@@ -195,7 +266,7 @@ CK_RV P11Object::saveTemplate(Token *token, bool isPrivate, CK_ATTRIBUTE_PTR pTe
 		}
 
 		// Additonal checks are done while updating the attributes themselves.
-		CK_RV rv = attr->update(token,isPrivate, pTemplate[i].pValue, pTemplate[i].ulValueLen, op);
+		CK_RV rv = attr->update(token, osobject, isPrivate, pTemplate[i].pValue, pTemplate[i].ulValueLen, op);
 		if (rv != CKR_OK)
 		{
 			osobject->abortTransaction();
@@ -270,6 +341,21 @@ bool P11Object::isModifiable()
 P11DataObj::P11DataObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of a data object
+const P11Schema P11DataObj::classSchema(P11DataObj::addAttributes);
+
+// Add the attributes to the schema
+void P11DataObj::addAttributes(P11Schema& schema)
+{
+	P11Object::addAttributes(schema);
+
+	schema.add(new P11AttrApplication());
+	schema.add(new P11AttrObjectID());
+	// NOTE: There is no mention in the PKCS#11 v2.3 spec that for a Data
+	schema.add(new P11AttrValue(0));
 }
 
 // Add attributes
@@ -282,34 +368,8 @@ bool P11DataObj::init(OSObject *osobject)
 	OSAttribute attrClass((unsigned long)CKO_DATA);
 	osobject->setAttribute(CKA_CLASS, attrClass);
 
-	// Create parent
-	if (!P11Object::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrApplication = new P11AttrApplication(osobject);
-	P11Attribute* attrObjectID = new P11AttrObjectID(osobject);
-	// NOTE: There is no mention in the PKCS#11 v2.3 spec that for a Data
-	//  Object the CKA_VALUE attribute may be modified after creation !
-	//  Therefore we assume it is not allowed to change the CKA_VALUE
-	//  attribute of a Data Object.
-	P11Attribute* attrValue = new P11AttrValue(osobject,0);
-
 	// Initialize the attributes
-	if
-	(
-		!attrApplication->init() ||
-		!attrObjectID->init() ||
-		!attrValue->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrApplication->getType()] = attrApplication;
-	attributes[attrObjectID->getType()] = attrObjectID;
-	attributes[attrValue->getType()] = attrValue;
+	if (!P11Object::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -321,6 +381,19 @@ P11CertificateObj::P11CertificateObj()
 	initialized = false;
 }
 
+// Add the attributes to the schema
+void P11CertificateObj::addAttributes(P11Schema& schema)
+{
+	P11Object::addAttributes(schema);
+
+	schema.add(new P11AttrCertificateType());
+	schema.add(new P11AttrTrusted());
+	schema.add(new P11AttrCertificateCategory());
+	schema.add(new P11AttrCheckValue());
+	schema.add(new P11AttrStartDate());
+	schema.add(new P11AttrEndDate());
+}
+
 // Add attributes
 bool P11CertificateObj::init(OSObject *osobject)
 {
@@ -331,39 +404,8 @@ bool P11CertificateObj::init(OSObject *osobject)
 	OSAttribute attrClass((unsigned long)CKO_CERTIFICATE);
 	osobject->setAttribute(CKA_CLASS, attrClass);
 
-	// Create parent
-	if (!P11Object::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrCertificateType = new P11AttrCertificateType(osobject);
-	P11Attribute* attrTrusted = new P11AttrTrusted(osobject);
-	P11Attribute* attrCertificateCategory = new P11AttrCertificateCategory(osobject);
-	P11Attribute* attrCheckValue = new P11AttrCheckValue(osobject);
-	P11Attribute* attrStartDate = new P11AttrStartDate(osobject);
-	P11Attribute* attrEndDate = new P11AttrEndDate(osobject);
-
 	// Initialize the attributes
-	if
-	(
-		!attrCertificateType->init() ||
-		!attrTrusted->init() ||
-		!attrCertificateCategory->init() ||
-		!attrCheckValue->init() ||
-		!attrStartDate->init() ||
-		!attrEndDate->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrCertificateType->getType()] = attrCertificateType;
-	attributes[attrTrusted->getType()] = attrTrusted;
-	attributes[attrCertificateCategory->getType()] = attrCertificateCategory;
-	attributes[attrCheckValue->getType()] = attrCheckValue;
-	attributes[attrStartDate->getType()] = attrStartDate;
-	attributes[attrEndDate->getType()] = attrEndDate;
+	if (!P11Object::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -373,6 +415,27 @@ bool P11CertificateObj::init(OSObject *osobject)
 P11X509CertificateObj::P11X509CertificateObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of an X.509 certificate
+const P11Schema P11X509CertificateObj::classSchema(P11X509CertificateObj::addAttributes);
+
+// Add the attributes to the schema
+void P11X509CertificateObj::addAttributes(P11Schema& schema)
+{
+	P11CertificateObj::addAttributes(schema);
+
+	schema.add(new P11AttrSubject(P11Attribute::ck1));
+	schema.add(new P11AttrID());
+	schema.add(new P11AttrIssuer());
+	schema.add(new P11AttrSerialNumber());
+	schema.add(new P11AttrValue(P11Attribute::ck1|P11Attribute::ck14));
+	schema.add(new P11AttrURL());
+	schema.add(new P11AttrHashOfSubjectPublicKey());
+	schema.add(new P11AttrHashOfIssuerPublicKey());
+	schema.add(new P11AttrJavaMidpSecurityDomain());
+	schema.add(new P11AttrNameHashAlgorithm());
 }
 
 // Add attributes
@@ -385,52 +448,10 @@ bool P11X509CertificateObj::init(OSObject *osobject)
 	OSAttribute attrCertType((unsigned long)CKC_X_509);
 	osobject->setAttribute(CKA_CERTIFICATE_TYPE, attrCertType);
 
-	// Create parent
-	if (!P11CertificateObj::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrSubject = new P11AttrSubject(osobject,P11Attribute::ck1);
-	P11Attribute* attrID = new P11AttrID(osobject);
-	P11Attribute* attrIssuer = new P11AttrIssuer(osobject);
-	P11Attribute* attrSerialNumber = new P11AttrSerialNumber(osobject);
-	P11Attribute* attrValue = new P11AttrValue(osobject,P11Attribute::ck1|P11Attribute::ck14);
-	P11Attribute* attrURL = new P11AttrURL(osobject);
-	P11Attribute* attrHashOfSubjectPublicKey = new P11AttrHashOfSubjectPublicKey(osobject);
-	P11Attribute* attrHashOfIssuerPublicKey = new P11AttrHashOfIssuerPublicKey(osobject);
-	P11Attribute* attrJavaMidpSecurityDomain = new P11AttrJavaMidpSecurityDomain(osobject);
-	P11Attribute* attrNameHashAlgorithm = new P11AttrNameHashAlgorithm(osobject);
-
 	// Initialize the attributes
-	if
-	(
-		!attrSubject->init() ||
-		!attrID->init() ||
-		!attrIssuer->init() ||
-		!attrSerialNumber->init() ||
-		!attrValue->init() ||
-		!attrURL->init() ||
-		!attrHashOfSubjectPublicKey->init() ||
-		!attrHashOfIssuerPublicKey->init() ||
-		!attrJavaMidpSecurityDomain->init() ||
-		!attrNameHashAlgorithm->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrSubject->getType()] = attrSubject;
-	attributes[attrID->getType()] = attrID;
-	attributes[attrIssuer->getType()] = attrIssuer;
-	attributes[attrSerialNumber->getType()] = attrSerialNumber;
-	attributes[attrValue->getType()] = attrValue;
-	attributes[attrURL->getType()] = attrURL;
-	attributes[attrHashOfSubjectPublicKey->getType()] = attrHashOfSubjectPublicKey;
-	attributes[attrHashOfIssuerPublicKey->getType()] = attrHashOfIssuerPublicKey;
-	attributes[attrJavaMidpSecurityDomain->getType()] = attrJavaMidpSecurityDomain;
-	attributes[attrNameHashAlgorithm->getType()] = attrNameHashAlgorithm;
+	if (!P11CertificateObj::init(osobject)) return false;
 
+	initialized = true;
 	return true;
 }
 
@@ -440,49 +461,29 @@ P11KeyObj::P11KeyObj()
 	initialized = false;
 }
 
+// Add the attributes to the schema
+void P11KeyObj::addAttributes(P11Schema& schema)
+{
+	P11Object::addAttributes(schema);
+
+	schema.add(new P11AttrKeyType());
+	schema.add(new P11AttrID());
+	schema.add(new P11AttrStartDate());
+	schema.add(new P11AttrEndDate());
+	schema.add(new P11AttrDerive());
+	schema.add(new P11AttrLocal());
+	schema.add(new P11AttrKeyGenMechanism());
+	// CKA_ALLOWED_MECHANISMS is not supported
+}
+
 // Add attributes
 bool P11KeyObj::init(OSObject *osobject)
 {
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
-	// Create parent
-	if (!P11Object::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrKeyType = new P11AttrKeyType(osobject);
-	P11Attribute* attrID = new P11AttrID(osobject);
-	P11Attribute* attrStartDate = new P11AttrStartDate(osobject);
-	P11Attribute* attrEndDate = new P11AttrEndDate(osobject);
-	P11Attribute* attrDerive = new P11AttrDerive(osobject);
-	P11Attribute* attrLocal = new P11AttrLocal(osobject);
-	P11Attribute* attrKeyGenMechanism = new P11AttrKeyGenMechanism(osobject);
-	// CKA_ALLOWED_MECHANISMS is not supported
-
 	// Initialize the attributes
-	if
-	(
-		!attrKeyType->init() ||
-		!attrID->init() ||
-		!attrStartDate->init() ||
-		!attrEndDate->init() ||
-		!attrDerive->init() ||
-		!attrLocal->init() ||
-		!attrKeyGenMechanism->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrKeyType->getType()] = attrKeyType;
-	attributes[attrID->getType()] = attrID;
-	attributes[attrStartDate->getType()] = attrStartDate;
-	attributes[attrEndDate->getType()] = attrEndDate;
-	attributes[attrDerive->getType()] = attrDerive;
-	attributes[attrLocal->getType()] = attrLocal;
-	attributes[attrKeyGenMechanism->getType()] = attrKeyGenMechanism;
+	if (!P11Object::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -494,51 +495,32 @@ P11PublicKeyObj::P11PublicKeyObj()
 	initialized = false;
 }
 
+// Add the attributes to the schema
+void P11PublicKeyObj::addAttributes(P11Schema& schema)
+{
+	P11KeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrSubject(P11Attribute::ck8));
+	schema.add(new P11AttrEncrypt());
+	schema.add(new P11AttrVerify());
+	schema.add(new P11AttrVerifyRecover());
+	schema.add(new P11AttrWrap());
+	schema.add(new P11AttrTrusted());
+	// CKA_WRAP_TEMPLATE is not supported
+}
+
 // Add attributes
 bool P11PublicKeyObj::init(OSObject *osobject)
 {
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrClass((unsigned long)CKO_PUBLIC_KEY);
 	osobject->setAttribute(CKA_CLASS, attrClass);
 
-	// Create parent
-	if (!P11KeyObj::init(osobject)) return false;
-
-	if (initialized) return true;
-
-	// Create attributes
-	P11Attribute* attrSubject = new P11AttrSubject(osobject,P11Attribute::ck8);
-	P11Attribute* attrEncrypt = new P11AttrEncrypt(osobject);
-	P11Attribute* attrVerify = new P11AttrVerify(osobject);
-	P11Attribute* attrVerifyRecover = new P11AttrVerifyRecover(osobject);
-	P11Attribute* attrWrap = new P11AttrWrap(osobject);
-	P11Attribute* attrTrusted = new P11AttrTrusted(osobject);
-		// CKA_WRAP_TEMPLATE is not supported
-
 	// Initialize the attributes
-	if
-	(
-		!attrSubject->init() ||
-		!attrEncrypt->init() ||
-		!attrVerify->init() ||
-		!attrVerifyRecover->init() ||
-		!attrWrap->init() ||
-		!attrTrusted->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrSubject->getType()] = attrSubject;
-	attributes[attrEncrypt->getType()] = attrEncrypt;
-	attributes[attrVerify->getType()] = attrVerify;
-	attributes[attrVerifyRecover->getType()] = attrVerifyRecover;
-	attributes[attrWrap->getType()] = attrWrap;
-	attributes[attrTrusted->getType()] = attrTrusted;
+	if (!P11KeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -548,6 +530,20 @@ bool P11PublicKeyObj::init(OSObject *osobject)
 P11RSAPublicKeyObj::P11RSAPublicKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of an RSA public key
+const P11Schema P11RSAPublicKeyObj::classSchema(P11RSAPublicKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11RSAPublicKeyObj::addAttributes(P11Schema& schema)
+{
+	P11PublicKeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrModulus());
+	schema.add(new P11AttrModulusBits());
+	schema.add(new P11AttrPublicExponent(P11Attribute::ck1));
 }
 
 // Add attributes
@@ -556,33 +552,12 @@ bool P11RSAPublicKeyObj::init(OSObject *osobject)
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_RSA);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	// Create parent
-	if (!P11PublicKeyObj::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrModulus = new P11AttrModulus(osobject);
-	P11Attribute* attrModulusBits = new P11AttrModulusBits(osobject);
-	P11Attribute* attrPublicExponent = new P11AttrPublicExponent(osobject,P11Attribute::ck1);
-
 	// Initialize the attributes
-	if
-	(
-		!attrModulus->init() ||
-		!attrModulusBits->init() ||
-		!attrPublicExponent->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrModulus->getType()] = attrModulus;
-	attributes[attrModulusBits->getType()] = attrModulusBits;
-	attributes[attrPublicExponent->getType()] = attrPublicExponent;
+	if (!P11PublicKeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -592,6 +567,21 @@ bool P11RSAPublicKeyObj::init(OSObject *osobject)
 P11DSAPublicKeyObj::P11DSAPublicKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of a DSA public key
+const P11Schema P11DSAPublicKeyObj::classSchema(P11DSAPublicKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11DSAPublicKeyObj::addAttributes(P11Schema& schema)
+{
+	P11PublicKeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrPrime(P11Attribute::ck3));
+	schema.add(new P11AttrSubPrime(P11Attribute::ck3));
+	schema.add(new P11AttrBase(P11Attribute::ck3));
+	schema.add(new P11AttrValue(P11Attribute::ck1));
 }
 
 // Add attributes
@@ -600,36 +590,12 @@ bool P11DSAPublicKeyObj::init(OSObject *osobject)
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_DSA);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	// Create parent
-	if (!P11PublicKeyObj::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrPrime = new P11AttrPrime(osobject,P11Attribute::ck3);
-	P11Attribute* attrSubPrime = new P11AttrSubPrime(osobject,P11Attribute::ck3);
-	P11Attribute* attrBase = new P11AttrBase(osobject,P11Attribute::ck3);
-	P11Attribute* attrValue = new P11AttrValue(osobject,P11Attribute::ck1);
-
 	// Initialize the attributes
-	if
-	(
-		!attrPrime->init() ||
-		!attrSubPrime->init() ||
-		!attrBase->init() ||
-		!attrValue->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrPrime->getType()] = attrPrime;
-	attributes[attrSubPrime->getType()] = attrSubPrime;
-	attributes[attrBase->getType()] = attrBase;
-	attributes[attrValue->getType()] = attrValue;
+	if (!P11PublicKeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -639,6 +605,19 @@ bool P11DSAPublicKeyObj::init(OSObject *osobject)
 P11ECPublicKeyObj::P11ECPublicKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of an EC public key
+const P11Schema P11ECPublicKeyObj::classSchema(P11ECPublicKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11ECPublicKeyObj::addAttributes(P11Schema& schema)
+{
+	P11PublicKeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrEcParams(P11Attribute::ck3));
+	schema.add(new P11AttrEcPoint());
 }
 
 // Add attributes
@@ -647,30 +626,12 @@ bool P11ECPublicKeyObj::init(OSObject *osobject)
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_EC);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	// Create parent
-	if (!P11PublicKeyObj::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrEcParams = new P11AttrEcParams(osobject,P11Attribute::ck3);
-	P11Attribute* attrEcPoint = new P11AttrEcPoint(osobject);
-
 	// Initialize the attributes
-	if
-	(
-		!attrEcParams->init() ||
-		!attrEcPoint->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrEcParams->getType()] = attrEcParams;
-	attributes[attrEcPoint->getType()] = attrEcPoint;
+	if (!P11PublicKeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -680,6 +641,20 @@ bool P11ECPublicKeyObj::init(OSObject *osobject)
 P11DHPublicKeyObj::P11DHPublicKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of a DH public key
+const P11Schema P11DHPublicKeyObj::classSchema(P11DHPublicKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11DHPublicKeyObj::addAttributes(P11Schema& schema)
+{
+	P11PublicKeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrPrime(P11Attribute::ck3));
+	schema.add(new P11AttrBase(P11Attribute::ck3));
+	schema.add(new P11AttrValue(P11Attribute::ck1));
 }
 
 // Add attributes
@@ -688,33 +663,12 @@ bool P11DHPublicKeyObj::init(OSObject *osobject)
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_DH);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	// Create parent
-	if (!P11PublicKeyObj::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrPrime = new P11AttrPrime(osobject,P11Attribute::ck3);
-	P11Attribute* attrBase = new P11AttrBase(osobject,P11Attribute::ck3);
-	P11Attribute* attrValue = new P11AttrValue(osobject,P11Attribute::ck1);
-
 	// Initialize the attributes
-	if
-	(
-		!attrPrime->init() ||
-		!attrBase->init() ||
-		!attrValue->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrPrime->getType()] = attrPrime;
-	attributes[attrBase->getType()] = attrBase;
-	attributes[attrValue->getType()] = attrValue;
+	if (!P11PublicKeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -724,6 +678,20 @@ bool P11DHPublicKeyObj::init(OSObject *osobject)
 P11GOSTPublicKeyObj::P11GOSTPublicKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of a GOST public key
+const P11Schema P11GOSTPublicKeyObj::classSchema(P11GOSTPublicKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11GOSTPublicKeyObj::addAttributes(P11Schema& schema)
+{
+	P11PublicKeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrValue(P11Attribute::ck1));
+	schema.add(new P11AttrGostR3410Params(P11Attribute::ck3));
+	schema.add(new P11AttrGostR3411Params(P11Attribute::ck3));
 }
 
 // Add attributes
@@ -732,101 +700,54 @@ bool P11GOSTPublicKeyObj::init(OSObject *osobject)
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_GOSTR3410);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	// Create parent
-	if (!P11PublicKeyObj::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrValue = new P11AttrValue(osobject,P11Attribute::ck1);
-	P11Attribute* attrGostR3410Params = new P11AttrGostR3410Params(osobject,P11Attribute::ck3);
-	P11Attribute* attrGostR3411Params = new P11AttrGostR3411Params(osobject,P11Attribute::ck3);
-
 	// Initialize the attributes
-	if
-	(
-		!attrValue->init() ||
-		!attrGostR3410Params->init() ||
-		!attrGostR3411Params->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrValue->getType()] = attrValue;
-	attributes[attrGostR3410Params->getType()] = attrGostR3410Params;
-	attributes[attrGostR3411Params->getType()] = attrGostR3411Params;
+	if (!P11PublicKeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
 }
 
-//constructor
+// Constructor
 P11PrivateKeyObj::P11PrivateKeyObj()
 {
 	initialized = false;
 }
 
+// Add the attributes to the schema
+void P11PrivateKeyObj::addAttributes(P11Schema& schema)
+{
+	P11KeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrSubject(P11Attribute::ck8));
+	schema.add(new P11AttrSensitive());
+	schema.add(new P11AttrDecrypt());
+	schema.add(new P11AttrSign());
+	schema.add(new P11AttrSignRecover());
+	schema.add(new P11AttrUnwrap());
+	schema.add(new P11AttrExtractable());
+	schema.add(new P11AttrAlwaysSensitive());
+	schema.add(new P11AttrNeverExtractable());
+	schema.add(new P11AttrWrapWithTrusted());
+	// CKA_UNWRAP_TEMPLATE is not supported
+	schema.add(new P11AttrAlwaysAuthenticate());
+}
+
 // Add attributes
 bool P11PrivateKeyObj::init(OSObject *osobject)
 {
 	if (initialized) return true;
+	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrClass((unsigned long)CKO_PRIVATE_KEY);
 	osobject->setAttribute(CKA_CLASS, attrClass);
 
-	// Create parent
-	if (!P11KeyObj::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrSubject = new P11AttrSubject(osobject,P11Attribute::ck8);
-	P11Attribute* attrSensitive = new P11AttrSensitive(osobject);
-	P11Attribute* attrDecrypt = new P11AttrDecrypt(osobject);
-	P11Attribute* attrSign = new P11AttrSign(osobject);
-	P11Attribute* attrSignRecover = new P11AttrSignRecover(osobject);
-	P11Attribute* attrUnwrap = new P11AttrUnwrap(osobject);
-	P11Attribute* attrExtractable = new P11AttrExtractable(osobject);
-	P11Attribute* attrAlwaysSensitive = new P11AttrAlwaysSensitive(osobject);
-	P11Attribute* attrNeverExtractable = new P11AttrNeverExtractable(osobject);
-	P11Attribute* attrWrapWithTrusted = new P11AttrWrapWithTrusted(osobject);
-		// CKA_UNWRAP_TEMPLATE is not supported
-	P11Attribute* attrAlwaysAuthenticate = new P11AttrAlwaysAuthenticate(osobject);
-
 	// Initialize the attributes
-	if
-	(
-		!attrSubject->init() ||
-		!attrSensitive->init() ||
-		!attrDecrypt->init() ||
-		!attrSign->init() ||
-		!attrSignRecover->init() ||
-		!attrUnwrap->init() ||
-		!attrExtractable->init() ||
-		!attrAlwaysSensitive->init() ||
-		!attrNeverExtractable->init() ||
-		!attrWrapWithTrusted->init() ||
-		!attrAlwaysAuthenticate->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrSubject->getType()] = attrSubject;
-	attributes[attrSensitive->getType()] = attrSensitive;
-	attributes[attrDecrypt->getType()] = attrDecrypt;
-	attributes[attrSign->getType()] = attrSign;
-	attributes[attrSignRecover->getType()] = attrSignRecover;
-	attributes[attrUnwrap->getType()] = attrUnwrap;
-	attributes[attrExtractable->getType()] = attrExtractable;
-	attributes[attrAlwaysSensitive->getType()] = attrAlwaysSensitive;
-	attributes[attrNeverExtractable->getType()] = attrNeverExtractable;
-	attributes[attrWrapWithTrusted->getType()] = attrWrapWithTrusted;
-	attributes[attrAlwaysAuthenticate->getType()] = attrAlwaysAuthenticate;
+	if (!P11KeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -836,55 +757,39 @@ bool P11PrivateKeyObj::init(OSObject *osobject)
 P11RSAPrivateKeyObj::P11RSAPrivateKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of an RSA private key
+const P11Schema P11RSAPrivateKeyObj::classSchema(P11RSAPrivateKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11RSAPrivateKeyObj::addAttributes(P11Schema& schema)
+{
+	P11PrivateKeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrModulus());
+	schema.add(new P11AttrPublicExponent(P11Attribute::ck4|P11Attribute::ck6));
+	schema.add(new P11AttrPrivateExponent());
+	schema.add(new P11AttrPrime1());
+	schema.add(new P11AttrPrime2());
+	schema.add(new P11AttrExponent1());
+	schema.add(new P11AttrExponent2());
+	schema.add(new P11AttrCoefficient());
 }
 
 // Add attributes
 bool P11RSAPrivateKeyObj::init(OSObject *osobject)
 {
-	// Create parent
-	if (!P11PrivateKeyObj::init(osobject)) return false;
+	if (initialized) return true;
+	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_RSA);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	if (initialized) return true;
-
-	// Create attributes
-	P11Attribute* attrModulus = new P11AttrModulus(osobject);
-	P11Attribute* attrPublicExponent = new P11AttrPublicExponent(osobject,P11Attribute::ck4|P11Attribute::ck6);
-	P11Attribute* attrPrivateExponent = new P11AttrPrivateExponent(osobject);
-	P11Attribute* attrPrime1 = new P11AttrPrime1(osobject);
-	P11Attribute* attrPrime2 = new P11AttrPrime2(osobject);
-	P11Attribute* attrExponent1 = new P11AttrExponent1(osobject);
-	P11Attribute* attrExponent2 = new P11AttrExponent2(osobject);
-	P11Attribute* attrCoefficient = new P11AttrCoefficient(osobject);
-
 	// Initialize the attributes
-	if
-	(
-		!attrModulus->init() ||
-		!attrPublicExponent->init() ||
-		!attrPrivateExponent->init() ||
-		!attrPrime1->init() ||
-		!attrPrime2->init() ||
-		!attrExponent1->init() ||
-		!attrExponent2->init() ||
-		!attrCoefficient->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrModulus->getType()] = attrModulus;
-	attributes[attrPublicExponent->getType()] = attrPublicExponent;
-	attributes[attrPrivateExponent->getType()] = attrPrivateExponent;
-	attributes[attrPrime1->getType()] = attrPrime1;
-	attributes[attrPrime2->getType()] = attrPrime2;
-	attributes[attrExponent1->getType()] = attrExponent1;
-	attributes[attrExponent2->getType()] = attrExponent2;
-	attributes[attrCoefficient->getType()] = attrCoefficient;
+	if (!P11PrivateKeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -894,43 +799,35 @@ bool P11RSAPrivateKeyObj::init(OSObject *osobject)
 P11DSAPrivateKeyObj::P11DSAPrivateKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of a DSA private key
+const P11Schema P11DSAPrivateKeyObj::classSchema(P11DSAPrivateKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11DSAPrivateKeyObj::addAttributes(P11Schema& schema)
+{
+	P11PrivateKeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrPrime(P11Attribute::ck4|P11Attribute::ck6));
+	schema.add(new P11AttrSubPrime(P11Attribute::ck4|P11Attribute::ck6));
+	schema.add(new P11AttrBase(P11Attribute::ck4|P11Attribute::ck6));
+	schema.add(new P11AttrValue(P11Attribute::ck1|P11Attribute::ck4|P11Attribute::ck6|P11Attribute::ck7));
 }
 
 // Add attributes
 bool P11DSAPrivateKeyObj::init(OSObject *osobject)
 {
-	// Create parent
-	if (!P11PrivateKeyObj::init(osobject)) return false;
+	if (initialized) return true;
+	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_DSA);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	if (initialized) return true;
-
-	// Create attributes
-	P11Attribute* attrPrime = new P11AttrPrime(osobject,P11Attribute::ck4|P11Attribute::ck6);
-	P11Attribute* attrSubPrime = new P11AttrSubPrime(osobject,P11Attribute::ck4|P11Attribute::ck6);
-	P11Attribute* attrBase = new P11AttrBase(osobject,P11Attribute::ck4|P11Attribute::ck6);
-	P11Attribute* attrValue = new P11AttrValue(osobject,P11Attribute::ck1|P11Attribute::ck4|P11Attribute::ck6|P11Attribute::ck7);
-
 	// Initialize the attributes
-	if
-	(
-		!attrPrime->init() ||
-		!attrSubPrime->init() ||
-		!attrBase->init() ||
-		!attrValue->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrPrime->getType()] = attrPrime;
-	attributes[attrSubPrime->getType()] = attrSubPrime;
-	attributes[attrBase->getType()] = attrBase;
-	attributes[attrValue->getType()] = attrValue;
+	if (!P11PrivateKeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -940,37 +837,33 @@ bool P11DSAPrivateKeyObj::init(OSObject *osobject)
 P11ECPrivateKeyObj::P11ECPrivateKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of an EC private key
+const P11Schema P11ECPrivateKeyObj::classSchema(P11ECPrivateKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11ECPrivateKeyObj::addAttributes(P11Schema& schema)
+{
+	P11PrivateKeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrEcParams(P11Attribute::ck4|P11Attribute::ck6));
+	schema.add(new P11AttrValue(P11Attribute::ck1|P11Attribute::ck4|P11Attribute::ck6|P11Attribute::ck7));
 }
 
 // Add attributes
 bool P11ECPrivateKeyObj::init(OSObject *osobject)
 {
-	// Create parent
-	if (!P11PrivateKeyObj::init(osobject)) return false;
+	if (initialized) return true;
+	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_EC);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	if (initialized) return true;
-
-	// Create attributes
-	P11Attribute* attrEcParams = new P11AttrEcParams(osobject,P11Attribute::ck4|P11Attribute::ck6);
-	P11Attribute* attrValue = new P11AttrValue(osobject,P11Attribute::ck1|P11Attribute::ck4|P11Attribute::ck6|P11Attribute::ck7);
-
 	// Initialize the attributes
-	if
-	(
-		!attrEcParams->init() ||
-		!attrValue->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrEcParams->getType()] = attrEcParams;
-	attributes[attrValue->getType()] = attrValue;
+	if (!P11PrivateKeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -980,40 +873,34 @@ bool P11ECPrivateKeyObj::init(OSObject *osobject)
 P11DHPrivateKeyObj::P11DHPrivateKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of a DH private key
+const P11Schema P11DHPrivateKeyObj::classSchema(P11DHPrivateKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11DHPrivateKeyObj::addAttributes(P11Schema& schema)
+{
+	P11PrivateKeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrPrime(P11Attribute::ck4|P11Attribute::ck6));
+	schema.add(new P11AttrBase(P11Attribute::ck4|P11Attribute::ck6));
+	schema.add(new P11AttrValue(P11Attribute::ck1|P11Attribute::ck4|P11Attribute::ck6|P11Attribute::ck7));
 }
 
 // Add attributes
 bool P11DHPrivateKeyObj::init(OSObject *osobject)
 {
-	// Create parent
-	if (!P11PrivateKeyObj::init(osobject)) return false;
+	if (initialized) return true;
+	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_DH);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	if (initialized) return true;
-
-	// Create attributes
-	P11Attribute* attrPrime = new P11AttrPrime(osobject,P11Attribute::ck4|P11Attribute::ck6);
-	P11Attribute* attrBase = new P11AttrBase(osobject,P11Attribute::ck4|P11Attribute::ck6);
-	P11Attribute* attrValue = new P11AttrValue(osobject,P11Attribute::ck1|P11Attribute::ck4|P11Attribute::ck6|P11Attribute::ck7);
-
 	// Initialize the attributes
-	if
-	(
-		!attrPrime->init() ||
-		!attrBase->init() ||
-		!attrValue->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrPrime->getType()] = attrPrime;
-	attributes[attrBase->getType()] = attrBase;
-	attributes[attrValue->getType()] = attrValue;
+	if (!P11PrivateKeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -1023,40 +910,34 @@ bool P11DHPrivateKeyObj::init(OSObject *osobject)
 P11GOSTPrivateKeyObj::P11GOSTPrivateKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of a GOST private key
+const P11Schema P11GOSTPrivateKeyObj::classSchema(P11GOSTPrivateKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11GOSTPrivateKeyObj::addAttributes(P11Schema& schema)
+{
+	P11PrivateKeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrValue(P11Attribute::ck1|P11Attribute::ck4|P11Attribute::ck6|P11Attribute::ck7));
+	schema.add(new P11AttrGostR3410Params(P11Attribute::ck4|P11Attribute::ck6));
+	schema.add(new P11AttrGostR3411Params(P11Attribute::ck4|P11Attribute::ck6));
 }
 
 // Add attributes
 bool P11GOSTPrivateKeyObj::init(OSObject *osobject)
 {
-	// Create parent
-	if (!P11PrivateKeyObj::init(osobject)) return false;
+	if (initialized) return true;
+	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_GOSTR3410);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	if (initialized) return true;
-
-	// Create attributes
-	P11Attribute* attrValue = new P11AttrValue(osobject,P11Attribute::ck1|P11Attribute::ck4|P11Attribute::ck6|P11Attribute::ck7);
-	P11Attribute* attrGostR3410Params = new P11AttrGostR3410Params(osobject,P11Attribute::ck4|P11Attribute::ck6);
-	P11Attribute* attrGostR3411Params = new P11AttrGostR3411Params(osobject,P11Attribute::ck4|P11Attribute::ck6);
-
 	// Initialize the attributes
-	if
-	(
-		!attrValue->init() ||
-		!attrGostR3410Params->init() ||
-		!attrGostR3411Params->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrValue->getType()] = attrValue;
-	attributes[attrGostR3410Params->getType()] = attrGostR3410Params;
-	attributes[attrGostR3411Params->getType()] = attrGostR3411Params;
+	if (!P11PrivateKeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -1066,6 +947,33 @@ bool P11GOSTPrivateKeyObj::init(OSObject *osobject)
 P11SecretKeyObj::P11SecretKeyObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of a secret key
+const P11Schema P11SecretKeyObj::classSchema(P11SecretKeyObj::addAttributes);
+
+// Add the attributes to the schema
+void P11SecretKeyObj::addAttributes(P11Schema& schema)
+{
+	P11KeyObj::addAttributes(schema);
+
+	schema.add(new P11AttrSensitive());
+	schema.add(new P11AttrEncrypt());
+	schema.add(new P11AttrDecrypt());
+	schema.add(new P11AttrSign());
+	schema.add(new P11AttrVerify());
+	schema.add(new P11AttrWrap());
+	schema.add(new P11AttrUnwrap());
+	schema.add(new P11AttrExtractable());
+	schema.add(new P11AttrAlwaysSensitive());
+	schema.add(new P11AttrNeverExtractable());
+	schema.add(new P11AttrCheckValue());
+	schema.add(new P11AttrWrapWithTrusted());
+	schema.add(new P11AttrTrusted());
+	schema.add(new P11AttrValue(0));
+	// CKA_WRAP_TEMPLATE is not supported
+	// CKA_UNWRAP_TEMPLATE is not supported
 }
 
 // Add attributes
@@ -1074,70 +982,14 @@ bool P11SecretKeyObj::init(OSObject *osobject)
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrClass((unsigned long)CKO_SECRET_KEY);
 	osobject->setAttribute(CKA_CLASS, attrClass);
 	OSAttribute attrKeyType(keytype);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	// Create parent
-	if (!P11KeyObj::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrSensitive = new P11AttrSensitive(osobject);
-	P11Attribute* attrEncrypt = new P11AttrEncrypt(osobject);
-	P11Attribute* attrDecrypt = new P11AttrDecrypt(osobject);
-	P11Attribute* attrSign = new P11AttrSign(osobject);
-	P11Attribute* attrVerify = new P11AttrVerify(osobject);
-	P11Attribute* attrWrap = new P11AttrWrap(osobject);
-	P11Attribute* attrUnwrap = new P11AttrUnwrap(osobject);
-	P11Attribute* attrExtractable = new P11AttrExtractable(osobject);
-	P11Attribute* attrAlwaysSensitive = new P11AttrAlwaysSensitive(osobject);
-	P11Attribute* attrNeverExtractable = new P11AttrNeverExtractable(osobject);
-	P11Attribute* attrCheckValue = new P11AttrCheckValue(osobject);
-	P11Attribute* attrWrapWithTrusted = new P11AttrWrapWithTrusted(osobject);
-	P11Attribute* attrTrusted = new P11AttrTrusted(osobject);
-	P11Attribute* attrValue = new P11AttrValue(osobject,0);
-		// CKA_WRAP_TEMPLATE is not supported
-		// CKA_UNWRAP_TEMPLATE is not supported
-
 	// Initialize the attributes
-	if
-	(
-		!attrSensitive->init() ||
-		!attrEncrypt->init() ||
-		!attrDecrypt->init() ||
-		!attrSign->init() ||
-		!attrVerify->init() ||
-		!attrWrap->init() ||
-		!attrUnwrap->init() ||
-		!attrExtractable->init() ||
-		!attrAlwaysSensitive->init() ||
-		!attrNeverExtractable->init() ||
-		!attrCheckValue->init() ||
-		!attrWrapWithTrusted->init() ||
-		!attrTrusted->init() ||
-		!attrValue->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrSensitive->getType()] = attrSensitive;
-	attributes[attrEncrypt->getType()] = attrEncrypt;
-	attributes[attrDecrypt->getType()] = attrDecrypt;
-	attributes[attrSign->getType()] = attrSign;
-	attributes[attrVerify->getType()] = attrVerify;
-	attributes[attrWrap->getType()] = attrWrap;
-	attributes[attrUnwrap->getType()] = attrUnwrap;
-	attributes[attrExtractable->getType()] = attrExtractable;
-	attributes[attrAlwaysSensitive->getType()] = attrAlwaysSensitive;
-	attributes[attrNeverExtractable->getType()] = attrNeverExtractable;
-	attributes[attrCheckValue->getType()] = attrCheckValue;
-	attributes[attrWrapWithTrusted->getType()] = attrWrapWithTrusted;
-	attributes[attrTrusted->getType()] = attrTrusted;
-	attributes[attrValue->getType()] = attrValue;
+	if (!P11KeyObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -1167,36 +1019,27 @@ P11DomainObj::P11DomainObj()
 	initialized = false;
 }
 
+// Add the attributes to the schema
+void P11DomainObj::addAttributes(P11Schema& schema)
+{
+	P11Object::addAttributes(schema);
+
+	schema.add(new P11AttrKeyType());
+	schema.add(new P11AttrLocal());
+}
+
 // Add attributes
 bool P11DomainObj::init(OSObject *osobject)
 {
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrClass((unsigned long)CKO_DOMAIN_PARAMETERS);
 	osobject->setAttribute(CKA_CLASS, attrClass);
 
-	// Create parent
-	if (!P11Object::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrKeyType = new P11AttrKeyType(osobject);
-	P11Attribute* attrLocal = new P11AttrLocal(osobject);
-
 	// Initialize the attributes
-	if
-	(
-		!attrKeyType->init() ||
-		!attrLocal->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrKeyType->getType()] = attrKeyType;
-	attributes[attrLocal->getType()] = attrLocal;
+	if (!P11Object::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -1206,6 +1049,21 @@ bool P11DomainObj::init(OSObject *osobject)
 P11DSADomainObj::P11DSADomainObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of DSA domain parameters
+const P11Schema P11DSADomainObj::classSchema(P11DSADomainObj::addAttributes);
+
+// Add the attributes to the schema
+void P11DSADomainObj::addAttributes(P11Schema& schema)
+{
+	P11DomainObj::addAttributes(schema);
+
+	schema.add(new P11AttrPrimeBits());
+	schema.add(new P11AttrPrime());
+	schema.add(new P11AttrSubPrime());
+	schema.add(new P11AttrBase());
 }
 
 // Add attributes
@@ -1214,36 +1072,12 @@ bool P11DSADomainObj::init(OSObject *osobject)
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_DSA);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	// Create parent
-	if (!P11DomainObj::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrPrimeBits = new P11AttrPrimeBits(osobject);
-	P11Attribute* attrPrime = new P11AttrPrime(osobject);
-	P11Attribute* attrSubPrime = new P11AttrSubPrime(osobject);
-	P11Attribute* attrBase = new P11AttrBase(osobject);
-
 	// Initialize the attributes
-	if
-	(
-		!attrPrimeBits->init() ||
-		!attrPrime->init() ||
-		!attrSubPrime->init() ||
-		!attrBase->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrPrimeBits->getType()] = attrPrimeBits;
-	attributes[attrPrime->getType()] = attrPrime;
-	attributes[attrSubPrime->getType()] = attrSubPrime;
-	attributes[attrBase->getType()] = attrBase;
+	if (!P11DomainObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -1253,6 +1087,20 @@ bool P11DSADomainObj::init(OSObject *osobject)
 P11DHDomainObj::P11DHDomainObj()
 {
 	initialized = false;
+	schema = &classSchema;
+}
+
+// The attributes of DH domain parameters
+const P11Schema P11DHDomainObj::classSchema(P11DHDomainObj::addAttributes);
+
+// Add the attributes to the schema
+void P11DHDomainObj::addAttributes(P11Schema& schema)
+{
+	P11DomainObj::addAttributes(schema);
+
+	schema.add(new P11AttrPrimeBits());
+	schema.add(new P11AttrPrime());
+	schema.add(new P11AttrBase());
 }
 
 // Add attributes
@@ -1261,33 +1109,12 @@ bool P11DHDomainObj::init(OSObject *osobject)
 	if (initialized) return true;
 	if (osobject == NULL) return false;
 
+	// Set default values for attributes that will be introduced in the parent
 	OSAttribute attrKeyType((unsigned long)CKK_DH);
 	osobject->setAttribute(CKA_KEY_TYPE, attrKeyType);
 
-	// Create parent
-	if (!P11DomainObj::init(osobject)) return false;
-
-	// Create attributes
-	P11Attribute* attrPrimeBits = new P11AttrPrimeBits(osobject);
-	P11Attribute* attrPrime = new P11AttrPrime(osobject);
-	P11Attribute* attrBase = new P11AttrBase(osobject);
-
 	// Initialize the attributes
-	if
-	(
-		!attrPrimeBits->init() ||
-		!attrPrime->init() ||
-		!attrBase->init()
-	)
-	{
-		ERROR_MSG("Could not initialize the attribute");
-		return false;
-	}
-
-	// Add them to the map
-	attributes[attrPrimeBits->getType()] = attrPrimeBits;
-	attributes[attrPrime->getType()] = attrPrime;
-	attributes[attrBase->getType()] = attrBase;
+	if (!P11DomainObj::init(osobject)) return false;
 
 	initialized = true;
 	return true;
@@ -37,7 +37,36 @@
 #include "P11Attributes.h"
 #include "Token.h"
 #include "cryptoki.h"
-#include <map>
+#include <vector>
+
+// The attributes of a class of objects; a schema is built once per class and
+// shared by all of its instances
+class P11Schema
+{
+public:
+	// Constructor; the supplied function adds the attributes to the schema
+	P11Schema(void (*addAttributes)(P11Schema& schema));
+
+	// Destructor
+	virtual ~P11Schema();
+
+	// Add an attribute, the schema takes ownership of it
+	void add(P11Attribute* attribute);
+
+	// Find the attribute of the given type
+	const P11Attribute* find(CK_ATTRIBUTE_TYPE type) const;
+
+	// The attributes in the order in which they were added
+	size_t size() const;
+	const P11Attribute* at(size_t i) const;
+
+private:
+	// The attributes in the order in which they were added
+	std::vector<P11Attribute*> attributes;
+
+	// The same attributes sorted by type
+	std::vector<P11Attribute*> index;
+};
 
 class P11Object
 {
@@ -52,8 +81,11 @@ protected:
 	// The object
 	OSObject* osobject;
 
-	// The attributes
-	std::map<CK_ATTRIBUTE_TYPE, P11Attribute*> attributes;
+	// The attributes of the class
+	const P11Schema* schema;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
 
 public:
 	// Add attributes
@@ -85,6 +117,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11CertificateObj : public P11Object
@@ -96,6 +134,9 @@ protected:
 	// Add attributes
 	virtual bool init(OSObject *osobject);
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
 };
 
 class P11X509CertificateObj : public P11CertificateObj
@@ -109,6 +150,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11KeyObj : public P11Object
@@ -120,6 +167,9 @@ protected:
 	// Add attributes
 	virtual bool init(OSObject *osobject);
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
 };
 
 class P11PublicKeyObj : public P11KeyObj
@@ -131,6 +181,9 @@ protected:
 	// Add attributes
 	virtual bool init(OSObject *osobject);
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
 };
 
 class P11RSAPublicKeyObj : public P11PublicKeyObj
@@ -144,6 +197,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11DSAPublicKeyObj : public P11PublicKeyObj
@@ -157,6 +216,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11ECPublicKeyObj : public P11PublicKeyObj
@@ -170,6 +235,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11DHPublicKeyObj : public P11PublicKeyObj
@@ -183,6 +254,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11GOSTPublicKeyObj : public P11PublicKeyObj
@@ -196,6 +273,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11PrivateKeyObj : public P11KeyObj
@@ -207,6 +290,9 @@ protected:
 	// Add attributes
 	virtual bool init(OSObject *osobject);
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
 };
 
 class P11RSAPrivateKeyObj : public P11PrivateKeyObj
@@ -220,6 +306,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11DSAPrivateKeyObj : public P11PrivateKeyObj
@@ -233,6 +325,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11ECPrivateKeyObj : public P11PrivateKeyObj
@@ -246,6 +344,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11DHPrivateKeyObj : public P11PrivateKeyObj
@@ -259,6 +363,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11GOSTPrivateKeyObj : public P11PrivateKeyObj
@@ -272,6 +382,12 @@ public:
 
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11SecretKeyObj : public P11KeyObj
@@ -289,6 +405,12 @@ public:
 protected:
 	bool initialized;
 	CK_KEY_TYPE keytype;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11DomainObj : public P11Object
@@ -300,6 +422,9 @@ protected:
 	// Add attributes
 	virtual bool init(OSObject *osobject);
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
 };
 
 class P11DSADomainObj : public P11DomainObj
@@ -312,6 +437,12 @@ public:
 	virtual bool init(OSObject *osobject);
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 class P11DHDomainObj : public P11DomainObj
@@ -324,6 +455,12 @@ public:
 	virtual bool init(OSObject *osobject);
 protected:
 	bool initialized;
+
+	// Add the attributes to the schema
+	static void addAttributes(P11Schema& schema);
+
+	// The attributes of the class
+	static const P11Schema classSchema;
 };
 
 #endif // !_SOFTHSM_V2_P11OBJECTS_H
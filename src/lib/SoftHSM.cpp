@@ -37,8 +37,13 @@
 #include "Configuration.h"
 #include "SimpleConfigLoader.h"
 #include "MutexFactory.h"
+#include "WorkerPool.h"
+#include "Statistics.h"
 #include "CryptoFactory.h"
 #include "AsymmetricAlgorithm.h"
+#include "SymmetricAlgorithm.h"
+#include "AESKey.h"
+#include "DESKey.h"
 #include "RNG.h"
 #include "RSAParameters.h"
 #include "RSAPublicKey.h"
@@ -110,7 +115,11 @@ static CK_RV newP11Object(CK_OBJECT_CLASS objClass, CK_KEY_TYPE keyType, std::au
 			    (keyType == CKK_SHA256_HMAC) ||
 			    (keyType == CKK_SHA384_HMAC) ||
 			    (keyType == CKK_SHA512_HMAC) ||
-			    (keyType == CKK_GOST28147))
+			    (keyType == CKK_GOST28147) ||
+			    (keyType == CKK_AES) ||
+			    (keyType == CKK_DES) ||
+			    (keyType == CKK_DES2) ||
+			    (keyType == CKK_DES3))
 			{
 				P11SecretKeyObj* key = new P11SecretKeyObj;
 				p11object.reset(key);
@@ -304,12 +313,16 @@ CK_RV SoftHSM::C_Initialize(CK_VOID_PTR pInitArgs)
 			return CKR_ARGUMENTS_BAD;
 		}
 
-		// Can we spawn our own threads?
-		// if (args->flags & CKF_LIBRARY_CANT_CREATE_OS_THREADS)
-		// {
-		//	DEBUG_MSG("Cannot create threads if CKF_LIBRARY_CANT_CREATE_OS_THREADS is set");
-		//	return CKR_NEED_TO_CREATE_THREADS;
-		// }
+		// Can we spawn our own threads? Threads are only used to speed up
+		// loading, which can be done without them as well
+		if (args->flags & CKF_LIBRARY_CANT_CREATE_OS_THREADS)
+		{
+			WorkerPool::i()->disable();
+		}
+		else
+		{
+			WorkerPool::i()->enable();
+		}
 
 		// Are we not supplied with mutex functions?
 		if
@@ -334,6 +347,7 @@ CK_RV SoftHSM::C_Initialize(CK_VOID_PTR pInitArgs)
 			{
 				// The external application is not using threading
 				MutexFactory::i()->disable();
+				WorkerPool::i()->disable();
 			}
 		}
 		else
@@ -366,6 +380,7 @@ CK_RV SoftHSM::C_Initialize(CK_VOID_PTR pInitArgs)
 	{
 		// No concurrent access by multiple threads
 		MutexFactory::i()->disable();
+		WorkerPool::i()->disable();
 	}
 
 	// (Re)load the configuration
@@ -374,6 +389,24 @@ CK_RV SoftHSM::C_Initialize(CK_VOID_PTR pInitArgs)
 		return CKR_GENERAL_ERROR;
 	}
 
+	// Configure the logging
+	if (!setLogLevel(Configuration::i()->getString("log.level", DEFAULT_LOG_LEVEL)) ||
+	    !setLogFile(Configuration::i()->getString("log.file")))
+	{
+		return CKR_GENERAL_ERROR;
+	}
+
+	WorkerPool::i()->setMaxThreads(Configuration::i()->getInt("objectstore.loadthreads", 4));
+
+	if (Configuration::i()->getBool("statistics.enabled", true))
+	{
+		Statistics::i()->enable();
+	}
+	else
+	{
+		Statistics::i()->disable();
+	}
+
 	sessionObjectStore = new SessionObjectStore();
 
 
@@ -396,6 +429,13 @@ CK_RV SoftHSM::C_Initialize(CK_VOID_PTR pInitArgs)
 	// Load the handle manager
 	handleManager = new HandleManager();
 
+	// Messages are written in the background if we may create threads;
+	// this is only done once nothing can fail any more
+	if (WorkerPool::i()->isEnabled())
+	{
+		startLogThread();
+	}
+
 	// Set the state to initialised
 	isInitialised = true;
 
@@ -424,6 +464,9 @@ CK_RV SoftHSM::C_Finalize(CK_VOID_PTR pReserved)
 
 	// TODO: What should we finalize?
 
+	// Write the messages that are still queued
+	stopLogThread();
+
 	isInitialised = false;
 
 	SoftHSM::reset();
@@ -497,15 +540,15 @@ CK_RV SoftHSM::C_GetMechanismList(CK_SLOT_ID slotID, CK_MECHANISM_TYPE_PTR pMech
 	// A list with the supported mechanisms
 #ifdef WITH_ECC
 #ifdef WITH_GOST
-	CK_ULONG nrSupportedMechanisms = 50;
+	CK_ULONG nrSupportedMechanisms = 55;
 #else
-	CK_ULONG nrSupportedMechanisms = 46;
+	CK_ULONG nrSupportedMechanisms = 51;
 #endif
 #else
 #ifdef WITH_GOST
-	CK_ULONG nrSupportedMechanisms = 47;
+	CK_ULONG nrSupportedMechanisms = 52;
 #else
-	CK_ULONG nrSupportedMechanisms = 43;
+	CK_ULONG nrSupportedMechanisms = 48;
 #endif
 #endif
 	CK_MECHANISM_TYPE supportedMechanisms[] =
@@ -537,11 +580,16 @@ CK_RV SoftHSM::C_GetMechanismList(CK_SLOT_ID slotID, CK_MECHANISM_TYPE_PTR pMech
 		CKM_DES3_KEY_GEN,
 		CKM_DES_ECB,
 		CKM_DES_CBC,
+		CKM_DES_CBC_PAD,
 		CKM_DES3_ECB,
 		CKM_DES3_CBC,
+		CKM_DES3_CBC_PAD,
 		CKM_AES_KEY_GEN,
 		CKM_AES_ECB,
 		CKM_AES_CBC,
+		CKM_AES_CBC_PAD,
+		CKM_AES_CTR,
+		CKM_AES_GCM,
 		CKM_DSA_PARAMETER_GEN,
 		CKM_DSA_KEY_PAIR_GEN,
 		CKM_DSA,
@@ -619,7 +667,7 @@ CK_RV SoftHSM::C_GetMechanismInfo(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_
 		return CKR_SLOT_ID_INVALID;
 	}
 
-	AsymmetricAlgorithm* rsa = CryptoFactory::i()->getAsymmetricAlgorithm("RSA");
+	AsymmetricAlgorithm* rsa = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::RSA);
 	if (rsa != NULL)
 	{
 		rsaMinSize = rsa->getMinKeySize();
@@ -631,7 +679,7 @@ CK_RV SoftHSM::C_GetMechanismInfo(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_
 	}
 	CryptoFactory::i()->recycleAsymmetricAlgorithm(rsa);
 
-	AsymmetricAlgorithm* dsa = CryptoFactory::i()->getAsymmetricAlgorithm("DSA");
+	AsymmetricAlgorithm* dsa = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::DSA);
 	if (dsa != NULL)
 	{
 		dsaMinSize = dsa->getMinKeySize();
@@ -654,7 +702,7 @@ CK_RV SoftHSM::C_GetMechanismInfo(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_
 	}
 	CryptoFactory::i()->recycleAsymmetricAlgorithm(dsa);
 
-	AsymmetricAlgorithm* dh = CryptoFactory::i()->getAsymmetricAlgorithm("DH");
+	AsymmetricAlgorithm* dh = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::DH);
 	if (dh != NULL)
 	{
 		dhMinSize = dh->getMinKeySize();
@@ -667,7 +715,7 @@ CK_RV SoftHSM::C_GetMechanismInfo(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_
 	CryptoFactory::i()->recycleAsymmetricAlgorithm(dh);
 
 #ifdef WITH_ECC
-	AsymmetricAlgorithm* ecdsa = CryptoFactory::i()->getAsymmetricAlgorithm("ECDSA");
+	AsymmetricAlgorithm* ecdsa = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::ECDSA);
 	if (ecdsa != NULL)
 	{
 		ecdsaMinSize = ecdsa->getMinKeySize();
@@ -679,7 +727,7 @@ CK_RV SoftHSM::C_GetMechanismInfo(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_
 	}
 	CryptoFactory::i()->recycleAsymmetricAlgorithm(ecdsa);
 
-	AsymmetricAlgorithm* ecdh = CryptoFactory::i()->getAsymmetricAlgorithm("ECDH");
+	AsymmetricAlgorithm* ecdh = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::ECDH);
 	if (ecdh != NULL)
 	{
 		ecdhMinSize = ecdh->getMinKeySize();
@@ -752,8 +800,10 @@ CK_RV SoftHSM::C_GetMechanismInfo(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_
 			break;
 		case CKM_DES_ECB:
 		case CKM_DES_CBC:
+		case CKM_DES_CBC_PAD:
 		case CKM_DES3_ECB:
 		case CKM_DES3_CBC:
+		case CKM_DES3_CBC_PAD:
 			// Key size is not in use
 			pInfo->ulMinKeySize = 0;
 			pInfo->ulMaxKeySize = 0;
@@ -766,6 +816,9 @@ CK_RV SoftHSM::C_GetMechanismInfo(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_
 			break;
 		case CKM_AES_ECB:
 		case CKM_AES_CBC:
+		case CKM_AES_CBC_PAD:
+		case CKM_AES_CTR:
+		case CKM_AES_GCM:
 			pInfo->ulMinKeySize = 16;
 			pInfo->ulMaxKeySize = 32;
 			pInfo->flags = CKF_ENCRYPT | CKF_DECRYPT;
@@ -1174,6 +1227,9 @@ CK_RV SoftHSM::C_DestroyObject(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObj
 	// Tell the handleManager to forget about the object.
 	handleManager->destroyObject(hObject);
 
+	// Do not keep any keys that were built from the object
+	token->discardCachedKeys(object);
+
 	// Destroy the object
 	if (!object->destroyObject())
 		return CKR_FUNCTION_FAILED;
@@ -1257,15 +1313,32 @@ CK_RV SoftHSM::C_SetAttributeValue(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE
 		return rv;
 	}
 
+	// Any missing default attributes are written back together with the template
+	if (!object->startTransaction())
+		return CKR_GENERAL_ERROR;
+
 	// Wrap a P11Object around the OSObject so we can access the attributes in the
 	// context of the object in which it is defined.
 	std::auto_ptr< P11Object > p11object;
 	rv = newP11Object(object,p11object);
 	if (rv != CKR_OK)
+	{
+		object->abortTransaction();
 		return rv;
+	}
 
 	// Ask the P11Object to save the template with attribute values.
-	return p11object->saveTemplate(token, isPrivate, pTemplate,ulCount,OBJECT_OP_SET);
+	rv = p11object->saveTemplate(token, isPrivate, pTemplate,ulCount,OBJECT_OP_SET);
+	if (rv != CKR_OK)
+	{
+		object->abortTransaction();
+		return rv;
+	}
+
+	if (!object->commitTransaction())
+		return CKR_GENERAL_ERROR;
+
+	return CKR_OK;
 }
 
 // Initialise object search in the specified session using the specified attribute template as search parameters
@@ -1306,9 +1379,15 @@ CK_RV SoftHSM::C_FindObjectsInit(CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pT
 	// Check if we are out of memory
 	if (findOp == NULL_PTR) return CKR_HOST_MEMORY;
 
+	// Use the attribute indices to narrow down the set of objects to match
 	std::set<OSObject*> allObjects;
-	token->getObjects(allObjects);
-	sessionObjectStore->getObjects(slot->getSlotID(),allObjects);
+	if (!token->findObjects(pTemplate,ulCount,allObjects) ||
+	    !sessionObjectStore->findObjects(slot->getSlotID(),pTemplate,ulCount,token,allObjects))
+	{
+		allObjects.clear();
+		token->getObjects(allObjects);
+		sessionObjectStore->getObjects(slot->getSlotID(),allObjects);
+	}
 
 	std::set<CK_OBJECT_HANDLE> handles;
 	std::set<OSObject*>::iterator it;
@@ -1456,8 +1535,254 @@ CK_RV SoftHSM::C_FindObjectsFinal(CK_SESSION_HANDLE hSession)
 	return CKR_OK;
 }
 
-// Initialise encryption using the specified object and mechanism
-CK_RV SoftHSM::C_EncryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
+// Encrypt*/Decrypt*() is for symmetric ciphers too
+static bool isSymMechanism(CK_MECHANISM_PTR pMechanism)
+{
+	if (pMechanism == NULL_PTR) return false;
+
+	switch(pMechanism->mechanism) {
+		case CKM_DES_ECB:
+		case CKM_DES_CBC:
+		case CKM_DES_CBC_PAD:
+		case CKM_DES3_ECB:
+		case CKM_DES3_CBC:
+		case CKM_DES3_CBC_PAD:
+		case CKM_AES_ECB:
+		case CKM_AES_CBC:
+		case CKM_AES_CBC_PAD:
+		case CKM_AES_CTR:
+		case CKM_AES_GCM:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// Get the cipher parameters of a symmetric mechanism and check that they
+// fit the type of the key
+static CK_RV getSymMechanism(CK_MECHANISM_PTR pMechanism, CK_KEY_TYPE keyType, SymAlgo::Type& algo, const char*& mode, bool& padding, ByteString& iv, size_t& counterBits, ByteString& aad, size_t& tagBytes)
+{
+	size_t blockSize = 8;
+	bool keyTypeValid = false;
+	switch(pMechanism->mechanism) {
+		case CKM_DES_ECB:
+		case CKM_DES_CBC:
+		case CKM_DES_CBC_PAD:
+			algo = SymAlgo::DES;
+			keyTypeValid = (keyType == CKK_DES);
+			break;
+		case CKM_DES3_ECB:
+		case CKM_DES3_CBC:
+		case CKM_DES3_CBC_PAD:
+			algo = SymAlgo::DES3;
+			keyTypeValid = (keyType == CKK_DES2 || keyType == CKK_DES3);
+			break;
+		case CKM_AES_ECB:
+		case CKM_AES_CBC:
+		case CKM_AES_CBC_PAD:
+		case CKM_AES_CTR:
+		case CKM_AES_GCM:
+			algo = SymAlgo::AES;
+			blockSize = 16;
+			keyTypeValid = (keyType == CKK_AES);
+			break;
+		default:
+			return CKR_MECHANISM_INVALID;
+	}
+	if (!keyTypeValid) return CKR_KEY_TYPE_INCONSISTENT;
+
+	padding = false;
+	counterBits = 0;
+	aad.wipe();
+	tagBytes = 0;
+
+	switch(pMechanism->mechanism) {
+		case CKM_DES_ECB:
+		case CKM_DES3_ECB:
+		case CKM_AES_ECB:
+			mode = "ecb";
+			iv.wipe();
+			return CKR_OK;
+		case CKM_AES_CTR:
+			if (pMechanism->pParameter == NULL_PTR ||
+			    pMechanism->ulParameterLen != sizeof(CK_AES_CTR_PARAMS))
+			{
+				DEBUG_MSG("pParameter must be of type CK_AES_CTR_PARAMS");
+				return CKR_MECHANISM_PARAM_INVALID;
+			}
+			if (CK_AES_CTR_PARAMS_PTR(pMechanism->pParameter)->ulCounterBits == 0 ||
+			    CK_AES_CTR_PARAMS_PTR(pMechanism->pParameter)->ulCounterBits > 128)
+			{
+				DEBUG_MSG("ulCounterBits must be between 1 and 128");
+				return CKR_MECHANISM_PARAM_INVALID;
+			}
+			mode = "ctr";
+			counterBits = CK_AES_CTR_PARAMS_PTR(pMechanism->pParameter)->ulCounterBits;
+			iv = ByteString(CK_AES_CTR_PARAMS_PTR(pMechanism->pParameter)->cb, 16);
+			return CKR_OK;
+		case CKM_AES_GCM:
+			if (pMechanism->pParameter == NULL_PTR ||
+			    pMechanism->ulParameterLen != sizeof(CK_GCM_PARAMS))
+			{
+				DEBUG_MSG("pParameter must be of type CK_GCM_PARAMS");
+				return CKR_MECHANISM_PARAM_INVALID;
+			}
+			if (CK_GCM_PARAMS_PTR(pMechanism->pParameter)->pIv == NULL_PTR ||
+			    CK_GCM_PARAMS_PTR(pMechanism->pParameter)->ulIvLen == 0)
+			{
+				DEBUG_MSG("An IV is required");
+				return CKR_MECHANISM_PARAM_INVALID;
+			}
+			if (CK_GCM_PARAMS_PTR(pMechanism->pParameter)->pAAD == NULL_PTR &&
+			    CK_GCM_PARAMS_PTR(pMechanism->pParameter)->ulAADLen != 0)
+			{
+				DEBUG_MSG("pAAD must be given if ulAADLen is not 0");
+				return CKR_MECHANISM_PARAM_INVALID;
+			}
+			if (CK_GCM_PARAMS_PTR(pMechanism->pParameter)->ulTagBits < 32 ||
+			    CK_GCM_PARAMS_PTR(pMechanism->pParameter)->ulTagBits > 128 ||
+			    CK_GCM_PARAMS_PTR(pMechanism->pParameter)->ulTagBits % 8 != 0)
+			{
+				DEBUG_MSG("ulTagBits must be a multiple of 8 between 32 and 128");
+				return CKR_MECHANISM_PARAM_INVALID;
+			}
+			mode = "gcm";
+			iv = ByteString(CK_GCM_PARAMS_PTR(pMechanism->pParameter)->pIv,
+					CK_GCM_PARAMS_PTR(pMechanism->pParameter)->ulIvLen);
+			if (CK_GCM_PARAMS_PTR(pMechanism->pParameter)->ulAADLen > 0)
+			{
+				aad = ByteString(CK_GCM_PARAMS_PTR(pMechanism->pParameter)->pAAD,
+						 CK_GCM_PARAMS_PTR(pMechanism->pParameter)->ulAADLen);
+			}
+			tagBytes = CK_GCM_PARAMS_PTR(pMechanism->pParameter)->ulTagBits / 8;
+			return CKR_OK;
+		case CKM_DES_CBC_PAD:
+		case CKM_DES3_CBC_PAD:
+		case CKM_AES_CBC_PAD:
+			padding = true;
+			break;
+		default:
+			break;
+	}
+
+	// The parameter of the CBC mechanisms is the IV
+	if (pMechanism->pParameter == NULL_PTR || pMechanism->ulParameterLen != blockSize)
+	{
+		DEBUG_MSG("pParameter must be an IV of %d bytes", blockSize);
+		return CKR_MECHANISM_PARAM_INVALID;
+	}
+	mode = "cbc";
+	iv = ByteString((unsigned char*)pMechanism->pParameter, pMechanism->ulParameterLen);
+
+	return CKR_OK;
+}
+
+// Create the key object for a symmetric cipher
+static SymmetricKey* newSymKey(CK_KEY_TYPE keyType)
+{
+	switch(keyType) {
+		case CKK_AES:
+			return new AESKey();
+		case CKK_DES:
+			return new DESKey(56);
+		case CKK_DES2:
+			return new DESKey(112);
+		case CKK_DES3:
+			return new DESKey(168);
+		default:
+			return NULL;
+	}
+}
+
+// SymmetricAlgorithm version of C_EncryptInit
+CK_RV SoftHSM::SymEncryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
+{
+	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
+
+	if (pMechanism == NULL_PTR) return CKR_ARGUMENTS_BAD;
+
+	// Get the session
+	Session* session = (Session*)handleManager->getSession(hSession);
+	if (session == NULL) return CKR_SESSION_HANDLE_INVALID;
+
+	// Check if we have another operation
+	if (session->getOpType() != SESSION_OP_NONE) return CKR_OPERATION_ACTIVE;
+
+	// Get the token
+	Token* token = session->getToken();
+	if (token == NULL) return CKR_GENERAL_ERROR;
+
+	// Check the key handle.
+	OSObject *key = (OSObject *)handleManager->getObject(hKey);
+	if (key == NULL_PTR) return CKR_OBJECT_HANDLE_INVALID;
+
+	// Check if key can be used for encryption
+	if (!key->attributeExists(CKA_ENCRYPT) || key->getAttribute(CKA_ENCRYPT)->getBooleanValue() == false)
+		return CKR_KEY_FUNCTION_NOT_PERMITTED;
+
+	// Get the cipher parameters matching the mechanism and the key type
+	if (!key->attributeExists(CKA_KEY_TYPE)) return CKR_KEY_TYPE_INCONSISTENT;
+	CK_KEY_TYPE keyType = key->getAttribute(CKA_KEY_TYPE)->getUnsignedLongValue();
+
+	SymAlgo::Type algo = SymAlgo::Unknown;
+	const char* mode = NULL;
+	bool padding = false;
+	ByteString iv;
+	size_t counterBits = 0;
+	ByteString aad;
+	size_t tagBytes = 0;
+	CK_RV rv = getSymMechanism(pMechanism, keyType, algo, mode, padding, iv, counterBits, aad, tagBytes);
+	if (rv != CKR_OK) return rv;
+
+	SymmetricAlgorithm* cipher = CryptoFactory::i()->getSymmetricAlgorithm(algo);
+	if (cipher == NULL) return CKR_MECHANISM_INVALID;
+
+	SymmetricKey* secretKey = newSymKey(keyType);
+	if (secretKey == NULL)
+	{
+		CryptoFactory::i()->recycleSymmetricAlgorithm(cipher);
+		return CKR_HOST_MEMORY;
+	}
+
+	if (getSymmetricKey(secretKey, token, key) != CKR_OK)
+	{
+		cipher->recycleKey(secretKey);
+		CryptoFactory::i()->recycleSymmetricAlgorithm(cipher);
+		return CKR_GENERAL_ERROR;
+	}
+
+	// AES keys come in several sizes
+	if (keyType == CKK_AES)
+	{
+		size_t bitLen = secretKey->getKeyBits().size() * 8;
+		if (bitLen != 128 && bitLen != 192 && bitLen != 256)
+		{
+			cipher->recycleKey(secretKey);
+			CryptoFactory::i()->recycleSymmetricAlgorithm(cipher);
+			return CKR_KEY_SIZE_RANGE;
+		}
+		secretKey->setBitLen(bitLen);
+	}
+
+	// Initialize encryption
+	if (!cipher->encryptInit(secretKey, mode, iv, padding, counterBits, aad, tagBytes))
+	{
+		cipher->recycleKey(secretKey);
+		CryptoFactory::i()->recycleSymmetricAlgorithm(cipher);
+		return CKR_MECHANISM_INVALID;
+	}
+
+	session->setOpType(SESSION_OP_ENCRYPT);
+	session->setSymmetricCryptoOp(cipher);
+	session->setAllowMultiPartOp(true);
+	session->setAllowSinglePartOp(true);
+	session->setSymmetricKey(secretKey);
+
+	return CKR_OK;
+}
+
+// AsymmetricAlgorithm version of C_EncryptInit
+CK_RV SoftHSM::AsymEncryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
 {
 	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
 
@@ -1521,23 +1846,33 @@ CK_RV SoftHSM::C_EncryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMecha
 
 	AsymmetricAlgorithm* asymCrypto = NULL;
 	PublicKey* publicKey = NULL;
+
+	// Keys that were built from the current version of the object are
+	// taken from the key cache of the token
+	unsigned long keyGeneration = key->getGeneration();
+	const char* keyAlgorithm = NULL;
 	if (isRSA)
 	{
-		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm("rsa");
+		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::RSA);
 		if (asymCrypto == NULL) return CKR_MECHANISM_INVALID;
+		keyAlgorithm = "rsa";
 
-		publicKey = asymCrypto->newPublicKey();
+		publicKey = token->getCachedPublicKey(key, keyGeneration, keyAlgorithm);
 		if (publicKey == NULL)
 		{
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_HOST_MEMORY;
-		}
+			publicKey = asymCrypto->newPublicKey();
+			if (publicKey == NULL)
+			{
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_HOST_MEMORY;
+			}
 
-		if (getRSAPublicKey((RSAPublicKey*)publicKey, token, key) != CKR_OK)
-		{
-			asymCrypto->recyclePublicKey(publicKey);
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_GENERAL_ERROR;
+			if (getRSAPublicKey((RSAPublicKey*)publicKey, token, key) != CKR_OK)
+			{
+				asymCrypto->recyclePublicKey(publicKey);
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_GENERAL_ERROR;
+			}
 		}
 	}
 	else
@@ -1551,26 +1886,77 @@ CK_RV SoftHSM::C_EncryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMecha
 	session->setAllowMultiPartOp(false);
 	session->setAllowSinglePartOp(true);
 	session->setPublicKey(publicKey);
+	session->setKeyOrigin(key, keyGeneration, keyAlgorithm);
 
 	return CKR_OK;
 }
 
-// Perform a single operation encryption operation in the specified session
-CK_RV SoftHSM::C_Encrypt(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen)
+// Initialise encryption using the specified object and mechanism
+CK_RV SoftHSM::C_EncryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
 {
-	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
+	if (isSymMechanism(pMechanism))
+		return SymEncryptInit(hSession, pMechanism, hKey);
+	else
+		return AsymEncryptInit(hSession, pMechanism, hKey);
+}
 
-	if (pData == NULL_PTR) return CKR_ARGUMENTS_BAD;
-	if (pulEncryptedDataLen == NULL_PTR) return CKR_ARGUMENTS_BAD;
+// SymmetricAlgorithm version of C_Encrypt
+static CK_RV SymEncrypt(Session* session, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen)
+{
+	SymmetricAlgorithm* cipher = session->getSymmetricCryptoOp();
+	if (cipher == NULL || !session->getAllowSinglePartOp())
+	{
+		session->resetOp();
+		return CKR_OPERATION_NOT_INITIALIZED;
+	}
 
-	// Get the session
-	Session* session = (Session*)handleManager->getSession(hSession);
-	if (session == NULL) return CKR_SESSION_HANDLE_INVALID;
+	// Size of the encrypted data; without padding the block modes only
+	// take whole blocks
+	size_t outputSize = 0;
+	if (!cipher->getOutputSize(ulDataLen, outputSize))
+	{
+		session->resetOp();
+		return CKR_DATA_LEN_RANGE;
+	}
+	CK_ULONG size = outputSize;
 
-	// Check if we are doing the correct operation
-	if (session->getOpType() != SESSION_OP_ENCRYPT)
-		return CKR_OPERATION_NOT_INITIALIZED;
+	if (pEncryptedData == NULL_PTR)
+	{
+		*pulEncryptedDataLen = size;
+		return CKR_OK;
+	}
+
+	// Check buffer size
+	if (*pulEncryptedDataLen < size)
+	{
+		*pulEncryptedDataLen = size;
+		return CKR_BUFFER_TOO_SMALL;
+	}
+
+	// Encrypt the data
+	size_t encryptedLen = size;
+	if (!cipher->encryptUpdate(pData, ulDataLen, pEncryptedData, encryptedLen))
+	{
+		session->resetOp();
+		return CKR_GENERAL_ERROR;
+	}
+
+	// Get the last part
+	size_t finalLen = size - encryptedLen;
+	if (!cipher->encryptFinal(pEncryptedData + encryptedLen, finalLen))
+	{
+		session->resetOp();
+		return CKR_GENERAL_ERROR;
+	}
+	*pulEncryptedDataLen = encryptedLen + finalLen;
 
+	session->resetOp();
+	return CKR_OK;
+}
+
+// AsymmetricAlgorithm version of C_Encrypt
+static CK_RV AsymEncrypt(Session* session, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen)
+{
 	AsymmetricAlgorithm* asymCrypto = session->getAsymmetricCryptoOp();
 	const char *mechanism = session->getMechanism();
 	PublicKey* publicKey = session->getPublicKey();
@@ -1629,16 +2015,132 @@ CK_RV SoftHSM::C_Encrypt(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG
 	return CKR_OK;
 }
 
+// Perform a single operation encryption operation in the specified session
+CK_RV SoftHSM::C_Encrypt(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen)
+{
+	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
+
+	if (pData == NULL_PTR) return CKR_ARGUMENTS_BAD;
+	if (pulEncryptedDataLen == NULL_PTR) return CKR_ARGUMENTS_BAD;
+
+	// Get the session
+	Session* session = (Session*)handleManager->getSession(hSession);
+	if (session == NULL) return CKR_SESSION_HANDLE_INVALID;
+
+	// Check if we are doing the correct operation
+	if (session->getOpType() != SESSION_OP_ENCRYPT)
+		return CKR_OPERATION_NOT_INITIALIZED;
+
+	if (session->getSymmetricCryptoOp() != NULL)
+		return SymEncrypt(session, pData, ulDataLen,
+				  pEncryptedData, pulEncryptedDataLen);
+	else
+		return AsymEncrypt(session, pData, ulDataLen,
+				   pEncryptedData, pulEncryptedDataLen);
+}
+
+// SymmetricAlgorithm version of C_EncryptUpdate
+static CK_RV SymEncryptUpdate(Session* session, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen)
+{
+	SymmetricAlgorithm* cipher = session->getSymmetricCryptoOp();
+	if (cipher == NULL || !session->getAllowMultiPartOp())
+	{
+		session->resetOp();
+		return CKR_OPERATION_NOT_INITIALIZED;
+	}
+
+	// Size of the encrypted data; the block modes return whole blocks only,
+	// and no more than the data rounded up to a whole number of blocks
+	CK_ULONG size = cipher->getMaxUpdateSize(ulDataLen);
+
+	if (pEncryptedData == NULL_PTR)
+	{
+		*pulEncryptedDataLen = size;
+		return CKR_OK;
+	}
+
+	// Check buffer size
+	if (*pulEncryptedDataLen < size)
+	{
+		*pulEncryptedDataLen = size;
+		return CKR_BUFFER_TOO_SMALL;
+	}
+
+	// Encrypt the data
+	size_t encryptedLen = *pulEncryptedDataLen;
+	if (!cipher->encryptUpdate(pData, ulDataLen, pEncryptedData, encryptedLen))
+	{
+		session->resetOp();
+		return CKR_GENERAL_ERROR;
+	}
+	*pulEncryptedDataLen = encryptedLen;
+
+	session->setAllowSinglePartOp(false);
+	return CKR_OK;
+}
+
 // Feed data to the running encryption operation in a session
 CK_RV SoftHSM::C_EncryptUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen)
 {
 	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
 
+	if (pData == NULL_PTR) return CKR_ARGUMENTS_BAD;
+	if (pulEncryptedDataLen == NULL_PTR) return CKR_ARGUMENTS_BAD;
+
 	// Get the session
 	Session* session = (Session*)handleManager->getSession(hSession);
 	if (session == NULL) return CKR_SESSION_HANDLE_INVALID;
 
-	return CKR_FUNCTION_NOT_SUPPORTED;
+	// Check if we are doing the correct operation
+	if (session->getOpType() != SESSION_OP_ENCRYPT)
+		return CKR_OPERATION_NOT_INITIALIZED;
+
+	// Asymmetric encryption is single-part only
+	if (session->getSymmetricCryptoOp() == NULL)
+		return CKR_FUNCTION_NOT_SUPPORTED;
+
+	return SymEncryptUpdate(session, pData, ulDataLen, pEncryptedData, pulEncryptedDataLen);
+}
+
+// SymmetricAlgorithm version of C_EncryptFinal
+static CK_RV SymEncryptFinal(Session* session, CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen)
+{
+	SymmetricAlgorithm* cipher = session->getSymmetricCryptoOp();
+	if (cipher == NULL || !session->getAllowMultiPartOp())
+	{
+		session->resetOp();
+		return CKR_OPERATION_NOT_INITIALIZED;
+	}
+
+	// Size of the last part
+	CK_ULONG size = cipher->getMaxFinalSize();
+
+	if (pEncryptedData == NULL_PTR)
+	{
+		*pulEncryptedDataLen = size;
+		return CKR_OK;
+	}
+
+	// Check buffer size
+	if (*pulEncryptedDataLen < size)
+	{
+		*pulEncryptedDataLen = size;
+		return CKR_BUFFER_TOO_SMALL;
+	}
+
+	// Get the last part; without padding the block modes fail if the data
+	// did not consist of whole blocks
+	size_t encryptedLen = *pulEncryptedDataLen;
+	if (!cipher->encryptFinal(pEncryptedData, encryptedLen))
+	{
+		CK_RV rv = (cipher->isBlockMode() && !cipher->getPaddingMode()) ? CKR_DATA_LEN_RANGE : CKR_GENERAL_ERROR;
+		session->resetOp();
+		return rv;
+	}
+	*pulEncryptedDataLen = encryptedLen;
+
+	session->resetOp();
+	return CKR_OK;
 }
 
 // Finalise the encryption operation
@@ -1646,6 +2148,8 @@ CK_RV SoftHSM::C_EncryptFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncrypted
 {
 	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
 
+	if (pulEncryptedDataLen == NULL_PTR) return CKR_ARGUMENTS_BAD;
+
 	// Get the session
 	Session* session = (Session*)handleManager->getSession(hSession);
 	if (session == NULL) return CKR_SESSION_HANDLE_INVALID;
@@ -1653,12 +2157,105 @@ CK_RV SoftHSM::C_EncryptFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncrypted
 	// Check if we are doing the correct operation
 	if (session->getOpType() != SESSION_OP_ENCRYPT) return CKR_OPERATION_NOT_INITIALIZED;
 
-	session->resetOp();
-	return CKR_FUNCTION_NOT_SUPPORTED;
+	// Asymmetric encryption is single-part only
+	if (session->getSymmetricCryptoOp() == NULL)
+	{
+		session->resetOp();
+		return CKR_FUNCTION_NOT_SUPPORTED;
+	}
+
+	return SymEncryptFinal(session, pEncryptedData, pulEncryptedDataLen);
 }
 
-// Initialise decryption using the specified object
-CK_RV SoftHSM::C_DecryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
+// SymmetricAlgorithm version of C_DecryptInit
+CK_RV SoftHSM::SymDecryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
+{
+	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
+
+	if (pMechanism == NULL_PTR) return CKR_ARGUMENTS_BAD;
+
+	// Get the session
+	Session* session = (Session*)handleManager->getSession(hSession);
+	if (session == NULL) return CKR_SESSION_HANDLE_INVALID;
+
+	// Check if we have another operation
+	if (session->getOpType() != SESSION_OP_NONE) return CKR_OPERATION_ACTIVE;
+
+	// Get the token
+	Token* token = session->getToken();
+	if (token == NULL) return CKR_GENERAL_ERROR;
+
+	// Check the key handle.
+	OSObject *key = (OSObject *)handleManager->getObject(hKey);
+	if (key == NULL_PTR) return CKR_OBJECT_HANDLE_INVALID;
+
+	// Check if key can be used for decryption
+	if (!key->attributeExists(CKA_DECRYPT) || key->getAttribute(CKA_DECRYPT)->getBooleanValue() == false)
+		return CKR_KEY_FUNCTION_NOT_PERMITTED;
+
+	// Get the cipher parameters matching the mechanism and the key type
+	if (!key->attributeExists(CKA_KEY_TYPE)) return CKR_KEY_TYPE_INCONSISTENT;
+	CK_KEY_TYPE keyType = key->getAttribute(CKA_KEY_TYPE)->getUnsignedLongValue();
+
+	SymAlgo::Type algo = SymAlgo::Unknown;
+	const char* mode = NULL;
+	bool padding = false;
+	ByteString iv;
+	size_t counterBits = 0;
+	ByteString aad;
+	size_t tagBytes = 0;
+	CK_RV rv = getSymMechanism(pMechanism, keyType, algo, mode, padding, iv, counterBits, aad, tagBytes);
+	if (rv != CKR_OK) return rv;
+
+	SymmetricAlgorithm* cipher = CryptoFactory::i()->getSymmetricAlgorithm(algo);
+	if (cipher == NULL) return CKR_MECHANISM_INVALID;
+
+	SymmetricKey* secretKey = newSymKey(keyType);
+	if (secretKey == NULL)
+	{
+		CryptoFactory::i()->recycleSymmetricAlgorithm(cipher);
+		return CKR_HOST_MEMORY;
+	}
+
+	if (getSymmetricKey(secretKey, token, key) != CKR_OK)
+	{
+		cipher->recycleKey(secretKey);
+		CryptoFactory::i()->recycleSymmetricAlgorithm(cipher);
+		return CKR_GENERAL_ERROR;
+	}
+
+	// AES keys come in several sizes
+	if (keyType == CKK_AES)
+	{
+		size_t bitLen = secretKey->getKeyBits().size() * 8;
+		if (bitLen != 128 && bitLen != 192 && bitLen != 256)
+		{
+			cipher->recycleKey(secretKey);
+			CryptoFactory::i()->recycleSymmetricAlgorithm(cipher);
+			return CKR_KEY_SIZE_RANGE;
+		}
+		secretKey->setBitLen(bitLen);
+	}
+
+	// Initialize decryption
+	if (!cipher->decryptInit(secretKey, mode, iv, padding, counterBits, aad, tagBytes))
+	{
+		cipher->recycleKey(secretKey);
+		CryptoFactory::i()->recycleSymmetricAlgorithm(cipher);
+		return CKR_MECHANISM_INVALID;
+	}
+
+	session->setOpType(SESSION_OP_DECRYPT);
+	session->setSymmetricCryptoOp(cipher);
+	session->setAllowMultiPartOp(true);
+	session->setAllowSinglePartOp(true);
+	session->setSymmetricKey(secretKey);
+
+	return CKR_OK;
+}
+
+// AsymmetricAlgorithm version of C_DecryptInit
+CK_RV SoftHSM::AsymDecryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
 {
 	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
 
@@ -1722,56 +2319,117 @@ CK_RV SoftHSM::C_DecryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMecha
 
 	AsymmetricAlgorithm* asymCrypto = NULL;
 	PrivateKey* privateKey = NULL;
+
+	// Keys that were built from the current version of the object are
+	// taken from the key cache of the token
+	unsigned long keyGeneration = key->getGeneration();
+	const char* keyAlgorithm = NULL;
 	if (isRSA)
 	{
-		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm("rsa");
+		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::RSA);
 		if (asymCrypto == NULL) return CKR_MECHANISM_INVALID;
+		keyAlgorithm = "rsa";
 
-		privateKey = asymCrypto->newPrivateKey();
+		privateKey = token->getCachedPrivateKey(key, keyGeneration, keyAlgorithm);
 		if (privateKey == NULL)
 		{
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_HOST_MEMORY;
-		}
+			privateKey = asymCrypto->newPrivateKey();
+			if (privateKey == NULL)
+			{
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_HOST_MEMORY;
+			}
 
-		if (getRSAPrivateKey((RSAPrivateKey*)privateKey, token, key) != CKR_OK)
-		{
-			asymCrypto->recyclePrivateKey(privateKey);
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_GENERAL_ERROR;
+			if (getRSAPrivateKey((RSAPrivateKey*)privateKey, token, key) != CKR_OK)
+			{
+				asymCrypto->recyclePrivateKey(privateKey);
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_GENERAL_ERROR;
+			}
 		}
 	}
-	else
+	else
+	{
+		return CKR_MECHANISM_INVALID;
+        }
+
+	session->setOpType(SESSION_OP_DECRYPT);
+	session->setAsymmetricCryptoOp(asymCrypto);
+	session->setMechanism(mechanism);
+	session->setAllowMultiPartOp(false);
+	session->setAllowSinglePartOp(true);
+	session->setPrivateKey(privateKey);
+	session->setKeyOrigin(key, keyGeneration, keyAlgorithm);
+
+	return CKR_OK;
+}
+
+// Initialise decryption using the specified object and mechanism
+CK_RV SoftHSM::C_DecryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
+{
+	if (isSymMechanism(pMechanism))
+		return SymDecryptInit(hSession, pMechanism, hKey);
+	else
+		return AsymDecryptInit(hSession, pMechanism, hKey);
+}
+
+// SymmetricAlgorithm version of C_Decrypt
+static CK_RV SymDecrypt(Session* session, CK_BYTE_PTR pEncryptedData, CK_ULONG ulEncryptedDataLen, CK_BYTE_PTR pData, CK_ULONG_PTR pulDataLen)
+{
+	SymmetricAlgorithm* cipher = session->getSymmetricCryptoOp();
+	if (cipher == NULL || !session->getAllowSinglePartOp())
+	{
+		session->resetOp();
+		return CKR_OPERATION_NOT_INITIALIZED;
+	}
+
+	// Size of the data; the block modes only take whole blocks, and the
+	// padding is only removed afterwards
+	size_t outputSize = 0;
+	if (!cipher->getOutputSize(ulEncryptedDataLen, outputSize))
+	{
+		session->resetOp();
+		return CKR_ENCRYPTED_DATA_LEN_RANGE;
+	}
+	CK_ULONG size = outputSize;
+
+	if (pData == NULL_PTR)
+	{
+		*pulDataLen = size;
+		return CKR_OK;
+	}
+
+	// Check buffer size
+	if (*pulDataLen < size)
+	{
+		*pulDataLen = size;
+		return CKR_BUFFER_TOO_SMALL;
+	}
+
+	// Decrypt the data
+	size_t dataLen = size;
+	if (!cipher->decryptUpdate(pEncryptedData, ulEncryptedDataLen, pData, dataLen))
 	{
-		return CKR_MECHANISM_INVALID;
-        }
+		session->resetOp();
+		return CKR_GENERAL_ERROR;
+	}
 
-	session->setOpType(SESSION_OP_DECRYPT);
-	session->setAsymmetricCryptoOp(asymCrypto);
-	session->setMechanism(mechanism);
-	session->setAllowMultiPartOp(false);
-	session->setAllowSinglePartOp(true);
-	session->setPrivateKey(privateKey);
+	// Get the last part; this removes the padding or checks the GCM tag
+	size_t finalLen = size - dataLen;
+	if (!cipher->decryptFinal(pData + dataLen, finalLen))
+	{
+		session->resetOp();
+		return CKR_ENCRYPTED_DATA_INVALID;
+	}
+	*pulDataLen = dataLen + finalLen;
 
+	session->resetOp();
 	return CKR_OK;
 }
 
-// Perform a single operation decryption in the given session
-CK_RV SoftHSM::C_Decrypt(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData, CK_ULONG ulEncryptedDataLen, CK_BYTE_PTR pData, CK_ULONG_PTR pulDataLen)
+// AsymmetricAlgorithm version of C_Decrypt
+static CK_RV AsymDecrypt(Session* session, CK_BYTE_PTR pEncryptedData, CK_ULONG ulEncryptedDataLen, CK_BYTE_PTR pData, CK_ULONG_PTR pulDataLen)
 {
-	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
-
-	if (pEncryptedData == NULL_PTR) return CKR_ARGUMENTS_BAD;
-	if (pulDataLen == NULL_PTR) return CKR_ARGUMENTS_BAD;
-
-	// Get the session
-	Session* session = (Session*)handleManager->getSession(hSession);
-	if (session == NULL) return CKR_SESSION_HANDLE_INVALID;
-
-	// Check if we are doing the correct operation
-	if (session->getOpType() != SESSION_OP_DECRYPT)
-		return CKR_OPERATION_NOT_INITIALIZED;
-
 	AsymmetricAlgorithm* asymCrypto = session->getAsymmetricCryptoOp();
 	const char *mechanism = session->getMechanism();
 	PrivateKey* privateKey = session->getPrivateKey();
@@ -1822,16 +2480,133 @@ CK_RV SoftHSM::C_Decrypt(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData,
 
 }
 
+// Perform a single operation decryption in the given session
+CK_RV SoftHSM::C_Decrypt(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData, CK_ULONG ulEncryptedDataLen, CK_BYTE_PTR pData, CK_ULONG_PTR pulDataLen)
+{
+	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
+
+	if (pEncryptedData == NULL_PTR) return CKR_ARGUMENTS_BAD;
+	if (pulDataLen == NULL_PTR) return CKR_ARGUMENTS_BAD;
+
+	// Get the session
+	Session* session = (Session*)handleManager->getSession(hSession);
+	if (session == NULL) return CKR_SESSION_HANDLE_INVALID;
+
+	// Check if we are doing the correct operation
+	if (session->getOpType() != SESSION_OP_DECRYPT)
+		return CKR_OPERATION_NOT_INITIALIZED;
+
+	if (session->getSymmetricCryptoOp() != NULL)
+		return SymDecrypt(session, pEncryptedData, ulEncryptedDataLen,
+				  pData, pulDataLen);
+	else
+		return AsymDecrypt(session, pEncryptedData, ulEncryptedDataLen,
+				   pData, pulDataLen);
+}
+
+// SymmetricAlgorithm version of C_DecryptUpdate
+static CK_RV SymDecryptUpdate(Session* session, CK_BYTE_PTR pEncryptedData, CK_ULONG ulEncryptedDataLen, CK_BYTE_PTR pData, CK_ULONG_PTR pDataLen)
+{
+	SymmetricAlgorithm* cipher = session->getSymmetricCryptoOp();
+	if (cipher == NULL || !session->getAllowMultiPartOp())
+	{
+		session->resetOp();
+		return CKR_OPERATION_NOT_INITIALIZED;
+	}
+
+	// Size of the data; the block modes return whole blocks only, and no
+	// more than the encrypted data rounded up to a whole number of blocks.
+	// In GCM mode nothing is returned until the tag has been checked
+	CK_ULONG size = cipher->getMaxUpdateSize(ulEncryptedDataLen);
+
+	if (pData == NULL_PTR)
+	{
+		*pDataLen = size;
+		return CKR_OK;
+	}
+
+	// Check buffer size
+	if (*pDataLen < size)
+	{
+		*pDataLen = size;
+		return CKR_BUFFER_TOO_SMALL;
+	}
+
+	// Decrypt the data
+	size_t dataLen = *pDataLen;
+	if (!cipher->decryptUpdate(pEncryptedData, ulEncryptedDataLen, pData, dataLen))
+	{
+		session->resetOp();
+		return CKR_GENERAL_ERROR;
+	}
+	*pDataLen = dataLen;
+
+	session->setAllowSinglePartOp(false);
+	return CKR_OK;
+}
+
 // Feed data to the running decryption operation in a session
 CK_RV SoftHSM::C_DecryptUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData, CK_ULONG ulEncryptedDataLen, CK_BYTE_PTR pData, CK_ULONG_PTR pDataLen)
 {
 	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
 
+	if (pEncryptedData == NULL_PTR) return CKR_ARGUMENTS_BAD;
+	if (pDataLen == NULL_PTR) return CKR_ARGUMENTS_BAD;
+
 	// Get the session
 	Session* session = (Session*)handleManager->getSession(hSession);
 	if (session == NULL) return CKR_SESSION_HANDLE_INVALID;
 
-	return CKR_FUNCTION_NOT_SUPPORTED;
+	// Check if we are doing the correct operation
+	if (session->getOpType() != SESSION_OP_DECRYPT)
+		return CKR_OPERATION_NOT_INITIALIZED;
+
+	// Asymmetric decryption is single-part only
+	if (session->getSymmetricCryptoOp() == NULL)
+		return CKR_FUNCTION_NOT_SUPPORTED;
+
+	return SymDecryptUpdate(session, pEncryptedData, ulEncryptedDataLen, pData, pDataLen);
+}
+
+// SymmetricAlgorithm version of C_DecryptFinal
+static CK_RV SymDecryptFinal(Session* session, CK_BYTE_PTR pData, CK_ULONG_PTR pDataLen)
+{
+	SymmetricAlgorithm* cipher = session->getSymmetricCryptoOp();
+	if (cipher == NULL || !session->getAllowMultiPartOp())
+	{
+		session->resetOp();
+		return CKR_OPERATION_NOT_INITIALIZED;
+	}
+
+	// Size of the last part
+	CK_ULONG size = cipher->getMaxFinalSize();
+
+	if (pData == NULL_PTR)
+	{
+		*pDataLen = size;
+		return CKR_OK;
+	}
+
+	// Check buffer size
+	if (*pDataLen < size)
+	{
+		*pDataLen = size;
+		return CKR_BUFFER_TOO_SMALL;
+	}
+
+	// Get the last part; this fails if the encrypted data did not consist
+	// of whole blocks, or if the padding or the GCM tag is wrong
+	size_t dataLen = *pDataLen;
+	if (!cipher->decryptFinal(pData, dataLen))
+	{
+		CK_RV rv = (cipher->isBlockMode() && !cipher->getPaddingMode()) ? CKR_ENCRYPTED_DATA_LEN_RANGE : CKR_ENCRYPTED_DATA_INVALID;
+		session->resetOp();
+		return rv;
+	}
+	*pDataLen = dataLen;
+
+	session->resetOp();
+	return CKR_OK;
 }
 
 // Finalise the decryption operation
@@ -1839,6 +2614,8 @@ CK_RV SoftHSM::C_DecryptFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_
 {
 	if (!isInitialised) return CKR_CRYPTOKI_NOT_INITIALIZED;
 
+	if (pDataLen == NULL_PTR) return CKR_ARGUMENTS_BAD;
+
 	// Get the session
 	Session* session = (Session*)handleManager->getSession(hSession);
 	if (session == NULL) return CKR_SESSION_HANDLE_INVALID;
@@ -1846,8 +2623,14 @@ CK_RV SoftHSM::C_DecryptFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_
 	// Check if we are doing the correct operation
 	if (session->getOpType() != SESSION_OP_DECRYPT) return CKR_OPERATION_NOT_INITIALIZED;
 
-	session->resetOp();
-	return CKR_FUNCTION_NOT_SUPPORTED;
+	// Asymmetric decryption is single-part only
+	if (session->getSymmetricCryptoOp() == NULL)
+	{
+		session->resetOp();
+		return CKR_FUNCTION_NOT_SUPPORTED;
+	}
+
+	return SymDecryptFinal(session, pData, pDataLen);
 }
 
 // Initialise digesting using the specified mechanism in the specified session
@@ -1868,26 +2651,26 @@ CK_RV SoftHSM::C_DigestInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechan
 	HashAlgorithm* hash = NULL;
 	switch(pMechanism->mechanism) {
 		case CKM_MD5:
-			hash = CryptoFactory::i()->getHashAlgorithm("md5");
+			hash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::MD5);
 			break;
 		case CKM_SHA_1:
-			hash = CryptoFactory::i()->getHashAlgorithm("sha1");
+			hash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA1);
 			break;
 		case CKM_SHA224:
-			hash = CryptoFactory::i()->getHashAlgorithm("sha224");
+			hash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA224);
 			break;
 		case CKM_SHA256:
-			hash = CryptoFactory::i()->getHashAlgorithm("sha256");
+			hash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA256);
 			break;
 		case CKM_SHA384:
-			hash = CryptoFactory::i()->getHashAlgorithm("sha384");
+			hash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA384);
 			break;
 		case CKM_SHA512:
-			hash = CryptoFactory::i()->getHashAlgorithm("sha512");
+			hash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA512);
 			break;
 #ifdef WITH_GOST
 		case CKM_GOSTR3411:
-			hash = CryptoFactory::i()->getHashAlgorithm("gost");
+			hash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::GOST);
 			break;
 #endif
 		default:
@@ -1938,32 +2721,28 @@ CK_RV SoftHSM::C_Digest(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG
 		return CKR_BUFFER_TOO_SMALL;
 	}
 
-	// Get the data
-	ByteString data(pData, ulDataLen);
-
 	// Digest the data
-	if (session->getDigestOp()->hashUpdate(data) == false)
+	if (session->getDigestOp()->hashUpdate(pData, ulDataLen) == false)
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
 
 	// Get the digest
-	ByteString digest;
-	if (session->getDigestOp()->hashFinal(digest) == false)
+	size_t digestLen = *pulDigestLen;
+	if (session->getDigestOp()->hashFinal(pDigest, digestLen) == false)
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
 
 	// Check size
-	if (digest.size() != size)
+	if (digestLen != size)
 	{
 		ERROR_MSG("The size of the digest differ from the size of the mechanism");
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
-	memcpy(pDigest, digest.byte_str(), size);
 	*pulDigestLen = size;
 
 	session->resetOp();
@@ -1985,11 +2764,8 @@ CK_RV SoftHSM::C_DigestUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_
 	// Check if we are doing the correct operation
 	if (session->getOpType() != SESSION_OP_DIGEST) return CKR_OPERATION_NOT_INITIALIZED;
 
-	// Get the data
-	ByteString data(pPart, ulPartLen);
-
 	// Digest the data
-	if (session->getDigestOp()->hashUpdate(data) == false)
+	if (session->getDigestOp()->hashUpdate(pPart, ulPartLen) == false)
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
@@ -2040,21 +2816,20 @@ CK_RV SoftHSM::C_DigestFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDigest, CK
 	}
 
 	// Get the digest
-	ByteString digest;
-	if (session->getDigestOp()->hashFinal(digest) == false)
+	size_t digestLen = *pulDigestLen;
+	if (session->getDigestOp()->hashFinal(pDigest, digestLen) == false)
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
 
 	// Check size
-	if (digest.size() != size)
+	if (digestLen != size)
 	{
 		ERROR_MSG("The size of the digest differ from the size of the mechanism");
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
-	memcpy(pDigest, digest.byte_str(), size);
 	*pulDigestLen = size;
 
 	session->resetOp();
@@ -2113,26 +2888,26 @@ CK_RV SoftHSM::MacSignInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechani
 	MacAlgorithm* mac = NULL;
 	switch(pMechanism->mechanism) {
 		case CKM_MD5_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-md5");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_MD5);
 			break;
 		case CKM_SHA_1_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-sha1");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_SHA1);
 			break;
 		case CKM_SHA224_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-sha224");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_SHA224);
 			break;
 		case CKM_SHA256_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-sha256");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_SHA256);
 			break;
 		case CKM_SHA384_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-sha384");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_SHA384);
 			break;
 		case CKM_SHA512_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-sha512");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_SHA512);
 			break;
 #ifdef WITH_GOST
 		case CKM_GOSTR3411_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-gost");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_GOST);
 			break;
 #endif
 		default:
@@ -2293,83 +3068,108 @@ CK_RV SoftHSM::AsymSignInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechan
 
 	AsymmetricAlgorithm* asymCrypto = NULL;
 	PrivateKey* privateKey = NULL;
+
+	// Keys that were built from the current version of the object are
+	// taken from the key cache of the token
+	unsigned long keyGeneration = key->getGeneration();
+	const char* keyAlgorithm = NULL;
 	if (isRSA)
 	{
-		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm("rsa");
+		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::RSA);
 		if (asymCrypto == NULL) return CKR_MECHANISM_INVALID;
+		keyAlgorithm = "rsa";
 
-		privateKey = asymCrypto->newPrivateKey();
+		privateKey = token->getCachedPrivateKey(key, keyGeneration, keyAlgorithm);
 		if (privateKey == NULL)
 		{
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_HOST_MEMORY;
-		}
+			privateKey = asymCrypto->newPrivateKey();
+			if (privateKey == NULL)
+			{
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_HOST_MEMORY;
+			}
 
-		if (getRSAPrivateKey((RSAPrivateKey*)privateKey, token, key) != CKR_OK)
-		{
-			asymCrypto->recyclePrivateKey(privateKey);
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_GENERAL_ERROR;
+			if (getRSAPrivateKey((RSAPrivateKey*)privateKey, token, key) != CKR_OK)
+			{
+				asymCrypto->recyclePrivateKey(privateKey);
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_GENERAL_ERROR;
+			}
 		}
 	}
 	else if (isDSA)
 	{
-		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm("dsa");
+		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::DSA);
 		if (asymCrypto == NULL) return CKR_MECHANISM_INVALID;
+		keyAlgorithm = "dsa";
 
-		privateKey = asymCrypto->newPrivateKey();
+		privateKey = token->getCachedPrivateKey(key, keyGeneration, keyAlgorithm);
 		if (privateKey == NULL)
 		{
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_HOST_MEMORY;
-		}
+			privateKey = asymCrypto->newPrivateKey();
+			if (privateKey == NULL)
+			{
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_HOST_MEMORY;
+			}
 
-		if (getDSAPrivateKey((DSAPrivateKey*)privateKey, token, key) != CKR_OK)
-		{
-			asymCrypto->recyclePrivateKey(privateKey);
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_GENERAL_ERROR;
+			if (getDSAPrivateKey((DSAPrivateKey*)privateKey, token, key) != CKR_OK)
+			{
+				asymCrypto->recyclePrivateKey(privateKey);
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_GENERAL_ERROR;
+			}
 		}
         }
 #ifdef WITH_ECC
 	else if (isECDSA)
 	{
-		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm("ecdsa");
+		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::ECDSA);
 		if (asymCrypto == NULL) return CKR_MECHANISM_INVALID;
+		keyAlgorithm = "ecdsa";
 
-		privateKey = asymCrypto->newPrivateKey();
+		privateKey = token->getCachedPrivateKey(key, keyGeneration, keyAlgorithm);
 		if (privateKey == NULL)
 		{
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_HOST_MEMORY;
-		}
+			privateKey = asymCrypto->newPrivateKey();
+			if (privateKey == NULL)
+			{
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_HOST_MEMORY;
+			}
 
-		if (getECPrivateKey((ECPrivateKey*)privateKey, token, key) != CKR_OK)
-		{
-			asymCrypto->recyclePrivateKey(privateKey);
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_GENERAL_ERROR;
+			if (getECPrivateKey((ECPrivateKey*)privateKey, token, key) != CKR_OK)
+			{
+				asymCrypto->recyclePrivateKey(privateKey);
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_GENERAL_ERROR;
+			}
 		}
 	}
 #endif
 	else
 	{
 #ifdef WITH_GOST
-		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm("gost");
+		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::GOST);
 		if (asymCrypto == NULL) return CKR_MECHANISM_INVALID;
+		keyAlgorithm = "gost";
 
-		privateKey = asymCrypto->newPrivateKey();
+		privateKey = token->getCachedPrivateKey(key, keyGeneration, keyAlgorithm);
 		if (privateKey == NULL)
 		{
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_HOST_MEMORY;
-		}
+			privateKey = asymCrypto->newPrivateKey();
+			if (privateKey == NULL)
+			{
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_HOST_MEMORY;
+			}
 
-		if (getGOSTPrivateKey((GOSTPrivateKey*)privateKey, token, key) != CKR_OK)
-		{
-			asymCrypto->recyclePrivateKey(privateKey);
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_GENERAL_ERROR;
+			if (getGOSTPrivateKey((GOSTPrivateKey*)privateKey, token, key) != CKR_OK)
+			{
+				asymCrypto->recyclePrivateKey(privateKey);
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_GENERAL_ERROR;
+			}
 		}
 #else
 		return CKR_MECHANISM_INVALID;
@@ -2390,6 +3190,7 @@ CK_RV SoftHSM::AsymSignInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechan
 	session->setAllowMultiPartOp(bAllowMultiPartOp);
 	session->setAllowSinglePartOp(true);
 	session->setPrivateKey(privateKey);
+	session->setKeyOrigin(key, keyGeneration, keyAlgorithm);
 
 	return CKR_OK;
 }
@@ -2428,32 +3229,28 @@ static CK_RV MacSign(Session* session, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK
 		return CKR_BUFFER_TOO_SMALL;
 	}
 
-	// Get the data
-	ByteString data(pData, ulDataLen);
-
 	// Sign the data
-	if (!mac->signUpdate(data))
+	if (!mac->signUpdate(pData, ulDataLen))
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
 
 	// Get the signature
-	ByteString signature;
-	if (!mac->signFinal(signature))
+	size_t signatureLen = *pulSignatureLen;
+	if (!mac->signFinal(pSignature, signatureLen))
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
 
 	// Check size
-	if (signature.size() != size)
+	if (signatureLen != size)
 	{
 		ERROR_MSG("The size of the signature differs from the size of the mechanism");
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
-	memcpy(pSignature, signature.byte_str(), size);
 	*pulSignatureLen = size;
 
 	session->resetOp();
@@ -2487,42 +3284,46 @@ static CK_RV AsymSign(Session* session, CK_BYTE_PTR pData, CK_ULONG ulDataLen, C
 		return CKR_BUFFER_TOO_SMALL;
 	}
 
-	// Get the data
-	ByteString data;
-
-	// PKCS #11 Mechanisms v2.30: Cryptoki Draft 7 page 32
-	// We must allow input length <= k and therfore need to prepend the data with zeroes.
-	if (strcmp(mechanism,"rsa-raw") == 0) {
-		data.wipe(size-ulDataLen);
-	}
-
-	data += ByteString(pData, ulDataLen);
-	ByteString signature;
+	size_t signatureLen = *pulSignatureLen;
 
 	// Sign the data
 	if (session->getAllowMultiPartOp())
 	{
-		if (!asymCrypto->signUpdate(data) ||
-		    !asymCrypto->signFinal(signature))
+		// The data is hashed, so it can be passed on without copying it
+		if (!asymCrypto->signUpdate(pData, ulDataLen) ||
+		    !asymCrypto->signFinal(pSignature, signatureLen))
 		{
 			session->resetOp();
 			return CKR_GENERAL_ERROR;
 		}
 	}
-	else if (!asymCrypto->sign(privateKey,data,signature,mechanism))
+	else
 	{
-		session->resetOp();
-		return CKR_GENERAL_ERROR;
+		// Get the data
+		ByteString data;
+
+		// PKCS #11 Mechanisms v2.30: Cryptoki Draft 7 page 32
+		// We must allow input length <= k and therfore need to prepend the data with zeroes.
+		if (strcmp(mechanism,"rsa-raw") == 0) {
+			data.wipe(size-ulDataLen);
+		}
+
+		data += ByteString(pData, ulDataLen);
+
+		if (!asymCrypto->sign(privateKey,data,pSignature,signatureLen,mechanism))
+		{
+			session->resetOp();
+			return CKR_GENERAL_ERROR;
+		}
 	}
 
 	// Check size
-	if (signature.size() != size)
+	if (signatureLen != size)
 	{
 		ERROR_MSG("The size of the signature differs from the size of the mechanism");
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
-	memcpy(pSignature, signature.byte_str(), size);
 	*pulSignatureLen = size;
 
 	session->resetOp();
@@ -2563,11 +3364,8 @@ static CK_RV MacSignUpdate(Session* session, CK_BYTE_PTR pPart, CK_ULONG ulPartL
 		return CKR_OPERATION_NOT_INITIALIZED;
 	}
 
-	// Get the part
-	ByteString part(pPart, ulPartLen);
-
 	// Sign the data
-	if (!mac->signUpdate(part))
+	if (!mac->signUpdate(pPart, ulPartLen))
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
@@ -2587,11 +3385,8 @@ static CK_RV AsymSignUpdate(Session* session, CK_BYTE_PTR pPart, CK_ULONG ulPart
 		return CKR_OPERATION_NOT_INITIALIZED;
 	}
 
-	// Get the part
-	ByteString part(pPart, ulPartLen);
-
 	// Sign the data
-	if (!asymCrypto->signUpdate(part))
+	if (!asymCrypto->signUpdate(pPart, ulPartLen))
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
@@ -2648,21 +3443,20 @@ static CK_RV MacSignFinal(Session* session, CK_BYTE_PTR pSignature, CK_ULONG_PTR
 	}
 
 	// Get the signature
-	ByteString signature;
-	if (!mac->signFinal(signature))
+	size_t signatureLen = *pulSignatureLen;
+	if (!mac->signFinal(pSignature, signatureLen))
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
 
 	// Check size
-	if (signature.size() != size)
+	if (signatureLen != size)
 	{
 		ERROR_MSG("The size of the signature differs from the size of the mechanism");
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
-	memcpy(pSignature, signature.byte_str(), size);
 	*pulSignatureLen = size;
 
 	session->resetOp();
@@ -2696,21 +3490,20 @@ static CK_RV AsymSignFinal(Session* session, CK_BYTE_PTR pSignature, CK_ULONG_PT
 	}
 
 	// Get the signature
-	ByteString signature;
-	if (!asymCrypto->signFinal(signature))
+	size_t signatureLen = *pulSignatureLen;
+	if (!asymCrypto->signFinal(pSignature, signatureLen))
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
 
 	// Check size
-	if (signature.size() != size)
+	if (signatureLen != size)
 	{
 		ERROR_MSG("The size of the signature differs from the size of the mechanism");
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
 	}
-	memcpy(pSignature, signature.byte_str(), size);
 	*pulSignatureLen = size;
 
 	session->resetOp();
@@ -2795,26 +3588,26 @@ CK_RV SoftHSM::MacVerifyInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMecha
 	MacAlgorithm* mac = NULL;
 	switch(pMechanism->mechanism) {
 		case CKM_MD5_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-md5");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_MD5);
 			break;
 		case CKM_SHA_1_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-sha1");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_SHA1);
 			break;
 		case CKM_SHA224_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-sha224");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_SHA224);
 			break;
 		case CKM_SHA256_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-sha256");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_SHA256);
 			break;
 		case CKM_SHA384_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-sha384");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_SHA384);
 			break;
 		case CKM_SHA512_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-sha512");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_SHA512);
 			break;
 #ifdef WITH_GOST
 		case CKM_GOSTR3411_HMAC:
-			mac = CryptoFactory::i()->getMacAlgorithm("hmac-gost");
+			mac = CryptoFactory::i()->getMacAlgorithm(MacAlgo::HMAC_GOST);
 			break;
 #endif
 		default:
@@ -2975,83 +3768,108 @@ CK_RV SoftHSM::AsymVerifyInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMech
 
 	AsymmetricAlgorithm* asymCrypto = NULL;
 	PublicKey* publicKey = NULL;
+
+	// Keys that were built from the current version of the object are
+	// taken from the key cache of the token
+	unsigned long keyGeneration = key->getGeneration();
+	const char* keyAlgorithm = NULL;
 	if (isRSA)
 	{
-		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm("rsa");
+		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::RSA);
 		if (asymCrypto == NULL) return CKR_MECHANISM_INVALID;
+		keyAlgorithm = "rsa";
 
-		publicKey = asymCrypto->newPublicKey();
+		publicKey = token->getCachedPublicKey(key, keyGeneration, keyAlgorithm);
 		if (publicKey == NULL)
 		{
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_HOST_MEMORY;
-		}
+			publicKey = asymCrypto->newPublicKey();
+			if (publicKey == NULL)
+			{
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_HOST_MEMORY;
+			}
 
-		if (getRSAPublicKey((RSAPublicKey*)publicKey, token, key) != CKR_OK)
-		{
-			asymCrypto->recyclePublicKey(publicKey);
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_GENERAL_ERROR;
+			if (getRSAPublicKey((RSAPublicKey*)publicKey, token, key) != CKR_OK)
+			{
+				asymCrypto->recyclePublicKey(publicKey);
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_GENERAL_ERROR;
+			}
 		}
 	}
 	else if (isDSA)
 	{
-		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm("dsa");
+		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::DSA);
 		if (asymCrypto == NULL) return CKR_MECHANISM_INVALID;
+		keyAlgorithm = "dsa";
 
-		publicKey = asymCrypto->newPublicKey();
+		publicKey = token->getCachedPublicKey(key, keyGeneration, keyAlgorithm);
 		if (publicKey == NULL)
 		{
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_HOST_MEMORY;
-		}
+			publicKey = asymCrypto->newPublicKey();
+			if (publicKey == NULL)
+			{
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_HOST_MEMORY;
+			}
 
-		if (getDSAPublicKey((DSAPublicKey*)publicKey, token, key) != CKR_OK)
-		{
-			asymCrypto->recyclePublicKey(publicKey);
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_GENERAL_ERROR;
+			if (getDSAPublicKey((DSAPublicKey*)publicKey, token, key) != CKR_OK)
+			{
+				asymCrypto->recyclePublicKey(publicKey);
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_GENERAL_ERROR;
+			}
 		}
         }
 #ifdef WITH_ECC
 	else if (isECDSA)
 	{
-		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm("ecdsa");
+		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::ECDSA);
 		if (asymCrypto == NULL) return CKR_MECHANISM_INVALID;
+		keyAlgorithm = "ecdsa";
 
-		publicKey = asymCrypto->newPublicKey();
+		publicKey = token->getCachedPublicKey(key, keyGeneration, keyAlgorithm);
 		if (publicKey == NULL)
 		{
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_HOST_MEMORY;
-		}
+			publicKey = asymCrypto->newPublicKey();
+			if (publicKey == NULL)
+			{
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_HOST_MEMORY;
+			}
 
-		if (getECPublicKey((ECPublicKey*)publicKey, token, key) != CKR_OK)
-		{
-			asymCrypto->recyclePublicKey(publicKey);
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_GENERAL_ERROR;
+			if (getECPublicKey((ECPublicKey*)publicKey, token, key) != CKR_OK)
+			{
+				asymCrypto->recyclePublicKey(publicKey);
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_GENERAL_ERROR;
+			}
 		}
 	}
 #endif
 	else
 	{
 #ifdef WITH_GOST
-		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm("gost");
+		asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::GOST);
 		if (asymCrypto == NULL) return CKR_MECHANISM_INVALID;
+		keyAlgorithm = "gost";
 
-		publicKey = asymCrypto->newPublicKey();
+		publicKey = token->getCachedPublicKey(key, keyGeneration, keyAlgorithm);
 		if (publicKey == NULL)
 		{
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_HOST_MEMORY;
-		}
+			publicKey = asymCrypto->newPublicKey();
+			if (publicKey == NULL)
+			{
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_HOST_MEMORY;
+			}
 
-		if (getGOSTPublicKey((GOSTPublicKey*)publicKey, token, key) != CKR_OK)
-		{
-			asymCrypto->recyclePublicKey(publicKey);
-			CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
-			return CKR_GENERAL_ERROR;
+			if (getGOSTPublicKey((GOSTPublicKey*)publicKey, token, key) != CKR_OK)
+			{
+				asymCrypto->recyclePublicKey(publicKey);
+				CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+				return CKR_GENERAL_ERROR;
+			}
 		}
 #else
 		return CKR_MECHANISM_INVALID;
@@ -3072,6 +3890,7 @@ CK_RV SoftHSM::AsymVerifyInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMech
 	session->setAllowMultiPartOp(bAllowMultiPartOp);
 	session->setAllowSinglePartOp(true);
 	session->setPublicKey(publicKey);
+	session->setKeyOrigin(key, keyGeneration, keyAlgorithm);
 
 	return CKR_OK;
 }
@@ -3106,11 +3925,8 @@ static CK_RV MacVerify(Session* session, CK_BYTE_PTR pData, CK_ULONG ulDataLen,
 		return CKR_SIGNATURE_LEN_RANGE;
 	}
 
-	// Get the data
-	ByteString data(pData, ulDataLen);
-
 	// Verify the data
-	if (!mac->verifyUpdate(data))
+	if (!mac->verifyUpdate(pData, ulDataLen))
 	{
 		session->resetOp();
 		return CKR_GENERAL_ERROR;
@@ -3153,32 +3969,37 @@ static CK_RV AsymVerify(Session* session, CK_BYTE_PTR pData, CK_ULONG ulDataLen,
 		return CKR_SIGNATURE_LEN_RANGE;
 	}
 
-	// Get the data
-	ByteString data;
-
-	// PKCS #11 Mechanisms v2.30: Cryptoki Draft 7 page 32
-	// We must allow input length <= k and therfore need to prepend the data with zeroes.
-	if (strcmp(mechanism,"rsa-raw") == 0) {
-		data.wipe(size-ulDataLen);
-	}
-
-	data += ByteString(pData, ulDataLen);
 	ByteString signature(pSignature, ulSignatureLen);
 
 	// Verify the data
 	if (session->getAllowMultiPartOp())
 	{
-		if (!asymCrypto->verifyUpdate(data) ||
+		// The data is hashed, so it can be passed on without copying it
+		if (!asymCrypto->verifyUpdate(pData, ulDataLen) ||
 		    !asymCrypto->verifyFinal(signature))
 		{
 			session->resetOp();
 			return CKR_SIGNATURE_INVALID;
 		}
 	}
-	else if (!asymCrypto->verify(publicKey,data,signature,mechanism))
+	else
 	{
-		session->resetOp();
-		return CKR_SIGNATURE_INVALID;
+		// Get the data
+		ByteString data;
+
+		// PKCS #11 Mechanisms v2.30: Cryptoki Draft 7 page 32
+		// We must allow input length <= k and therfore need to prepend the data with zeroes.
+		if (strcmp(mechanism,"rsa-raw") == 0) {
+			data.wipe(size-ulDataLen);
+		}
+
+		data += ByteString(pData, ulDataLen);
+
+		if (!asymCrypto->verify(publicKey,data,signature,mechanism))
+		{
+			session->resetOp();
+			return CKR_SIGNATURE_INVALID;
+		}
 	}
 
 	session->resetOp();
@@ -3219,11 +4040,8 @@ static CK_RV MacVerifyUpdate(Session* session, CK_BYTE_PTR pPart, CK_ULONG ulPar
 		return CKR_OPERATION_NOT_INITIALIZED;
 	}
 
-	// Get the part
-	ByteString part(pPart, ulPartLen);
-
 	// Verify the data
-	if (!mac->verifyUpdate(part))
+	if (!mac->verifyUpdate(pPart, ulPartLen))
 	{
 		// verifyUpdate can't fail for a logical reason, so we assume total breakdown.
 		session->resetOp();
@@ -3244,11 +4062,8 @@ static CK_RV AsymVerifyUpdate(Session* session, CK_BYTE_PTR pPart, CK_ULONG ulPa
 		return CKR_OPERATION_NOT_INITIALIZED;
 	}
 
-	// Get the part
-	ByteString part(pPart, ulPartLen);
-
 	// Verify the data
-	if (!asymCrypto->verifyUpdate(part))
+	if (!asymCrypto->verifyUpdate(pPart, ulPartLen))
 	{
 		// verifyUpdate can't fail for a logical reason, so we assume total breakdown.
 		session->resetOp();
@@ -3971,7 +4786,7 @@ CK_RV SoftHSM::generateRSA
 
 	// Generate key pair
 	AsymmetricKeyPair* kp = NULL;
-	AsymmetricAlgorithm* rsa = CryptoFactory::i()->getAsymmetricAlgorithm("RSA");
+	AsymmetricAlgorithm* rsa = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::RSA);
 	if (rsa == NULL)
 		return CKR_GENERAL_ERROR;
 	if (!rsa->generateKeyPair(&kp, &p))
@@ -4253,7 +5068,7 @@ CK_RV SoftHSM::generateDSA
 
 	// Generate key pair
 	AsymmetricKeyPair* kp = NULL;
-	AsymmetricAlgorithm* dsa = CryptoFactory::i()->getAsymmetricAlgorithm("DSA");
+	AsymmetricAlgorithm* dsa = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::DSA);
 	if (dsa == NULL) return CKR_GENERAL_ERROR;
 	if (!dsa->generateKeyPair(&kp, &p))
 	{
@@ -4528,7 +5343,7 @@ CK_RV SoftHSM::generateDSAParameters
 
 	// Generate domain parameters
 	AsymmetricParameters* p = NULL;
-	AsymmetricAlgorithm* dsa = CryptoFactory::i()->getAsymmetricAlgorithm("DSA");
+	AsymmetricAlgorithm* dsa = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::DSA);
 	if (dsa == NULL) return CKR_GENERAL_ERROR;
 	if (!dsa->generateParameters(&p, (void *)bitLen))
 	{
@@ -4687,7 +5502,7 @@ CK_RV SoftHSM::generateEC
 
 	// Generate key pair
 	AsymmetricKeyPair* kp = NULL;
-	AsymmetricAlgorithm* ec = CryptoFactory::i()->getAsymmetricAlgorithm("ECDSA");
+	AsymmetricAlgorithm* ec = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::ECDSA);
 	if (ec == NULL) return CKR_GENERAL_ERROR;
 	if (!ec->generateKeyPair(&kp, &p))
 	{
@@ -4936,7 +5751,7 @@ CK_RV SoftHSM::generateDH
 
 	// Generate key pair
 	AsymmetricKeyPair* kp = NULL;
-	AsymmetricAlgorithm* dh = CryptoFactory::i()->getAsymmetricAlgorithm("DH");
+	AsymmetricAlgorithm* dh = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::DH);
 	if (dh == NULL) return CKR_GENERAL_ERROR;
 	if (!dh->generateKeyPair(&kp, &p))
 	{
@@ -5187,7 +6002,7 @@ CK_RV SoftHSM::generateDHParameters
 
 	// Generate domain parameters
 	AsymmetricParameters* p = NULL;
-	AsymmetricAlgorithm* dh = CryptoFactory::i()->getAsymmetricAlgorithm("DH");
+	AsymmetricAlgorithm* dh = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::DH);
 	if (dh == NULL) return CKR_GENERAL_ERROR;
 	if (!dh->generateParameters(&p, (void *)bitLen))
 	{
@@ -5326,7 +6141,7 @@ CK_RV SoftHSM::generateGOST
 
 	// Generate key pair
 	AsymmetricKeyPair* kp = NULL;
-	AsymmetricAlgorithm* gost = CryptoFactory::i()->getAsymmetricAlgorithm("GOST");
+	AsymmetricAlgorithm* gost = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::GOST);
 	if (gost == NULL) return CKR_GENERAL_ERROR;
 	if (!gost->generateKeyPair(&kp, &p))
 	{
@@ -5563,7 +6378,7 @@ CK_RV SoftHSM::deriveDH
 		return CKR_KEY_HANDLE_INVALID;
 
 	// Get the DH algorithm handler
-	AsymmetricAlgorithm* dh = CryptoFactory::i()->getAsymmetricAlgorithm("DH");
+	AsymmetricAlgorithm* dh = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::DH);
 	if (dh == NULL)
 		return CKR_MECHANISM_INVALID;
 
@@ -5770,7 +6585,7 @@ CK_RV SoftHSM::deriveECDH
 		return CKR_KEY_HANDLE_INVALID;
 
 	// Get the ECDH algorithm handler
-	AsymmetricAlgorithm* ecdh = CryptoFactory::i()->getAsymmetricAlgorithm("ECDH");
+	AsymmetricAlgorithm* ecdh = CryptoFactory::i()->getAsymmetricAlgorithm(AsymAlgo::ECDH);
 	if (ecdh == NULL)
 		return CKR_MECHANISM_INVALID;
 
@@ -5967,11 +6782,26 @@ CK_RV SoftHSM::CreateObject(CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTempla
 	}
 	if (object == NULL) return CKR_GENERAL_ERROR;
 
-	p11object->init(object);
+	// Accumulate the default attributes and the template in memory so that
+	// the new object is written back only once
+	if (!object->startTransaction())
+		return CKR_GENERAL_ERROR;
+
+	if (!p11object->init(object))
+	{
+		object->abortTransaction();
+		return CKR_GENERAL_ERROR;
+	}
 
 	rv = p11object->saveTemplate(token, isPrivate, pTemplate,ulCount,op);
 	if (rv != CKR_OK)
+	{
+		object->abortTransaction();
 		return rv;
+	}
+
+	if (!object->commitTransaction())
+		return CKR_GENERAL_ERROR;
 
 	if (isToken) {
 		*phObject = handleManager->addTokenObject(slot->getSlotID(), isPrivate, object);
@@ -6365,7 +7195,8 @@ CK_RV SoftHSM::getSymmetricKey(SymmetricKey* skey, Token* token, OSObject* key)
 		keybits = key->getAttribute(CKA_VALUE)->getByteStringValue();
 	}
 
-	skey->setKeyBits(keybits);
+	if (!skey->setKeyBits(keybits))
+		return CKR_GENERAL_ERROR;
 
 	return CKR_OK;
 }
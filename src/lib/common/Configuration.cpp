@@ -41,6 +41,13 @@ std::auto_ptr<Configuration> Configuration::instance(NULL);
 // Add all valid configurations
 const struct config Configuration::valid_config[] = {
 	{ "directories.tokendir",	CONFIG_TYPE_STRING },
+	{ "keycache.size",		CONFIG_TYPE_INT },
+	{ "objectstore.fsync",		CONFIG_TYPE_BOOL },
+	{ "objectstore.backend",	CONFIG_TYPE_STRING },
+	{ "objectstore.loadthreads",	CONFIG_TYPE_INT },
+	{ "log.level",			CONFIG_TYPE_STRING },
+	{ "log.file",			CONFIG_TYPE_STRING },
+	{ "statistics.enabled",		CONFIG_TYPE_BOOL },
 	{ "",				CONFIG_TYPE_UNSUPPORTED }
 };
 
@@ -27,13 +27,10 @@
 /*****************************************************************************
  IPCSignal.cpp
 
- This class implements rudimentary IPC signalling based on POSIX semaphores.
-
- N.B.: Because of the way this code works, SoftHSM v2 is not suitable for use
-       in environments where it is both long lived as well as has a high
-       object change ratio (either separately is not a problem). This is
-       caused by the fact that the counter on a POSIX semaphore has a limit
-       of INT_MAX.
+ This class implements rudimentary IPC signalling based on the change
+ counters in a shared memory table (see SharedCounters.h). Triggering a
+ signal increments its counter; a listener compares the counter with the
+ value it saw last, which does not require a system call.
  *****************************************************************************/
 
 #include "config.h"
@@ -41,52 +38,41 @@
 #include "IPCSignal.h"
 
 // Factory
-IPCSignal* IPCSignal::create(const std::string name)
+IPCSignal* IPCSignal::create(const std::string tokenPath, const std::string objectName /* = "" */)
 {
-	Semaphore* semaphore = Semaphore::create(0, name);
+	SharedCounters* table = SharedCounters::get(tokenPath);
 
-	if (semaphore == NULL)
+	if (table == NULL)
 	{
-		ERROR_MSG("Failed to create a named semaphore (%s)", name.c_str());
-			
+		ERROR_MSG("Failed to get the change counters of %s", tokenPath.c_str());
+
 		return NULL;
 	}
 
-	return new IPCSignal(semaphore);
+	if (objectName.empty())
+	{
+		return new IPCSignal(table, table->getTokenCounter());
+	}
+
+	return new IPCSignal(table, table->getObjectCounter(objectName));
 }
 
 // Destructor
 IPCSignal::~IPCSignal()
 {
-	delete semaphore;
+	SharedCounters::release(table);
 }
 
 // Update the signal
 void IPCSignal::trigger()
 {
-	if (!semaphore->inc())
-	{
-		if (semaphore->getValue() > 0)
-		{
-			// Decrement by 10; this is to prevent listeners from missing
-			// the changed in case of a saturated semaphore. This is not 
-			// ideal, however
-			for (int i = 0; i < 10; i++) semaphore->dec();
-
-			currentValue -= 10;
-		}
-		else
-		{
-			// Make sure this instance isn't triggered by its own action
-			currentValue++;
-		}
-	}
+	SharedCounters::increment(counter);
 }
 
 // Has the signal been triggered?
 bool IPCSignal::wasTriggered()
 {
-	int value = semaphore->getValue();
+	unsigned long long value = *counter;
 
 	if (value != currentValue)
 	{
@@ -99,9 +85,9 @@ bool IPCSignal::wasTriggered()
 }
 
 // Constructor
-IPCSignal::IPCSignal(Semaphore* semaphore)
+IPCSignal::IPCSignal(SharedCounters* table, volatile unsigned long long* counter)
 {
-	this->semaphore = semaphore;
-	currentValue = semaphore->getValue();
+	this->table = table;
+	this->counter = counter;
+	currentValue = *counter;
 }
-
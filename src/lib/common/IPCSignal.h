@@ -27,27 +27,25 @@
 /*****************************************************************************
  IPCSignal.h
 
- This class implements rudimentary IPC signalling based on POSIX semaphores.
-
- N.B.: Because of the way this code works, SoftHSM v2 is not suitable for use
-       in environments where it is both long lived as well as has a high
-       object change ratio (either separately is not a problem). This is
-       caused by the fact that the counter on a POSIX semaphore has a limit
-       of INT_MAX.
+ This class implements rudimentary IPC signalling based on the change
+ counters in a shared memory table (see SharedCounters.h). Triggering a
+ signal increments its counter; a listener compares the counter with the
+ value it saw last, which does not require a system call.
  *****************************************************************************/
 
 #ifndef _SOFTHSM_V2_IPCSIGNAL_H
 #define _SOFTHSM_V2_IPCSIGNAL_H
 
 #include "config.h"
-#include "Semaphore.h"
+#include "SharedCounters.h"
 #include <string>
 
 class IPCSignal
 {
 public:
-	// Factory
-	static IPCSignal* create(const std::string name);
+	// Factory; returns the signal of the token at tokenPath, or that of the
+	// object with the specified name in this token
+	static IPCSignal* create(const std::string tokenPath, const std::string objectName = "");
 
 	// Destructor
 	virtual ~IPCSignal();
@@ -60,13 +58,16 @@ public:
 
 private:
 	// Constructor
-	IPCSignal(Semaphore* semaphore);
+	IPCSignal(SharedCounters* table, volatile unsigned long long* counter);
+
+	// The table that holds the counter
+	SharedCounters* table;
+
+	// The counter
+	volatile unsigned long long* counter;
 
-	// The semaphore
-	Semaphore* semaphore;
-	
-	// The current semaphore value
-	int currentValue;
+	// The value of the counter when it was last checked
+	unsigned long long currentValue;
 };
 
 #endif // !_SOFTHSM_V2_IPCSIGNAL_H
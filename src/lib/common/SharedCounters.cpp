@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ SharedCounters.cpp
+
+ A table of change counters in a shared memory segment
+ *****************************************************************************/
+
+#include "config.h"
+#include "log.h"
+#include "SharedCounters.h"
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// The tables that are in use by this process; the lock is a static POSIX mutex
+// since tokens may be opened by several threads at the same time
+static std::map<std::string, SharedCounters*> tables;
+static pthread_mutex_t tablesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Hash a name (64-bit FNV-1a)
+static unsigned long long hashName(const std::string& name)
+{
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+
+	for (size_t i = 0; i < name.size(); i++)
+	{
+		hash ^= (unsigned char) name[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+// Return the name of the shared memory segment of a table; it is derived from
+// a hash of the table name to stay within the limits on the length of shared
+// memory names
+static std::string segmentName(const std::string& name)
+{
+	char shmName[32];
+	snprintf(shmName, sizeof(shmName), "/softhsm2-%016llx", hashName(name));
+
+	return shmName;
+}
+
+// Open the shared memory segment of a table; a new segment gets the owner,
+// the group and the owner and group permissions of the token
+static int openSegment(const std::string& name, const std::string& shmName)
+{
+	struct stat tokenStat;
+	bool haveStat = (stat(name.c_str(), &tokenStat) == 0);
+	mode_t mode = S_IRUSR | S_IWUSR;
+
+	if (haveStat)
+	{
+		mode |= tokenStat.st_mode & (S_IRGRP | S_IWGRP);
+	}
+
+	int fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, mode);
+
+	if (fd == -1)
+	{
+		return (errno == EEXIST) ? shm_open(shmName.c_str(), O_RDWR, 0) : -1;
+	}
+
+	// The mode passed to shm_open is subject to the umask
+	fchmod(fd, mode);
+
+	// Only a privileged process can give the segment away; others can
+	// still hand it to the group of the token
+	if (haveStat &&
+	    (fchown(fd, tokenStat.st_uid, tokenStat.st_gid) != 0) &&
+	    (fchown(fd, (uid_t) -1, tokenStat.st_gid) != 0))
+	{
+		DEBUG_MSG("Could not change the group of shared memory segment %s: %s", shmName.c_str(), strerror(errno));
+	}
+
+	return fd;
+}
+
+// Get the table with the specified name
+/*static*/ SharedCounters* SharedCounters::get(const std::string& name)
+{
+	pthread_mutex_lock(&tablesMutex);
+
+	std::map<std::string, SharedCounters*>::iterator i = tables.find(name);
+
+	if (i != tables.end())
+	{
+		i->second->refCount++;
+
+		pthread_mutex_unlock(&tablesMutex);
+
+		return i->second;
+	}
+
+	std::string shmName = segmentName(name);
+
+	int fd = openSegment(name, shmName);
+
+	if (fd == -1)
+	{
+		ERROR_MSG("Could not open shared memory segment %s for %s: %s", shmName.c_str(), name.c_str(), strerror(errno));
+
+		pthread_mutex_unlock(&tablesMutex);
+
+		return NULL;
+	}
+
+	// Every process sets the same size, a new segment is filled with zeroes
+	void* mapped = MAP_FAILED;
+
+	if (ftruncate(fd, SEGMENT_SIZE) == 0)
+	{
+		mapped = mmap(NULL, SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+
+	if (mapped == MAP_FAILED)
+	{
+		ERROR_MSG("Could not map shared memory segment %s for %s: %s", shmName.c_str(), name.c_str(), strerror(errno));
+
+		close(fd);
+
+		pthread_mutex_unlock(&tablesMutex);
+
+		return NULL;
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+
+	SharedCounters* table = new SharedCounters(name, (volatile unsigned long long*) mapped);
+	tables[name] = table;
+
+	pthread_mutex_unlock(&tablesMutex);
+
+	return table;
+}
+
+// Release a table obtained with get()
+/*static*/ void SharedCounters::release(SharedCounters* table)
+{
+	if (table == NULL) return;
+
+	pthread_mutex_lock(&tablesMutex);
+
+	if (--table->refCount == 0)
+	{
+		// The table may already have been replaced after it was removed
+		std::map<std::string, SharedCounters*>::iterator i = tables.find(table->name);
+
+		if ((i != tables.end()) && (i->second == table))
+		{
+			tables.erase(i);
+		}
+
+		delete table;
+	}
+
+	pthread_mutex_unlock(&tablesMutex);
+}
+
+// Remove the table with the specified name
+/*static*/ void SharedCounters::remove(const std::string& name)
+{
+	pthread_mutex_lock(&tablesMutex);
+
+	// Users in this process keep the table until they release it; a token
+	// that is created with the same name gets a new table
+	tables.erase(name);
+
+	std::string shmName = segmentName(name);
+
+	if (shm_unlink(shmName.c_str()) && (errno != ENOENT))
+	{
+		ERROR_MSG("Could not remove shared memory segment %s for %s: %s", shmName.c_str(), name.c_str(), strerror(errno));
+	}
+
+	pthread_mutex_unlock(&tablesMutex);
+}
+
+// Constructor
+SharedCounters::SharedCounters(const std::string& name, volatile unsigned long long* counters)
+{
+	this->name = name;
+	this->counters = counters;
+	refCount = 1;
+}
+
+// Destructor; the segment itself is kept so other processes can continue to
+// use it, it is only removed when the token is deleted
+SharedCounters::~SharedCounters()
+{
+	munmap((void*) counters, SEGMENT_SIZE);
+}
+
+// Return the counter of the token
+volatile unsigned long long* SharedCounters::getTokenCounter()
+{
+	return &counters[0];
+}
+
+// Return the counter for the object with the specified name
+volatile unsigned long long* SharedCounters::getObjectCounter(const std::string& objectName)
+{
+	return &counters[1 + (hashName(objectName) % NR_COUNTERS)];
+}
+
+// Increment a counter
+/*static*/ void SharedCounters::increment(volatile unsigned long long* counter)
+{
+	__sync_add_and_fetch(counter, 1);
+}
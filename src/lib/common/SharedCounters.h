@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ SharedCounters.h
+
+ A table of change counters in a shared memory segment. There is one table
+ per token, shared by all processes that use the token. It holds a counter
+ for the token as a whole and a fixed number of counters for the objects of
+ the token. Objects are assigned to a counter by a hash of their name, so
+ several objects may share a counter; a change to one of them then makes the
+ others look changed as well, which only causes an unnecessary refresh.
+
+ Counters are 64 bits wide and are incremented atomically; reading them is a
+ plain load from the shared memory, so no system call is needed to check if
+ another process made a change.
+
+ The shared memory segment gets the owner, the group and the owner and group
+ permissions of the token, so that only users that can access the token can
+ access its counters.
+ *****************************************************************************/
+
+#ifndef _SOFTHSM_V2_SHAREDCOUNTERS_H
+#define _SOFTHSM_V2_SHAREDCOUNTERS_H
+
+#include "config.h"
+#include <string>
+
+class SharedCounters
+{
+public:
+	// Get the table with the specified name (normally the token path); the
+	// table is created if it does not exist yet. Tables are shared within
+	// the process, each get() must be matched by a call to release()
+	static SharedCounters* get(const std::string& name);
+
+	// Release a table obtained with get()
+	static void release(SharedCounters* table);
+
+	// Remove the table with the specified name when its token is deleted;
+	// processes that still use the table keep their copy of the counters
+	static void remove(const std::string& name);
+
+	// Return the counter of the token
+	volatile unsigned long long* getTokenCounter();
+
+	// Return the counter for the object with the specified name
+	volatile unsigned long long* getObjectCounter(const std::string& objectName);
+
+	// Increment a counter
+	static void increment(volatile unsigned long long* counter);
+
+	// The number of object counters in a table
+	static const size_t NR_COUNTERS = 65536;
+
+private:
+	// Constructor
+	SharedCounters(const std::string& name, volatile unsigned long long* counters);
+
+	// Destructor
+	~SharedCounters();
+
+	// The layout of the shared memory: the token counter followed by the
+	// object counters
+	static const size_t SEGMENT_SIZE = (NR_COUNTERS + 1) * sizeof(unsigned long long);
+
+	// The name of the table
+	std::string name;
+
+	// The mapped counters
+	volatile unsigned long long* counters;
+
+	// The number of users in this process
+	size_t refCount;
+};
+
+#endif // !_SOFTHSM_V2_SHAREDCOUNTERS_H
+
@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ Statistics.cpp
+
+ Keeps call counts, error counts and latency histograms for the PKCS #11
+ entry points and for the main phases of their implementation
+ *****************************************************************************/
+
+#include "config.h"
+#include "Statistics.h"
+#include "log.h"
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+// The names of the counters, in the order of StatCounter::Type
+static const char* counterNames[StatCounter::Count] =
+{
+	"C_Initialize",
+	"C_Finalize",
+	"C_GetInfo",
+	"C_GetFunctionList",
+	"C_GetSlotList",
+	"C_GetSlotInfo",
+	"C_GetTokenInfo",
+	"C_GetMechanismList",
+	"C_GetMechanismInfo",
+	"C_InitToken",
+	"C_InitPIN",
+	"C_SetPIN",
+	"C_OpenSession",
+	"C_CloseSession",
+	"C_CloseAllSessions",
+	"C_GetSessionInfo",
+	"C_GetOperationState",
+	"C_SetOperationState",
+	"C_Login",
+	"C_Logout",
+	"C_CreateObject",
+	"C_CopyObject",
+	"C_DestroyObject",
+	"C_GetObjectSize",
+	"C_GetAttributeValue",
+	"C_SetAttributeValue",
+	"C_FindObjectsInit",
+	"C_FindObjects",
+	"C_FindObjectsFinal",
+	"C_EncryptInit",
+	"C_Encrypt",
+	"C_EncryptUpdate",
+	"C_EncryptFinal",
+	"C_DecryptInit",
+	"C_Decrypt",
+	"C_DecryptUpdate",
+	"C_DecryptFinal",
+	"C_DigestInit",
+	"C_Digest",
+	"C_DigestUpdate",
+	"C_DigestKey",
+	"C_DigestFinal",
+	"C_SignInit",
+	"C_Sign",
+	"C_SignUpdate",
+	"C_SignFinal",
+	"C_SignRecoverInit",
+	"C_SignRecover",
+	"C_VerifyInit",
+	"C_Verify",
+	"C_VerifyUpdate",
+	"C_VerifyFinal",
+	"C_VerifyRecoverInit",
+	"C_VerifyRecover",
+	"C_DigestEncryptUpdate",
+	"C_DecryptDigestUpdate",
+	"C_SignEncryptUpdate",
+	"C_DecryptVerifyUpdate",
+	"C_GenerateKey",
+	"C_GenerateKeyPair",
+	"C_WrapKey",
+	"C_UnwrapKey",
+	"C_DeriveKey",
+	"C_SeedRandom",
+	"C_GenerateRandom",
+	"C_GetFunctionStatus",
+	"C_CancelFunction",
+	"C_WaitForSlotEvent",
+	"Token::decrypt",
+	"ObjectFile::refresh",
+	"ObjectFile::store",
+	"OSToken::index",
+	"CryptoFactory::get",
+	"CryptoFactory::recycle"
+};
+
+// Initialise the one-and-only instance
+std::auto_ptr<Statistics> Statistics::instance(NULL);
+
+// Return the one-and-only instance
+Statistics* Statistics::i()
+{
+	if (instance.get() == NULL)
+	{
+		instance = std::auto_ptr<Statistics>(new Statistics());
+	}
+
+	return instance.get();
+}
+
+// Constructor
+Statistics::Statistics()
+{
+	enabled = true;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_init(&countersMutex, NULL);
+
+	countersKeyValid = (pthread_key_create(&countersKey, releaseThreadCounters) == 0);
+#endif
+}
+
+// Destructor
+Statistics::~Statistics()
+{
+#ifdef HAVE_PTHREAD_H
+	if (countersKeyValid) pthread_key_delete(countersKey);
+
+	pthread_mutex_destroy(&countersMutex);
+#endif
+
+	for (std::vector<ThreadCounters*>::iterator i = allCounters.begin(); i != allCounters.end(); i++)
+	{
+		delete *i;
+	}
+}
+
+void Statistics::enable()
+{
+	enabled = true;
+}
+
+void Statistics::disable()
+{
+	enabled = false;
+}
+
+bool Statistics::isEnabled()
+{
+	return enabled;
+}
+
+// Get the time in nanoseconds from a monotonic clock
+unsigned long long Statistics::now()
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+	{
+		return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	}
+#endif
+
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (unsigned long long) tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000ULL;
+}
+
+#ifdef HAVE_PTHREAD_H
+// Release the counters of an exiting thread; they are kept for the totals
+void Statistics::releaseThreadCounters(void* counters)
+{
+	Statistics* statistics = instance.get();
+
+	if (statistics == NULL) return;
+
+	pthread_mutex_lock(&statistics->countersMutex);
+	((ThreadCounters*) counters)->owned = false;
+	pthread_mutex_unlock(&statistics->countersMutex);
+}
+#endif
+
+// Get the counters of the calling thread
+Statistics::ThreadCounters* Statistics::getThreadCounters()
+{
+	ThreadCounters* counters = NULL;
+
+#ifdef HAVE_PTHREAD_H
+	if (!countersKeyValid) return NULL;
+
+	counters = (ThreadCounters*) pthread_getspecific(countersKey);
+
+	if (counters != NULL) return counters;
+
+	pthread_mutex_lock(&countersMutex);
+
+	// Take over the counters of a thread that has exited
+	for (std::vector<ThreadCounters*>::iterator i = allCounters.begin(); i != allCounters.end(); i++)
+	{
+		if (!(*i)->owned)
+		{
+			counters = *i;
+
+			break;
+		}
+	}
+
+	if (counters == NULL)
+	{
+		counters = new ThreadCounters;
+		memset(counters, 0, sizeof(ThreadCounters));
+
+		allCounters.push_back(counters);
+	}
+
+	counters->owned = true;
+
+	pthread_mutex_unlock(&countersMutex);
+
+	if (pthread_setspecific(countersKey, counters) != 0)
+	{
+		pthread_mutex_lock(&countersMutex);
+		counters->owned = false;
+		pthread_mutex_unlock(&countersMutex);
+
+		return NULL;
+	}
+#else
+	if (allCounters.empty())
+	{
+		counters = new ThreadCounters;
+		memset(counters, 0, sizeof(ThreadCounters));
+
+		allCounters.push_back(counters);
+	}
+
+	counters = allCounters.front();
+#endif
+
+	return counters;
+}
+
+// Record a call
+void Statistics::record(StatCounter::Type counter, unsigned long long nanoseconds, bool failed)
+{
+	ThreadCounters* counters = getThreadCounters();
+
+	if (counters == NULL) return;
+
+	// The bucket is the position of the most significant bit
+	int bucket = 0;
+
+	while ((bucket < CK_STATISTICS_BUCKETS - 1) && (nanoseconds >> (bucket + 1)))
+	{
+		bucket++;
+	}
+
+	counters->calls[counter]++;
+	counters->nanoseconds[counter] += nanoseconds;
+	counters->buckets[counter][bucket]++;
+
+	if (failed) counters->errors[counter]++;
+}
+
+// Retrieve the totals of all threads. Threads keep updating their counters
+// while they are added up, so the totals are not an exact snapshot
+void Statistics::getStatistics(std::vector<CK_STATISTICS>& statistics)
+{
+	statistics.resize(StatCounter::Count);
+
+	for (int c = 0; c < StatCounter::Count; c++)
+	{
+		CK_STATISTICS& entry = statistics[c];
+
+		memset(&entry, 0, sizeof(entry));
+		strncpy((char*) entry.name, counterNames[c], sizeof(entry.name) - 1);
+	}
+
+	std::vector<unsigned long long> nanoseconds(StatCounter::Count, 0);
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_lock(&countersMutex);
+#endif
+
+	for (std::vector<ThreadCounters*>::iterator i = allCounters.begin(); i != allCounters.end(); i++)
+	{
+		for (int c = 0; c < StatCounter::Count; c++)
+		{
+			CK_STATISTICS& entry = statistics[c];
+
+			entry.calls += (*i)->calls[c];
+			entry.errors += (*i)->errors[c];
+			nanoseconds[c] += (*i)->nanoseconds[c];
+
+			for (int b = 0; b < CK_STATISTICS_BUCKETS; b++)
+			{
+				entry.buckets[b] += (*i)->buckets[c][b];
+			}
+		}
+	}
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_unlock(&countersMutex);
+#endif
+
+	for (int c = 0; c < StatCounter::Count; c++)
+	{
+		statistics[c].totalMicroseconds = nanoseconds[c] / 1000;
+	}
+}
+
+// Constructor
+StatTimer::StatTimer(StatCounter::Type counter)
+{
+	this->counter = counter;
+	isFailed = false;
+
+	start = Statistics::i()->isEnabled() ? Statistics::now() : 0;
+}
+
+// Destructor
+StatTimer::~StatTimer()
+{
+	if (start == 0) return;
+
+	Statistics::i()->record(counter, Statistics::now() - start, isFailed);
+}
+
+// Mark the call as failed
+void StatTimer::failed()
+{
+	isFailed = true;
+}
+
+// Mark the call as failed if the return value is not CKR_OK
+CK_RV StatTimer::result(CK_RV rv)
+{
+	if (rv != CKR_OK) isFailed = true;
+
+	return rv;
+}
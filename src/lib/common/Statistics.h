@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ Statistics.h
+
+ Keeps call counts, error counts and latency histograms for the PKCS #11
+ entry points and for the main phases of their implementation. Every thread
+ updates its own set of counters, so recording a call needs no locking; the
+ counters of all threads are added up when the statistics are retrieved.
+ *****************************************************************************/
+
+#ifndef _SOFTHSM_V2_STATISTICS_H
+#define _SOFTHSM_V2_STATISTICS_H
+
+#include "config.h"
+#include "cryptoki.h"
+#include "softhsm_statistics.h"
+#include <memory>
+#include <vector>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+// The things that are measured
+struct StatCounter
+{
+	enum Type
+	{
+		// The PKCS #11 entry points
+		C_Initialize,
+		C_Finalize,
+		C_GetInfo,
+		C_GetFunctionList,
+		C_GetSlotList,
+		C_GetSlotInfo,
+		C_GetTokenInfo,
+		C_GetMechanismList,
+		C_GetMechanismInfo,
+		C_InitToken,
+		C_InitPIN,
+		C_SetPIN,
+		C_OpenSession,
+		C_CloseSession,
+		C_CloseAllSessions,
+		C_GetSessionInfo,
+		C_GetOperationState,
+		C_SetOperationState,
+		C_Login,
+		C_Logout,
+		C_CreateObject,
+		C_CopyObject,
+		C_DestroyObject,
+		C_GetObjectSize,
+		C_GetAttributeValue,
+		C_SetAttributeValue,
+		C_FindObjectsInit,
+		C_FindObjects,
+		C_FindObjectsFinal,
+		C_EncryptInit,
+		C_Encrypt,
+		C_EncryptUpdate,
+		C_EncryptFinal,
+		C_DecryptInit,
+		C_Decrypt,
+		C_DecryptUpdate,
+		C_DecryptFinal,
+		C_DigestInit,
+		C_Digest,
+		C_DigestUpdate,
+		C_DigestKey,
+		C_DigestFinal,
+		C_SignInit,
+		C_Sign,
+		C_SignUpdate,
+		C_SignFinal,
+		C_SignRecoverInit,
+		C_SignRecover,
+		C_VerifyInit,
+		C_Verify,
+		C_VerifyUpdate,
+		C_VerifyFinal,
+		C_VerifyRecoverInit,
+		C_VerifyRecover,
+		C_DigestEncryptUpdate,
+		C_DecryptDigestUpdate,
+		C_SignEncryptUpdate,
+		C_DecryptVerifyUpdate,
+		C_GenerateKey,
+		C_GenerateKeyPair,
+		C_WrapKey,
+		C_UnwrapKey,
+		C_DeriveKey,
+		C_SeedRandom,
+		C_GenerateRandom,
+		C_GetFunctionStatus,
+		C_CancelFunction,
+		C_WaitForSlotEvent,
+
+		// Phases of the implementation
+		TokenDecrypt,
+		ObjectFileRefresh,
+		ObjectFileStore,
+		OSTokenIndex,
+		CryptoFactoryGet,
+		CryptoFactoryRecycle,
+
+		// The number of counters
+		Count
+	};
+};
+
+class Statistics
+{
+public:
+	// Return the one-and-only instance
+	static Statistics* i();
+
+	// Destructor
+	virtual ~Statistics();
+
+	// Enable/disable keeping statistics
+	void enable();
+	void disable();
+	bool isEnabled();
+
+	// Record a call that took the specified number of nanoseconds
+	void record(StatCounter::Type counter, unsigned long long nanoseconds, bool failed);
+
+	// Retrieve the totals of all threads
+	void getStatistics(std::vector<CK_STATISTICS>& statistics);
+
+	// Get the time in nanoseconds from a monotonic clock
+	static unsigned long long now();
+
+private:
+	// Constructor
+	Statistics();
+
+	// The counters of a single thread
+	struct ThreadCounters
+	{
+		unsigned long long calls[StatCounter::Count];
+		unsigned long long errors[StatCounter::Count];
+		unsigned long long nanoseconds[StatCounter::Count];
+		unsigned long long buckets[StatCounter::Count][CK_STATISTICS_BUCKETS];
+		bool owned;
+	};
+
+	// Get the counters of the calling thread
+	ThreadCounters* getThreadCounters();
+
+	// The one-and-only instance
+	static std::auto_ptr<Statistics> instance;
+
+	// Are statistics kept?
+	bool enabled;
+
+	// The counters of all threads that ever recorded a call; the counters
+	// of a thread that has exited are taken over by the next new thread
+	std::vector<ThreadCounters*> allCounters;
+
+#ifdef HAVE_PTHREAD_H
+	// Releases the counters of an exiting thread
+	static void releaseThreadCounters(void* counters);
+
+	// For thread safeness of the list of counters
+	pthread_mutex_t countersMutex;
+
+	// Refers to the counters of a thread
+	pthread_key_t countersKey;
+	bool countersKeyValid;
+#endif
+};
+
+// Measures the time spent in a scope
+class StatTimer
+{
+public:
+	// Constructor
+	StatTimer(StatCounter::Type counter);
+
+	// Destructor; records the call
+	~StatTimer();
+
+	// Mark the call as failed
+	void failed();
+
+	// Mark the call as failed if the return value is not CKR_OK and
+	// pass the return value on
+	CK_RV result(CK_RV rv);
+
+private:
+	StatCounter::Type counter;
+	unsigned long long start;
+	bool isFailed;
+};
+
+#endif // !_SOFTHSM_V2_STATISTICS_H
+
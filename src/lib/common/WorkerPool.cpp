@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ WorkerPool.cpp
+
+ Runs a batch of independent tasks on a number of worker threads. Threads are
+ only started for the duration of a batch, so no threads are left behind when
+ the library is finalised or when the process forks. The tasks are handed out
+ in order to whichever thread is free first.
+ *****************************************************************************/
+
+#include "config.h"
+#include "WorkerPool.h"
+#include "log.h"
+#include <memory>
+#include <vector>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+// The tasks of a batch that is being run
+struct WorkerBatch
+{
+	std::vector<WorkerTask*>* tasks;
+	volatile size_t next;
+};
+
+// Run tasks of the batch until all of them have been handed out
+static void* runBatch(void* arg)
+{
+	WorkerBatch* batch = (WorkerBatch*) arg;
+
+	for (;;)
+	{
+		size_t i = __sync_fetch_and_add(&batch->next, 1);
+
+		if (i >= batch->tasks->size()) break;
+
+		(*batch->tasks)[i]->run();
+	}
+
+	return NULL;
+}
+
+// Initialise the one-and-only instance
+std::auto_ptr<WorkerPool> WorkerPool::instance(NULL);
+
+// Constructor
+WorkerPool::WorkerPool()
+{
+	maxThreads = 1;
+	enabled = false;
+}
+
+// Destructor
+WorkerPool::~WorkerPool()
+{
+}
+
+// Return the one-and-only instance
+WorkerPool* WorkerPool::i()
+{
+	if (!instance.get())
+	{
+		instance = std::auto_ptr<WorkerPool>(new WorkerPool());
+	}
+
+	return instance.get();
+}
+
+// Run the tasks and wait until all of them have finished
+void WorkerPool::runTasks(std::vector<WorkerTask*>& tasks)
+{
+	WorkerBatch batch;
+	batch.tasks = &tasks;
+	batch.next = 0;
+
+#ifdef HAVE_PTHREAD_H
+	std::vector<pthread_t> threads;
+
+	if (enabled && (tasks.size() > 1))
+	{
+		// The calling thread is one of the workers
+		size_t extraThreads = (maxThreads > 1) ? maxThreads - 1 : 0;
+
+		if (extraThreads > tasks.size() - 1)
+		{
+			extraThreads = tasks.size() - 1;
+		}
+
+		for (size_t i = 0; i < extraThreads; i++)
+		{
+			pthread_t thread;
+
+			if (pthread_create(&thread, NULL, runBatch, &batch))
+			{
+				// The remaining tasks are run by the threads we do have
+				WARNING_MSG("Could not start a worker thread");
+
+				break;
+			}
+
+			threads.push_back(thread);
+		}
+	}
+#endif
+
+	runBatch(&batch);
+
+#ifdef HAVE_PTHREAD_H
+	for (std::vector<pthread_t>::iterator i = threads.begin(); i != threads.end(); i++)
+	{
+		pthread_join(*i, NULL);
+	}
+#endif
+}
+
+// Set the maximum number of threads
+void WorkerPool::setMaxThreads(int maxThreads)
+{
+	this->maxThreads = (maxThreads > 1) ? maxThreads : 1;
+}
+
+void WorkerPool::enable()
+{
+	enabled = true;
+}
+
+void WorkerPool::disable()
+{
+	enabled = false;
+}
+
+bool WorkerPool::isEnabled()
+{
+	return enabled;
+}
+
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ WorkerPool.h
+
+ Runs a batch of independent tasks on a number of worker threads, for
+ instance to load tokens and objects in parallel
+ *****************************************************************************/
+
+#ifndef _SOFTHSM_V2_WORKERPOOL_H
+#define _SOFTHSM_V2_WORKERPOOL_H
+
+#include "config.h"
+#include <memory>
+#include <vector>
+
+class WorkerTask
+{
+public:
+	// Destructor
+	virtual ~WorkerTask() { }
+
+	// Perform the task
+	virtual void run() = 0;
+};
+
+class WorkerPool
+{
+public:
+	// Return the one-and-only instance
+	static WorkerPool* i();
+
+	// Destructor
+	virtual ~WorkerPool();
+
+	// Run the tasks and wait until all of them have finished; the calling
+	// thread takes part in running the tasks and runs all of them by itself
+	// if no threads can be used
+	void runTasks(std::vector<WorkerTask*>& tasks);
+
+	// Set the maximum number of threads that run tasks, including the
+	// calling thread
+	void setMaxThreads(int maxThreads);
+
+	// Enable/disable the use of threads; threads may only be used when the
+	// application allows the library to create them and mutexes are used
+	void enable();
+	void disable();
+
+	// Check if threads may be used
+	bool isEnabled();
+
+private:
+	// Constructor
+	WorkerPool();
+
+	// The one-and-only instance
+	static std::auto_ptr<WorkerPool> instance;
+
+	// The maximum number of threads
+	int maxThreads;
+
+	// Can we use threads?
+	bool enabled;
+};
+
+#endif // !_SOFTHSM_V2_WORKERPOOL_H
+
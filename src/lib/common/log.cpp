@@ -30,48 +30,466 @@
  Implements logging functions. This file is based on the concepts from 
  SoftHSM v1 but extends the logging functions with support for a variable
  argument list as defined in stdarg (3).
+
+ Messages are formatted by the thread that logs them into a ring buffer that
+ belongs to that thread. A background thread writes the queued messages to
+ syslog or to the log file, so logging threads never wait for the output.
+ Each ring has exactly one writer and one reader, so no locks are needed to
+ queue a message. Messages that do not fit in a ring slot, or that are logged
+ while the background thread is not running, are written directly.
  *****************************************************************************/
 
 #include <stdarg.h>
 #include <syslog.h>
 #include <stdio.h>
-#include <sstream>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/time.h>
+#include <new>
 #include <vector>
 #include "config.h"
 #include "log.h"
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+// The number of messages that can be queued per thread and their maximum size
+#define LOG_RING_SLOTS		64
+#define LOG_SLOT_SIZE		1024
+
+// The interval in milliseconds at which queued messages are written
+#define LOG_DRAIN_INTERVAL	100
+
+// The log level that is in effect
+int softLogLevel = SOFTINFO;
+
+// The log file; messages go to syslog if it is not set
+static FILE* logFile = NULL;
+
+// Get the name of a syslog priority
+static const char* priorityName(int priority)
+{
+	switch (priority)
+	{
+		case LOG_ERR:
+			return "ERROR";
+		case LOG_WARNING:
+			return "WARNING";
+		case LOG_INFO:
+			return "INFO";
+		default:
+			return "DEBUG";
+	}
+}
+
+// Write a message to the log
+static void writeLog(int priority, time_t when, const char* message)
+{
+	if (logFile != NULL)
+	{
+		char timestamp[32];
+		struct tm tm;
+
+		strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime_r(&when, &tm));
+
+		fprintf(logFile, "%s %s: %s\n", timestamp, priorityName(priority), message);
+	}
+	else
+	{
+		syslog(priority, "%s", message);
+	}
+
+#ifdef DEBUG_LOG_STDERR
+	fprintf(stderr, "%s\n", message);
+	fflush(stderr);
+#endif // DEBUG_LOG_STDERR
+}
+
+#ifdef HAVE_PTHREAD_H
+// A queued message
+struct LogEntry
+{
+	int priority;
+	time_t when;
+	char message[LOG_SLOT_SIZE];
+};
+
+// The messages queued by a single thread; only the owning thread advances
+// the head and only the background thread advances the tail
+struct LogRing
+{
+	LogEntry entries[LOG_RING_SLOTS];
+	volatile unsigned long head;
+	volatile unsigned long tail;
+	volatile int owned;
+	LogRing* next;
+};
+
+// All rings that were ever created; rings are never freed but are handed to
+// a new thread once their owner has exited
+static LogRing* volatile rings = NULL;
+
+// State of the background thread
+static pthread_mutex_t drainMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t drainCond = PTHREAD_COND_INITIALIZER;
+static pthread_t drainThread;
+static volatile bool running = false;
+
+// The number of threads that are queueing a message; the background thread
+// is only stopped for good once these have published their entries
+static volatile int writers = 0;
+
+// Release the ring of an exiting thread
+static void releaseRing(void* arg)
+{
+	LogRing* ring = (LogRing*) arg;
+
+	__sync_synchronize();
+	ring->owned = 0;
+}
+
+static void stopInChild();
+
+// The thread-specific key that refers to the ring of a thread; it is created
+// and deleted along with the library
+static struct LogRingKey
+{
+	pthread_key_t key;
+	bool valid;
+
+	LogRingKey()
+	{
+		valid = (pthread_key_create(&key, releaseRing) == 0);
+
+		pthread_atfork(NULL, NULL, stopInChild);
+	}
+
+	~LogRingKey()
+	{
+		stopLogThread();
+
+		if (valid) pthread_key_delete(key);
+	}
+} ringKey;
+
+// Stop queueing in a child process, which does not have the background
+// thread. The messages that are still queued are written by the parent, and
+// only the thread that forked exists in the child
+static void stopInChild()
+{
+	pthread_mutex_init(&drainMutex, NULL);
+	pthread_cond_init(&drainCond, NULL);
+	running = false;
+	writers = 0;
+
+	LogRing* own = ringKey.valid ? (LogRing*) pthread_getspecific(ringKey.key) : NULL;
+
+	for (LogRing* ring = rings; ring != NULL; ring = ring->next)
+	{
+		ring->tail = ring->head;
+
+		if (ring != own) ring->owned = 0;
+	}
+}
+
+// Get the ring of the calling thread
+static LogRing* getRing()
+{
+	if (!ringKey.valid) return NULL;
+
+	LogRing* ring = (LogRing*) pthread_getspecific(ringKey.key);
+
+	if (ring != NULL) return ring;
+
+	// Take over the ring of a thread that has exited
+	for (ring = rings; ring != NULL; ring = ring->next)
+	{
+		if (!ring->owned && __sync_bool_compare_and_swap(&ring->owned, 0, 1)) break;
+	}
+
+	if (ring == NULL)
+	{
+		ring = new (std::nothrow) LogRing;
+
+		if (ring == NULL) return NULL;
+
+		ring->head = 0;
+		ring->tail = 0;
+		ring->owned = 1;
+
+		do
+		{
+			ring->next = rings;
+		}
+		while (!__sync_bool_compare_and_swap(&rings, ring->next, ring));
+	}
+
+	if (pthread_setspecific(ringKey.key, ring) != 0)
+	{
+		releaseRing(ring);
+
+		return NULL;
+	}
+
+	return ring;
+}
+
+// Write the queued messages of all threads
+static void drainRings()
+{
+	for (LogRing* ring = rings; ring != NULL; ring = ring->next)
+	{
+		unsigned long head = ring->head;
+		unsigned long tail = ring->tail;
+
+		if (head == tail) continue;
+
+		// Make sure the entries are read after the head
+		__sync_synchronize();
+
+		for (; tail != head; tail++)
+		{
+			LogEntry* entry = &ring->entries[tail % LOG_RING_SLOTS];
+
+			writeLog(entry->priority, entry->when, entry->message);
+		}
+
+		// Only hand the slots back once they have been written
+		__sync_synchronize();
+		ring->tail = tail;
+	}
+
+	if (logFile != NULL) fflush(logFile);
+}
+
+// The background thread
+static void* runDrain(void*)
+{
+	pthread_mutex_lock(&drainMutex);
+
+	while (running)
+	{
+		pthread_mutex_unlock(&drainMutex);
+
+		drainRings();
+
+		struct timeval now;
+		struct timespec timeout;
+
+		gettimeofday(&now, NULL);
+		timeout.tv_sec = now.tv_sec + (now.tv_usec / 1000 + LOG_DRAIN_INTERVAL) / 1000;
+		timeout.tv_nsec = ((now.tv_usec / 1000 + LOG_DRAIN_INTERVAL) % 1000) * 1000000;
+
+		pthread_mutex_lock(&drainMutex);
+
+		if (running) pthread_cond_timedwait(&drainCond, &drainMutex, &timeout);
+	}
+
+	pthread_mutex_unlock(&drainMutex);
+
+	return NULL;
+}
+
+// Put a message in the ring of the calling thread
+static bool queueEntry(int priority, const char* prepend, const char* format, va_list args)
+{
+	LogRing* ring = getRing();
+
+	if ((ring == NULL) || (ring->head - ring->tail >= LOG_RING_SLOTS)) return false;
+
+	LogEntry* entry = &ring->entries[ring->head % LOG_RING_SLOTS];
+
+	size_t prependLen = strlen(prepend);
+
+	if (prependLen >= LOG_SLOT_SIZE) return false;
+
+	memcpy(entry->message, prepend, prependLen);
+
+	int len = vsnprintf(entry->message + prependLen, LOG_SLOT_SIZE - prependLen, format, args);
+
+	if ((len < 0) || ((size_t) len >= LOG_SLOT_SIZE - prependLen)) return false;
+
+	entry->priority = priority;
+	entry->when = time(NULL);
+
+	// Make sure the entry is complete before it is published
+	__sync_synchronize();
+	ring->head++;
+
+	return true;
+}
+
+// Queue a message in the ring of the calling thread; returns false if the
+// message has to be written directly
+static bool queueLog(int priority, const char* prepend, const char* format, va_list args)
+{
+	// Register as a writer before checking if the background thread runs,
+	// so that stopLogThread either sees this thread or this thread sees
+	// that the background thread is stopping
+	__sync_fetch_and_add(&writers, 1);
+
+	bool queued = running && queueEntry(priority, prepend, format, args);
+
+	__sync_fetch_and_sub(&writers, 1);
+
+	return queued;
+}
+#endif // HAVE_PTHREAD_H
 
 void softHSMLog(const int loglevel, const char* functionName, const char* fileName, const int lineNo, const char* format, ...)
 {
-	std::stringstream prepend;
+	char prepend[256];
 
-#ifdef SOFTHSM_LOG_FILE_AND_LINE
-	prepend << fileName << "(" << lineNo << ")";
-#ifndef SOFTHSM_LOG_FUNCTION_NAME
-	prepend << ":";
-#endif // !SOFTHSM_LOG_FUNCTION_NAME
-	prepend << " ";
-#endif // SOFTHSM_LOG_FILE_AND_LINE
+	prepend[0] = '\0';
 
+#ifdef SOFTHSM_LOG_FILE_AND_LINE
 #ifdef SOFTHSM_LOG_FUNCTION_NAME
-	prepend << functionName << ": ";
+	snprintf(prepend, sizeof(prepend), "%s(%d) %s: ", fileName, lineNo, functionName);
+#else
+	snprintf(prepend, sizeof(prepend), "%s(%d): ", fileName, lineNo);
 #endif // SOFTHSM_LOG_FUNCTION_NAME
+#elif defined(SOFTHSM_LOG_FUNCTION_NAME)
+	snprintf(prepend, sizeof(prepend), "%s: ", functionName);
+#endif // SOFTHSM_LOG_FILE_AND_LINE
+
+	va_list args;
+
+#ifdef HAVE_PTHREAD_H
+	va_start(args, format);
+	bool queued = queueLog(loglevel, prepend, format, args);
+	va_end(args);
+
+	if (queued) return;
+#endif // HAVE_PTHREAD_H
 
 	// Print the format to a log message
+	va_start(args, format);
+	int len = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	if (len < 0) return;
+
 	std::vector<char> logMessage;
-	va_list args;
+	size_t prependLen = strlen(prepend);
 
-	logMessage.resize(4096);
+	logMessage.resize(prependLen + len + 1);
+	memcpy(&logMessage[0], prepend, prependLen);
 
 	va_start(args, format);
-	vsnprintf(&logMessage[0], 4096, format, args);
+	vsnprintf(&logMessage[prependLen], len + 1, format, args);
 	va_end(args);
 
 	// And log it
-	syslog(loglevel, "%s%s", prepend.str().c_str(), &logMessage[0]);
+	writeLog(loglevel, time(NULL), &logMessage[0]);
 
-#ifdef DEBUG_LOG_STDERR
-	fprintf(stderr, "%s%s\n", prepend.str().c_str(), &logMessage[0]);
-	fflush(stderr);
-#endif // DEBUG_LOG_STDERR
+	if (logFile != NULL) fflush(logFile);
+}
+
+// Set the log level
+bool setLogLevel(const std::string& loglevel)
+{
+	if (loglevel == "ERROR")
+	{
+		softLogLevel = SOFTERROR;
+	}
+	else if (loglevel == "WARNING")
+	{
+		softLogLevel = SOFTWARNING;
+	}
+	else if (loglevel == "INFO")
+	{
+		softLogLevel = SOFTINFO;
+	}
+	else if (loglevel == "DEBUG")
+	{
+		softLogLevel = SOFTDEBUG;
+	}
+	else
+	{
+		ERROR_MSG("Unknown value (%s) for log.level in configuration", loglevel.c_str());
+
+		return false;
+	}
+
+	return true;
+}
+
+// Set the log file
+bool setLogFile(const std::string& path)
+{
+	// The background thread must not write while the file is replaced
+	stopLogThread();
+
+	if (logFile != NULL)
+	{
+		fclose(logFile);
+		logFile = NULL;
+	}
+
+	if (path.empty()) return true;
+
+	logFile = fopen(path.c_str(), "a");
+
+	if (logFile == NULL)
+	{
+		ERROR_MSG("Could not open the log file %s", path.c_str());
+
+		return false;
+	}
+
+	return true;
 }
 
+// Start the background thread
+bool startLogThread()
+{
+#ifdef HAVE_PTHREAD_H
+	if (running) return true;
+
+	running = true;
+
+	if (pthread_create(&drainThread, NULL, runDrain, NULL))
+	{
+		running = false;
+
+		WARNING_MSG("Could not start the log thread");
+
+		return false;
+	}
+
+	return true;
+#else
+	return false;
+#endif // HAVE_PTHREAD_H
+}
+
+// Stop the background thread after it has written all queued messages
+void stopLogThread()
+{
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_lock(&drainMutex);
+
+	if (!running)
+	{
+		pthread_mutex_unlock(&drainMutex);
+
+		return;
+	}
+
+	running = false;
+
+	pthread_cond_signal(&drainCond);
+	pthread_mutex_unlock(&drainMutex);
+
+	pthread_join(drainThread, NULL);
+
+	// Wait for the threads that saw the background thread running to
+	// publish their messages, then write them
+	__sync_synchronize();
+
+	while (writers > 0) sched_yield();
+
+	drainRings();
+#endif // HAVE_PTHREAD_H
+}
@@ -30,12 +30,17 @@
  Implements logging functions. This file is based on the concepts from 
  SoftHSM v1 but extends the logging functions with support for a variable
  argument list as defined in stdarg (3).
+
+ SOFTLOGLEVEL determines which messages are compiled in at all; of those,
+ only the messages up to the log level that is set at runtime are formatted
+ and written.
  *****************************************************************************/
 
 #ifndef _SOFTHSM_V2_LOG_H
 #define _SOFTHSM_V2_LOG_H
 
 #include <syslog.h>
+#include <string>
 #include "config.h"
 
 /* The log levels */
@@ -49,6 +54,9 @@
 #define SOFTLOGLEVEL	SOFTDEBUG
 #endif /* !SOFTLOGLEVEL */
 
+/* The log level that is used until it is set from the configuration */
+#define DEFAULT_LOG_LEVEL	"INFO"
+
 /* Unset this define if you don't want to log the source file name and line number */
 #define SOFTHSM_LOG_FILE_AND_LINE
 
@@ -60,34 +68,48 @@
 
 /* Logging errors */
 #if SOFTLOGLEVEL >= SOFTERROR
-#define ERROR_MSG(...) softHSMLog(LOG_ERR, __func__, __FILE__, __LINE__, __VA_ARGS__);
+#define ERROR_MSG(...) do { if (softLogLevel >= SOFTERROR) softHSMLog(LOG_ERR, __func__, __FILE__, __LINE__, __VA_ARGS__); } while (0);
 #else
 #define ERROR_MSG(...)
 #endif
 
 /* Logging warnings */
 #if SOFTLOGLEVEL >= SOFTWARNING
-#define WARNING_MSG(...) softHSMLog(LOG_WARNING, __func__, __FILE__, __LINE__, __VA_ARGS__);
+#define WARNING_MSG(...) do { if (softLogLevel >= SOFTWARNING) softHSMLog(LOG_WARNING, __func__, __FILE__, __LINE__, __VA_ARGS__); } while (0);
 #else
 #define WARNING_MSG(...)
 #endif
 
 /* Logging information */
 #if SOFTLOGLEVEL >= SOFTINFO
-#define INFO_MSG(...) softHSMLog(LOG_INFO, __func__, __FILE__, __LINE__, __VA_ARGS__);
+#define INFO_MSG(...) do { if (softLogLevel >= SOFTINFO) softHSMLog(LOG_INFO, __func__, __FILE__, __LINE__, __VA_ARGS__); } while (0);
 #else
 #define INFO_MSG(...)
 #endif
 
 /* Logging debug information */
 #if SOFTLOGLEVEL >= SOFTDEBUG
-#define DEBUG_MSG(...) softHSMLog(LOG_DEBUG, __func__, __FILE__, __LINE__, __VA_ARGS__);
+#define DEBUG_MSG(...) do { if (softLogLevel >= SOFTDEBUG) softHSMLog(LOG_DEBUG, __func__, __FILE__, __LINE__, __VA_ARGS__); } while (0);
 #else
 #define DEBUG_MSG(...)
 #endif
 
+/* The log level that is in effect */
+extern int softLogLevel;
+
 /* Function definitions */
 void softHSMLog(const int loglevel, const char* functionName, const char* fileName, const int lineNo, const char* format, ...);
 
+/* Set the log level (ERROR, WARNING, INFO or DEBUG) */
+bool setLogLevel(const std::string& loglevel);
+
+/* Write to the specified file instead of syslog; an empty path selects syslog */
+bool setLogFile(const std::string& path);
+
+/* Start/stop the thread that writes queued messages; as long as it is not
+   running, messages are written by the thread that logs them */
+bool startLogThread();
+void stopLogThread();
+
 #endif /* !_SOFTHSM_V2_LOG_H */
 
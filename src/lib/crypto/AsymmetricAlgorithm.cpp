@@ -33,6 +33,7 @@
 #include "config.h"
 #include "log.h"
 #include "AsymmetricAlgorithm.h"
+#include "CryptoUtil.h"
 
 // Base constructor
 AsymmetricAlgorithm::AsymmetricAlgorithm()
@@ -40,6 +41,21 @@ AsymmetricAlgorithm::AsymmetricAlgorithm()
 	currentOperation = NONE;
 	currentPublicKey = NULL;
 	currentPrivateKey = NULL;
+	factoryType = AsymAlgo::Unknown;
+}
+
+// Prepare the instance for reuse
+bool AsymmetricAlgorithm::reset()
+{
+	if (currentOperation != NONE)
+	{
+		return false;
+	}
+
+	currentPublicKey = NULL;
+	currentPrivateKey = NULL;
+
+	return true;
 }
 
 // Signing functions
@@ -64,6 +80,11 @@ bool AsymmetricAlgorithm::signInit(PrivateKey* privateKey, const std::string mec
 }
 
 bool AsymmetricAlgorithm::signUpdate(const ByteString& dataToSign)
+{
+	return signUpdate(dataToSign.const_byte_str(), dataToSign.size());
+}
+
+bool AsymmetricAlgorithm::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
 	if (currentOperation != SIGN)
 	{
@@ -87,6 +108,30 @@ bool AsymmetricAlgorithm::signFinal(ByteString& signature)
 	return true;
 }
 
+bool AsymmetricAlgorithm::sign(PrivateKey* privateKey, const ByteString& dataToSign, unsigned char* signature, size_t& len, const std::string mechanism)
+{
+	ByteString result;
+
+	if (!sign(privateKey, dataToSign, result, mechanism))
+	{
+		return false;
+	}
+
+	return CryptoUtil::copyResult(result, signature, len);
+}
+
+bool AsymmetricAlgorithm::signFinal(unsigned char* signature, size_t& len)
+{
+	ByteString result;
+
+	if (!signFinal(result))
+	{
+		return false;
+	}
+
+	return CryptoUtil::copyResult(result, signature, len);
+}
+
 // Verification functions
 bool AsymmetricAlgorithm::verify(PublicKey* publicKey, const ByteString& originalData, const ByteString& signature, const std::string mechanism)
 {
@@ -109,6 +154,11 @@ bool AsymmetricAlgorithm::verifyInit(PublicKey* publicKey, const std::string mec
 }
 
 bool AsymmetricAlgorithm::verifyUpdate(const ByteString& originalData)
+{
+	return verifyUpdate(originalData.const_byte_str(), originalData.size());
+}
+
+bool AsymmetricAlgorithm::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
 	if (currentOperation != VERIFY)
 	{
@@ -42,6 +42,21 @@
 #include "SymmetricKey.h"
 #include "RNG.h"
 
+// The algorithms that the CryptoFactory can create
+struct AsymAlgo
+{
+	enum Type
+	{
+		Unknown,
+		RSA,
+		DSA,
+		DH,
+		ECDH,
+		ECDSA,
+		GOST
+	};
+};
+
 class AsymmetricAlgorithm
 {
 public:
@@ -51,16 +66,27 @@ public:
 	// Destructor
 	virtual ~AsymmetricAlgorithm() { }
 
+	// Prepare the instance for reuse by another operation; returns false if
+	// it cannot be reused, e.g. because an operation is still in progress
+	virtual bool reset();
+
 	// Signing functions
 	virtual bool sign(PrivateKey* privateKey, const ByteString& dataToSign, ByteString& signature, const std::string mechanism);
 	virtual bool signInit(PrivateKey* privateKey, const std::string mechanism);
-	virtual bool signUpdate(const ByteString& dataToSign);
+	bool signUpdate(const ByteString& dataToSign);
+	virtual bool signUpdate(const unsigned char* dataToSign, const size_t len);
 	virtual bool signFinal(ByteString& signature);
 
+	// Variants that write the signature to a buffer supplied by the caller;
+	// on input len is the size of the buffer, on output the size of the signature
+	virtual bool sign(PrivateKey* privateKey, const ByteString& dataToSign, unsigned char* signature, size_t& len, const std::string mechanism);
+	virtual bool signFinal(unsigned char* signature, size_t& len);
+
 	// Verification functions
 	virtual bool verify(PublicKey* publicKey, const ByteString& originalData, const ByteString& signature, const std::string mechanism);
 	virtual bool verifyInit(PublicKey* publicKey, const std::string mechanism);
-	virtual bool verifyUpdate(const ByteString& originalData);
+	bool verifyUpdate(const ByteString& originalData);
+	virtual bool verifyUpdate(const unsigned char* originalData, const size_t len);
 	virtual bool verifyFinal(const ByteString& signature);
 
 	// Encryption functions
@@ -105,6 +131,10 @@ private:
 		VERIFY
 	}
 	currentOperation;
+
+	// The type under which the CryptoFactory pools this instance
+	friend class CryptoFactory;
+	AsymAlgo::Type factoryType;
 };
 
 #endif // !_SOFTHSM_V2_ASYMMETRICALGORITHM_H
@@ -54,11 +54,11 @@ std::string BotanAES::getCipher() const
 		switch(currentKey->getBitLen())
 		{
 			case 128:
-				return "AES-128/CBC/PKCS7";
+				return "AES-128/CBC/" + getPadding();
 			case 192:
-				return "AES-192/CBC/PKCS7";
+				return "AES-192/CBC/" + getPadding();
 			case 256:
-				return "AES-256/CBC/PKCS7";
+				return "AES-256/CBC/" + getPadding();
 		};
 	}
 	else if (!currentCipherMode.compare("ecb"))
@@ -66,11 +66,23 @@ std::string BotanAES::getCipher() const
 		switch(currentKey->getBitLen())
 		{
 			case 128:
-				return "AES-128/ECB/PKCS7";
+				return "AES-128/ECB/" + getPadding();
 			case 192:
-				return "AES-192/ECB/PKCS7";
+				return "AES-192/ECB/" + getPadding();
 			case 256:
-				return "AES-256/ECB/PKCS7";
+				return "AES-256/ECB/" + getPadding();
+		};
+	}
+	else if (!currentCipherMode.compare("ctr"))
+	{
+		switch(currentKey->getBitLen())
+		{
+			case 128:
+				return "AES-128/CTR-BE";
+			case 192:
+				return "AES-192/CTR-BE";
+			case 256:
+				return "AES-256/CTR-BE";
 		};
 	}
 
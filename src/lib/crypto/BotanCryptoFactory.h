@@ -55,23 +55,24 @@ public:
 	// Return the one-and-only instance
 	static BotanCryptoFactory* i();
 
+	// Get the global RNG (may be an unique RNG per thread)
+	RNG* getRNG(std::string name = "default");
+
+	// Destructor
+	~BotanCryptoFactory();
+
+protected:
 	// Create a concrete instance of a symmetric algorithm
-	SymmetricAlgorithm* getSymmetricAlgorithm(std::string algorithm);
+	SymmetricAlgorithm* createSymmetricAlgorithm(SymAlgo::Type algorithm);
 
 	// Create a concrete instance of an asymmetric algorithm
-	AsymmetricAlgorithm* getAsymmetricAlgorithm(std::string algorithm);
+	AsymmetricAlgorithm* createAsymmetricAlgorithm(AsymAlgo::Type algorithm);
 
 	// Create a concrete instance of a hash algorithm
-	HashAlgorithm* getHashAlgorithm(std::string algorithm);
+	HashAlgorithm* createHashAlgorithm(HashAlgo::Type algorithm);
 
 	// Create a concrete instance of a MAC algorithm
-	MacAlgorithm* getMacAlgorithm(std::string algorithm);
-
-	// Get the global RNG (may be an unique RNG per thread)
-	RNG* getRNG(std::string name = "default");
-
-	// Destructor
-	~BotanCryptoFactory();
+	MacAlgorithm* createMacAlgorithm(MacAlgo::Type algorithm);
 
 private:
 	// Constructor
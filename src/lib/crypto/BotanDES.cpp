@@ -60,11 +60,11 @@ std::string BotanDES::getCipher() const
 		switch(currentKey->getBitLen())
 		{
 			case 56:
-				return "DES/CBC/PKCS7";
+				return "DES/CBC/" + getPadding();
 			case 112:
-				return "TripleDES/CBC/PKCS7";
+				return "TripleDES/CBC/" + getPadding();
 			case 168:
-				return "TripleDES/CBC/PKCS7";
+				return "TripleDES/CBC/" + getPadding();
 		};
 	}
 	else if (!currentCipherMode.compare("ecb"))
@@ -72,11 +72,11 @@ std::string BotanDES::getCipher() const
 		switch(currentKey->getBitLen())
 		{
 			case 56:
-				return "DES/ECB/PKCS7";
+				return "DES/ECB/" + getPadding();
 			case 112:
-				return "TripleDES/ECB/PKCS7";
+				return "TripleDES/ECB/" + getPadding();
 			case 168:
-				return "TripleDES/ECB/PKCS7";
+				return "TripleDES/ECB/" + getPadding();
 		};
 	}
 	else if (!currentCipherMode.compare("ofb"))
@@ -52,7 +52,7 @@ bool BotanDH::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return false;
 }
 
-bool BotanDH::signUpdate(const ByteString& dataToSign)
+bool BotanDH::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
 	ERROR_MSG("DH does not support signing");
 
@@ -74,7 +74,7 @@ bool BotanDH::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return false;
 }
 
-bool BotanDH::verifyUpdate(const ByteString& originalData)
+bool BotanDH::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
 	ERROR_MSG("DH does not support verifying");
 
@@ -218,16 +218,16 @@ bool BotanDSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return true;
 }
 
-bool BotanDSA::signUpdate(const ByteString& dataToSign)
+bool BotanDSA::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
-	if (!AsymmetricAlgorithm::signUpdate(dataToSign))
+	if (!AsymmetricAlgorithm::signUpdate(dataToSign, len))
 	{
 		return false;
 	}
 
 	try
 	{
-		signer->update(dataToSign.const_byte_str(), dataToSign.size());
+		signer->update(dataToSign, len);
 	}
 	catch (...)
 	{
@@ -435,16 +435,16 @@ bool BotanDSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return true;
 }
 
-bool BotanDSA::verifyUpdate(const ByteString& originalData)
+bool BotanDSA::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
-	if (!AsymmetricAlgorithm::verifyUpdate(originalData))
+	if (!AsymmetricAlgorithm::verifyUpdate(originalData, len))
 	{
 		return false;
 	}
 
 	try
 	{
-		verifier->update(originalData.const_byte_str(), originalData.size());
+		verifier->update(originalData, len);
 	}
 	catch (...)
 	{
@@ -53,7 +53,7 @@ bool BotanECDH::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return false;
 }
 
-bool BotanECDH::signUpdate(const ByteString& dataToSign)
+bool BotanECDH::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
 	ERROR_MSG("ECDH does not support signing");
 
@@ -75,7 +75,7 @@ bool BotanECDH::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return false;
 }
 
-bool BotanECDH::verifyUpdate(const ByteString& originalData)
+bool BotanECDH::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
 	ERROR_MSG("ECDH does not support verifying");
 
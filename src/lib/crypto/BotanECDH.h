@@ -45,12 +45,14 @@ public:
 
 	// Signing functions
 	virtual bool signInit(PrivateKey* privateKey, const std::string mechanism);
-	virtual bool signUpdate(const ByteString& dataToSign);
+	using AsymmetricAlgorithm::signUpdate;
+	virtual bool signUpdate(const unsigned char* dataToSign, const size_t len);
 	virtual bool signFinal(ByteString& signature);
 
 	// Verification functions
 	virtual bool verifyInit(PublicKey* publicKey, const std::string mechanism);
-	virtual bool verifyUpdate(const ByteString& originalData);
+	using AsymmetricAlgorithm::verifyUpdate;
+	virtual bool verifyUpdate(const unsigned char* originalData, const size_t len);
 	virtual bool verifyFinal(const ByteString& signature);
 
 	// Encryption functions
@@ -142,7 +142,7 @@ bool BotanECDSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return false;
 }
 
-bool BotanECDSA::signUpdate(const ByteString& dataToSign)
+bool BotanECDSA::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
 	ERROR_MSG("ECDSA does not support multi part signing");
 
@@ -237,7 +237,7 @@ bool BotanECDSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return false;
 }
 
-bool BotanECDSA::verifyUpdate(const ByteString& originalData)
+bool BotanECDSA::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
 	ERROR_MSG("ECDSA does not support multi part verifying");
 
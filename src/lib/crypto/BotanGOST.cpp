@@ -128,16 +128,16 @@ bool BotanGOST::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return true;
 }
 
-bool BotanGOST::signUpdate(const ByteString& dataToSign)
+bool BotanGOST::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
-	if (!AsymmetricAlgorithm::signUpdate(dataToSign))
+	if (!AsymmetricAlgorithm::signUpdate(dataToSign, len))
 	{
 		return false;
 	}
 
 	try
 	{
-		signer->update(dataToSign.const_byte_str(), dataToSign.size());
+		signer->update(dataToSign, len);
 	}
 	catch (...)
 	{
@@ -257,16 +257,16 @@ bool BotanGOST::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return true;
 }
 
-bool BotanGOST::verifyUpdate(const ByteString& originalData)
+bool BotanGOST::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
-	if (!AsymmetricAlgorithm::verifyUpdate(originalData))
+	if (!AsymmetricAlgorithm::verifyUpdate(originalData, len))
 	{
 		return false;
 	}
 
 	try
 	{
-		verifier->update(originalData.const_byte_str(), originalData.size());
+		verifier->update(originalData, len);
 	}
 	catch (...)
 	{
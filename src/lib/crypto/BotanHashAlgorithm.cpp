@@ -79,9 +79,9 @@ bool BotanHashAlgorithm::hashInit()
 	return true;
 }
 
-bool BotanHashAlgorithm::hashUpdate(const ByteString& data)
+bool BotanHashAlgorithm::hashUpdate(const unsigned char* data, const size_t len)
 {
-	if (!HashAlgorithm::hashUpdate(data))
+	if (!HashAlgorithm::hashUpdate(data, len))
 	{
 		return false;
 	}
@@ -89,7 +89,7 @@ bool BotanHashAlgorithm::hashUpdate(const ByteString& data)
 	// Continue digesting
 	try
 	{
-		hash->update(data.const_byte_str(), data.size());
+		hash->update(data, len);
 	}
 	catch (...)
 	{
@@ -106,18 +106,40 @@ bool BotanHashAlgorithm::hashUpdate(const ByteString& data)
 
 bool BotanHashAlgorithm::hashFinal(ByteString& hashedData)
 {
-	if (!HashAlgorithm::hashFinal(hashedData))
+	// Resize
+	hashedData.resize(getHashSize());
+	size_t outLen = hashedData.size();
+
+	if (!hashFinal(&hashedData[0], outLen))
 	{
 		return false;
 	}
 
-	// Resize
-	hashedData.resize(hash->output_length());
+	hashedData.resize(outLen);
+
+	return true;
+}
+
+bool BotanHashAlgorithm::hashFinal(unsigned char* hashedData, size_t& len)
+{
+	ByteString dummy;
+
+	if (!HashAlgorithm::hashFinal(dummy))
+	{
+		return false;
+	}
+
+	if (len < hash->output_length())
+	{
+		ERROR_MSG("The output buffer is too small (%d bytes, need %d bytes)", len, hash->output_length());
+
+		return false;
+	}
 
 	// Read the digest
 	try
 	{
-		hash->final(&hashedData[0]);
+		hash->final(hashedData);
 	}
 	catch (...)
 	{
@@ -126,5 +148,7 @@ bool BotanHashAlgorithm::hashFinal(ByteString& hashedData)
 		return false;
 	}
 
+	len = hash->output_length();
+
 	return true;
 }
@@ -96,9 +96,9 @@ bool BotanMacAlgorithm::signInit(const SymmetricKey* key)
 	return true;
 }
 
-bool BotanMacAlgorithm::signUpdate(const ByteString& dataToSign)
+bool BotanMacAlgorithm::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
-	if (!MacAlgorithm::signUpdate(dataToSign))
+	if (!MacAlgorithm::signUpdate(dataToSign, len))
 	{
 		delete hmac;
 		hmac = NULL;
@@ -108,7 +108,7 @@ bool BotanMacAlgorithm::signUpdate(const ByteString& dataToSign)
 
 	try
 	{
-		hmac->update(dataToSign.const_byte_str(), dataToSign.size());
+		hmac->update(dataToSign, len);
 	}
 	catch (...)
 	{
@@ -203,9 +203,9 @@ bool BotanMacAlgorithm::verifyInit(const SymmetricKey* key)
 	return true;
 }
 
-bool BotanMacAlgorithm::verifyUpdate(const ByteString& originalData)
+bool BotanMacAlgorithm::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
-	if (!MacAlgorithm::verifyUpdate(originalData))
+	if (!MacAlgorithm::verifyUpdate(originalData, len))
 	{
 		delete hmac;
 		hmac = NULL;
@@ -215,7 +215,7 @@ bool BotanMacAlgorithm::verifyUpdate(const ByteString& originalData)
 
 	try
 	{
-		hmac->update(originalData.const_byte_str(), originalData.size());
+		hmac->update(originalData, len);
 	}
 	catch (...)
 	{
@@ -50,12 +50,14 @@ public:
 
 	// Signing functions
 	virtual bool signInit(const SymmetricKey* key);
-	virtual bool signUpdate(const ByteString& dataToSign);
+	using MacAlgorithm::signUpdate;
+	virtual bool signUpdate(const unsigned char* dataToSign, const size_t len);
 	virtual bool signFinal(ByteString& signature);
 
 	// Verification functions
 	virtual bool verifyInit(const SymmetricKey* key);
-	virtual bool verifyUpdate(const ByteString& originalData);
+	using MacAlgorithm::verifyUpdate;
+	virtual bool verifyUpdate(const unsigned char* originalData, const size_t len);
 	virtual bool verifyFinal(ByteString& signature);
 
 	// Return the MAC size
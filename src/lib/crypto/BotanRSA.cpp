@@ -227,16 +227,16 @@ bool BotanRSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return true;
 }
 
-bool BotanRSA::signUpdate(const ByteString& dataToSign)
+bool BotanRSA::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
-	if (!AsymmetricAlgorithm::signUpdate(dataToSign))
+	if (!AsymmetricAlgorithm::signUpdate(dataToSign, len))
 	{
 		return false;
 	}
 
 	try
 	{
-		signer->update(dataToSign.const_byte_str(), dataToSign.size());
+		signer->update(dataToSign, len);
 	}
 	catch (...)
 	{
@@ -455,16 +455,16 @@ bool BotanRSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return true;
 }
 
-bool BotanRSA::verifyUpdate(const ByteString& originalData)
+bool BotanRSA::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
-	if (!AsymmetricAlgorithm::verifyUpdate(originalData))
+	if (!AsymmetricAlgorithm::verifyUpdate(originalData, len))
 	{
 		return false;
 	}
 
 	try
 	{
-		verifier->update(originalData.const_byte_str(), originalData.size());
+		verifier->update(originalData, len);
 	}
 	catch (...)
 	{
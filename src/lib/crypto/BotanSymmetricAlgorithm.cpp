@@ -54,14 +54,25 @@ BotanSymmetricAlgorithm::~BotanSymmetricAlgorithm()
 }
 
 // Encryption functions
-bool BotanSymmetricAlgorithm::encryptInit(const SymmetricKey* key, const std::string mode /* = "cbc" */, const ByteString& IV /* = ByteString()*/)
+bool BotanSymmetricAlgorithm::encryptInit(const SymmetricKey* key, const std::string mode /* = "cbc" */, const ByteString& IV /* = ByteString()*/, bool padding /* = true */, size_t counterBits /* = 0 */, const ByteString& aad /* = ByteString() */, size_t tagBytes /* = 0 */)
 {
 	// Call the superclass initialiser
-	if (!SymmetricAlgorithm::encryptInit(key, mode, IV))
+	if (!SymmetricAlgorithm::encryptInit(key, mode, IV, padding, counterBits, aad, tagBytes))
 	{
 		return false;
 	}
 
+	// GCM mode is not available through the Botan pipe interface
+	if (!currentCipherMode.compare("gcm"))
+	{
+		ERROR_MSG("GCM mode is not supported");
+
+		ByteString dummy;
+		SymmetricAlgorithm::encryptFinal(dummy);
+
+		return false;
+	}
+
 	// Check the IV
 	if ((IV.size() > 0) && (IV.size() != getBlockSize()))
 	{
@@ -223,11 +234,22 @@ bool BotanSymmetricAlgorithm::encryptFinal(ByteString& encryptedData)
 }
 
 // Decryption functions
-bool BotanSymmetricAlgorithm::decryptInit(const SymmetricKey* key, const std::string mode /* = "cbc" */, const ByteString& IV /* = ByteString() */)
+bool BotanSymmetricAlgorithm::decryptInit(const SymmetricKey* key, const std::string mode /* = "cbc" */, const ByteString& IV /* = ByteString() */, bool padding /* = true */, size_t counterBits /* = 0 */, const ByteString& aad /* = ByteString() */, size_t tagBytes /* = 0 */)
 {
 	// Call the superclass initialiser
-	if (!SymmetricAlgorithm::decryptInit(key, mode, IV))
+	if (!SymmetricAlgorithm::decryptInit(key, mode, IV, padding, counterBits, aad, tagBytes))
+	{
+		return false;
+	}
+
+	// GCM mode is not available through the Botan pipe interface
+	if (!currentCipherMode.compare("gcm"))
 	{
+		ERROR_MSG("GCM mode is not supported");
+
+		ByteString dummy;
+		SymmetricAlgorithm::decryptFinal(dummy);
+
 		return false;
 	}
 
@@ -391,3 +413,8 @@ bool BotanSymmetricAlgorithm::decryptFinal(ByteString& data)
 	return true;
 }
 
+// Return the padding scheme for block modes
+std::string BotanSymmetricAlgorithm::getPadding() const
+{
+	return currentPaddingMode ? "PKCS7" : "NoPadding";
+}
@@ -34,6 +34,9 @@
 
 #include "config.h"
 #include "CryptoFactory.h"
+#include "log.h"
+#include "Statistics.h"
+#include <algorithm>
 
 #if defined(WITH_OPENSSL)
 
@@ -61,30 +64,354 @@ CryptoFactory* CryptoFactory::i()
 
 #endif
 
-// Recycle a symmetric algorithm instance -- override this function in the derived
-// class if you need to perform specific clean-up
+// Take an idle instance of the specified type from a pool
+template<class T> static T* takeFromPool(std::map<int, std::vector<T*> >& pool, int type)
+{
+	typename std::map<int, std::vector<T*> >::iterator i = pool.find(type);
+
+	if ((i == pool.end()) || i->second.empty())
+	{
+		return NULL;
+	}
+
+	T* instance = i->second.back();
+	i->second.pop_back();
+
+	return instance;
+}
+
+// Return an instance to a pool; returns false if the pool is full
+template<class T> static bool returnToPool(std::map<int, std::vector<T*> >& pool, int type, T* instance)
+{
+	std::vector<T*>& idle = pool[type];
+
+	if (idle.size() >= CryptoFactory::POOL_SIZE)
+	{
+		return false;
+	}
+
+	idle.push_back(instance);
+
+	return true;
+}
+
+// Delete all instances in a pool
+template<class T> static void clearPool(std::map<int, std::vector<T*> >& pool)
+{
+	for (typename std::map<int, std::vector<T*> >::iterator i = pool.begin(); i != pool.end(); i++)
+	{
+		for (size_t j = 0; j < i->second.size(); j++)
+		{
+			delete i->second[j];
+		}
+	}
+
+	pool.clear();
+}
+
+// Convert an algorithm name to its lower case form
+static std::string toLower(const std::string& name)
+{
+	std::string lcName;
+	lcName.resize(name.size());
+	std::transform(name.begin(), name.end(), lcName.begin(), tolower);
+
+	return lcName;
+}
+
+// Constructor
+CryptoFactory::CryptoFactory()
+{
+	poolKeyValid = (pthread_key_create(&poolKey, releaseThreadPool) == 0);
+
+	if (!poolKeyValid)
+	{
+		ERROR_MSG("Could not create the key for the algorithm pools; instances will not be reused");
+	}
+}
+
+// Destructor
+CryptoFactory::~CryptoFactory()
+{
+	if (!poolKeyValid) return;
+
+	clearThreadPool();
+
+	pthread_key_delete(poolKey);
+}
+
+// Delete the idle instances of the calling thread
+void CryptoFactory::clearThreadPool()
+{
+	if (!poolKeyValid) return;
+
+	ThreadPool* pool = (ThreadPool*) pthread_getspecific(poolKey);
+
+	if (pool != NULL)
+	{
+		pthread_setspecific(poolKey, NULL);
+
+		releaseThreadPool(pool);
+	}
+}
+
+// Get the pool of the calling thread
+CryptoFactory::ThreadPool* CryptoFactory::getThreadPool()
+{
+	if (!poolKeyValid) return NULL;
+
+	ThreadPool* pool = (ThreadPool*) pthread_getspecific(poolKey);
+
+	if (pool != NULL) return pool;
+
+	pool = new ThreadPool();
+
+	if (pthread_setspecific(poolKey, pool) != 0)
+	{
+		delete pool;
+
+		return NULL;
+	}
+
+	return pool;
+}
+
+// Delete the instances in the pool of a thread that exits
+/*static*/ void CryptoFactory::releaseThreadPool(void* pool)
+{
+	ThreadPool* threadPool = (ThreadPool*) pool;
+
+	clearPool(threadPool->symmetric);
+	clearPool(threadPool->asymmetric);
+	clearPool(threadPool->hash);
+	clearPool(threadPool->mac);
+
+	delete threadPool;
+}
+
+// Get an instance of a symmetric algorithm
+SymmetricAlgorithm* CryptoFactory::getSymmetricAlgorithm(SymAlgo::Type algorithm)
+{
+	StatTimer timer(StatCounter::CryptoFactoryGet);
+	ThreadPool* pool = getThreadPool();
+	SymmetricAlgorithm* instance = NULL;
+
+	if (pool != NULL)
+	{
+		instance = takeFromPool(pool->symmetric, algorithm);
+	}
+
+	if (instance == NULL)
+	{
+		instance = createSymmetricAlgorithm(algorithm);
+
+		if (instance == NULL) return NULL;
+
+		instance->factoryType = algorithm;
+	}
+
+	return instance;
+}
+
+SymmetricAlgorithm* CryptoFactory::getSymmetricAlgorithm(std::string algorithm)
+{
+	std::string lcAlgo = toLower(algorithm);
+
+	if (!lcAlgo.compare("aes")) return getSymmetricAlgorithm(SymAlgo::AES);
+	if (!lcAlgo.compare("des")) return getSymmetricAlgorithm(SymAlgo::DES);
+	if (!lcAlgo.compare("3des")) return getSymmetricAlgorithm(SymAlgo::DES3);
+
+	// No algorithm implementation is available
+	ERROR_MSG("Unknown algorithm '%s'", algorithm.c_str());
+
+	return NULL;
+}
+
+// Recycle a symmetric algorithm instance
 void CryptoFactory::recycleSymmetricAlgorithm(SymmetricAlgorithm* toRecycle)
 {
-	delete toRecycle;
+	if (toRecycle == NULL) return;
+
+	StatTimer timer(StatCounter::CryptoFactoryRecycle);
+	ThreadPool* pool = getThreadPool();
+
+	if ((pool == NULL) ||
+	    !toRecycle->reset() ||
+	    !returnToPool(pool->symmetric, toRecycle->factoryType, toRecycle))
+	{
+		delete toRecycle;
+	}
 }
-	
-// Recycle an asymmetric algorithm instance -- override this function in the derived
-// class if you need to perform specific clean-up
+
+// Get an instance of an asymmetric algorithm
+AsymmetricAlgorithm* CryptoFactory::getAsymmetricAlgorithm(AsymAlgo::Type algorithm)
+{
+	StatTimer timer(StatCounter::CryptoFactoryGet);
+	ThreadPool* pool = getThreadPool();
+	AsymmetricAlgorithm* instance = NULL;
+
+	if (pool != NULL)
+	{
+		instance = takeFromPool(pool->asymmetric, algorithm);
+	}
+
+	if (instance == NULL)
+	{
+		instance = createAsymmetricAlgorithm(algorithm);
+
+		if (instance == NULL) return NULL;
+
+		instance->factoryType = algorithm;
+	}
+
+	return instance;
+}
+
+AsymmetricAlgorithm* CryptoFactory::getAsymmetricAlgorithm(std::string algorithm)
+{
+	std::string lcAlgo = toLower(algorithm);
+
+	if (!lcAlgo.compare("rsa")) return getAsymmetricAlgorithm(AsymAlgo::RSA);
+	if (!lcAlgo.compare("dsa")) return getAsymmetricAlgorithm(AsymAlgo::DSA);
+	if (!lcAlgo.compare("dh")) return getAsymmetricAlgorithm(AsymAlgo::DH);
+	if (!lcAlgo.compare("ecdh")) return getAsymmetricAlgorithm(AsymAlgo::ECDH);
+	if (!lcAlgo.compare("ecdsa")) return getAsymmetricAlgorithm(AsymAlgo::ECDSA);
+	if (!lcAlgo.compare("gost")) return getAsymmetricAlgorithm(AsymAlgo::GOST);
+
+	// No algorithm implementation is available
+	ERROR_MSG("Unknown algorithm '%s'", algorithm.c_str());
+
+	return NULL;
+}
+
+// Recycle an asymmetric algorithm instance
 void CryptoFactory::recycleAsymmetricAlgorithm(AsymmetricAlgorithm* toRecycle)
 {
-	delete toRecycle;
+	if (toRecycle == NULL) return;
+
+	StatTimer timer(StatCounter::CryptoFactoryRecycle);
+	ThreadPool* pool = getThreadPool();
+
+	if ((pool == NULL) ||
+	    !toRecycle->reset() ||
+	    !returnToPool(pool->asymmetric, toRecycle->factoryType, toRecycle))
+	{
+		delete toRecycle;
+	}
 }
 
-// Recycle a hash algorithm instance -- override this function in the derived
-// class if you need to perform specific clean-up
+// Get an instance of a hash algorithm
+HashAlgorithm* CryptoFactory::getHashAlgorithm(HashAlgo::Type algorithm)
+{
+	StatTimer timer(StatCounter::CryptoFactoryGet);
+	ThreadPool* pool = getThreadPool();
+	HashAlgorithm* instance = NULL;
+
+	if (pool != NULL)
+	{
+		instance = takeFromPool(pool->hash, algorithm);
+	}
+
+	if (instance == NULL)
+	{
+		instance = createHashAlgorithm(algorithm);
+
+		if (instance == NULL) return NULL;
+
+		instance->factoryType = algorithm;
+	}
+
+	return instance;
+}
+
+HashAlgorithm* CryptoFactory::getHashAlgorithm(std::string algorithm)
+{
+	std::string lcAlgo = toLower(algorithm);
+
+	if (!lcAlgo.compare("md5")) return getHashAlgorithm(HashAlgo::MD5);
+	if (!lcAlgo.compare("sha1")) return getHashAlgorithm(HashAlgo::SHA1);
+	if (!lcAlgo.compare("sha224")) return getHashAlgorithm(HashAlgo::SHA224);
+	if (!lcAlgo.compare("sha256")) return getHashAlgorithm(HashAlgo::SHA256);
+	if (!lcAlgo.compare("sha384")) return getHashAlgorithm(HashAlgo::SHA384);
+	if (!lcAlgo.compare("sha512")) return getHashAlgorithm(HashAlgo::SHA512);
+	if (!lcAlgo.compare("gost")) return getHashAlgorithm(HashAlgo::GOST);
+
+	// No algorithm implementation is available
+	ERROR_MSG("Unknown algorithm '%s'", algorithm.c_str());
+
+	return NULL;
+}
+
+// Recycle a hash algorithm instance
 void CryptoFactory::recycleHashAlgorithm(HashAlgorithm* toRecycle)
 {
-	delete toRecycle;
+	if (toRecycle == NULL) return;
+
+	StatTimer timer(StatCounter::CryptoFactoryRecycle);
+	ThreadPool* pool = getThreadPool();
+
+	if ((pool == NULL) ||
+	    !toRecycle->reset() ||
+	    !returnToPool(pool->hash, toRecycle->factoryType, toRecycle))
+	{
+		delete toRecycle;
+	}
+}
+
+// Get an instance of a MAC algorithm
+MacAlgorithm* CryptoFactory::getMacAlgorithm(MacAlgo::Type algorithm)
+{
+	StatTimer timer(StatCounter::CryptoFactoryGet);
+	ThreadPool* pool = getThreadPool();
+	MacAlgorithm* instance = NULL;
+
+	if (pool != NULL)
+	{
+		instance = takeFromPool(pool->mac, algorithm);
+	}
+
+	if (instance == NULL)
+	{
+		instance = createMacAlgorithm(algorithm);
+
+		if (instance == NULL) return NULL;
+
+		instance->factoryType = algorithm;
+	}
+
+	return instance;
+}
+
+MacAlgorithm* CryptoFactory::getMacAlgorithm(std::string algorithm)
+{
+	std::string lcAlgo = toLower(algorithm);
+
+	if (!lcAlgo.compare("hmac-md5")) return getMacAlgorithm(MacAlgo::HMAC_MD5);
+	if (!lcAlgo.compare("hmac-sha1")) return getMacAlgorithm(MacAlgo::HMAC_SHA1);
+	if (!lcAlgo.compare("hmac-sha224")) return getMacAlgorithm(MacAlgo::HMAC_SHA224);
+	if (!lcAlgo.compare("hmac-sha256")) return getMacAlgorithm(MacAlgo::HMAC_SHA256);
+	if (!lcAlgo.compare("hmac-sha384")) return getMacAlgorithm(MacAlgo::HMAC_SHA384);
+	if (!lcAlgo.compare("hmac-sha512")) return getMacAlgorithm(MacAlgo::HMAC_SHA512);
+	if (!lcAlgo.compare("hmac-gost")) return getMacAlgorithm(MacAlgo::HMAC_GOST);
+
+	// No algorithm implementation is available
+	ERROR_MSG("Unknown algorithm '%s'", algorithm.c_str());
+
+	return NULL;
 }
 
-// Recycle a MAC algorithm instance -- override this function in the derived
-// class if you need to perform specific clean-up
+// Recycle a MAC algorithm instance
 void CryptoFactory::recycleMacAlgorithm(MacAlgorithm* toRecycle)
 {
-	delete toRecycle;
+	if (toRecycle == NULL) return;
+
+	StatTimer timer(StatCounter::CryptoFactoryRecycle);
+	ThreadPool* pool = getThreadPool();
+
+	if ((pool == NULL) ||
+	    !toRecycle->reset() ||
+	    !returnToPool(pool->mac, toRecycle->factoryType, toRecycle))
+	{
+		delete toRecycle;
+	}
 }
@@ -41,6 +41,10 @@
 #include "HashAlgorithm.h"
 #include "MacAlgorithm.h"
 #include "RNG.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <pthread.h>
 
 class CryptoFactory
 {
@@ -48,41 +52,93 @@ public:
 	// Return the one-and-only instance
 	static CryptoFactory* i();
 
-	// Create a concrete instance of a symmetric algorithm
-	virtual SymmetricAlgorithm* getSymmetricAlgorithm(std::string algorithm) = 0;
+	// Get an instance of a symmetric algorithm; instances are taken from a
+	// pool of the calling thread if one is available
+	SymmetricAlgorithm* getSymmetricAlgorithm(SymAlgo::Type algorithm);
+
+	// Get an instance of a symmetric algorithm by its name
+	SymmetricAlgorithm* getSymmetricAlgorithm(std::string algorithm);
 
-	// Recycle a symmetric algorithm instance -- override this function in the derived
-	// class if you need to perform specific clean-up
+	// Recycle a symmetric algorithm instance; the instance is reset and
+	// returned to the pool of the calling thread, or deleted if it cannot be reused
 	virtual void recycleSymmetricAlgorithm(SymmetricAlgorithm* toRecycle);
 
-	// Create a concrete instance of an asymmetric algorithm
-	virtual AsymmetricAlgorithm* getAsymmetricAlgorithm(std::string algorithm) = 0;
+	// Get an instance of an asymmetric algorithm
+	AsymmetricAlgorithm* getAsymmetricAlgorithm(AsymAlgo::Type algorithm);
 
-	// Recycle an asymmetric algorithm instance -- override this function in the derived
-	// class if you need to perform specific clean-up
+	// Get an instance of an asymmetric algorithm by its name
+	AsymmetricAlgorithm* getAsymmetricAlgorithm(std::string algorithm);
+
+	// Recycle an asymmetric algorithm instance
 	virtual void recycleAsymmetricAlgorithm(AsymmetricAlgorithm* toRecycle);
 
-	// Create a concrete instance of a hash algorithm
-	virtual HashAlgorithm* getHashAlgorithm(std::string algorithm) = 0;
+	// Get an instance of a hash algorithm
+	HashAlgorithm* getHashAlgorithm(HashAlgo::Type algorithm);
 
-	// Recycle a hash algorithm instance -- override this function in the derived
-	// class if you need to perform specific clean-up
+	// Get an instance of a hash algorithm by its name
+	HashAlgorithm* getHashAlgorithm(std::string algorithm);
+
+	// Recycle a hash algorithm instance
 	virtual void recycleHashAlgorithm(HashAlgorithm* toRecycle);
 
-	// Create a concrete instance of a MAC algorithm
-	virtual MacAlgorithm* getMacAlgorithm(std::string algorithm) = 0;
+	// Get an instance of a MAC algorithm
+	MacAlgorithm* getMacAlgorithm(MacAlgo::Type algorithm);
+
+	// Get an instance of a MAC algorithm by its name
+	MacAlgorithm* getMacAlgorithm(std::string algorithm);
 
-	// Recycle a MAC algorithm instance -- override this function in the derived
-	// class if you need to perform specific clean-up
+	// Recycle a MAC algorithm instance
 	virtual void recycleMacAlgorithm(MacAlgorithm* toRecycle);
 
 	// Get the global RNG (may be an unique RNG per thread)
 	virtual RNG* getRNG(std::string name = "default") = 0;
 
 	// Destructor
-	virtual ~CryptoFactory() { }
+	virtual ~CryptoFactory();
+
+	// The maximum number of idle instances of an algorithm a thread keeps
+	static const size_t POOL_SIZE = 4;
+
+protected:
+	// Constructor
+	CryptoFactory();
+
+	// Delete the idle instances of the calling thread; the instances of other
+	// threads are deleted when these threads exit. Derived classes call this
+	// before shutting down the cryptographic library
+	void clearThreadPool();
+
+	// Create a concrete instance of a symmetric algorithm
+	virtual SymmetricAlgorithm* createSymmetricAlgorithm(SymAlgo::Type algorithm) = 0;
+
+	// Create a concrete instance of an asymmetric algorithm
+	virtual AsymmetricAlgorithm* createAsymmetricAlgorithm(AsymAlgo::Type algorithm) = 0;
+
+	// Create a concrete instance of a hash algorithm
+	virtual HashAlgorithm* createHashAlgorithm(HashAlgo::Type algorithm) = 0;
+
+	// Create a concrete instance of a MAC algorithm
+	virtual MacAlgorithm* createMacAlgorithm(MacAlgo::Type algorithm) = 0;
 
 private:
+	// The idle instances of a thread, by algorithm type
+	struct ThreadPool
+	{
+		std::map<int, std::vector<SymmetricAlgorithm*> > symmetric;
+		std::map<int, std::vector<AsymmetricAlgorithm*> > asymmetric;
+		std::map<int, std::vector<HashAlgorithm*> > hash;
+		std::map<int, std::vector<MacAlgorithm*> > mac;
+	};
+
+	// Get the pool of the calling thread; creates it if needed
+	ThreadPool* getThreadPool();
+
+	// Delete the instances in the pool of a thread that exits
+	static void releaseThreadPool(void* pool);
+
+	// The key of the thread pools
+	pthread_key_t poolKey;
+	bool poolKeyValid;
 };
 
 #endif // !_SOFTHSM_V2_CRYPTOFACTORY_H
@@ -31,12 +31,21 @@
  *****************************************************************************/
 
 #include "config.h"
+#include "log.h"
 #include "HashAlgorithm.h"
+#include "CryptoUtil.h"
 
 // Base constructor
 HashAlgorithm::HashAlgorithm()
 {
 	currentOperation = NONE;
+	factoryType = HashAlgo::Unknown;
+}
+
+// Prepare the instance for reuse
+bool HashAlgorithm::reset()
+{
+	return (currentOperation == NONE);
 }
 
 // Hashing functions
@@ -53,6 +62,11 @@ bool HashAlgorithm::hashInit()
 }
 
 bool HashAlgorithm::hashUpdate(const ByteString& data)
+{
+	return hashUpdate(data.const_byte_str(), data.size());
+}
+
+bool HashAlgorithm::hashUpdate(const unsigned char* data, const size_t len)
 {
 	if (currentOperation != HASHING)
 	{
@@ -74,3 +88,15 @@ bool HashAlgorithm::hashFinal(ByteString& hashedData)
 	return true;
 }
 
+bool HashAlgorithm::hashFinal(unsigned char* hashedData, size_t& len)
+{
+	ByteString result;
+
+	if (!hashFinal(result))
+	{
+		return false;
+	}
+
+	return CryptoUtil::copyResult(result, hashedData, len);
+}
+
@@ -36,6 +36,22 @@
 #include "config.h"
 #include "ByteString.h"
 
+// The algorithms that the CryptoFactory can create
+struct HashAlgo
+{
+	enum Type
+	{
+		Unknown,
+		MD5,
+		SHA1,
+		SHA224,
+		SHA256,
+		SHA384,
+		SHA512,
+		GOST
+	};
+};
+
 class HashAlgorithm
 {
 public:
@@ -45,11 +61,20 @@ public:
 	// Destructor
 	virtual ~HashAlgorithm() { }
 
+	// Prepare the instance for reuse by another operation; returns false if
+	// it cannot be reused, e.g. because an operation is still in progress
+	virtual bool reset();
+
 	// Hashing functions
 	virtual bool hashInit();
-	virtual bool hashUpdate(const ByteString& data);
+	bool hashUpdate(const ByteString& data);
+	virtual bool hashUpdate(const unsigned char* data, const size_t len);
 	virtual bool hashFinal(ByteString& hashedData);
 
+	// Write the hash to a buffer supplied by the caller; on input len is
+	// the size of the buffer, on output the size of the hash
+	virtual bool hashFinal(unsigned char* hashedData, size_t& len);
+
 	virtual int getHashSize() = 0;
 protected:
 	// The current operation
@@ -59,6 +84,11 @@ protected:
 		HASHING
 	}
 	currentOperation;
+
+private:
+	// The type under which the CryptoFactory pools this instance
+	friend class CryptoFactory;
+	HashAlgo::Type factoryType;
 };
 
 #endif // !_SOFTHSM_V2_HASHALGORITHM_H
@@ -30,7 +30,9 @@
  Base class for MAC algorithm classes
  *****************************************************************************/
 
+#include "log.h"
 #include "MacAlgorithm.h"
+#include "CryptoUtil.h"
 #include <algorithm>
 #include <string.h>
 
@@ -38,6 +40,20 @@ MacAlgorithm::MacAlgorithm()
 {
 	currentOperation = NONE;
 	currentKey = NULL;
+	factoryType = MacAlgo::Unknown;
+}
+
+// Prepare the instance for reuse
+bool MacAlgorithm::reset()
+{
+	if (currentOperation != NONE)
+	{
+		return false;
+	}
+
+	currentKey = NULL;
+
+	return true;
 }
 
 bool MacAlgorithm::signInit(const SymmetricKey* key)
@@ -54,6 +70,11 @@ bool MacAlgorithm::signInit(const SymmetricKey* key)
 }
 
 bool MacAlgorithm::signUpdate(const ByteString& dataToSign)
+{
+	return signUpdate(dataToSign.const_byte_str(), dataToSign.size());
+}
+
+bool MacAlgorithm::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
 	if (currentOperation != SIGN)
 	{
@@ -76,6 +97,18 @@ bool MacAlgorithm::signFinal(ByteString& signature)
 	return true;
 }
 
+bool MacAlgorithm::signFinal(unsigned char* signature, size_t& len)
+{
+	ByteString result;
+
+	if (!signFinal(result))
+	{
+		return false;
+	}
+
+	return CryptoUtil::copyResult(result, signature, len);
+}
+
 bool MacAlgorithm::verifyInit(const SymmetricKey* key)
 {
 	if ((key == NULL) || (currentOperation != NONE))
@@ -90,6 +123,11 @@ bool MacAlgorithm::verifyInit(const SymmetricKey* key)
 }
 
 bool MacAlgorithm::verifyUpdate(const ByteString& originalData)
+{
+	return verifyUpdate(originalData.const_byte_str(), originalData.size());
+}
+
+bool MacAlgorithm::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
 	if (currentOperation != VERIFY)
 	{
@@ -38,6 +38,22 @@
 #include "SymmetricKey.h"
 #include "RNG.h"
 
+// The algorithms that the CryptoFactory can create
+struct MacAlgo
+{
+	enum Type
+	{
+		Unknown,
+		HMAC_MD5,
+		HMAC_SHA1,
+		HMAC_SHA224,
+		HMAC_SHA256,
+		HMAC_SHA384,
+		HMAC_SHA512,
+		HMAC_GOST
+	};
+};
+
 class MacAlgorithm
 {
 public:
@@ -47,14 +63,24 @@ public:
 	// Destructor
 	virtual ~MacAlgorithm() { }
 
+	// Prepare the instance for reuse by another operation; returns false if
+	// it cannot be reused, e.g. because an operation is still in progress
+	virtual bool reset();
+
 	// Signing functions
 	virtual bool signInit(const SymmetricKey* key);
-	virtual bool signUpdate(const ByteString& dataToSign);
+	bool signUpdate(const ByteString& dataToSign);
+	virtual bool signUpdate(const unsigned char* dataToSign, const size_t len);
 	virtual bool signFinal(ByteString& signature);
 
+	// Write the signature to a buffer supplied by the caller; on input len
+	// is the size of the buffer, on output the size of the signature
+	virtual bool signFinal(unsigned char* signature, size_t& len);
+
 	// Verification functions
 	virtual bool verifyInit(const SymmetricKey* key);
-	virtual bool verifyUpdate(const ByteString& originalData);
+	bool verifyUpdate(const ByteString& originalData);
+	virtual bool verifyUpdate(const unsigned char* originalData, const size_t len);
 	virtual bool verifyFinal(ByteString& signature);
 
 	// Key
@@ -78,6 +104,10 @@ private:
 		VERIFY
 	} 
 	currentOperation;
+
+	// The type under which the CryptoFactory pools this instance
+	friend class CryptoFactory;
+	MacAlgo::Type factoryType;
 };
 
 #endif // !_SOFTHSM_V2_MACALGORITHM_H
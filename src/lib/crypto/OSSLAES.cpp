@@ -73,6 +73,33 @@ const EVP_CIPHER* OSSLAES::getCipher() const
 				return EVP_aes_256_ecb();
 		};
 	}
+#ifdef EVP_CTRL_GCM_SET_IVLEN
+	// CTR and GCM mode are available as of OpenSSL 1.0.1
+	else if (!currentCipherMode.compare("ctr"))
+	{
+		switch(currentKey->getBitLen())
+		{
+			case 128:
+				return EVP_aes_128_ctr();
+			case 192:
+				return EVP_aes_192_ctr();
+			case 256:
+				return EVP_aes_256_ctr();
+		};
+	}
+	else if (!currentCipherMode.compare("gcm"))
+	{
+		switch(currentKey->getBitLen())
+		{
+			case 128:
+				return EVP_aes_128_gcm();
+			case 192:
+				return EVP_aes_192_gcm();
+			case 256:
+				return EVP_aes_256_gcm();
+		};
+	}
+#endif
 
 	ERROR_MSG("Invalid AES cipher mode %s", currentCipherMode.c_str());
 
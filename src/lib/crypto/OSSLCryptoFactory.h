@@ -52,18 +52,6 @@ public:
 	// Return the one-and-only instance
 	static OSSLCryptoFactory* i();
 
-	// Create a concrete instance of a symmetric algorithm
-	virtual SymmetricAlgorithm* getSymmetricAlgorithm(std::string algorithm);
-
-	// Create a concrete instance of an asymmetric algorithm
-	virtual AsymmetricAlgorithm* getAsymmetricAlgorithm(std::string algorithm);
-
-	// Create a concrete instance of a hash algorithm
-	virtual HashAlgorithm* getHashAlgorithm(std::string algorithm);
-
-	// Create a concrete instance of a MAC algorithm
-	virtual MacAlgorithm* getMacAlgorithm(std::string algorithm);
-
 	// Get the global RNG (may be an unique RNG per thread)
 	virtual RNG* getRNG(std::string name = "default");
 
@@ -75,6 +63,19 @@ public:
 	const EVP_MD *EVP_GOST_34_11;
 #endif
 
+protected:
+	// Create a concrete instance of a symmetric algorithm
+	virtual SymmetricAlgorithm* createSymmetricAlgorithm(SymAlgo::Type algorithm);
+
+	// Create a concrete instance of an asymmetric algorithm
+	virtual AsymmetricAlgorithm* createAsymmetricAlgorithm(AsymAlgo::Type algorithm);
+
+	// Create a concrete instance of a hash algorithm
+	virtual HashAlgorithm* createHashAlgorithm(HashAlgo::Type algorithm);
+
+	// Create a concrete instance of a MAC algorithm
+	virtual MacAlgorithm* createMacAlgorithm(MacAlgo::Type algorithm);
+
 private:
 	// Constructor
 	OSSLCryptoFactory();
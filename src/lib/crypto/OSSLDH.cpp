@@ -50,7 +50,7 @@ bool OSSLDH::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return false;
 }
 
-bool OSSLDH::signUpdate(const ByteString& dataToSign)
+bool OSSLDH::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
 	ERROR_MSG("DH does not support signing");
 
@@ -72,7 +72,7 @@ bool OSSLDH::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return false;
 }
 
-bool OSSLDH::verifyUpdate(const ByteString& originalData)
+bool OSSLDH::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
 	ERROR_MSG("DH does not support verifying");
 
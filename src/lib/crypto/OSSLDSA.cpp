@@ -126,7 +126,7 @@ bool OSSLDSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 
 	if (!lowerMechanism.compare("dsa-sha1"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha1");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA1);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -136,7 +136,7 @@ bool OSSLDSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("dsa-sha224"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha224");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA224);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -146,7 +146,7 @@ bool OSSLDSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("dsa-sha256"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha256");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA256);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -156,7 +156,7 @@ bool OSSLDSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("dsa-sha384"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha384");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA384);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -166,7 +166,7 @@ bool OSSLDSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	}
 	if (!lowerMechanism.compare("dsa-sha512"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha512");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA512);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -186,14 +186,14 @@ bool OSSLDSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return true;
 }
 
-bool OSSLDSA::signUpdate(const ByteString& dataToSign)
+bool OSSLDSA::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
-	if (!AsymmetricAlgorithm::signUpdate(dataToSign))
+	if (!AsymmetricAlgorithm::signUpdate(dataToSign, len))
 	{
 		return false;
 	}
 
-	if (!pCurrentHash->hashUpdate(dataToSign))
+	if (!pCurrentHash->hashUpdate(dataToSign, len))
 	{
 		delete pCurrentHash;
 		pCurrentHash = NULL;
@@ -330,7 +330,7 @@ bool OSSLDSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 
 	if (!lowerMechanism.compare("dsa-sha1"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha1");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA1);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -340,7 +340,7 @@ bool OSSLDSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("dsa-sha224"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha224");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA224);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -350,7 +350,7 @@ bool OSSLDSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("dsa-sha256"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha256");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA256);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -360,7 +360,7 @@ bool OSSLDSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("dsa-sha384"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha384");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA384);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -370,7 +370,7 @@ bool OSSLDSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("dsa-sha512"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha512");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA512);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -390,14 +390,14 @@ bool OSSLDSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return true;
 }
 
-bool OSSLDSA::verifyUpdate(const ByteString& originalData)
+bool OSSLDSA::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
-	if (!AsymmetricAlgorithm::verifyUpdate(originalData))
+	if (!AsymmetricAlgorithm::verifyUpdate(originalData, len))
 	{
 		return false;
 	}
 
-	if (!pCurrentHash->hashUpdate(originalData))
+	if (!pCurrentHash->hashUpdate(originalData, len))
 	{
 		delete pCurrentHash;
 		pCurrentHash = NULL;
@@ -51,7 +51,7 @@ bool OSSLECDH::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return false;
 }
 
-bool OSSLECDH::signUpdate(const ByteString& dataToSign)
+bool OSSLECDH::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
 	ERROR_MSG("ECDH does not support signing");
 
@@ -73,7 +73,7 @@ bool OSSLECDH::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return false;
 }
 
-bool OSSLECDH::verifyUpdate(const ByteString& originalData)
+bool OSSLECDH::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
 	ERROR_MSG("ECDH does not support verifying");
 
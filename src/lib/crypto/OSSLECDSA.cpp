@@ -98,7 +98,7 @@ bool OSSLECDSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return false;
 }
 
-bool OSSLECDSA::signUpdate(const ByteString& dataToSign)
+bool OSSLECDSA::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
 	ERROR_MSG("ECDSA does not support multi part signing");
 
@@ -185,7 +185,7 @@ bool OSSLECDSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return false;
 }
 
-bool OSSLECDSA::verifyUpdate(const ByteString& originalData)
+bool OSSLECDSA::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
 	ERROR_MSG("ECDSA does not support multi part verifying");
 
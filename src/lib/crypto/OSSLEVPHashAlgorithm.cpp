@@ -66,20 +66,20 @@ bool OSSLEVPHashAlgorithm::hashInit()
 	return true;
 }
 
-bool OSSLEVPHashAlgorithm::hashUpdate(const ByteString& data)
+bool OSSLEVPHashAlgorithm::hashUpdate(const unsigned char* data, const size_t len)
 {
-	if (!HashAlgorithm::hashUpdate(data))
+	if (!HashAlgorithm::hashUpdate(data, len))
 	{
 		return false;
 	}
 
 	// Continue digesting
-	if (data.size() == 0)
+	if (len == 0)
 	{
 		return true;
 	}
 
-	if (!EVP_DigestUpdate(&curCTX, (unsigned char*) data.const_byte_str(), data.size()))
+	if (!EVP_DigestUpdate(&curCTX, data, len))
 	{
 		ERROR_MSG("EVP_DigestUpdate failed");
 
@@ -96,15 +96,40 @@ bool OSSLEVPHashAlgorithm::hashUpdate(const ByteString& data)
 
 bool OSSLEVPHashAlgorithm::hashFinal(ByteString& hashedData)
 {
-	if (!HashAlgorithm::hashFinal(hashedData))
+	hashedData.resize(EVP_MD_size(getEVPHash()));
+	size_t outLen = hashedData.size();
+
+	if (!hashFinal(&hashedData[0], outLen))
 	{
 		return false;
 	}
 
-	hashedData.resize(EVP_MD_size(getEVPHash()));
-	unsigned int outLen = hashedData.size();
+	hashedData.resize(outLen);
+
+	return true;
+}
+
+bool OSSLEVPHashAlgorithm::hashFinal(unsigned char* hashedData, size_t& len)
+{
+	ByteString dummy;
+
+	if (!HashAlgorithm::hashFinal(dummy))
+	{
+		return false;
+	}
+
+	unsigned int outLen = EVP_MD_size(getEVPHash());
 
-	if (!EVP_DigestFinal_ex(&curCTX, &hashedData[0], &outLen))
+	if (len < outLen)
+	{
+		ERROR_MSG("The output buffer is too small (%d bytes, need %d bytes)", len, outLen);
+
+		EVP_MD_CTX_cleanup(&curCTX);
+
+		return false;
+	}
+
+	if (!EVP_DigestFinal_ex(&curCTX, hashedData, &outLen))
 	{
 		ERROR_MSG("EVP_DigestFinal failed");
 
@@ -113,7 +138,7 @@ bool OSSLEVPHashAlgorithm::hashFinal(ByteString& hashedData)
 		return false;
 	}
 
-	hashedData.resize(outLen);
+	len = outLen;
 
 	EVP_MD_CTX_cleanup(&curCTX);
 
@@ -48,8 +48,10 @@ public:
 
 	// Hashing functions
 	virtual bool hashInit();
-	virtual bool hashUpdate(const ByteString& data);
+	using HashAlgorithm::hashUpdate;
+	virtual bool hashUpdate(const unsigned char* data, const size_t len);
 	virtual bool hashFinal(ByteString& hashedData);
+	virtual bool hashFinal(unsigned char* hashedData, size_t& len);
 
 	virtual int getHashSize() = 0;
 protected:
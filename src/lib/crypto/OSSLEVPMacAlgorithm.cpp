@@ -70,14 +70,14 @@ bool OSSLEVPMacAlgorithm::signInit(const SymmetricKey* key)
 	return true;
 }
 
-bool OSSLEVPMacAlgorithm::signUpdate(const ByteString& dataToSign)
+bool OSSLEVPMacAlgorithm::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
-	if (!MacAlgorithm::signUpdate(dataToSign))
+	if (!MacAlgorithm::signUpdate(dataToSign, len))
 	{
 		return false;
 	}
 
-	if (!HMAC_Update(&curCTX, dataToSign.const_byte_str(), dataToSign.size()))
+	if (!HMAC_Update(&curCTX, dataToSign, len))
 	{
 		ERROR_MSG("HMAC_Update failed");
 
@@ -94,15 +94,40 @@ bool OSSLEVPMacAlgorithm::signUpdate(const ByteString& dataToSign)
 
 bool OSSLEVPMacAlgorithm::signFinal(ByteString& signature)
 {
-	if (!MacAlgorithm::signFinal(signature))
+	signature.resize(EVP_MD_size(getEVPHash()));
+	size_t outLen = signature.size();
+
+	if (!signFinal(&signature[0], outLen))
 	{
 		return false;
 	}
 
-	signature.resize(EVP_MD_size(getEVPHash()));
-	unsigned int outLen = signature.size();
+	signature.resize(outLen);
+
+	return true;
+}
+
+bool OSSLEVPMacAlgorithm::signFinal(unsigned char* signature, size_t& len)
+{
+	ByteString dummy;
 
-	if (!HMAC_Final(&curCTX, &signature[0], &outLen))
+	if (!MacAlgorithm::signFinal(dummy))
+	{
+		return false;
+	}
+
+	unsigned int outLen = EVP_MD_size(getEVPHash());
+
+	if (len < outLen)
+	{
+		ERROR_MSG("The output buffer is too small (%d bytes, need %d bytes)", len, outLen);
+
+		HMAC_CTX_cleanup(&curCTX);
+
+		return false;
+	}
+
+	if (!HMAC_Final(&curCTX, signature, &outLen))
 	{
 		ERROR_MSG("HMAC_Final failed");
 
@@ -111,7 +136,7 @@ bool OSSLEVPMacAlgorithm::signFinal(ByteString& signature)
 		return false;
 	}
 
-	signature.resize(outLen);
+	len = outLen;
 
 	HMAC_CTX_cleanup(&curCTX);
 
@@ -146,14 +171,14 @@ bool OSSLEVPMacAlgorithm::verifyInit(const SymmetricKey* key)
 	return true;
 }
 
-bool OSSLEVPMacAlgorithm::verifyUpdate(const ByteString& originalData)
+bool OSSLEVPMacAlgorithm::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
-	if (!MacAlgorithm::verifyUpdate(originalData))
+	if (!MacAlgorithm::verifyUpdate(originalData, len))
 	{
 		return false;
 	}
 
-	if (!HMAC_Update(&curCTX, originalData.const_byte_str(), originalData.size()))
+	if (!HMAC_Update(&curCTX, originalData, len))
 	{
 		ERROR_MSG("HMAC_Update failed");
 
@@ -35,11 +35,15 @@
 #include "config.h"
 #include "OSSLEVPSymmetricAlgorithm.h"
 #include "salloc.h"
+#include <string.h>
+#include <algorithm>
 
 // Constructor
 OSSLEVPSymmetricAlgorithm::OSSLEVPSymmetricAlgorithm()
 {
 	pCurCTX = NULL;
+	keyRetained = false;
+	retainedEncrypt = false;
 }
 
 // Destructor
@@ -47,21 +51,53 @@ OSSLEVPSymmetricAlgorithm::~OSSLEVPSymmetricAlgorithm()
 {
 	if (pCurCTX != NULL)
 	{
+		EVP_CIPHER_CTX_cleanup(pCurCTX);
 		sfree(pCurCTX);
 	}
 }
 
+// Discard the retained key
+void OSSLEVPSymmetricAlgorithm::discardKey()
+{
+	if (!keyRetained || (pCurCTX == NULL)) return;
+
+	EVP_CIPHER_CTX_cleanup(pCurCTX);
+	sfree(pCurCTX);
+	pCurCTX = NULL;
+
+	keyRetained = false;
+}
+
+// Check if the context holds a retained key for the operation
+bool OSSLEVPSymmetricAlgorithm::hasRetainedKey(const bool encrypt, const std::string& mode) const
+{
+	// The key schedule of some modes depends on the direction
+	return keyRetained && (pCurCTX != NULL) && (retainedEncrypt == encrypt) && (retainedMode == mode);
+}
+
 // Encryption functions
-bool OSSLEVPSymmetricAlgorithm::encryptInit(const SymmetricKey* key, const std::string mode /* = "cbc" */, const ByteString& IV /* = ByteString()*/)
+bool OSSLEVPSymmetricAlgorithm::encryptInit(const SymmetricKey* key, const std::string mode /* = "cbc" */, const ByteString& IV /* = ByteString()*/, bool padding /* = true */, size_t counterBits /* = 0 */, const ByteString& aad /* = ByteString() */, size_t tagBytes /* = 0 */)
 {
 	// Call the superclass initialiser
-	if (!SymmetricAlgorithm::encryptInit(key, mode, IV))
+	if (!SymmetricAlgorithm::encryptInit(key, mode, IV, padding, counterBits, aad, tagBytes))
 	{
 		return false;
 	}
 
-	// Check the IV
-	if ((IV.size() > 0) && (IV.size() != getBlockSize()))
+	// Check the IV; GCM takes an IV of any size and needs a tag size
+	if (!currentCipherMode.compare("gcm"))
+	{
+		if ((IV.size() == 0) || (tagBytes == 0) || (tagBytes > 16))
+		{
+			ERROR_MSG("Invalid GCM parameters (%d bytes IV, %d bytes tag)", IV.size(), tagBytes);
+
+			ByteString dummy;
+			SymmetricAlgorithm::encryptFinal(dummy);
+
+			return false;
+		}
+	}
+	else if ((IV.size() > 0) && (IV.size() != getBlockSize()))
 	{
 		ERROR_MSG("Invalid IV size (%d bytes, expected %d bytes)", IV.size(), getBlockSize());
 
@@ -82,35 +118,47 @@ bool OSSLEVPSymmetricAlgorithm::encryptInit(const SymmetricKey* key, const std::
 		iv.wipe(getBlockSize());
 	}
 
-	// Determine the cipher class
-	const EVP_CIPHER* cipher = getCipher();
+	// Determine the cipher class; the retained key already has one
+	const EVP_CIPHER* cipher = NULL;
 
-	if (cipher == NULL)
+	if (key != NULL)
 	{
-		ERROR_MSG("Failed to initialise EVP encrypt operation");
+		cipher = getCipher();
 
-		ByteString dummy;
-		SymmetricAlgorithm::encryptFinal(dummy);
+		if (cipher == NULL)
+		{
+			ERROR_MSG("Failed to initialise EVP encrypt operation");
 
-		return false;
+			ByteString dummy;
+			SymmetricAlgorithm::encryptFinal(dummy);
+
+			return false;
+		}
 	}
 
-	// Allocate the EVP context
-	pCurCTX = (EVP_CIPHER_CTX*) salloc(sizeof(EVP_CIPHER_CTX));
+	keyRetained = false;
 
+	// Allocate the EVP context, or reuse the one of the retained key
 	if (pCurCTX == NULL)
 	{
-		ERROR_MSG("Failed to allocate space for EVP_CIPHER_CTX");
+		pCurCTX = (EVP_CIPHER_CTX*) salloc(sizeof(EVP_CIPHER_CTX));
 
-		ByteString dummy;
-		SymmetricAlgorithm::encryptFinal(dummy);
+		if (pCurCTX == NULL)
+		{
+			ERROR_MSG("Failed to allocate space for EVP_CIPHER_CTX");
 
-		return false;
-	}
+			ByteString dummy;
+			SymmetricAlgorithm::encryptFinal(dummy);
 
-	int rv = EVP_EncryptInit(pCurCTX, cipher, (unsigned char*) currentKey->getKeyBits().const_byte_str(), iv.byte_str());
+			return false;
+		}
+	}
+	else if (cipher != NULL)
+	{
+		EVP_CIPHER_CTX_cleanup(pCurCTX);
+	}
 
-	if (!rv)
+	if (!initContext(cipher, iv, true))
 	{
 		ERROR_MSG("Failed to initialise EVP encrypt operation");
 
@@ -129,7 +177,27 @@ bool OSSLEVPSymmetricAlgorithm::encryptInit(const SymmetricKey* key, const std::
 
 bool OSSLEVPSymmetricAlgorithm::encryptUpdate(const ByteString& data, ByteString& encryptedData)
 {
-	if (!SymmetricAlgorithm::encryptUpdate(data, encryptedData))
+	// Prepare the output block
+	encryptedData.resize(data.size() + getBlockSize() - 1);
+
+	size_t outLen = encryptedData.size();
+
+	if (!encryptUpdate(data.const_byte_str(), data.size(), &encryptedData[0], outLen))
+	{
+		return false;
+	}
+
+	// Resize the output block
+	encryptedData.resize(outLen);
+
+	return true;
+}
+
+bool OSSLEVPSymmetricAlgorithm::encryptUpdate(const unsigned char* data, const size_t inLen, unsigned char* encryptedData, size_t& outLen)
+{
+	ByteString dummy;
+
+	if (!SymmetricAlgorithm::encryptUpdate(dummy, dummy))
 	{
 		if (pCurCTX != NULL)
 		{
@@ -141,11 +209,37 @@ bool OSSLEVPSymmetricAlgorithm::encryptUpdate(const ByteString& data, ByteString
 		return false;
 	}
 
-	// Prepare the output block
-	encryptedData.resize(data.size() + getBlockSize() - 1);
+	// Check that the counter does not wrap
+	if (!checkCounter(inLen))
+	{
+		EVP_CIPHER_CTX_cleanup(pCurCTX);
+		sfree(pCurCTX);
+		pCurCTX = NULL;
+
+		SymmetricAlgorithm::encryptFinal(dummy);
+
+		return false;
+	}
+
+	// Check the size of the output block
+	size_t maxLen = getMaxUpdateSize(inLen);
+
+	if (outLen < maxLen)
+	{
+		ERROR_MSG("The output buffer is too small (%d bytes, need %d bytes)", outLen, maxLen);
+
+		EVP_CIPHER_CTX_cleanup(pCurCTX);
+		sfree(pCurCTX);
+		pCurCTX = NULL;
+
+		SymmetricAlgorithm::encryptFinal(dummy);
+
+		return false;
+	}
+
+	int len = 0;
 
-	int outLen = encryptedData.size();
-	if (!EVP_EncryptUpdate(pCurCTX, &encryptedData[0], &outLen, (unsigned char*) data.const_byte_str(), data.size()))
+	if (!EVP_EncryptUpdate(pCurCTX, encryptedData, &len, (unsigned char*) data, inLen))
 	{
 		ERROR_MSG("EVP_EncryptUpdate failed");
 
@@ -153,21 +247,42 @@ bool OSSLEVPSymmetricAlgorithm::encryptUpdate(const ByteString& data, ByteString
 		sfree(pCurCTX);
 		pCurCTX = NULL;
 
-		ByteString dummy;
 		SymmetricAlgorithm::encryptFinal(dummy);
 
 		return false;
 	}
 
+	outLen = len;
+
+	return true;
+}
+
+bool OSSLEVPSymmetricAlgorithm::encryptFinal(ByteString& encryptedData)
+{
+	// Prepare the output block
+	encryptedData.resize(std::max(getBlockSize(), getMaxFinalSize()));
+
+	size_t outLen = encryptedData.size();
+
+	if (!encryptFinal(&encryptedData[0], outLen))
+	{
+		return false;
+	}
+
 	// Resize the output block
 	encryptedData.resize(outLen);
 
 	return true;
 }
 
-bool OSSLEVPSymmetricAlgorithm::encryptFinal(ByteString& encryptedData)
+bool OSSLEVPSymmetricAlgorithm::encryptFinal(unsigned char* encryptedData, size_t& outLen)
 {
-	if (!SymmetricAlgorithm::encryptFinal(encryptedData))
+	ByteString dummy;
+
+	// The size of the result depends on the state of the operation
+	size_t maxLen = getMaxFinalSize();
+
+	if (!SymmetricAlgorithm::encryptFinal(dummy))
 	{
 		if (pCurCTX != NULL)
 		{
@@ -179,12 +294,21 @@ bool OSSLEVPSymmetricAlgorithm::encryptFinal(ByteString& encryptedData)
 		return false;
 	}
 
-	// Prepare the output block
-	encryptedData.resize(getBlockSize());
+	// Check the size of the output block
+	if (outLen < maxLen)
+	{
+		ERROR_MSG("The output buffer is too small (%d bytes, need %d bytes)", outLen, maxLen);
+
+		EVP_CIPHER_CTX_cleanup(pCurCTX);
+		sfree(pCurCTX);
+		pCurCTX = NULL;
+
+		return false;
+	}
 
-	int outLen = encryptedData.size();
+	int len = 0;
 
-	if (!EVP_EncryptFinal(pCurCTX, &encryptedData[0], &outLen))
+	if (!EVP_EncryptFinal_ex(pCurCTX, encryptedData, &len))
 	{
 		ERROR_MSG("EVP_EncryptFinal failed");
 
@@ -195,27 +319,55 @@ bool OSSLEVPSymmetricAlgorithm::encryptFinal(ByteString& encryptedData)
 		return false;
 	}
 
-	// Resize the output block
-	encryptedData.resize(outLen);
+	outLen = len;
 
-	EVP_CIPHER_CTX_cleanup(pCurCTX);
-	sfree(pCurCTX);
-	pCurCTX = NULL;
+#ifdef EVP_CTRL_GCM_GET_TAG
+	// Append the tag
+	if (!currentCipherMode.compare("gcm"))
+	{
+		if (!EVP_CIPHER_CTX_ctrl(pCurCTX, EVP_CTRL_GCM_GET_TAG, currentTagBytes, encryptedData + outLen))
+		{
+			ERROR_MSG("Failed to retrieve the GCM tag");
+
+			EVP_CIPHER_CTX_cleanup(pCurCTX);
+			sfree(pCurCTX);
+			pCurCTX = NULL;
+
+			return false;
+		}
+
+		outLen += currentTagBytes;
+	}
+#endif
+
+	finishContext(true);
 
 	return true;
 }
 
 // Decryption functions
-bool OSSLEVPSymmetricAlgorithm::decryptInit(const SymmetricKey* key, const std::string mode /* = "cbc" */, const ByteString& IV /* = ByteString() */)
+bool OSSLEVPSymmetricAlgorithm::decryptInit(const SymmetricKey* key, const std::string mode /* = "cbc" */, const ByteString& IV /* = ByteString() */, bool padding /* = true */, size_t counterBits /* = 0 */, const ByteString& aad /* = ByteString() */, size_t tagBytes /* = 0 */)
 {
 	// Call the superclass initialiser
-	if (!SymmetricAlgorithm::decryptInit(key, mode, IV))
+	if (!SymmetricAlgorithm::decryptInit(key, mode, IV, padding, counterBits, aad, tagBytes))
 	{
 		return false;
 	}
 
-	// Check the IV
-	if ((IV.size() > 0) && (IV.size() != getBlockSize()))
+	// Check the IV; GCM takes an IV of any size and needs a tag size
+	if (!currentCipherMode.compare("gcm"))
+	{
+		if ((IV.size() == 0) || (tagBytes == 0) || (tagBytes > 16))
+		{
+			ERROR_MSG("Invalid GCM parameters (%d bytes IV, %d bytes tag)", IV.size(), tagBytes);
+
+			ByteString dummy;
+			SymmetricAlgorithm::decryptFinal(dummy);
+
+			return false;
+		}
+	}
+	else if ((IV.size() > 0) && (IV.size() != getBlockSize()))
 	{
 		ERROR_MSG("Invalid IV size (%d bytes, expected %d bytes)", IV.size(), getBlockSize());
 
@@ -236,35 +388,47 @@ bool OSSLEVPSymmetricAlgorithm::decryptInit(const SymmetricKey* key, const std::
 		iv.wipe(getBlockSize());
 	}
 
-	// Determine the cipher class
-	const EVP_CIPHER* cipher = getCipher();
+	// Determine the cipher class; the retained key already has one
+	const EVP_CIPHER* cipher = NULL;
 
-	if (cipher == NULL)
+	if (key != NULL)
 	{
-		ERROR_MSG("Failed to initialise EVP decrypt operation");
+		cipher = getCipher();
 
-		ByteString dummy;
-		SymmetricAlgorithm::decryptFinal(dummy);
+		if (cipher == NULL)
+		{
+			ERROR_MSG("Failed to initialise EVP decrypt operation");
 
-		return false;
+			ByteString dummy;
+			SymmetricAlgorithm::decryptFinal(dummy);
+
+			return false;
+		}
 	}
 
-	// Allocate the EVP context
-	pCurCTX = (EVP_CIPHER_CTX*) salloc(sizeof(EVP_CIPHER_CTX));
+	keyRetained = false;
 
+	// Allocate the EVP context, or reuse the one of the retained key
 	if (pCurCTX == NULL)
 	{
-		ERROR_MSG("Failed to allocate space for EVP_CIPHER_CTX");
+		pCurCTX = (EVP_CIPHER_CTX*) salloc(sizeof(EVP_CIPHER_CTX));
 
-		ByteString dummy;
-		SymmetricAlgorithm::decryptFinal(dummy);
+		if (pCurCTX == NULL)
+		{
+			ERROR_MSG("Failed to allocate space for EVP_CIPHER_CTX");
 
-		return false;
-	}
+			ByteString dummy;
+			SymmetricAlgorithm::decryptFinal(dummy);
 
-	int rv = EVP_DecryptInit(pCurCTX, cipher, (unsigned char*) currentKey->getKeyBits().const_byte_str(), iv.byte_str());
+			return false;
+		}
+	}
+	else if (cipher != NULL)
+	{
+		EVP_CIPHER_CTX_cleanup(pCurCTX);
+	}
 
-	if (!rv)
+	if (!initContext(cipher, iv, false))
 	{
 		ERROR_MSG("Failed to initialise EVP decrypt operation");
 
@@ -283,7 +447,27 @@ bool OSSLEVPSymmetricAlgorithm::decryptInit(const SymmetricKey* key, const std::
 
 bool OSSLEVPSymmetricAlgorithm::decryptUpdate(const ByteString& encryptedData, ByteString& data)
 {
-	if (!SymmetricAlgorithm::decryptUpdate(encryptedData, data))
+	// Prepare the output block
+	data.resize(encryptedData.size() + getBlockSize());
+
+	size_t outLen = data.size();
+
+	if (!decryptUpdate(encryptedData.const_byte_str(), encryptedData.size(), &data[0], outLen))
+	{
+		return false;
+	}
+
+	// Resize the output block
+	data.resize(outLen);
+
+	return true;
+}
+
+bool OSSLEVPSymmetricAlgorithm::decryptUpdate(const unsigned char* encryptedData, const size_t inLen, unsigned char* data, size_t& outLen)
+{
+	ByteString dummy;
+
+	if (!SymmetricAlgorithm::decryptUpdate(dummy, dummy))
 	{
 		if (pCurCTX != NULL)
 		{
@@ -295,14 +479,69 @@ bool OSSLEVPSymmetricAlgorithm::decryptUpdate(const ByteString& encryptedData, B
 		return false;
 	}
 
-	// Prepare the output block
-	data.resize(encryptedData.size() + getBlockSize() - 1);
+	// Check that the counter does not wrap
+	if (!checkCounter(inLen))
+	{
+		EVP_CIPHER_CTX_cleanup(pCurCTX);
+		sfree(pCurCTX);
+		pCurCTX = NULL;
+
+		SymmetricAlgorithm::decryptFinal(dummy);
+
+		return false;
+	}
+
+	// Check the size of the output block
+	size_t maxLen = getMaxUpdateSize(inLen);
+
+	if (outLen < maxLen)
+	{
+		ERROR_MSG("The output buffer is too small (%d bytes, need %d bytes)", outLen, maxLen);
+
+		EVP_CIPHER_CTX_cleanup(pCurCTX);
+		sfree(pCurCTX);
+		pCurCTX = NULL;
+
+		SymmetricAlgorithm::decryptFinal(dummy);
+
+		return false;
+	}
+
+	// In GCM mode the data is collected until the tag can be checked
+	if (!currentCipherMode.compare("gcm"))
+	{
+		currentAEADBuffer += ByteString(encryptedData, inLen);
+		outLen = 0;
+
+		return true;
+	}
+
+	DEBUG_MSG("Decrypting %d bytes into buffer of %d bytes", inLen, outLen);
+
+	int len = 0;
+	int rv;
+
+	// With padding enabled, EVP_DecryptUpdate writes the block it holds back
+	// for the padding check to the output as well; use an intermediate buffer
+	// if the output buffer has no room for it
+	if (currentPaddingMode && (outLen < inLen + getBlockSize()))
+	{
+		ByteString buffer;
+		buffer.resize(inLen + getBlockSize());
 
-	int outLen = data.size();
+		rv = EVP_DecryptUpdate(pCurCTX, &buffer[0], &len, (unsigned char*) encryptedData, inLen);
 
-	DEBUG_MSG("Decrypting %d bytes into buffer of %d bytes", encryptedData.size(), data.size());
+		if (rv && (len > 0))
+		{
+			memcpy(data, buffer.const_byte_str(), len);
+		}
+	}
+	else
+	{
+		rv = EVP_DecryptUpdate(pCurCTX, data, &len, (unsigned char*) encryptedData, inLen);
+	}
 
-	if (!EVP_DecryptUpdate(pCurCTX, &data[0], &outLen, (unsigned char*) encryptedData.const_byte_str(), encryptedData.size()))
+	if (!rv)
 	{
 		ERROR_MSG("EVP_DecryptUpdate failed");
 
@@ -310,13 +549,29 @@ bool OSSLEVPSymmetricAlgorithm::decryptUpdate(const ByteString& encryptedData, B
 		sfree(pCurCTX);
 		pCurCTX = NULL;
 
-		ByteString dummy;
 		SymmetricAlgorithm::decryptFinal(dummy);
 
 		return false;
 	}
 
-	DEBUG_MSG("Decrypt returned %d bytes of data", outLen);
+	DEBUG_MSG("Decrypt returned %d bytes of data", len);
+
+	outLen = len;
+
+	return true;
+}
+
+bool OSSLEVPSymmetricAlgorithm::decryptFinal(ByteString& data)
+{
+	// Prepare the output block
+	data.resize(std::max(getBlockSize(), getMaxFinalSize()));
+
+	size_t outLen = data.size();
+
+	if (!decryptFinal(&data[0], outLen))
+	{
+		return false;
+	}
 
 	// Resize the output block
 	data.resize(outLen);
@@ -324,9 +579,14 @@ bool OSSLEVPSymmetricAlgorithm::decryptUpdate(const ByteString& encryptedData, B
 	return true;
 }
 
-bool OSSLEVPSymmetricAlgorithm::decryptFinal(ByteString& data)
+bool OSSLEVPSymmetricAlgorithm::decryptFinal(unsigned char* data, size_t& outLen)
 {
-	if (!SymmetricAlgorithm::decryptFinal(data))
+	ByteString dummy;
+
+	// The size of the result depends on the state of the operation
+	size_t maxLen = getMaxFinalSize();
+
+	if (!SymmetricAlgorithm::decryptFinal(dummy))
 	{
 		if (pCurCTX != NULL)
 		{
@@ -338,13 +598,78 @@ bool OSSLEVPSymmetricAlgorithm::decryptFinal(ByteString& data)
 		return false;
 	}
 
-	// Prepare the output block
-	data.resize(getBlockSize());
+	// Check the size of the output block
+	if (outLen < maxLen)
+	{
+		ERROR_MSG("The output buffer is too small (%d bytes, need %d bytes)", outLen, maxLen);
+
+		EVP_CIPHER_CTX_cleanup(pCurCTX);
+		sfree(pCurCTX);
+		pCurCTX = NULL;
 
-	int outLen = data.size();
+		return false;
+	}
+
+	int len = 0;
 	int rv;
+	size_t dataLen = 0;
+
+	// In GCM mode the plaintext is only unauthenticated until the tag has
+	// been checked, so it is decrypted into secure memory first and only
+	// copied to the output block if the tag is correct
+	ByteString aeadPlainText;
+	unsigned char* out = data;
 
-	if (!(rv = EVP_DecryptFinal(pCurCTX, &data[0], &outLen)))
+#ifdef EVP_CTRL_GCM_SET_TAG
+	// Decrypt the collected data and set the tag to check
+	if (!currentCipherMode.compare("gcm"))
+	{
+		if (currentAEADBuffer.size() < currentTagBytes)
+		{
+			ERROR_MSG("The encrypted data is shorter than the GCM tag");
+
+			EVP_CIPHER_CTX_cleanup(pCurCTX);
+			sfree(pCurCTX);
+			pCurCTX = NULL;
+
+			return false;
+		}
+
+		dataLen = currentAEADBuffer.size() - currentTagBytes;
+		ByteString tag = currentAEADBuffer.substr(dataLen);
+
+		aeadPlainText.resize(dataLen + getBlockSize());
+		out = &aeadPlainText[0];
+
+		if ((dataLen > 0) && !EVP_DecryptUpdate(pCurCTX, out, &len, currentAEADBuffer.const_byte_str(), dataLen))
+		{
+			ERROR_MSG("EVP_DecryptUpdate failed");
+
+			EVP_CIPHER_CTX_cleanup(pCurCTX);
+			sfree(pCurCTX);
+			pCurCTX = NULL;
+
+			return false;
+		}
+
+		dataLen = len;
+		currentAEADBuffer.resize(0);
+
+		if (!EVP_CIPHER_CTX_ctrl(pCurCTX, EVP_CTRL_GCM_SET_TAG, tag.size(), &tag[0]))
+		{
+			ERROR_MSG("Failed to set the GCM tag");
+
+			EVP_CIPHER_CTX_cleanup(pCurCTX);
+			sfree(pCurCTX);
+			pCurCTX = NULL;
+
+			return false;
+		}
+	}
+#endif
+
+	// This checks the padding, or the tag in GCM mode
+	if (!(rv = EVP_DecryptFinal_ex(pCurCTX, out + dataLen, &len)))
 	{
 		ERROR_MSG("EVP_DecryptFinal failed (0x%08X)", rv);
 
@@ -355,13 +680,89 @@ bool OSSLEVPSymmetricAlgorithm::decryptFinal(ByteString& data)
 		return false;
 	}
 
-	// Resize the output block
-	data.resize(outLen);
+	outLen = dataLen + len;
 
-	EVP_CIPHER_CTX_cleanup(pCurCTX);
-	sfree(pCurCTX);
-	pCurCTX = NULL;
+	if (out != data)
+	{
+		memcpy(data, out, outLen);
+	}
+
+	finishContext(false);
 
 	return true;
 }
 
+// Initialise the EVP context for the current key and mode
+bool OSSLEVPSymmetricAlgorithm::initContext(const EVP_CIPHER* cipher, const ByteString& iv, bool encrypt)
+{
+	// Without a cipher the key in the context is kept
+	unsigned char* key = NULL;
+	int enc = encrypt ? 1 : 0;
+
+	if (cipher != NULL)
+	{
+		key = (unsigned char*) currentKey->getKeyBits().const_byte_str();
+	}
+
+#ifdef EVP_CTRL_GCM_SET_IVLEN
+	if (!currentCipherMode.compare("gcm"))
+	{
+		// The IV size has to be set before the IV itself, and the
+		// additional authenticated data goes in before any data
+		if (cipher != NULL)
+		{
+			EVP_CIPHER_CTX_init(pCurCTX);
+
+			if (!EVP_CipherInit_ex(pCurCTX, cipher, NULL, NULL, NULL, enc))
+			{
+				return false;
+			}
+		}
+
+		if (!EVP_CIPHER_CTX_ctrl(pCurCTX, EVP_CTRL_GCM_SET_IVLEN, iv.size(), NULL) ||
+		    !EVP_CipherInit_ex(pCurCTX, NULL, NULL, key, iv.const_byte_str(), enc))
+		{
+			return false;
+		}
+
+		int len = 0;
+
+		return (currentAAD.size() == 0) ||
+		       EVP_CipherUpdate(pCurCTX, NULL, &len, currentAAD.const_byte_str(), currentAAD.size());
+	}
+#endif
+
+	if (cipher != NULL)
+	{
+		if (!EVP_CipherInit(pCurCTX, cipher, key, iv.const_byte_str(), enc))
+		{
+			return false;
+		}
+	}
+	else if (!EVP_CipherInit_ex(pCurCTX, NULL, NULL, NULL, iv.const_byte_str(), enc))
+	{
+		return false;
+	}
+
+	EVP_CIPHER_CTX_set_padding(pCurCTX, currentPaddingMode ? 1 : 0);
+
+	return true;
+}
+
+// Free the EVP context at the end of an operation, or keep it if the key
+// is to be retained
+void OSSLEVPSymmetricAlgorithm::finishContext(bool encrypt)
+{
+	if (keyRetention)
+	{
+		keyRetained = true;
+		retainedEncrypt = encrypt;
+		retainedMode = currentCipherMode;
+
+		return;
+	}
+
+	EVP_CIPHER_CTX_cleanup(pCurCTX);
+	sfree(pCurCTX);
+	pCurCTX = NULL;
+}
@@ -49,25 +49,49 @@ public:
 	virtual ~OSSLEVPSymmetricAlgorithm();
 
 	// Encryption functions
-	virtual bool encryptInit(const SymmetricKey* key, const std::string mode = "cbc", const ByteString& IV = ByteString());
+	virtual bool encryptInit(const SymmetricKey* key, const std::string mode = "cbc", const ByteString& IV = ByteString(), bool padding = true, size_t counterBits = 0, const ByteString& aad = ByteString(), size_t tagBytes = 0);
 	virtual bool encryptUpdate(const ByteString& data, ByteString& encryptedData);
 	virtual bool encryptFinal(ByteString& encryptedData);
+	virtual bool encryptUpdate(const unsigned char* data, const size_t inLen, unsigned char* encryptedData, size_t& outLen);
+	virtual bool encryptFinal(unsigned char* encryptedData, size_t& outLen);
 
 	// Decryption functions
-	virtual bool decryptInit(const SymmetricKey* key, const std::string mode = "cbc", const ByteString& IV = ByteString());
+	virtual bool decryptInit(const SymmetricKey* key, const std::string mode = "cbc", const ByteString& IV = ByteString(), bool padding = true, size_t counterBits = 0, const ByteString& aad = ByteString(), size_t tagBytes = 0);
 	virtual bool decryptUpdate(const ByteString& encryptedData, ByteString& data);
 	virtual bool decryptFinal(ByteString& data);
+	virtual bool decryptUpdate(const unsigned char* encryptedData, const size_t inLen, unsigned char* data, size_t& outLen);
+	virtual bool decryptFinal(unsigned char* data, size_t& outLen);
 
 	// Return the block size
 	virtual size_t getBlockSize() const = 0;
 
+	// Discard the retained key
+	virtual void discardKey();
+
 protected:
 	// Return the right EVP cipher for the operation
 	virtual const EVP_CIPHER* getCipher() const = 0;
 
+	// Check if the context holds a retained key for the operation
+	virtual bool hasRetainedKey(const bool encrypt, const std::string& mode) const;
+
 private:
-	// The current EVP context
+	// The current EVP context; it outlives the operation if the key is
+	// retained
 	EVP_CIPHER_CTX* pCurCTX;
+
+	// The direction and mode the retained key was used for
+	bool keyRetained;
+	bool retainedEncrypt;
+	std::string retainedMode;
+
+	// Initialise the EVP context for the current key and mode; without a
+	// cipher only the IV of the retained context is replaced
+	bool initContext(const EVP_CIPHER* cipher, const ByteString& iv, bool encrypt);
+
+	// Free the EVP context at the end of an operation, or keep it if the
+	// key is to be retained
+	void finishContext(bool encrypt);
 };
 
 #endif // !_SOFTHSM_V2_OSSLEVPSYMMETRICALGORITHM_H
@@ -102,14 +102,14 @@ bool OSSLGOST::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return true;
 }
 
-bool OSSLGOST::signUpdate(const ByteString& dataToSign)
+bool OSSLGOST::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
-	if (!AsymmetricAlgorithm::signUpdate(dataToSign))
+	if (!AsymmetricAlgorithm::signUpdate(dataToSign, len))
 	{
 		return false;
 	}
 
-	if (!EVP_DigestUpdate(&curCTX, dataToSign.const_byte_str(), dataToSign.size()))
+	if (!EVP_DigestUpdate(&curCTX, dataToSign, len))
 	{
 		ERROR_MSG("EVP_DigestUpdate failed");
 
@@ -216,14 +216,14 @@ bool OSSLGOST::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return true;
 }
 
-bool OSSLGOST::verifyUpdate(const ByteString& originalData)
+bool OSSLGOST::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
-	if (!AsymmetricAlgorithm::verifyUpdate(originalData))
+	if (!AsymmetricAlgorithm::verifyUpdate(originalData, len))
 	{
 		return false;
 	}
 
-	if (!EVP_DigestUpdate(&curCTX, originalData.const_byte_str(), originalData.size()))
+	if (!EVP_DigestUpdate(&curCTX, originalData, len))
 	{
 		ERROR_MSG("EVP_DigestUpdate failed");
 
@@ -100,17 +100,8 @@ bool OSSLRSA::sign(PrivateKey* privateKey, const ByteString& dataToSign, ByteStr
 
 		RSA* rsa = osslKey->getOSSLKey();
 
-		if (!RSA_blinding_on(rsa, NULL))
-		{
-			ERROR_MSG("Failed to turn on blinding for OpenSSL RSA key");
-
-			return false;
-		}
-
 		int sigLen = RSA_private_encrypt(dataToSign.size(), (unsigned char*) dataToSign.const_byte_str(), &signature[0], rsa, RSA_PKCS1_PADDING);
 
-		RSA_blinding_off(rsa);
-
 		if (sigLen == -1)
 		{
 			ERROR_MSG("An error occurred while performing a PKCS #1 signature");
@@ -149,17 +140,8 @@ bool OSSLRSA::sign(PrivateKey* privateKey, const ByteString& dataToSign, ByteStr
 
 		RSA* rsa = osslKey->getOSSLKey();
 
-		if (!RSA_blinding_on(rsa, NULL))
-		{
-			ERROR_MSG("Failed to turn on blinding for OpenSSL RSA key");
-
-			return false;
-		}
-
 		int sigLen = RSA_private_encrypt(dataToSign.size(), (unsigned char*) dataToSign.const_byte_str(), &signature[0], rsa, RSA_NO_PADDING);
 
-		RSA_blinding_off(rsa);
-
 		if (sigLen == -1)
 		{
 			ERROR_MSG("An error occurred while performing a raw RSA signature");
@@ -202,7 +184,7 @@ bool OSSLRSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 
 	if (!lowerMechanism.compare("rsa-md5-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("md5");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::MD5);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -212,7 +194,7 @@ bool OSSLRSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-sha1-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha1");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA1);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -222,7 +204,7 @@ bool OSSLRSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-sha224-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha224");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA224);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -232,7 +214,7 @@ bool OSSLRSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-sha256-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha256");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA256);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -242,7 +224,7 @@ bool OSSLRSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-sha384-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha384");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA384);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -252,7 +234,7 @@ bool OSSLRSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-sha512-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha512");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA512);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -262,8 +244,8 @@ bool OSSLRSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-ssl"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("md5");
-		pSecondHash = CryptoFactory::i()->getHashAlgorithm("sha1");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::MD5);
+		pSecondHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA1);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -292,14 +274,14 @@ bool OSSLRSA::signInit(PrivateKey* privateKey, const std::string mechanism)
 	return true;
 }
 
-bool OSSLRSA::signUpdate(const ByteString& dataToSign)
+bool OSSLRSA::signUpdate(const unsigned char* dataToSign, const size_t len)
 {
-	if (!AsymmetricAlgorithm::signUpdate(dataToSign))
+	if (!AsymmetricAlgorithm::signUpdate(dataToSign, len))
 	{
 		return false;
 	}
 
-	if (!pCurrentHash->hashUpdate(dataToSign))
+	if (!pCurrentHash->hashUpdate(dataToSign, len))
 	{
 		delete pCurrentHash;
 		pCurrentHash = NULL;
@@ -310,7 +292,7 @@ bool OSSLRSA::signUpdate(const ByteString& dataToSign)
 		return false;
 	}
 
-	if ((pSecondHash != NULL) && !pSecondHash->hashUpdate(dataToSign))
+	if ((pSecondHash != NULL) && !pSecondHash->hashUpdate(dataToSign, len))
 	{
 		delete pCurrentHash;
 		pCurrentHash = NULL;
@@ -403,16 +385,7 @@ bool OSSLRSA::signFinal(ByteString& signature)
 
 	RSA* rsa = pk->getOSSLKey();
 
-	if (!RSA_blinding_on(rsa, NULL))
-	{
-		ERROR_MSG("Failed to turn blinding on for OpenSSL RSA key");
-	
-		return false;
-	}
-
-	bool rv = (RSA_sign(type, &digest[0], digest.size(), &signature[0], &sigLen, pk->getOSSLKey()) == 1);
-
-	RSA_blinding_off(rsa);
+	bool rv = (RSA_sign(type, &digest[0], digest.size(), &signature[0], &sigLen, rsa) == 1);
 
 	signature.resize(sigLen);
 
@@ -529,7 +502,7 @@ bool OSSLRSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 
 	if (!lowerMechanism.compare("rsa-md5-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("md5");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::MD5);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -539,7 +512,7 @@ bool OSSLRSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-sha1-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha1");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA1);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -549,7 +522,7 @@ bool OSSLRSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-sha224-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha224");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA224);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -559,7 +532,7 @@ bool OSSLRSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-sha256-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha256");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA256);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -569,7 +542,7 @@ bool OSSLRSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-sha384-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha384");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA384);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -579,7 +552,7 @@ bool OSSLRSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-sha512-pkcs"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("sha512");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA512);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -589,8 +562,8 @@ bool OSSLRSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	}
 	else if (!lowerMechanism.compare("rsa-ssl"))
 	{
-		pCurrentHash = CryptoFactory::i()->getHashAlgorithm("md5");
-		pSecondHash = CryptoFactory::i()->getHashAlgorithm("sha1");
+		pCurrentHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::MD5);
+		pSecondHash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA1);
 
 		if (!pCurrentHash->hashInit())
 		{
@@ -619,14 +592,14 @@ bool OSSLRSA::verifyInit(PublicKey* publicKey, const std::string mechanism)
 	return true;
 }
 
-bool OSSLRSA::verifyUpdate(const ByteString& originalData)
+bool OSSLRSA::verifyUpdate(const unsigned char* originalData, const size_t len)
 {
-	if (!AsymmetricAlgorithm::verifyUpdate(originalData))
+	if (!AsymmetricAlgorithm::verifyUpdate(originalData, len))
 	{
 		return false;
 	}
 
-	if (!pCurrentHash->hashUpdate(originalData))
+	if (!pCurrentHash->hashUpdate(originalData, len))
 	{
 		delete pCurrentHash;
 		pCurrentHash = NULL;
@@ -637,7 +610,7 @@ bool OSSLRSA::verifyUpdate(const ByteString& originalData)
 		return false;
 	}
 
-	if ((pSecondHash != NULL) && !pSecondHash->hashUpdate(originalData))
+	if ((pSecondHash != NULL) && !pSecondHash->hashUpdate(originalData, len))
 	{
 		delete pCurrentHash;
 		pCurrentHash = NULL;
@@ -40,16 +40,27 @@
 // Constructors
 OSSLRSAPrivateKey::OSSLRSAPrivateKey()
 {
-	rsa = RSA_new();
+	init();
 }
 
 OSSLRSAPrivateKey::OSSLRSAPrivateKey(const RSA* inRSA)
 {
-	OSSLRSAPrivateKey();
+	init();
 
 	setFromOSSL(inRSA);
 }
 
+// Create the OpenSSL key; OpenSSL keeps the blinding factor and the
+// Montgomery contexts of the key with it, so they are only computed once for
+// as long as this object lives (e.g. in the key cache of a token)
+void OSSLRSAPrivateKey::init()
+{
+	rsa = RSA_new();
+
+	rsa->flags &= ~RSA_FLAG_NO_BLINDING;
+	rsa->flags |= RSA_FLAG_CACHE_PUBLIC | RSA_FLAG_CACHE_PRIVATE;
+}
+
 // Destructor
 OSSLRSAPrivateKey::~OSSLRSAPrivateKey()
 {
@@ -90,6 +101,8 @@ void OSSLRSAPrivateKey::setP(const ByteString& p)
 	}
 
 	rsa->p = OSSL::byteString2bn(p);
+
+	OSSL::resetRSAPrecomputation(rsa);
 }
 
 void OSSLRSAPrivateKey::setQ(const ByteString& q)
@@ -103,6 +116,8 @@ void OSSLRSAPrivateKey::setQ(const ByteString& q)
 	}
 
 	rsa->q = OSSL::byteString2bn(q);
+
+	OSSL::resetRSAPrecomputation(rsa);
 }
 
 void OSSLRSAPrivateKey::setPQ(const ByteString& pq)
@@ -116,6 +131,8 @@ void OSSLRSAPrivateKey::setPQ(const ByteString& pq)
 	}
 
 	rsa->iqmp = OSSL::byteString2bn(pq);
+
+	OSSL::resetRSAPrecomputation(rsa);
 }
 
 void OSSLRSAPrivateKey::setDP1(const ByteString& dp1)
@@ -129,6 +146,8 @@ void OSSLRSAPrivateKey::setDP1(const ByteString& dp1)
 	}
 
 	rsa->dmp1 = OSSL::byteString2bn(dp1);
+
+	OSSL::resetRSAPrecomputation(rsa);
 }
 
 void OSSLRSAPrivateKey::setDQ1(const ByteString& dq1)
@@ -142,6 +161,8 @@ void OSSLRSAPrivateKey::setDQ1(const ByteString& dq1)
 	}
 
 	rsa->dmq1 = OSSL::byteString2bn(dq1);
+
+	OSSL::resetRSAPrecomputation(rsa);
 }
 
 void OSSLRSAPrivateKey::setD(const ByteString& d)
@@ -155,6 +176,8 @@ void OSSLRSAPrivateKey::setD(const ByteString& d)
 	}
 
 	rsa->d = OSSL::byteString2bn(d);
+
+	OSSL::resetRSAPrecomputation(rsa);
 }
 
 
@@ -170,6 +193,8 @@ void OSSLRSAPrivateKey::setN(const ByteString& n)
 	}
 
 	rsa->n = OSSL::byteString2bn(n);
+
+	OSSL::resetRSAPrecomputation(rsa);
 }
 
 void OSSLRSAPrivateKey::setE(const ByteString& e)
@@ -183,6 +208,8 @@ void OSSLRSAPrivateKey::setE(const ByteString& e)
 	}
 
 	rsa->e = OSSL::byteString2bn(e);
+
+	OSSL::resetRSAPrecomputation(rsa);
 }
 
 // Retrieve the OpenSSL representation of the key
@@ -73,6 +73,9 @@ public:
 	RSA* getOSSLKey();
 
 private:
+	// Create the internal OpenSSL representation
+	void init();
+
 	// The internal OpenSSL representation
 	RSA* rsa;
 };
@@ -45,7 +45,7 @@ OSSLRSAPublicKey::OSSLRSAPublicKey()
 
 OSSLRSAPublicKey::OSSLRSAPublicKey(const RSA* inRSA)
 {
-	OSSLRSAPublicKey();
+	rsa = RSA_new();
 
 	setFromOSSL(inRSA);
 }
@@ -84,6 +84,8 @@ void OSSLRSAPublicKey::setN(const ByteString& n)
 	}
 
 	rsa->n = OSSL::byteString2bn(n);
+
+	OSSL::resetRSAPrecomputation(rsa);
 }
 
 void OSSLRSAPublicKey::setE(const ByteString& e)
@@ -97,6 +99,8 @@ void OSSLRSAPublicKey::setE(const ByteString& e)
 	}
 
 	rsa->e = OSSL::byteString2bn(e);
+
+	OSSL::resetRSAPrecomputation(rsa);
 }
 
 // Retrieve the OpenSSL representation of the key
@@ -55,6 +55,40 @@ BIGNUM* OSSL::byteString2bn(const ByteString& byteString)
 	return BN_bin2bn(byteString.const_byte_str(), byteString.size(), NULL);
 }
 
+// Discard the Montgomery contexts and blinding factors of an RSA key
+void OSSL::resetRSAPrecomputation(RSA* rsa)
+{
+	if (rsa->_method_mod_n != NULL)
+	{
+		BN_MONT_CTX_free(rsa->_method_mod_n);
+		rsa->_method_mod_n = NULL;
+	}
+
+	if (rsa->_method_mod_p != NULL)
+	{
+		BN_MONT_CTX_free(rsa->_method_mod_p);
+		rsa->_method_mod_p = NULL;
+	}
+
+	if (rsa->_method_mod_q != NULL)
+	{
+		BN_MONT_CTX_free(rsa->_method_mod_q);
+		rsa->_method_mod_q = NULL;
+	}
+
+	if (rsa->blinding != NULL)
+	{
+		BN_BLINDING_free(rsa->blinding);
+		rsa->blinding = NULL;
+	}
+
+	if (rsa->mt_blinding != NULL)
+	{
+		BN_BLINDING_free(rsa->mt_blinding);
+		rsa->mt_blinding = NULL;
+	}
+}
+
 #ifdef WITH_ECC
 // Convert an OpenSSL EC GROUP to a ByteString
 ByteString OSSL::grp2ByteString(const EC_GROUP* grp)
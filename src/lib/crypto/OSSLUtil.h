@@ -36,6 +36,7 @@
 #include "config.h"
 #include "ByteString.h"
 #include <openssl/bn.h>
+#include <openssl/rsa.h>
 #ifdef WITH_ECC
 #include <openssl/ec.h>
 #endif
@@ -48,6 +49,10 @@ namespace OSSL
 	// Convert a ByteString to an OpenSSL BIGNUM
 	BIGNUM* byteString2bn(const ByteString& byteString);
 
+	// Discard the Montgomery contexts and blinding factors that OpenSSL keeps
+	// with an RSA key; these are computed again when the key is next used
+	void resetRSAPrecomputation(RSA* rsa);
+
 #ifdef WITH_ECC
 	// Convert an OpenSSL EC GROUP to a ByteString
 	ByteString grp2ByteString(const EC_GROUP* grp);
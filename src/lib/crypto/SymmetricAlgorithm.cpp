@@ -30,28 +30,85 @@
  Base class for symmetric algorithm classes
  *****************************************************************************/
 
+#include "log.h"
 #include "SymmetricAlgorithm.h"
+#include "CryptoUtil.h"
 #include <algorithm>
 #include <string.h>
 
+// Determine the number of blocks that can be processed in CTR mode before
+// the counter in the low counterBits bits of the IV wraps; 0 means there is
+// no limit within reach
+static unsigned long long getCounterBlocks(const ByteString& IV, size_t counterBits)
+{
+	if ((counterBits == 0) || (IV.size() == 0)) return 0;
+
+	if (counterBits > IV.size() * 8) counterBits = IV.size() * 8;
+
+	const unsigned char* iv = IV.const_byte_str();
+	size_t last = IV.size() - 1;
+
+	// A counter of more than 64 bits can only wrap within reach if all of
+	// its bits above the low 64 bits are set
+	for (size_t bit = 64; bit < counterBits; bit++)
+	{
+		if (!(iv[last - bit / 8] & (1 << (bit % 8)))) return 0;
+	}
+
+	size_t bits = (counterBits < 64) ? counterBits : 64;
+	unsigned long long counter = 0;
+
+	for (size_t bit = 0; bit < bits; bit++)
+	{
+		if (iv[last - bit / 8] & (1 << (bit % 8)))
+		{
+			counter |= 1ULL << bit;
+		}
+	}
+
+	if (bits == 64) return 0ULL - counter;
+
+	return (1ULL << bits) - counter;
+}
+
 SymmetricAlgorithm::SymmetricAlgorithm()
 {
 	currentCipherMode = "invalid";
 	currentKey = NULL;
+	currentPaddingMode = true;
+	currentCounterBlocks = 0;
+	currentProcessedBytes = 0;
+	currentTagBytes = 0;
 	currentOperation = NONE;
+	keyRetention = false;
+	factoryType = SymAlgo::Unknown;
 }
 
-bool SymmetricAlgorithm::encryptInit(const SymmetricKey* key, const std::string mode /* = "CBC" */, const ByteString& IV /* = ByteString() */)
+bool SymmetricAlgorithm::encryptInit(const SymmetricKey* key, const std::string mode /* = "CBC" */, const ByteString& IV /* = ByteString() */, bool padding /* = true */, size_t counterBits /* = 0 */, const ByteString& aad /* = ByteString() */, size_t tagBytes /* = 0 */)
 {
-	if ((key == NULL) || (currentOperation != NONE))
+	if (currentOperation != NONE)
+	{
+		return false;
+	}
+
+	std::string lowerMode;
+	lowerMode.resize(mode.size());
+	transform(mode.begin(), mode.end(), lowerMode.begin(), tolower);
+
+	// Without a key the retained key of the previous operation is used
+	if ((key == NULL) && !hasRetainedKey(true, lowerMode))
 	{
 		return false;
 	}
 
 	currentKey = key;
-	currentCipherMode.clear();
-	currentCipherMode.resize(mode.size());
-	transform(mode.begin(), mode.end(), currentCipherMode.begin(), tolower);
+	currentCipherMode = lowerMode;
+	currentPaddingMode = padding;
+	currentCounterBlocks = currentCipherMode.compare("ctr") ? 0 : getCounterBlocks(IV, counterBits);
+	currentProcessedBytes = 0;
+	currentAAD = aad;
+	currentTagBytes = tagBytes;
+	currentAEADBuffer.resize(0);
 	currentOperation = ENCRYPT;
 
 	return true;
@@ -64,6 +121,13 @@ bool SymmetricAlgorithm::encryptUpdate(const ByteString& data, ByteString& encry
 		return false;
 	}
 
+	if (!checkCounter(data.size()))
+	{
+		currentOperation = NONE;
+
+		return false;
+	}
+
 	return true;
 }
 
@@ -79,17 +143,55 @@ bool SymmetricAlgorithm::encryptFinal(ByteString& encryptedData)
 	return true;
 }
 
-bool SymmetricAlgorithm::decryptInit(const SymmetricKey* key, const std::string mode /* = "CBC" */, const ByteString& IV /* = ByteString() */)
+bool SymmetricAlgorithm::encryptUpdate(const unsigned char* data, const size_t inLen, unsigned char* encryptedData, size_t& outLen)
+{
+	ByteString result;
+
+	if (!encryptUpdate(ByteString(data, inLen), result))
+	{
+		return false;
+	}
+
+	return CryptoUtil::copyResult(result, encryptedData, outLen);
+}
+
+bool SymmetricAlgorithm::encryptFinal(unsigned char* encryptedData, size_t& outLen)
 {
-	if ((key == NULL) || (currentOperation != NONE))
+	ByteString result;
+
+	if (!encryptFinal(result))
+	{
+		return false;
+	}
+
+	return CryptoUtil::copyResult(result, encryptedData, outLen);
+}
+
+bool SymmetricAlgorithm::decryptInit(const SymmetricKey* key, const std::string mode /* = "CBC" */, const ByteString& IV /* = ByteString() */, bool padding /* = true */, size_t counterBits /* = 0 */, const ByteString& aad /* = ByteString() */, size_t tagBytes /* = 0 */)
+{
+	if (currentOperation != NONE)
+	{
+		return false;
+	}
+
+	std::string lowerMode;
+	lowerMode.resize(mode.size());
+	transform(mode.begin(), mode.end(), lowerMode.begin(), tolower);
+
+	// Without a key the retained key of the previous operation is used
+	if ((key == NULL) && !hasRetainedKey(false, lowerMode))
 	{
 		return false;
 	}
 
 	currentKey = key;
-	currentCipherMode.clear();
-	currentCipherMode.resize(mode.size());
-	transform(mode.begin(), mode.end(), currentCipherMode.begin(), tolower);
+	currentCipherMode = lowerMode;
+	currentPaddingMode = padding;
+	currentCounterBlocks = currentCipherMode.compare("ctr") ? 0 : getCounterBlocks(IV, counterBits);
+	currentProcessedBytes = 0;
+	currentAAD = aad;
+	currentTagBytes = tagBytes;
+	currentAEADBuffer.resize(0);
 	currentOperation = DECRYPT;
 
 	return true;
@@ -103,6 +205,13 @@ bool SymmetricAlgorithm::decryptUpdate(const ByteString& encryptedData, ByteStri
 		return false;
 	}
 
+	if (!checkCounter(encryptedData.size()))
+	{
+		currentOperation = NONE;
+
+		return false;
+	}
+
 	return true;
 }
 
@@ -118,6 +227,30 @@ bool SymmetricAlgorithm::decryptFinal(ByteString& data)
 	return true;
 }
 
+bool SymmetricAlgorithm::decryptUpdate(const unsigned char* encryptedData, const size_t inLen, unsigned char* data, size_t& outLen)
+{
+	ByteString result;
+
+	if (!decryptUpdate(ByteString(encryptedData, inLen), result))
+	{
+		return false;
+	}
+
+	return CryptoUtil::copyResult(result, data, outLen);
+}
+
+bool SymmetricAlgorithm::decryptFinal(unsigned char* data, size_t& outLen)
+{
+	ByteString result;
+
+	if (!decryptFinal(result))
+	{
+		return false;
+	}
+
+	return CryptoUtil::copyResult(result, data, outLen);
+}
+
 // Key factory
 bool SymmetricAlgorithm::generateKey(SymmetricKey& key, RNG* rng /* = NULL */)
 {
@@ -148,3 +281,143 @@ bool SymmetricAlgorithm::reconstructKey(SymmetricKey& key, const ByteString& ser
 	return key.setKeyBits(serialisedData);
 }
 
+void SymmetricAlgorithm::recycleKey(SymmetricKey* toRecycle)
+{
+	delete toRecycle;
+}
+
+void SymmetricAlgorithm::setKeyRetention(const bool retain)
+{
+	keyRetention = retain;
+
+	if (!retain) discardKey();
+}
+
+void SymmetricAlgorithm::discardKey()
+{
+}
+
+bool SymmetricAlgorithm::reset()
+{
+	if (currentOperation != NONE)
+	{
+		return false;
+	}
+
+	// The next user must not find the key of the previous one
+	setKeyRetention(false);
+
+	currentKey = NULL;
+	currentCipherMode = "invalid";
+	currentAAD.wipe();
+	currentAEADBuffer.wipe();
+
+	return true;
+}
+
+bool SymmetricAlgorithm::hasRetainedKey(const bool /*encrypt*/, const std::string& /*mode*/) const
+{
+	return false;
+}
+
+bool SymmetricAlgorithm::getPaddingMode() const
+{
+	return currentPaddingMode;
+}
+
+bool SymmetricAlgorithm::getOutputSize(const size_t inLen, size_t& outLen) const
+{
+	size_t blockSize = getBlockSize();
+
+	outLen = inLen;
+
+	if (!currentCipherMode.compare("gcm"))
+	{
+		if (currentOperation == ENCRYPT)
+		{
+			outLen = inLen + currentTagBytes;
+
+			return true;
+		}
+
+		// The tag is part of the encrypted data
+		if (inLen < currentTagBytes) return false;
+
+		outLen = inLen - currentTagBytes;
+
+		return true;
+	}
+
+	if (!isBlockMode())
+	{
+		// The counter may not wrap within the data
+		if (currentCounterBlocks == 0) return true;
+
+		return ((currentProcessedBytes + inLen + blockSize - 1) / blockSize) <= currentCounterBlocks;
+	}
+
+	// Padding adds at least one byte on encryption, and the padding is
+	// only removed after decryption
+	if (currentPaddingMode && (currentOperation == ENCRYPT))
+	{
+		outLen = (inLen / blockSize + 1) * blockSize;
+
+		return true;
+	}
+
+	if ((inLen % blockSize) != 0) return false;
+
+	return !currentPaddingMode || (inLen > 0);
+}
+
+size_t SymmetricAlgorithm::getMaxUpdateSize(const size_t inLen) const
+{
+	if (!currentCipherMode.compare("gcm"))
+	{
+		return (currentOperation == DECRYPT) ? 0 : inLen;
+	}
+
+	if (!isBlockMode()) return inLen;
+
+	// Data is processed in whole blocks
+	return ((inLen + getBlockSize() - 1) / getBlockSize()) * getBlockSize();
+}
+
+size_t SymmetricAlgorithm::getMaxFinalSize() const
+{
+	if (!currentCipherMode.compare("gcm"))
+	{
+		if (currentOperation == ENCRYPT) return currentTagBytes;
+
+		if (currentAEADBuffer.size() < currentTagBytes) return 0;
+
+		return currentAEADBuffer.size() - currentTagBytes;
+	}
+
+	if (!isBlockMode()) return 0;
+
+	return currentPaddingMode ? getBlockSize() : 0;
+}
+
+bool SymmetricAlgorithm::isBlockMode() const
+{
+	return !currentCipherMode.compare("ecb") || !currentCipherMode.compare("cbc");
+}
+
+bool SymmetricAlgorithm::checkCounter(const size_t inLen)
+{
+	currentProcessedBytes += inLen;
+
+	if (currentCounterBlocks == 0) return true;
+
+	unsigned long long blocks = (currentProcessedBytes + getBlockSize() - 1) / getBlockSize();
+
+	if (blocks > currentCounterBlocks)
+	{
+		ERROR_MSG("The counter would wrap after %llu blocks", currentCounterBlocks);
+
+		return false;
+	}
+
+	return true;
+}
@@ -38,6 +38,18 @@
 #include "SymmetricKey.h"
 #include "RNG.h"
 
+// The algorithms that the CryptoFactory can create
+struct SymAlgo
+{
+	enum Type
+	{
+		Unknown,
+		AES,
+		DES,
+		DES3
+	};
+};
+
 class SymmetricAlgorithm
 {
 public:
@@ -47,23 +59,70 @@ public:
 	// Destructor
 	virtual ~SymmetricAlgorithm() { }
 
-	// Encryption functions
-	virtual bool encryptInit(const SymmetricKey* key, const std::string mode = "cbc", const ByteString& IV = ByteString());
+	// Prepare the instance for reuse by another operation; returns false if
+	// it cannot be reused, e.g. because an operation is still in progress
+	virtual bool reset();
+
+	// Encryption functions; block modes use PKCS #7 padding unless padding
+	// is disabled, in which case the data must be a multiple of the block size.
+	// In CTR mode the IV is the initial counter block of which the low
+	// counterBits bits are the counter (0 for all bits). In GCM mode aad is
+	// the additional authenticated data, and a tag of tagBytes bytes is
+	// appended to the encrypted data
+	virtual bool encryptInit(const SymmetricKey* key, const std::string mode = "cbc", const ByteString& IV = ByteString(), bool padding = true, size_t counterBits = 0, const ByteString& aad = ByteString(), size_t tagBytes = 0);
 	virtual bool encryptUpdate(const ByteString& data, ByteString& encryptedData);
 	virtual bool encryptFinal(ByteString& encryptedData);
 
-	// Decryption functions
-	virtual bool decryptInit(const SymmetricKey* key, const std::string mode = "cbc", const ByteString& IV = ByteString());
+	// Variants that write the result to a buffer supplied by the caller; on
+	// input outLen is the size of the buffer, on output the size of the
+	// result. See getMaxUpdateSize() and getMaxFinalSize() for the size of
+	// the buffer that is needed
+	virtual bool encryptUpdate(const unsigned char* data, const size_t inLen, unsigned char* encryptedData, size_t& outLen);
+	virtual bool encryptFinal(unsigned char* encryptedData, size_t& outLen);
+
+	// Decryption functions; in GCM mode the tag is expected at the end of
+	// the encrypted data. No data is returned until the final call has
+	// checked the tag, so updates return nothing
+	virtual bool decryptInit(const SymmetricKey* key, const std::string mode = "cbc", const ByteString& IV = ByteString(), bool padding = true, size_t counterBits = 0, const ByteString& aad = ByteString(), size_t tagBytes = 0);
 	virtual bool decryptUpdate(const ByteString& encryptedData, ByteString& data);
 	virtual bool decryptFinal(ByteString& data);
+	virtual bool decryptUpdate(const unsigned char* encryptedData, const size_t inLen, unsigned char* data, size_t& outLen);
+	virtual bool decryptFinal(unsigned char* data, size_t& outLen);
 
 	// Key factory
 	virtual bool generateKey(SymmetricKey& key, RNG* rng = NULL);
 	virtual bool reconstructKey(SymmetricKey& key, const ByteString& serialisedData);
 
+	// Key recycling
+	virtual void recycleKey(SymmetricKey* toRecycle);
+
+	// Keep the expanded key once an operation has finished, so that the
+	// next operation in the same direction and mode can be started with a
+	// NULL key and only a new IV. Backends that cannot keep the key reject
+	// a NULL key, in which case the caller has to supply the key again
+	void setKeyRetention(const bool retain);
+
+	// Discard the retained key, if any
+	virtual void discardKey();
+
 	// Return the block size
 	virtual size_t getBlockSize() const = 0;
 
+	// Check if padding is enabled for the current operation
+	bool getPaddingMode() const;
+
+	// Check if the current mode works on whole blocks (ECB and CBC)
+	bool isBlockMode() const;
+
+	// Check if processing inLen bytes in total is valid for the current
+	// operation and return the size of the result
+	bool getOutputSize(const size_t inLen, size_t& outLen) const;
+
+	// Return the maximum size of the result of an update with inLen bytes
+	// of input, and of the final call of the current operation
+	size_t getMaxUpdateSize(const size_t inLen) const;
+	size_t getMaxFinalSize() const;
+
 protected:
 	// The current cipher mode
 	std::string currentCipherMode;
@@ -71,6 +130,32 @@ protected:
 	// The current key
 	const SymmetricKey* currentKey;
 
+	// The current padding mode
+	bool currentPaddingMode;
+
+	// The number of blocks left before the counter wraps in CTR mode, and
+	// the number of bytes processed so far; no limit applies if it is 0
+	unsigned long long currentCounterBlocks;
+	unsigned long long currentProcessedBytes;
+
+	// The additional authenticated data and tag size in GCM mode
+	ByteString currentAAD;
+	size_t currentTagBytes;
+
+	// The encrypted data that is collected until the tag can be checked
+	ByteString currentAEADBuffer;
+
+	// Account for another inLen bytes of data; fails if the counter
+	// would wrap in CTR mode
+	bool checkCounter(const size_t inLen);
+
+	// Whether the expanded key is kept after an operation
+	bool keyRetention;
+
+	// Check if the backend holds a retained key for an operation in the
+	// given direction and mode
+	virtual bool hasRetainedKey(const bool encrypt, const std::string& mode) const;
+
 	// The current operation
 	enum
 	{
@@ -79,6 +164,11 @@ protected:
 		DECRYPT
 	} 
 	currentOperation;
+
+private:
+	// The type under which the CryptoFactory pools this instance
+	friend class CryptoFactory;
+	SymAlgo::Type factoryType;
 };
 
 #endif // !_SOFTHSM_V2_SYMMETRICALGORITHM_H
@@ -78,3 +78,8 @@ size_t SymmetricKey::getBitLen() const
 	return bitLen;
 }
 
+// Set the bit length
+void SymmetricKey::setBitLen(const size_t bitLen)
+{
+	this->bitLen = bitLen;
+}
@@ -60,6 +60,9 @@ public:
 	// Retrieve the bit length
 	virtual size_t getBitLen() const;
 
+	// Set the bit length
+	virtual void setBitLen(const size_t bitLen);
+
 protected:
 	// The key
 	ByteString keyData;
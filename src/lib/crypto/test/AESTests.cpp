@@ -31,6 +31,7 @@
  *****************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 #include <cppunit/extensions/HelperMacros.h>
 #include "AESTests.h"
 #include "CryptoFactory.h"
@@ -424,6 +425,277 @@ void AESTests::testECB()
 	}
 }
 
+void AESTests::testCTR()
+{
+	// Test vector from NIST SP 800-38A, F.5.1
+	AESKey aesKey(128);
+	CPPUNIT_ASSERT(aesKey.setKeyBits(ByteString("2B7E151628AED2A6ABF7158809CF4F3C")));
+
+	ByteString IV("F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF");
+	ByteString plainText("6BC1BEE22E409F96E93D7E117393172AAE2D8A571E03AC9C9EB76FAC45AF8E5130C81C46A35CE411E5FBC1191A0A52EFF69F2445DF4F9B17AD2B417BE66C3710");
+	ByteString cipherText("874D6191B620E3261BEF6864990DB6CE9806F66B7970FDFF8617187BB9FFFDFF5AE4DF3EDBD5D35E5B4F09020DB03EAB1E031DDA2FBE03D1792170A0F3009CEE");
+
+	// Encrypt in parts that are not aligned to the block size
+	ByteString shsmCipherText, OB;
+
+	CPPUNIT_ASSERT(aes->encryptInit(&aesKey, "ctr", IV, false, 128));
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText.substr(0, 7), OB));
+	CPPUNIT_ASSERT(OB.size() == 7);
+	shsmCipherText += OB;
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText.substr(7), OB));
+	shsmCipherText += OB;
+	CPPUNIT_ASSERT(aes->encryptFinal(OB));
+	shsmCipherText += OB;
+
+	CPPUNIT_ASSERT(shsmCipherText == cipherText);
+
+	// Decrypt it again
+	ByteString shsmPlainText;
+
+	CPPUNIT_ASSERT(aes->decryptInit(&aesKey, "ctr", IV, false, 128));
+	CPPUNIT_ASSERT(aes->decryptUpdate(cipherText, OB));
+	shsmPlainText += OB;
+	CPPUNIT_ASSERT(aes->decryptFinal(OB));
+	shsmPlainText += OB;
+
+	CPPUNIT_ASSERT(shsmPlainText == plainText);
+
+	// The last byte of the counter is 0xFF, so with an 8-bit counter the
+	// second block would reuse the first counter value
+	CPPUNIT_ASSERT(aes->encryptInit(&aesKey, "ctr", IV, false, 8));
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText.substr(0, 16), OB));
+	CPPUNIT_ASSERT(!aes->encryptUpdate(plainText.substr(16, 1), OB));
+}
+
+void AESTests::testGCM()
+{
+#ifndef WITH_BOTAN
+	// Test case 4 from the GCM specification
+	AESKey aesKey(128);
+	CPPUNIT_ASSERT(aesKey.setKeyBits(ByteString("FEFFE9928665731C6D6A8F9467308308")));
+
+	ByteString IV("CAFEBABEFACEDBADDECAF888");
+	ByteString aad("FEEDFACEDEADBEEFFEEDFACEDEADBEEFABADDAD2");
+	ByteString plainText("D9313225F88406E5A55909C5AFF5269A86A7A9531534F7DA2E4C303D8A318A721C3C0C95956809532FCF0E2449A6B525B16AEDF5AA0DE657BA637B39");
+	ByteString cipherText("42831EC2217774244B7221B784D0D49CE3AA212F2C02A4E035C17E2329ACA12E21D514B25466931C7D8F6A5AAC84AA051BA30B396A0AAC973D58E091");
+	cipherText += ByteString("5BC94FBC3221A5DB94FAE95AE7121A47");
+
+	// Encrypt; the final part contains the tag
+	ByteString shsmCipherText, OB;
+
+	CPPUNIT_ASSERT(aes->encryptInit(&aesKey, "gcm", IV, false, 0, aad, 16));
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText.substr(0, 21), OB));
+	shsmCipherText += OB;
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText.substr(21), OB));
+	shsmCipherText += OB;
+	CPPUNIT_ASSERT(aes->encryptFinal(OB));
+	shsmCipherText += OB;
+
+	CPPUNIT_ASSERT(shsmCipherText == cipherText);
+
+	// Decrypt; nothing is returned before the tag has been checked
+	ByteString shsmPlainText;
+
+	CPPUNIT_ASSERT(aes->decryptInit(&aesKey, "gcm", IV, false, 0, aad, 16));
+	CPPUNIT_ASSERT(aes->decryptUpdate(cipherText, OB));
+	CPPUNIT_ASSERT(OB.size() == 0);
+	CPPUNIT_ASSERT(aes->decryptFinal(OB));
+	shsmPlainText += OB;
+
+	CPPUNIT_ASSERT(shsmPlainText == plainText);
+
+	// A modified tag or modified additional data must be rejected
+	ByteString badCipherText = cipherText;
+	badCipherText[badCipherText.size() - 1] ^= 0x01;
+
+	CPPUNIT_ASSERT(aes->decryptInit(&aesKey, "gcm", IV, false, 0, aad, 16));
+	CPPUNIT_ASSERT(aes->decryptUpdate(badCipherText, OB));
+	CPPUNIT_ASSERT(!aes->decryptFinal(OB));
+
+	ByteString badAAD = aad;
+	badAAD[0] ^= 0x01;
+
+	CPPUNIT_ASSERT(aes->decryptInit(&aesKey, "gcm", IV, false, 0, badAAD, 16));
+	CPPUNIT_ASSERT(aes->decryptUpdate(cipherText, OB));
+	CPPUNIT_ASSERT(!aes->decryptFinal(OB));
+#endif
+}
+
+void AESTests::testGCMBadTag()
+{
+#ifndef WITH_BOTAN
+	// Test case 4 from the GCM specification
+	AESKey aesKey(128);
+	CPPUNIT_ASSERT(aesKey.setKeyBits(ByteString("FEFFE9928665731C6D6A8F9467308308")));
+
+	ByteString IV("CAFEBABEFACEDBADDECAF888");
+	ByteString aad("FEEDFACEDEADBEEFFEEDFACEDEADBEEFABADDAD2");
+	ByteString cipherText("42831EC2217774244B7221B784D0D49CE3AA212F2C02A4E035C17E2329ACA12E21D514B25466931C7D8F6A5AAC84AA051BA30B396A0AAC973D58E091");
+	cipherText += ByteString("5BC94FBC3221A5DB94FAE95AE7121A46");
+
+	// Decrypt with a corrupted tag straight into a buffer
+	unsigned char result[256];
+	size_t len = sizeof(result);
+
+	memset(result, 0xAA, sizeof(result));
+
+	CPPUNIT_ASSERT(aes->decryptInit(&aesKey, "gcm", IV, false, 0, aad, 16));
+	CPPUNIT_ASSERT(aes->decryptUpdate(cipherText.const_byte_str(), cipherText.size(), result, len));
+	CPPUNIT_ASSERT(len == 0);
+	len = sizeof(result);
+	CPPUNIT_ASSERT(!aes->decryptFinal(result, len));
+
+	// None of the unauthenticated plaintext may have been returned
+	for (size_t i = 0; i < sizeof(result); i++)
+	{
+		CPPUNIT_ASSERT(result[i] == 0xAA);
+	}
+#endif
+}
+
+void AESTests::testBufferOutput()
+{
+	AESKey aesKey(128);
+	CPPUNIT_ASSERT(aesKey.setKeyBits(ByteString("0102030405060708090A0B0C0D0E0F10")));
+
+	ByteString IV("69836472094875029486750948672066");
+	ByteString plainText("4938673409687134684698438657403986439058740935874395813968496846");
+	plainText += plainText.substr(0, 13);
+
+	// Encrypt the data using the ByteString interface
+	ByteString cipherText, OB;
+
+	CPPUNIT_ASSERT(aes->encryptInit(&aesKey, "cbc", IV));
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText, OB));
+	cipherText += OB;
+	CPPUNIT_ASSERT(aes->encryptFinal(OB));
+	cipherText += OB;
+
+	// Now encrypt it straight into a buffer
+	unsigned char buffer[256];
+	size_t len = sizeof(buffer);
+	size_t total = 0;
+
+	CPPUNIT_ASSERT(aes->encryptInit(&aesKey, "cbc", IV));
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText.const_byte_str(), plainText.size(), buffer, len));
+	total += len;
+	len = sizeof(buffer) - total;
+	CPPUNIT_ASSERT(aes->encryptFinal(buffer + total, len));
+	total += len;
+
+	CPPUNIT_ASSERT(ByteString(buffer, total) == cipherText);
+
+	// Decrypt it into a buffer again
+	unsigned char result[256];
+	len = sizeof(result);
+	total = 0;
+
+	CPPUNIT_ASSERT(aes->decryptInit(&aesKey, "cbc", IV));
+	CPPUNIT_ASSERT(aes->decryptUpdate(cipherText.const_byte_str(), cipherText.size(), result, len));
+	total += len;
+	len = sizeof(result) - total;
+	CPPUNIT_ASSERT(aes->decryptFinal(result + total, len));
+	total += len;
+
+	CPPUNIT_ASSERT(ByteString(result, total) == plainText);
+
+	// A buffer that is too small must be rejected
+	len = aes->getBlockSize() - 1;
+
+	CPPUNIT_ASSERT(aes->encryptInit(&aesKey, "cbc", IV));
+	CPPUNIT_ASSERT(!aes->encryptUpdate(plainText.const_byte_str(), plainText.size(), buffer, len));
+}
+
+void AESTests::testKeyRetention()
+{
+	AESKey aesKey(256);
+	CPPUNIT_ASSERT(aesKey.setKeyBits(ByteString("0102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F20")));
+
+	ByteString IV1("69836472094875029486750948672066");
+	ByteString IV2("48670943876904867104398574908554");
+	ByteString plainText("4938673409687134684698438657403986439058740935874395813968496846");
+
+	// Without a retained key a key is needed
+	CPPUNIT_ASSERT(!aes->encryptInit(NULL, "cbc", IV1));
+
+	// Compute the expected results
+	ByteString expected1, expected2, OB;
+
+	CPPUNIT_ASSERT(aes->encryptInit(&aesKey, "cbc", IV1));
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText, OB));
+	expected1 += OB;
+	CPPUNIT_ASSERT(aes->encryptFinal(OB));
+	expected1 += OB;
+
+	CPPUNIT_ASSERT(aes->encryptInit(&aesKey, "cbc", IV2));
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText, OB));
+	expected2 += OB;
+	CPPUNIT_ASSERT(aes->encryptFinal(OB));
+	expected2 += OB;
+
+	CPPUNIT_ASSERT(!aes->encryptInit(NULL, "cbc", IV1));
+
+	// Keep the key and reuse it with another IV
+	aes->setKeyRetention(true);
+
+	ByteString cipherText;
+
+	CPPUNIT_ASSERT(aes->encryptInit(&aesKey, "cbc", IV1));
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText, OB));
+	cipherText += OB;
+	CPPUNIT_ASSERT(aes->encryptFinal(OB));
+	cipherText += OB;
+
+	CPPUNIT_ASSERT(cipherText == expected1);
+
+#ifndef WITH_BOTAN
+	cipherText.wipe();
+	CPPUNIT_ASSERT(aes->encryptInit(NULL, "cbc", IV2));
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText, OB));
+	cipherText += OB;
+	CPPUNIT_ASSERT(aes->encryptFinal(OB));
+	cipherText += OB;
+
+	CPPUNIT_ASSERT(cipherText == expected2);
+
+	// The retained key only applies to the same direction and mode
+	CPPUNIT_ASSERT(!aes->decryptInit(NULL, "cbc", IV2));
+	CPPUNIT_ASSERT(!aes->encryptInit(NULL, "ecb", IV2));
+
+	// Decryption keeps a key as well
+	ByteString plainText2;
+
+	CPPUNIT_ASSERT(aes->decryptInit(&aesKey, "cbc", IV1));
+	CPPUNIT_ASSERT(aes->decryptUpdate(expected1, OB));
+	CPPUNIT_ASSERT(aes->decryptFinal(OB));
+
+	CPPUNIT_ASSERT(aes->decryptInit(NULL, "cbc", IV2));
+	CPPUNIT_ASSERT(aes->decryptUpdate(expected2, OB));
+	plainText2 += OB;
+	CPPUNIT_ASSERT(aes->decryptFinal(OB));
+	plainText2 += OB;
+
+	CPPUNIT_ASSERT(plainText2 == plainText);
+
+	// A discarded key can no longer be used
+	aes->discardKey();
+	CPPUNIT_ASSERT(!aes->decryptInit(NULL, "cbc", IV1));
+
+	// Recycling an instance discards its key too
+	CPPUNIT_ASSERT(aes->encryptInit(&aesKey, "cbc", IV1));
+	CPPUNIT_ASSERT(aes->encryptUpdate(plainText, OB));
+	CPPUNIT_ASSERT(aes->encryptFinal(OB));
+
+	SymmetricAlgorithm* recycled = aes;
+	CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
+
+	CPPUNIT_ASSERT((aes = CryptoFactory::i()->getSymmetricAlgorithm(SymAlgo::AES)) == recycled);
+	CPPUNIT_ASSERT(!aes->encryptInit(NULL, "cbc", IV2));
+#endif
+
+	aes->setKeyRetention(false);
+}
+
 void AESTests::writeTmpFile(ByteString& data)
 {
 	FILE* out = fopen("shsmv2-aestest.tmp", "w");
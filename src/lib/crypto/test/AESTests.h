@@ -42,12 +42,22 @@ class AESTests : public CppUnit::TestFixture
 	CPPUNIT_TEST(testBlockSize);
 	CPPUNIT_TEST(testCBC);
 	CPPUNIT_TEST(testECB);
+	CPPUNIT_TEST(testCTR);
+	CPPUNIT_TEST(testGCM);
+	CPPUNIT_TEST(testGCMBadTag);
+	CPPUNIT_TEST(testBufferOutput);
+	CPPUNIT_TEST(testKeyRetention);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
 	void testBlockSize();
 	void testCBC();
 	void testECB();
+	void testCTR();
+	void testGCM();
+	void testGCMBadTag();
+	void testBufferOutput();
+	void testKeyRetention();
 
 	void setUp();
 	void tearDown();
@@ -326,6 +326,88 @@ void HashTests::testSHA512()
 	rng = NULL;
 }
 
+void HashTests::testBufferInput()
+{
+	// Get an RNG and SHA256 hash instance
+	CPPUNIT_ASSERT((rng = CryptoFactory::i()->getRNG()) != NULL);
+	CPPUNIT_ASSERT((hash = CryptoFactory::i()->getHashAlgorithm("sha256")) != NULL);
+
+	// Generate some random input data
+	ByteString b;
+	ByteString byteStringHash, bufferHash;
+
+	CPPUNIT_ASSERT(rng->generateRandom(b, 41731));
+
+	// Hash it from a ByteString
+	CPPUNIT_ASSERT(hash->hashInit());
+	CPPUNIT_ASSERT(hash->hashUpdate(b));
+	CPPUNIT_ASSERT(hash->hashFinal(byteStringHash));
+
+	// Hash it straight from the buffer in a multiple part operation,
+	// including an empty part
+	const unsigned char* data = b.const_byte_str();
+
+	CPPUNIT_ASSERT(hash->hashInit());
+	CPPUNIT_ASSERT(hash->hashUpdate(data, 567));
+	CPPUNIT_ASSERT(hash->hashUpdate(data + 567, 0));
+	CPPUNIT_ASSERT(hash->hashUpdate(data + 567, b.size() - 567));
+	CPPUNIT_ASSERT(hash->hashFinal(bufferHash));
+
+	CPPUNIT_ASSERT(byteStringHash == bufferHash);
+
+	// Write the hash straight into a buffer
+	unsigned char digest[64];
+	size_t len = sizeof(digest);
+
+	CPPUNIT_ASSERT(hash->hashInit());
+	CPPUNIT_ASSERT(hash->hashUpdate(data, b.size()));
+	CPPUNIT_ASSERT(hash->hashFinal(digest, len));
+
+	CPPUNIT_ASSERT(len == (size_t) hash->getHashSize());
+	CPPUNIT_ASSERT(ByteString(digest, len) == byteStringHash);
+
+	// Updating without a running operation must fail
+	CPPUNIT_ASSERT(!hash->hashUpdate(data, b.size()));
+
+	CryptoFactory::i()->recycleHashAlgorithm(hash);
+
+	hash = NULL;
+	rng = NULL;
+}
+
+void HashTests::testRecycle()
+{
+	ByteString b("0102030405060708");
+	ByteString hash1, hash2;
+
+	// A recycled instance is handed out again
+	CPPUNIT_ASSERT((hash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA256)) != NULL);
+	CPPUNIT_ASSERT(hash->hashInit());
+	CPPUNIT_ASSERT(hash->hashUpdate(b));
+	CPPUNIT_ASSERT(hash->hashFinal(hash1));
+
+	HashAlgorithm* recycled = hash;
+	CryptoFactory::i()->recycleHashAlgorithm(hash);
+
+	CPPUNIT_ASSERT((hash = CryptoFactory::i()->getHashAlgorithm("SHA256")) == recycled);
+	CPPUNIT_ASSERT(hash->hashInit());
+	CPPUNIT_ASSERT(hash->hashUpdate(b));
+	CPPUNIT_ASSERT(hash->hashFinal(hash2));
+
+	CPPUNIT_ASSERT(hash1 == hash2);
+
+	// An instance with an operation in progress is not reused
+	CPPUNIT_ASSERT(hash->hashInit());
+	CryptoFactory::i()->recycleHashAlgorithm(hash);
+
+	CPPUNIT_ASSERT((hash = CryptoFactory::i()->getHashAlgorithm(HashAlgo::SHA256)) != NULL);
+	CPPUNIT_ASSERT(hash->hashInit());
+	CPPUNIT_ASSERT(hash->hashUpdate(b));
+	CPPUNIT_ASSERT(hash->hashFinal(hash2));
+
+	CPPUNIT_ASSERT(hash1 == hash2);
+}
+
 void HashTests::writeTmpFile(ByteString& data)
 {
 	FILE* out = fopen("shsmv2-hashtest.tmp", "w");
@@ -46,6 +46,8 @@ class HashTests : public CppUnit::TestFixture
 	CPPUNIT_TEST(testSHA256);
 	CPPUNIT_TEST(testSHA384);
 	CPPUNIT_TEST(testSHA512);
+	CPPUNIT_TEST(testBufferInput);
+	CPPUNIT_TEST(testRecycle);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -55,6 +57,8 @@ public:
 	void testSHA256();
 	void testSHA384();
 	void testSHA512();
+	void testBufferInput();
+	void testRecycle();
 
 	void setUp();
 	void tearDown();
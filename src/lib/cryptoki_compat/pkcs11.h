@@ -183,6 +183,15 @@ extern "C" {
 
 #define public_key publicKey
 
+#define counter_bits ulCounterBits
+
+#define iv pIv
+#define iv_len ulIvLen
+#define iv_bits ulIvBits
+#define aad pAAD
+#define aad_len ulAADLen
+#define tag_bits ulTagBits
+
 #define ck_x9_42_dh_kdf_type_t CK_X9_42_DH_KDF_TYPE
 
 #define other_info_len ulOtherInfoLen
@@ -925,6 +934,20 @@ struct ck_ecdh1_derive_params {
   unsigned char *public_data;
 };
 
+struct ck_aes_ctr_params {
+  unsigned long counter_bits;
+  unsigned char cb[16];
+};
+
+struct ck_gcm_params {
+  unsigned char *iv;
+  unsigned long iv_len;
+  unsigned long iv_bits;
+  unsigned char *aad;
+  unsigned long aad_len;
+  unsigned long tag_bits;
+};
+
 struct ck_ecdh2_derive_params {
   ck_ec_kdf_type_t kdf;
   unsigned long shared_data_len;
@@ -1556,6 +1579,12 @@ typedef struct ck_rsa_pkcs_oaep_params *CK_RSA_PKCS_OAEP_PARAMS_PTR;
 typedef struct ck_ecdh1_derive_params CK_ECDH1_DERIVE_PARAMS;
 typedef struct ck_ecdh1_derive_params *CK_ECDH1_DERIVE_PARAMS_PTR;
 
+typedef struct ck_aes_ctr_params CK_AES_CTR_PARAMS;
+typedef struct ck_aes_ctr_params *CK_AES_CTR_PARAMS_PTR;
+
+typedef struct ck_gcm_params CK_GCM_PARAMS;
+typedef struct ck_gcm_params *CK_GCM_PARAMS_PTR;
+
 typedef struct ck_function_list CK_FUNCTION_LIST;
 typedef struct ck_function_list *CK_FUNCTION_LIST_PTR;
 typedef struct ck_function_list **CK_FUNCTION_LIST_PTR_PTR;
@@ -1645,6 +1674,15 @@ typedef struct ck_c_initialize_args *CK_C_INITIALIZE_ARGS_PTR;
 #undef public_data2
 #undef public_key
 
+#undef counter_bits
+
+#undef iv
+#undef iv_len
+#undef iv_bits
+#undef aad
+#undef aad_len
+#undef tag_bits
+
 #undef ck_x9_42_dh_kdf_type_t
 #undef other_info_len
 #undef other_info
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ softhsm_statistics.h
+
+ Vendor extension of the PKCS #11 interface that returns the call statistics
+ that SoftHSM keeps for its entry points and for the main phases of their
+ implementation. The statistics cover all threads of the calling process.
+
+ The extension is not part of the function list; look it up in the library
+ by name:
+
+   CK_C_GetStatistics pGetStatistics =
+     (CK_C_GetStatistics) dlsym(handle, "C_GetStatistics");
+ *****************************************************************************/
+
+#ifndef _SOFTHSM_V2_SOFTHSM_STATISTICS_H
+#define _SOFTHSM_V2_SOFTHSM_STATISTICS_H
+
+#include "pkcs11.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* The number of latency buckets; bucket i counts the calls that took at
+   least 2^i and less than 2^(i+1) nanoseconds. The last bucket also counts
+   all calls that took longer */
+#define CK_STATISTICS_BUCKETS	40
+
+/* The statistics of a single entry point or phase */
+typedef struct CK_STATISTICS
+{
+	/* The name of the entry point or phase, NUL-terminated */
+	CK_CHAR name[32];
+	/* The number of calls */
+	CK_ULONG calls;
+	/* The number of calls that failed */
+	CK_ULONG errors;
+	/* The total time spent in the calls in microseconds */
+	CK_ULONG totalMicroseconds;
+	/* The number of calls per latency bucket */
+	CK_ULONG buckets[CK_STATISTICS_BUCKETS];
+} CK_STATISTICS;
+
+typedef CK_STATISTICS * CK_STATISTICS_PTR;
+
+/* Retrieve the statistics. Follows the PKCS #11 convention for returning
+   lists: if pStatistics is NULL_PTR only the number of entries is returned
+   in pulCount, otherwise pulCount holds the size of the buffer on input.
+   The library does not have to be initialised */
+CK_RV C_GetStatistics(CK_STATISTICS_PTR pStatistics, CK_ULONG_PTR pulCount);
+
+typedef CK_RV (*CK_C_GetStatistics)(CK_STATISTICS_PTR pStatistics, CK_ULONG_PTR pulCount);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* !_SOFTHSM_V2_SOFTHSM_STATISTICS_H */
+
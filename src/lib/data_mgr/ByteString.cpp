@@ -31,26 +31,51 @@
  *****************************************************************************/
 
 #include <algorithm>
+#include <new>
 #include <string>
 #include <stdio.h>
+#include <string.h>
 #include "config.h"
 #include "log.h"
 #include "ByteString.h"
 
-// Constructors
+// Constructors; secret strings have no inline capacity, so their data is
+// always allocated from the SecureArena
 ByteString::ByteString()
 {
+	byteString = inlineData;
+	publicData = false;
+	length = 0;
+	capacity = 0;
 }
 
-ByteString::ByteString(const unsigned char* bytes, const size_t bytesLen)
+ByteString::ByteString(const Kind kind)
 {
-	byteString.resize(bytesLen);
+	byteString = inlineData;
+	publicData = (kind == Public);
+	length = 0;
+	capacity = publicData ? INLINE_SIZE : 0;
+}
+
+ByteString::ByteString(const unsigned char* bytes, const size_t bytesLen, const Kind kind /* = Secret */)
+{
+	byteString = inlineData;
+	publicData = (kind == Public);
+	length = 0;
+	capacity = publicData ? INLINE_SIZE : 0;
+
+	resize(bytesLen);
 
-	memcpy(&byteString[0], bytes, bytesLen);
+	memcpy(byteString, bytes, bytesLen);
 }
 
 ByteString::ByteString(const char* hexString)
 {
+	byteString = inlineData;
+	publicData = false;
+	length = 0;
+	capacity = 0;
+
 	std::string hex = std::string(hexString);
 
 	if (hex.size() % 2 != 0)
@@ -58,6 +83,8 @@ ByteString::ByteString(const char* hexString)
 		hex = "0" + hex;
 	}
 
+	reserve(hex.size() / 2);
+
 	for (size_t i = 0; i < hex.size(); i += 2)
 	{
 		std::string byteStr;
@@ -72,6 +99,11 @@ ByteString::ByteString(const char* hexString)
 
 ByteString::ByteString(const unsigned long longValue)
 {
+	byteString = inlineData;
+	publicData = true;
+	length = 8;
+	capacity = INLINE_SIZE;
+
 	unsigned long setValue = longValue;
 
 	// Convert the value to a big-endian byte string; N.B.: this code assumes that unsigned long
@@ -85,40 +117,202 @@ ByteString::ByteString(const unsigned long longValue)
 	// read the storage of a 64-bit version and vice versa under the assumption that the stored
 	// values never exceed 32-bits, which is likely since these values are only used to encode
 	// byte string lengths)
-	unsigned char byteStrIn[8];
-	
 	for (size_t i = 0; i < 8; i++)
 	{
-		byteStrIn[7-i] = (unsigned char) (setValue & 0xFF);
+		byteString[7-i] = (unsigned char) (setValue & 0xFF);
 		setValue >>= 8;
 	}
-
-	byteString.resize(8);
-	memcpy(&byteString[0], byteStrIn, 8);
 }
 
 ByteString::ByteString(const ByteString& in)
 {
-	this->byteString = in.byteString;
+	byteString = inlineData;
+	publicData = in.publicData;
+	length = 0;
+	capacity = publicData ? INLINE_SIZE : 0;
+
+	resize(in.length);
+
+	memcpy(byteString, in.byteString, length);
+}
+
+#if __cplusplus >= 201103L
+ByteString::ByteString(ByteString&& in)
+{
+	byteString = inlineData;
+	publicData = false;
+	length = 0;
+	capacity = 0;
+
+	take(in);
+}
+#endif
+
+// Destructor
+ByteString::~ByteString()
+{
+	release();
+
+	// Wipe the inline buffer
+	memset(inlineData, 0x00, INLINE_SIZE);
+}
+
+// Assignment
+ByteString& ByteString::operator=(const ByteString& in)
+{
+	if (this == &in) return *this;
+
+	if (!in.publicData) makeSecret();
+
+	// Existing data beyond the new length is wiped by resize
+	resize(0);
+	resize(in.length);
+
+	memcpy(byteString, in.byteString, length);
+
+	return *this;
+}
+
+#if __cplusplus >= 201103L
+ByteString& ByteString::operator=(ByteString&& in)
+{
+	if (this != &in)
+	{
+		take(in);
+	}
+
+	return *this;
+}
+#endif
+
+// Exchange the contents with another byte string
+void ByteString::swap(ByteString& other)
+{
+	if (this == &other) return;
+
+	ByteString tmp;
+
+	tmp.take(*this);
+	take(other);
+	other.take(tmp);
+}
+
+// Make room for at least newCapacity bytes
+void ByteString::reserve(const size_t newCapacity)
+{
+	if (newCapacity <= capacity) return;
+
+	// Grow geometrically to keep appending cheap
+	size_t allocSize = std::max(newCapacity, capacity * 2);
+
+	unsigned char* newData = (unsigned char*) SecureArena::i()->allocate(allocSize);
+
+	if (newData == NULL)
+	{
+		throw std::bad_alloc();
+	}
+
+	memcpy(newData, byteString, length);
+
+	if (byteString == inlineData)
+	{
+		memset(inlineData, 0x00, INLINE_SIZE);
+	}
+	else
+	{
+		SecureArena::i()->deallocate(byteString, capacity);
+	}
+
+	byteString = newData;
+	capacity = allocSize;
+}
+
+// Move the data to secure memory if the string is public
+void ByteString::makeSecret()
+{
+	if (!publicData) return;
+
+	publicData = false;
+
+	if (byteString == inlineData)
+	{
+		capacity = 0;
+
+		if (length > 0) reserve(length);
+	}
+}
+
+// Release heap allocated data and return to the inline buffer
+void ByteString::release()
+{
+	if (byteString != inlineData)
+	{
+		// The arena wipes the memory
+		SecureArena::i()->deallocate(byteString, capacity);
+	}
+	else
+	{
+		memset(inlineData, 0x00, length);
+	}
+
+	byteString = inlineData;
+	length = 0;
+	capacity = publicData ? INLINE_SIZE : 0;
+}
+
+// Take over the contents of another byte string, leaving it empty; the kind
+// of the data is taken over as well
+void ByteString::take(ByteString& from)
+{
+	release();
+
+	publicData = from.publicData;
+
+	if (from.byteString != from.inlineData)
+	{
+		byteString = from.byteString;
+		length = from.length;
+		capacity = from.capacity;
+
+		from.byteString = from.inlineData;
+		from.length = 0;
+		from.capacity = from.publicData ? INLINE_SIZE : 0;
+	}
+	else
+	{
+		memcpy(inlineData, from.inlineData, from.length);
+		length = from.length;
+		capacity = publicData ? INLINE_SIZE : 0;
+
+		from.release();
+	}
 }
 
 // Append data
 ByteString& ByteString::operator+=(const ByteString& append)
 {
-	size_t curLen = byteString.size();
-	size_t toAdd = append.byteString.size();
-	size_t newLen = curLen + toAdd;
+	size_t curLen = length;
+	size_t toAdd = append.length;
+
+	if (!append.publicData) makeSecret();
 
-	byteString.resize(newLen);
+	// N.B.: the source is read after resizing, which may move it if a
+	// string is appended to itself
+	resize(curLen + toAdd);
 
-	memcpy(&byteString[curLen], &append.byteString[0], toAdd);
+	memcpy(&byteString[curLen], append.byteString, toAdd);
 
 	return *this;
 }
 
 ByteString& ByteString::operator+=(const unsigned char byte)
 {
-	byteString.push_back(byte);
+	if (length == capacity)
+	{
+		reserve(length + 1);
+	}
+
+	byteString[length++] = byte;
 
 	return *this;
 }
@@ -128,6 +322,8 @@ ByteString& ByteString::operator^=(const ByteString& rhs)
 {
 	size_t xorLen = std::min(this->size(), rhs.size());
 
+	if (!rhs.publicData) makeSecret();
+
 	for (size_t i = 0; i < xorLen; i++)
 	{
 		byteString[i] ^= rhs.const_byte_str()[i];
@@ -139,15 +335,15 @@ ByteString& ByteString::operator^=(const ByteString& rhs)
 // Return a substring
 ByteString ByteString::substr(const size_t start, const size_t len /* = SIZE_T_MAX */) const
 {
-	size_t retLen = std::min(len, byteString.size() - start);
+	size_t retLen = std::min(len, length - start);
 
-	if (start >= byteString.size())
+	if (start >= length)
 	{
 		return ByteString();
 	}
 	else
 	{
-		return ByteString(&byteString[start], retLen);
+		return ByteString(&byteString[start], retLen, publicData ? Public : Secret);
 	}
 }
 
@@ -185,13 +381,13 @@ unsigned char& ByteString::operator[](size_t pos)
 // Return the byte string data
 unsigned char* ByteString::byte_str()
 {
-	return &byteString[0];
+	return byteString;
 }
 
 // Return the const byte string
 const unsigned char* ByteString::const_byte_str() const
 {
-	return (const unsigned char*) &byteString[0];
+	return (const unsigned char*) byteString;
 }
 
 // Return a hexadecimal character representation of the string
@@ -200,7 +396,7 @@ std::string ByteString::hex_str() const
 	std::string rv;
 	char hex[3];
 
-	for (size_t i = 0; i < byteString.size(); i++)
+	for (size_t i = 0; i < length; i++)
 	{
 		sprintf(hex, "%02X", byteString[i]);
 
@@ -216,7 +412,7 @@ const unsigned long ByteString::long_val() const
 	// Convert the first 8 bytes of the string to an unsigned long value
 	unsigned long rv = 0;
 
-	for (size_t i = 0; i < std::min(size_t(8), byteString.size()); i++)
+	for (size_t i = 0; i < std::min(size_t(8), length); i++)
 	{
 		rv <<= 8;
 		rv += byteString[i];
@@ -225,6 +421,20 @@ const unsigned long ByteString::long_val() const
 	return rv;
 }
 
+// Decode an 8 byte big-endian value
+/* static */ unsigned long ByteString::decodeULong(const unsigned char* data)
+{
+	unsigned long rv = 0;
+
+	for (size_t i = 0; i < 8; i++)
+	{
+		rv <<= 8;
+		rv += data[i];
+	}
+
+	return rv;
+}
+
 // Cut of the first part of the string and convert it to a long value
 unsigned long ByteString::firstLong()
 {
@@ -240,7 +450,7 @@ ByteString ByteString::split(size_t len)
 {
 	ByteString rv = substr(0, len);
 
-	size_t newSize = (byteString.size() > len) ? (byteString.size() - len) : 0;
+	size_t newSize = (length > len) ? (length - len) : 0;
 
 	if (newSize > 0)
 	{
@@ -250,7 +460,7 @@ ByteString ByteString::split(size_t len)
 		}
 	}
 
-	byteString.resize(newSize);
+	resize(newSize);
 
 	return rv;
 }
@@ -258,11 +468,11 @@ ByteString ByteString::split(size_t len)
 // The size of the byte string in bits
 size_t ByteString::bits() const
 {
-	size_t bits = byteString.size() * 8;
+	size_t bits = length * 8;
 
 	if (bits == 0) return 0;
 
-	for (size_t i = 0; i < byteString.size(); i++)
+	for (size_t i = 0; i < length; i++)
 	{
 		unsigned char byte = byteString[i];
 
@@ -285,19 +495,38 @@ size_t ByteString::bits() const
 // The size of the byte string in bytes
 size_t ByteString::size() const
 {
-	return byteString.size();
+	return length;
+}
+
+// Is the string public?
+bool ByteString::isPublic() const
+{
+	return publicData;
 }
 
 void ByteString::resize(const size_t newSize)
 {
-	byteString.resize(newSize);
+	if (newSize > length)
+	{
+		reserve(newSize);
+
+		// New bytes are zeroed
+		memset(&byteString[length], 0x00, newSize - length);
+	}
+	else
+	{
+		// Wipe the part that is cut off
+		memset(&byteString[newSize], 0x00, length - newSize);
+	}
+
+	length = newSize;
 }
 
 void ByteString::wipe(const size_t newSize /* = 0 */)
 {
 	this->resize(newSize);
 
-	memset(&byteString[0], 0x00, byteString.size());
+	memset(byteString, 0x00, length);
 }
 
 // Comparison
@@ -308,7 +537,7 @@ bool ByteString::operator==(const ByteString& compareTo) const
 		return false;
 	}
 
-	return (memcmp(&byteString[0], &compareTo.byteString[0], this->size()) == 0);
+	return (memcmp(byteString, &compareTo.byteString[0], this->size()) == 0);
 }
 
 bool ByteString::operator!=(const ByteString& compareTo) const
@@ -318,7 +547,7 @@ bool ByteString::operator!=(const ByteString& compareTo) const
 		return true;
 	}
 
-	return (memcmp(&byteString[0], &compareTo.byteString[0], this->size()) != 0);
+	return (memcmp(byteString, &compareTo.byteString[0], this->size()) != 0);
 }
 
 // XOR data
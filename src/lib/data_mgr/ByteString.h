@@ -27,7 +27,12 @@
 /*****************************************************************************
  ByteString.h
 
- A string class for byte strings stored in securely allocated memory
+ A string class for byte strings stored in securely allocated memory. Strings
+ that are created as public, such as encoded lengths and attribute headers,
+ are kept in a buffer inside the object itself while they are short, so they
+ do not need to be allocated from the SecureArena; this buffer is wiped when
+ the object is destroyed or the string moves to the heap. A public string
+ becomes secret as soon as secret data is assigned or appended to it
  *****************************************************************************/
 
 #ifndef _SOFTHSM_V2_BYTESTRING_H
@@ -49,19 +54,44 @@
 class ByteString
 {
 public:
+	// The kind of data that is stored in a byte string
+	enum Kind
+	{
+		Secret,
+		Public
+	};
+
 	// Constructors
 	ByteString();
 
-	ByteString(const unsigned char* bytes, const size_t bytesLen);
+	explicit ByteString(const Kind kind);
+
+	ByteString(const unsigned char* bytes, const size_t bytesLen, const Kind kind = Secret);
 
 	ByteString(const char* hexString);
 
+	// Encoded values are public
 	ByteString(const unsigned long longValue);
 
 	ByteString(const ByteString& in);
 
+#if __cplusplus >= 201103L
+	ByteString(ByteString&& in);
+#endif
+
 	// Destructor
-	virtual ~ByteString() { }
+	virtual ~ByteString();
+
+	// Assignment
+	ByteString& operator=(const ByteString& in);
+
+#if __cplusplus >= 201103L
+	ByteString& operator=(ByteString&& in);
+#endif
+
+	// Exchange the contents with another byte string without copying
+	// heap allocated data
+	void swap(ByteString& other);
 
 	// Append data
 	ByteString& operator+=(const ByteString& append);
@@ -97,6 +127,9 @@ public:
 	// Return the size in bytes
 	size_t size() const;
 
+	// Is the string public?
+	bool isPublic() const;
+
 	// Resize
 	void resize(const size_t newSize);
 
@@ -115,8 +148,38 @@ public:
 
 	static ByteString chainDeserialise(ByteString& serialised);
 
+	// Decode an 8 byte big-endian value as encoded by ByteString(unsigned long)
+	static unsigned long decodeULong(const unsigned char* data);
+
+	// Number of bytes of a public string that are stored without
+	// allocating memory
+	static const size_t INLINE_SIZE = 64;
+
 private:
-	std::vector<unsigned char, SecureAllocator<unsigned char> > byteString;
+	// Make room for at least newCapacity bytes
+	void reserve(const size_t newCapacity);
+
+	// Move the data to secure memory if the string is public
+	void makeSecret();
+
+	// Release heap allocated data and return to the inline buffer
+	void release();
+
+	// Take over the contents of another byte string, leaving it empty
+	void take(ByteString& from);
+
+	// The data; points to either inlineData or memory from the SecureArena
+	unsigned char* byteString;
+
+	// Only public strings use the inline buffer
+	bool publicData;
+
+	// The length of the string and the size of the memory it is stored in
+	size_t length;
+	size_t capacity;
+
+	// Storage for short public strings
+	unsigned char inlineData[INLINE_SIZE];
 };
 
 // Add data
@@ -39,12 +39,9 @@
 #include <limits>
 #include <stdlib.h>
 #include <string.h>
-#ifdef SENSITIVE_NON_PAGED
-#include <sys/mman.h>
-#endif // SENSITIVE_NON_PAGED
 #include "config.h"
 #include "log.h"
-#include "SecureMemoryRegistry.h"
+#include "SecureArena.h"
 
 template<class T> class SecureAllocator
 {
@@ -94,9 +91,7 @@ public:
 	// Allocate n elements of type T
 	inline pointer allocate(size_type n, const void* = NULL)
 	{
-#ifdef SENSITIVE_NON_PAGED
-		// Allocate memory on a page boundary
-		pointer r = (pointer) valloc(n * sizeof(T));
+		pointer r = (pointer) SecureArena::i()->allocate(n * sizeof(T));
 
 		if (r == NULL)
 		{
@@ -105,60 +100,13 @@ public:
 			return NULL;
 		}
 
-		// Lock the memory so it doesn't get swapped out
-		if (mlock((const void*) r, n * sizeof(T)) != 0)
-		{
-			ERROR_MSG("Could not allocate non-paged memory for secure storage");
-
-			// Hmmm... best to not return any allocated space in this case
-			free(r);
-
-			return NULL;
-		}
-
-		// Register the memory in the secure memory registry
-		SecureMemoryRegistry::i()->add(r, n * sizeof(T));
-
 		return r;
-#else
-		pointer r = (pointer)(::operator new(n * sizeof(T)));
-
-		if (r == NULL)
-		{
-			ERROR_MSG("Out of memory");
-
-			return NULL;
-		}
-
-		// Register the memory in the secure memory registry
-		SecureMemoryRegistry::i()->add(r, n * sizeof(T));
-
-		return r;
-#endif // SENSITIVE_NON_PAGED
 	}
 
-	// Deallocate n elements of type T
+	// Deallocate n elements of type T; the memory is wiped by the arena
 	inline void deallocate(pointer p, size_type n)
 	{
-#ifdef PARANOID
-		// First toggle all bits on
-		memset(p, 0xFF, n * sizeof(T));
-#endif // PARANOID
-
-		// Toggle all bits off
-		memset(p, 0x00, n * sizeof(T));
-
-		// Unregister the memory from the secure memory registry
-		SecureMemoryRegistry::i()->remove(p);
-
-#ifdef SENSITIVE_NON_PAGED
-		munlock((const void*) p, n * sizeof(T));
-
-		free(p);
-#else
-		// Release the memory
-		::operator delete((void*) p);
-#endif // SENSITIVE_NON_PAGED
+		SecureArena::i()->deallocate(p, n * sizeof(T));
 	}
 
 	// Initialise allocate storage with a value
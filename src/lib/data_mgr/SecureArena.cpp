@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ SecureArena.cpp
+
+ Implements a singleton class that hands out securely allocated memory from
+ slabs of locked pages, using a lock-free cache of free blocks per thread
+ *****************************************************************************/
+
+#include "config.h"
+#include "log.h"
+#include "SecureArena.h"
+#include "SecureMemoryRegistry.h"
+#include <string.h>
+#ifdef SENSITIVE_NON_PAGED
+#include <sys/mman.h>
+#endif // SENSITIVE_NON_PAGED
+
+// Initialise the one-and-only instance
+SecureArena* SecureArena::instance = NULL;
+
+// Deletes the key of the thread caches when the library is unloaded; a key
+// that outlives the library would make every exiting thread call its
+// destructor in unmapped code. Memory that is released afterwards goes to
+// the shared free lists
+static struct CacheKeyGuard
+{
+	~CacheKeyGuard()
+	{
+		SecureArena* arena = SecureArena::instance;
+
+		if ((arena == NULL) || !arena->cacheKeyValid) return;
+
+		arena->cacheKeyValid = false;
+
+		// The blocks in the cache of the unloading thread are not returned,
+		// since the secure memory may already have been wiped
+		free(pthread_getspecific(arena->cacheKey));
+
+		pthread_key_delete(arena->cacheKey);
+	}
+} cacheKeyGuard;
+
+// Constructor
+SecureArena::SecureArena()
+{
+	for (size_t i = 0; i < NR_CLASSES; i++)
+	{
+		freeBlocks[i] = NULL;
+	}
+
+	pthread_mutex_init(&arenaMutex, NULL);
+
+	cacheKeyValid = (pthread_key_create(&cacheKey, releaseThreadCache) == 0);
+
+	if (!cacheKeyValid)
+	{
+		ERROR_MSG("Could not create the key for the secure memory thread caches");
+	}
+}
+
+// Return the one-and-only instance; see SecureArena.h on why the first call
+// must not be raced
+SecureArena* SecureArena::i()
+{
+	if (instance == NULL)
+	{
+		instance = new SecureArena();
+
+		if (instance == NULL)
+		{
+			// This is very bad!
+			ERROR_MSG("Fatal: failed to instantiate SecureArena");
+
+			exit(-1);
+		}
+	}
+
+	return instance;
+}
+
+// Allocate a block of len bytes
+void* SecureArena::allocate(size_t len)
+{
+	if (len > MAX_BLOCK) return allocateDirect(len);
+
+	size_t sizeClass = getSizeClass(len);
+	ThreadCache* cache = getThreadCache();
+
+	// Without a thread cache every block comes from the shared list
+	if (cache == NULL)
+	{
+		pthread_mutex_lock(&arenaMutex);
+
+		if ((freeBlocks[sizeClass] == NULL) && !newSlab(sizeClass))
+		{
+			pthread_mutex_unlock(&arenaMutex);
+
+			return NULL;
+		}
+
+		FreeBlock* block = freeBlocks[sizeClass];
+		freeBlocks[sizeClass] = block->next;
+
+		pthread_mutex_unlock(&arenaMutex);
+
+		block->next = NULL;
+
+		return block;
+	}
+
+	if ((cache->blocks[sizeClass] == NULL) && !refill(cache, sizeClass))
+	{
+		return NULL;
+	}
+
+	FreeBlock* block = cache->blocks[sizeClass];
+	cache->blocks[sizeClass] = block->next;
+	cache->count[sizeClass]--;
+
+	block->next = NULL;
+
+	return block;
+}
+
+// Wipe and release a block of len bytes
+void SecureArena::deallocate(void* ptr, size_t len)
+{
+	if (ptr == NULL) return;
+
+	if (len > MAX_BLOCK)
+	{
+		deallocateDirect(ptr, len);
+
+		return;
+	}
+
+	size_t sizeClass = getSizeClass(len);
+
+	// Wipe the whole block, not just the part that was asked for
+#ifdef PARANOID
+	// First toggle all bits on
+	memset(ptr, 0xFF, MIN_BLOCK << sizeClass);
+#endif // PARANOID
+
+	// Toggle all bits off
+	memset(ptr, 0x00, MIN_BLOCK << sizeClass);
+
+	FreeBlock* block = (FreeBlock*) ptr;
+	ThreadCache* cache = getThreadCache();
+
+	if (cache == NULL)
+	{
+		pthread_mutex_lock(&arenaMutex);
+
+		block->next = freeBlocks[sizeClass];
+		freeBlocks[sizeClass] = block;
+
+		pthread_mutex_unlock(&arenaMutex);
+
+		return;
+	}
+
+	block->next = cache->blocks[sizeClass];
+	cache->blocks[sizeClass] = block;
+	cache->count[sizeClass]++;
+
+	// Give some of the blocks back if the cache gets too big
+	if (cache->count[sizeClass] > CACHE_BLOCKS)
+	{
+		drain(cache, sizeClass, CACHE_BLOCKS - BATCH_BLOCKS);
+	}
+}
+
+// Return the size class for a block of len bytes
+/*static*/ size_t SecureArena::getSizeClass(size_t len)
+{
+	size_t sizeClass = 0;
+
+	while ((MIN_BLOCK << sizeClass) < len)
+	{
+		sizeClass++;
+	}
+
+	return sizeClass;
+}
+
+// Get the cache of the calling thread
+SecureArena::ThreadCache* SecureArena::getThreadCache()
+{
+	if (!cacheKeyValid) return NULL;
+
+	ThreadCache* cache = (ThreadCache*) pthread_getspecific(cacheKey);
+
+	if (cache != NULL) return cache;
+
+	// The cache only holds pointers to free blocks, so it does not
+	// need to be allocated securely
+	cache = (ThreadCache*) calloc(1, sizeof(ThreadCache));
+
+	if (cache == NULL) return NULL;
+
+	if (pthread_setspecific(cacheKey, cache) != 0)
+	{
+		free(cache);
+
+		return NULL;
+	}
+
+	return cache;
+}
+
+// Move a batch of blocks from the shared free list to a thread cache
+bool SecureArena::refill(ThreadCache* cache, size_t sizeClass)
+{
+	pthread_mutex_lock(&arenaMutex);
+
+	if ((freeBlocks[sizeClass] == NULL) && !newSlab(sizeClass))
+	{
+		pthread_mutex_unlock(&arenaMutex);
+
+		return false;
+	}
+
+	for (size_t n = 0; (n < BATCH_BLOCKS) && (freeBlocks[sizeClass] != NULL); n++)
+	{
+		FreeBlock* block = freeBlocks[sizeClass];
+		freeBlocks[sizeClass] = block->next;
+
+		block->next = cache->blocks[sizeClass];
+		cache->blocks[sizeClass] = block;
+		cache->count[sizeClass]++;
+	}
+
+	pthread_mutex_unlock(&arenaMutex);
+
+	return true;
+}
+
+// Move blocks from a thread cache to the shared free list
+void SecureArena::drain(ThreadCache* cache, size_t sizeClass, size_t keep)
+{
+	if (cache->count[sizeClass] <= keep) return;
+
+	// Unlink the surplus blocks before taking the lock
+	FreeBlock* first = cache->blocks[sizeClass];
+	FreeBlock* last = first;
+
+	for (size_t n = cache->count[sizeClass] - keep; n > 1; n--)
+	{
+		last = last->next;
+	}
+
+	cache->blocks[sizeClass] = last->next;
+	cache->count[sizeClass] = keep;
+
+	pthread_mutex_lock(&arenaMutex);
+
+	last->next = freeBlocks[sizeClass];
+	freeBlocks[sizeClass] = first;
+
+	pthread_mutex_unlock(&arenaMutex);
+}
+
+// Create a new slab for a size class
+bool SecureArena::newSlab(size_t sizeClass)
+{
+	void* slab = allocateDirect(SLAB_SIZE);
+
+	if (slab == NULL) return false;
+
+	// Carve the slab into blocks
+	size_t blockSize = MIN_BLOCK << sizeClass;
+	unsigned char* start = (unsigned char*) slab;
+
+	for (size_t offset = SLAB_SIZE; offset >= blockSize; offset -= blockSize)
+	{
+		FreeBlock* block = (FreeBlock*) (start + offset - blockSize);
+
+		block->next = freeBlocks[sizeClass];
+		freeBlocks[sizeClass] = block;
+	}
+
+	return true;
+}
+
+// Allocate a block that is not taken from a slab
+/*static*/ void* SecureArena::allocateDirect(size_t len)
+{
+#ifdef SENSITIVE_NON_PAGED
+	// Allocate memory on a page boundary
+	void* ptr = (void*) valloc(len);
+
+	if (ptr == NULL)
+	{
+		ERROR_MSG("Out of memory");
+
+		return NULL;
+	}
+
+	// Lock the memory so it doesn't get swapped out
+	if (mlock((const void*) ptr, len) != 0)
+	{
+		ERROR_MSG("Could not allocate non-paged memory for secure storage");
+
+		// Hmmm... best to not return any allocated space in this case
+		free(ptr);
+
+		return NULL;
+	}
+#else
+	void* ptr = (void*) malloc(len);
+
+	if (ptr == NULL)
+	{
+		ERROR_MSG("Out of memory");
+
+		return NULL;
+	}
+#endif // SENSITIVE_NON_PAGED
+
+	memset(ptr, 0x00, len);
+
+	// Register the memory in the secure memory registry
+	SecureMemoryRegistry::i()->add(ptr, len);
+
+	return ptr;
+}
+
+// Release a block that is not taken from a slab
+/*static*/ void SecureArena::deallocateDirect(void* ptr, size_t len)
+{
+#ifdef PARANOID
+	// First toggle all bits on
+	memset(ptr, 0xFF, len);
+#endif // PARANOID
+
+	// Toggle all bits off
+	memset(ptr, 0x00, len);
+
+	// Unregister the memory from the secure memory registry
+	SecureMemoryRegistry::i()->remove(ptr);
+
+#ifdef SENSITIVE_NON_PAGED
+	munlock((const void*) ptr, len);
+#endif // SENSITIVE_NON_PAGED
+
+	free(ptr);
+}
+
+// Return the cache of a thread that exits to the shared free lists
+/*static*/ void SecureArena::releaseThreadCache(void* cache)
+{
+	ThreadCache* threadCache = (ThreadCache*) cache;
+
+	for (size_t i = 0; i < NR_CLASSES; i++)
+	{
+		instance->drain(threadCache, i, 0);
+	}
+
+	free(threadCache);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ SecureArena.h
+
+ Implements a singleton class that hands out securely allocated memory. Small
+ blocks are carved from slabs of (if SENSITIVE_NON_PAGED is defined) locked
+ pages; every slab serves a single size class and is registered with the
+ secure memory registry as a whole, so that allocating or freeing a block
+ does not have to update the registry. Each thread keeps a cache of free
+ blocks per size class that it uses without locking; a lock is only taken
+ to move a batch of blocks between a thread cache and the shared free lists,
+ or to create a new slab. Slabs are kept until the process exits.
+
+ Blocks that are larger than the largest size class are allocated and
+ registered individually.
+
+ The shared free lists are protected by a POSIX mutex rather than by one
+ from the MutexFactory, since memory is allocated before the application
+ supplies its locking functions to C_Initialize.
+ *****************************************************************************/
+
+#ifndef _SOFTHSM_V2_SECUREARENA_H
+#define _SOFTHSM_V2_SECUREARENA_H
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "config.h"
+
+class SecureArena
+{
+public:
+	// Return the one-and-only instance; the instance is created on first
+	// use without any locking, so the first call must not be raced by
+	// another thread. Secure memory is already used while the library is
+	// loaded and before C_Initialize, when no locking is available yet
+	static SecureArena* i();
+
+	// Allocate a block of len bytes
+	void* allocate(size_t len);
+
+	// Wipe and release a block of len bytes; len must be the size that
+	// was passed when the block was allocated
+	void deallocate(void* ptr, size_t len);
+
+	// Number of size classes, and the smallest and largest class
+	static const size_t NR_CLASSES = 8;
+	static const size_t MIN_BLOCK = 16;
+	static const size_t MAX_BLOCK = MIN_BLOCK << (NR_CLASSES - 1);
+
+private:
+	// A free block; the link is stored in the block itself
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	// The free blocks a thread keeps for itself
+	struct ThreadCache
+	{
+		FreeBlock* blocks[NR_CLASSES];
+		size_t count[NR_CLASSES];
+	};
+
+	// Size of a slab, the number of blocks a thread cache may hold per
+	// size class, and the number of blocks moved at a time
+	static const size_t SLAB_SIZE = 64 * 1024;
+	static const size_t CACHE_BLOCKS = 64;
+	static const size_t BATCH_BLOCKS = 32;
+
+	// Constructor
+	SecureArena();
+
+	// Return the size class for a block of len bytes
+	static size_t getSizeClass(size_t len);
+
+	// Get the cache of the calling thread; creates it if needed
+	ThreadCache* getThreadCache();
+
+	// Move a batch of blocks from the shared free list to a thread cache
+	bool refill(ThreadCache* cache, size_t sizeClass);
+
+	// Move blocks from a thread cache to the shared free list until no
+	// more than keep blocks are left
+	void drain(ThreadCache* cache, size_t sizeClass, size_t keep);
+
+	// Create a new slab for a size class and add its blocks to the
+	// shared free list; arenaMutex must be held
+	bool newSlab(size_t sizeClass);
+
+	// Allocate and release a block that is not taken from a slab
+	static void* allocateDirect(size_t len);
+	static void deallocateDirect(void* ptr, size_t len);
+
+	// Return the cache of a thread that exits to the shared free lists
+	static void releaseThreadCache(void* cache);
+
+	// The one-and-only instance
+	static SecureArena* instance;
+
+	// The shared free lists
+	FreeBlock* freeBlocks[NR_CLASSES];
+
+	// The key of the thread caches; it is deleted when the library is
+	// unloaded by the CacheKeyGuard in SecureArena.cpp
+	pthread_key_t cacheKey;
+	bool cacheKeyValid;
+	friend struct CacheKeyGuard;
+
+	// Protects the shared free lists
+	pthread_mutex_t arenaMutex;
+};
+
+#endif // !_SOFTHSM_V2_SECUREARENA_H
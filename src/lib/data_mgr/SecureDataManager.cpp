@@ -45,6 +45,7 @@
 #include "AESKey.h"
 #include "SymmetricAlgorithm.h"
 #include "RFC4880.h"
+#include <string.h>
 
 // Constructors
 
@@ -54,9 +55,6 @@ void SecureDataManager::initObject()
 	// Get an RNG instance
 	rng = CryptoFactory::i()->getRNG();
 
-	// Get an AES implementation
-	aes = CryptoFactory::i()->getSymmetricAlgorithm("aes");
-
 	// Initialise masking data
 	mask = new ByteString();
 
@@ -68,6 +66,11 @@ void SecureDataManager::initObject()
 	// Set the magic
 	magic = ByteString("524A52"); // RJR
 
+	// Tokens created by earlier versions use AES-CBC
+	scheme = AES_CBC;
+
+	keyGeneration = 0;
+
 	// Get a mutex
 	dataMgrMutex = MutexFactory::i()->getMutex();
 }
@@ -80,10 +83,12 @@ SecureDataManager::SecureDataManager()
 }
 
 // Constructs a SecureDataManager using the specified key blob
-SecureDataManager::SecureDataManager(const ByteString& soPINBlob, const ByteString& userPINBlob)
+SecureDataManager::SecureDataManager(const ByteString& soPINBlob, const ByteString& userPINBlob, const EncryptionScheme scheme /* = AES_CBC */)
 {
 	initObject();
 
+	this->scheme = scheme;
+
 	// De-serialise the key blob
 	soEncryptedKey = soPINBlob;
 	userEncryptedKey = userPINBlob;
@@ -92,8 +97,16 @@ SecureDataManager::SecureDataManager(const ByteString& soPINBlob, const ByteStri
 // Destructor
 SecureDataManager::~SecureDataManager()
 {
-	// Recycle the AES instance
-	CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
+	// Recycle the AES instances
+	for (std::vector<SymmetricAlgorithm*>::iterator i = aesPool.begin(); i != aesPool.end(); i++)
+	{
+		CryptoFactory::i()->recycleSymmetricAlgorithm(*i);
+	}
+
+	for (std::vector<SymmetricAlgorithm*>::iterator i = keyPool.begin(); i != keyPool.end(); i++)
+	{
+		CryptoFactory::i()->recycleSymmetricAlgorithm(*i);
+	}
 
 	// Clean up the mask
 	delete mask;
@@ -101,6 +114,39 @@ SecureDataManager::~SecureDataManager()
 	MutexFactory::i()->recycleMutex(dataMgrMutex);
 }
 
+// Returns the scheme to use for new tokens
+/*static*/ SecureDataManager::EncryptionScheme SecureDataManager::getDefaultScheme()
+{
+	SymmetricAlgorithm* aes = CryptoFactory::i()->getSymmetricAlgorithm(SymAlgo::AES);
+
+	if (aes == NULL) return AES_CBC;
+
+	// Check if the backend accepts GCM
+	AESKey key(256);
+	ByteString keyBits;
+	keyBits.resize(32);
+	memset(&keyBits[0], 0, 32);
+	key.setKeyBits(keyBits);
+
+	ByteString IV;
+	IV.resize(12);
+	memset(&IV[0], 0, 12);
+
+	EncryptionScheme rv = AES_CBC;
+
+	if (aes->encryptInit(&key, "gcm", IV, false, 0, ByteString(), 16))
+	{
+		ByteString dummy;
+		aes->encryptFinal(dummy);
+
+		rv = AES_GCM;
+	}
+
+	CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
+
+	return rv;
+}
+
 // Generic function for creating an encrypted version of the key from the specified passphrase
 bool SecureDataManager::pbeEncryptKey(const ByteString& passphrase, ByteString& encryptedKey)
 {
@@ -117,6 +163,15 @@ bool SecureDataManager::pbeEncryptKey(const ByteString& passphrase, ByteString&
 		return false;
 	}
 
+	SymmetricAlgorithm* aes = getAES();
+
+	if (aes == NULL)
+	{
+		delete pbeKey;
+
+		return false;
+	}
+
 	// Add the salt
 	encryptedKey.wipe();
 	encryptedKey += salt;
@@ -124,7 +179,13 @@ bool SecureDataManager::pbeEncryptKey(const ByteString& passphrase, ByteString&
 	// Generate random IV
 	ByteString IV;
 
-	if (!rng->generateRandom(IV, aes->getBlockSize())) return false;
+	if (!rng->generateRandom(IV, aes->getBlockSize()))
+	{
+		recycleAES(aes);
+		delete pbeKey;
+
+		return false;
+	}
 
 	// Add the IV
 	encryptedKey += IV;
@@ -134,6 +195,7 @@ bool SecureDataManager::pbeEncryptKey(const ByteString& passphrase, ByteString&
 
 	if (!aes->encryptInit(pbeKey, "cbc", IV)) 
 	{
+		CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
 		delete pbeKey;
 
 		return false;
@@ -142,6 +204,7 @@ bool SecureDataManager::pbeEncryptKey(const ByteString& passphrase, ByteString&
 	// First, add the magic
 	if (!aes->encryptUpdate(magic, block))
 	{
+		CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
 		delete pbeKey;
 
 		return false;
@@ -163,6 +226,7 @@ bool SecureDataManager::pbeEncryptKey(const ByteString& passphrase, ByteString&
 	
 		if (!rv) 
 		{
+			CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
 			delete pbeKey;
 		
 			return false;
@@ -174,6 +238,7 @@ bool SecureDataManager::pbeEncryptKey(const ByteString& passphrase, ByteString&
 	// And finalise encryption
 	if (!aes->encryptFinal(block)) 
 	{
+		CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
 		delete pbeKey;
 		
 		return false;
@@ -181,6 +246,7 @@ bool SecureDataManager::pbeEncryptKey(const ByteString& passphrase, ByteString&
 
 	encryptedKey += block;
 
+	recycleAES(aes);
 	delete pbeKey;
 
 	return true;
@@ -249,6 +315,10 @@ bool SecureDataManager::login(const ByteString& passphrase, const ByteString& en
 	// Log out first
 	this->logout();
 
+	SymmetricAlgorithm* aes = getAES();
+
+	if (aes == NULL) return false;
+
 	// First, take the salt from the encrypted key
 	ByteString salt = encryptedKey.substr(0,8);
 
@@ -263,6 +333,8 @@ bool SecureDataManager::login(const ByteString& passphrase, const ByteString& en
 
 	if (!RFC4880::PBEDeriveKey(passphrase, salt, &pbeKey))
 	{
+		recycleAES(aes);
+
 		return false;
 	}
 
@@ -275,11 +347,13 @@ bool SecureDataManager::login(const ByteString& passphrase, const ByteString& en
 	    !aes->decryptUpdate(encryptedKeyData, decryptedKeyData) ||
 	    !aes->decryptFinal(finalBlock))
 	{
+		CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
 		delete pbeKey;
 
 		return false;
 	}
 
+	recycleAES(aes);
 	delete pbeKey;
 
 	decryptedKeyData += finalBlock;
@@ -327,49 +401,60 @@ void SecureDataManager::logout()
 
 	// Clear the masked key
 	maskedKey.wipe();
+
+	// Discard the expanded key
+	flushKeyPool();
 }
 
 // Decrypt the supplied data
 bool SecureDataManager::decrypt(const ByteString& encrypted, ByteString& plaintext)
 {
-	// Check the object logged in state
-	if ((!userLoggedIn && !soLoggedIn) || (maskedKey.size() != 32))
-	{
-		return false;
-	}
+	unsigned long generation;
+	SymmetricAlgorithm* aes = getKeyAES(generation);
 
-	AESKey theKey(256);
-	ByteString unmaskedKey;
+	if (aes == NULL) return false;
 
-	{
-		MutexLocker lock(dataMgrMutex);
+	// Take the IV from the input data; GCM also needs room for the tag
+	size_t ivLen = (scheme == AES_GCM) ? 12 : aes->getBlockSize();
+	size_t tagLen = (scheme == AES_GCM) ? 16 : 0;
+	ByteString IV = encrypted.substr(0, ivLen);
 
-		unmask(unmaskedKey);
+	if ((IV.size() != ivLen) || (encrypted.size() < ivLen + tagLen))
+	{
+		ERROR_MSG("Invalid IV in encrypted data");
 
-		theKey.setKeyBits(unmaskedKey);
+		recycleKeyAES(aes, generation);
 
-		remask(unmaskedKey);
+		return false;
 	}
-	
-	// Take the IV from the input data
-	ByteString IV = encrypted.substr(0, aes->getBlockSize());
 
-	if (IV.size() != aes->getBlockSize())
+	// Use the expanded key if the instance holds it, otherwise supply it
+	if (!initOperation(aes, NULL, IV, false))
 	{
-		ERROR_MSG("Invalid IV in encrypted data");
+		AESKey theKey(256);
 
-		return false;
+		if (!getKey(theKey, generation) || !initOperation(aes, &theKey, IV, false))
+		{
+			recycleKeyAES(aes, generation);
+
+			return false;
+		}
 	}
 
 	ByteString finalBlock;
 
-	if (!aes->decryptInit(&theKey, "cbc", IV) ||
-	    !aes->decryptUpdate(encrypted.substr(aes->getBlockSize()), plaintext) ||
+	// With GCM the plaintext is only returned once the tag has been checked
+	if (!aes->decryptUpdate(encrypted.substr(ivLen), plaintext) ||
 	    !aes->decryptFinal(finalBlock))
 	{
+		// A failed operation may leave the instance in an undefined state
+		CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
+
 		return false;
 	}
 
+	recycleKeyAES(aes, generation);
+
 	plaintext += finalBlock;
 
 	return true;
@@ -378,42 +463,50 @@ bool SecureDataManager::decrypt(const ByteString& encrypted, ByteString& plainte
 // Encrypt the supplied data
 bool SecureDataManager::encrypt(const ByteString& plaintext, ByteString& encrypted)
 {
-	// Check the object logged in state
-	if ((!userLoggedIn && !soLoggedIn) || (maskedKey.size() != 32))
-	{
-		return false;
-	}
+	unsigned long generation;
+	SymmetricAlgorithm* aes = getKeyAES(generation);
 
-	AESKey theKey(256);
-	ByteString unmaskedKey;
+	if (aes == NULL) return false;
 
-	{
-		MutexLocker lock(dataMgrMutex);
+	// Wipe encrypted data block
+	encrypted.wipe();
 
-		unmask(unmaskedKey);
+	// Generate random IV; GCM uses a 96-bit IV
+	ByteString IV;
 
-		theKey.setKeyBits(unmaskedKey);
+	if (!rng->generateRandom(IV, (scheme == AES_GCM) ? 12 : aes->getBlockSize()))
+	{
+		recycleKeyAES(aes, generation);
 
-		remask(unmaskedKey);
+		return false;
 	}
 
-	// Wipe encrypted data block
-	encrypted.wipe();
+	// Use the expanded key if the instance holds it, otherwise supply it
+	if (!initOperation(aes, NULL, IV, true))
+	{
+		AESKey theKey(256);
 
-	// Generate random IV
-	ByteString IV;
+		if (!getKey(theKey, generation) || !initOperation(aes, &theKey, IV, true))
+		{
+			recycleKeyAES(aes, generation);
 
-	if (!rng->generateRandom(IV, aes->getBlockSize())) return false;
+			return false;
+		}
+	}
 
 	ByteString finalBlock;
 
-	if (!aes->encryptInit(&theKey, "cbc", IV) ||
-	    !aes->encryptUpdate(plaintext, encrypted) ||
+	// With GCM the final block is the tag
+	if (!aes->encryptUpdate(plaintext, encrypted) ||
 	    !aes->encryptFinal(finalBlock))
 	{
+		CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
+
 		return false;
 	}
 
+	recycleKeyAES(aes, generation);
+
 	encrypted += finalBlock;
 
 	// Add IV to output data
@@ -422,6 +515,19 @@ bool SecureDataManager::encrypt(const ByteString& plaintext, ByteString& encrypt
 	return true;
 }
 
+// Start an operation using the encryption scheme
+bool SecureDataManager::initOperation(SymmetricAlgorithm* aes, const AESKey* key, const ByteString& IV, bool encrypt)
+{
+	if (scheme == AES_GCM)
+	{
+		return encrypt ?
+			aes->encryptInit(key, "gcm", IV, false, 0, ByteString(), 16) :
+			aes->decryptInit(key, "gcm", IV, false, 0, ByteString(), 16);
+	}
+
+	return encrypt ? aes->encryptInit(key, "cbc", IV) : aes->decryptInit(key, "cbc", IV);
+}
+
 // Returns the key blob for the SO PIN
 ByteString SecureDataManager::getSOPINBlob()
 {
@@ -434,6 +540,12 @@ ByteString SecureDataManager::getUserPINBlob()
 	return userEncryptedKey;
 }
 
+// Returns the scheme used to encrypt sensitive attributes
+SecureDataManager::EncryptionScheme SecureDataManager::getEncryptionScheme()
+{
+	return scheme;
+}
+
 // Unmask the key
 void SecureDataManager::unmask(ByteString& key)
 {
@@ -451,6 +563,134 @@ void SecureDataManager::remask(ByteString& key)
 	maskedKey = key;
 }
 
+// Retrieve the unmasked key if someone is logged in
+bool SecureDataManager::getKey(AESKey& key, unsigned long generation)
+{
+	MutexLocker lock(dataMgrMutex);
+
+	// Check the object logged in state, and that there was no logout
+	// since the caller took its AES instance
+	if ((!userLoggedIn && !soLoggedIn) || (maskedKey.size() != 32) || (generation != keyGeneration))
+	{
+		return false;
+	}
+
+	ByteString unmaskedKey;
+
+	unmask(unmaskedKey);
+
+	key.setKeyBits(unmaskedKey);
+
+	remask(unmaskedKey);
+
+	return true;
+}
+
+// Take an AES instance from the pool
+SymmetricAlgorithm* SecureDataManager::getAES()
+{
+	{
+		MutexLocker lock(dataMgrMutex);
+
+		if (!aesPool.empty())
+		{
+			SymmetricAlgorithm* aes = aesPool.back();
+
+			aesPool.pop_back();
+
+			return aes;
+		}
+	}
+
+	// All instances are in use; create a new one
+	SymmetricAlgorithm* aes = CryptoFactory::i()->getSymmetricAlgorithm(SymAlgo::AES);
+
+	if (aes == NULL)
+	{
+		ERROR_MSG("Could not get an AES instance");
+	}
+
+	return aes;
+}
+
+// Return an AES instance to the pool
+void SecureDataManager::recycleAES(SymmetricAlgorithm* aes)
+{
+	MutexLocker lock(dataMgrMutex);
+
+	aesPool.push_back(aes);
+}
+
+// Take an AES instance for use with the master key
+SymmetricAlgorithm* SecureDataManager::getKeyAES(unsigned long& generation)
+{
+	{
+		MutexLocker lock(dataMgrMutex);
+
+		// Check the object logged in state
+		if ((!userLoggedIn && !soLoggedIn) || (maskedKey.size() != 32))
+		{
+			return NULL;
+		}
+
+		generation = keyGeneration;
+
+		if (!keyPool.empty())
+		{
+			SymmetricAlgorithm* aes = keyPool.back();
+
+			keyPool.pop_back();
+
+			return aes;
+		}
+	}
+
+	// All instances are in use; create a new one
+	SymmetricAlgorithm* aes = CryptoFactory::i()->getSymmetricAlgorithm(SymAlgo::AES);
+
+	if (aes == NULL)
+	{
+		ERROR_MSG("Could not get an AES instance");
+
+		return NULL;
+	}
+
+	aes->setKeyRetention(true);
+
+	return aes;
+}
+
+// Return an AES instance used with the master key
+void SecureDataManager::recycleKeyAES(SymmetricAlgorithm* aes, unsigned long generation)
+{
+	{
+		MutexLocker lock(dataMgrMutex);
+
+		if (generation == keyGeneration)
+		{
+			keyPool.push_back(aes);
+
+			return;
+		}
+	}
+
+	// The instance may hold a key that is no longer valid
+	CryptoFactory::i()->recycleSymmetricAlgorithm(aes);
+}
+
+// Discard the instances holding the expanded key
+void SecureDataManager::flushKeyPool()
+{
+	keyGeneration++;
+
+	for (std::vector<SymmetricAlgorithm*>::iterator i = keyPool.begin(); i != keyPool.end(); i++)
+	{
+		CryptoFactory::i()->recycleSymmetricAlgorithm(*i);
+	}
+
+	keyPool.clear();
+}
+
 // Check if the SO is logged in
 bool SecureDataManager::isSOLoggedIn()
 {
@@ -37,6 +37,18 @@
  in; authentication using the SO PIN is required to be able to change the
  user PIN. The master key that is used to decrypt/encrypt sensitive attributes
  is stored in memory under a mask that is changed every time the key is used.
+
+ Decryption and encryption can be performed by several threads at the same
+ time; only unmasking the key is done under a lock. Every operation takes an
+ AES instance from a pool of instances, so that no instance is shared. The
+ instances used with the master key keep the expanded key for as long as the
+ login lasts, so that the key only needs to be unmasked and expanded once per
+ instance instead of for every attribute; they are discarded on logout.
+
+ Sensitive attributes are encrypted with AES-256-CBC on tokens created by
+ earlier versions and with AES-256-GCM on new tokens; the scheme is recorded
+ in the token object. GCM detects modified attribute values and does not
+ need padding.
  *****************************************************************************/
 
 #ifndef _SOFTHSM_V2_SECUREDATAMANAGER_H
@@ -49,10 +61,22 @@
 #include "RNG.h"
 #include "SymmetricAlgorithm.h"
 #include "MutexFactory.h"
+#include <vector>
 
 class SecureDataManager
 {
 public:
+	// The schemes used to encrypt sensitive attributes
+	enum EncryptionScheme
+	{
+		AES_CBC = 0,	// IV (16 bytes) || AES-256-CBC(data)
+		AES_GCM = 1	// IV (12 bytes) || AES-256-GCM(data) || tag (16 bytes)
+	};
+
+	// Returns the scheme to use for new tokens; this is AES-GCM if the
+	// crypto backend supports it
+	static EncryptionScheme getDefaultScheme();
+
 	// Constructors
 
 	// Constructs a new SecureDataManager for a blank token; actual
@@ -60,7 +84,8 @@ public:
 	SecureDataManager();
 
 	// Constructs a SecureDataManager using the specified SO PIN and user PIN
-	SecureDataManager(const ByteString& soPINBlob, const ByteString& userPINBlob);
+	// and the scheme that is used to encrypt sensitive attributes
+	SecureDataManager(const ByteString& soPINBlob, const ByteString& userPINBlob, const EncryptionScheme scheme = AES_CBC);
 
 	// Destructor
 	virtual ~SecureDataManager();
@@ -96,6 +121,9 @@ public:
 	// Returns the key blob for the user PIN
 	ByteString getUserPINBlob();
 
+	// Returns the scheme used to encrypt sensitive attributes
+	EncryptionScheme getEncryptionScheme();
+
 private:
 	// Initialise the object
 	void initObject();
@@ -112,6 +140,32 @@ private:
 	// Remask the key
 	void remask(ByteString& key);
 
+	// Retrieve the unmasked key if someone is logged in and the key has
+	// not changed since the given generation; remasks the key
+	bool getKey(AESKey& key, unsigned long generation);
+
+	// Take an AES instance from the pool
+	SymmetricAlgorithm* getAES();
+
+	// Return an AES instance to the pool
+	void recycleAES(SymmetricAlgorithm* aes);
+
+	// Take an AES instance for use with the master key; fails if no one
+	// is logged in. The instance may hold the expanded key already
+	SymmetricAlgorithm* getKeyAES(unsigned long& generation);
+
+	// Return an AES instance used with the master key; it is discarded
+	// if the key has changed since it was taken
+	void recycleKeyAES(SymmetricAlgorithm* aes, unsigned long generation);
+
+	// Discard the instances holding the expanded key; dataMgrMutex must
+	// be held
+	void flushKeyPool();
+
+	// Start an operation using the encryption scheme; without a key the
+	// expanded key held by the instance is used
+	bool initOperation(SymmetricAlgorithm* aes, const AESKey* key, const ByteString& IV, bool encrypt);
+
 	// The user PIN encrypted key
 	ByteString userEncryptedKey;
 
@@ -125,6 +179,9 @@ private:
 	// The masked version of the actual key
 	ByteString maskedKey;
 
+	// The scheme used to encrypt sensitive attributes
+	EncryptionScheme scheme;
+
 	// The "magic" data used to detect if a PIN was likely to be correct
 	ByteString magic;
 
@@ -136,8 +193,15 @@ private:
 	// Random number generator instance
 	RNG* rng;
 
-	// AES instance
-	SymmetricAlgorithm* aes;
+	// AES instances that are not in use
+	std::vector<SymmetricAlgorithm*> aesPool;
+
+	// AES instances that are not in use and that hold the expanded master
+	// key of the current login
+	std::vector<SymmetricAlgorithm*> keyPool;
+
+	// Changes whenever the master key is cleared
+	unsigned long keyGeneration;
 
 	// Mutex
 	Mutex* dataMgrMutex;
@@ -29,7 +29,8 @@
 
  Implements a singleton class that keeps track of all securely allocated
  memory. This registry can be used to wipe securely allocated memory in case
- of a fatal exception
+ of a fatal exception. Memory handed out by the SecureArena is registered per
+ slab rather than per allocation
  *****************************************************************************/
 
 #ifndef _SOFTHSM_V2_SECUREMEMORYREGISTRY_H
@@ -33,19 +33,17 @@
 #include "config.h"
 #include "log.h"
 #include "salloc.h"
-#include <limits>
-#ifdef SENSITIVE_NON_PAGED
-#include <sys/mman.h>
-#endif // SENSITIVE_NON_PAGED
-#include <string.h>
-#include "SecureMemoryRegistry.h"
+#include "SecureArena.h"
+
+// The length of an allocation is stored in a header in front of the memory
+// handed out, since sfree is not told how much memory to release; the header
+// is 16 bytes to keep the memory suitably aligned
+#define SALLOC_HEADER	16
 
 // Allocate memory
 void* salloc(size_t len)
 {
-#ifdef SENSITIVE_NON_PAGED
-	// Allocate memory on a page boundary
-	void* ptr = (void*) valloc(len);
+	unsigned char* ptr = (unsigned char*) SecureArena::i()->allocate(len + SALLOC_HEADER);
 
 	if (ptr == NULL)
 	{
@@ -54,56 +52,18 @@ void* salloc(size_t len)
 		return NULL;
 	}
 
-	// Lock the memory so it doesn't get swapped out
-	if (mlock((const void*) ptr, len) != 0)
-	{
-		ERROR_MSG("Could not allocate non-paged memory for secure storage");
-
-		// Hmmm... best to not return any allocated space in this case
-		free(ptr);
-
-		return NULL;
-	}
-
-	// Register the memory in the secure memory registry
-	SecureMemoryRegistry::i()->add(ptr, len);
-
-	return ptr;
-#else
-	void* ptr = (void*) malloc(len);
+	*((size_t*) ptr) = len;
 
-	if (ptr == NULL)
-	{
-		ERROR_MSG("Out of memory");
-
-		return NULL;
-	}
-
-	// Register the memory in the secure memory registry
-	SecureMemoryRegistry::i()->add(ptr, len);
-
-	return ptr;
-#endif // SENSITIVE_NON_PAGED
+	return ptr + SALLOC_HEADER;
 }
 
 // Free memory
 void sfree(void* ptr)
 {
-	// Unregister the memory from the secure memory registry
-	size_t len = SecureMemoryRegistry::i()->remove(ptr);
-
-#ifdef PARANOID
-	// First toggle all bits on
-	memset(ptr, 0xFF, len);
-#endif // PARANOID
+	if (ptr == NULL) return;
 
-	// Toggle all bits off
-	memset(ptr, 0x00, len);
+	unsigned char* start = (unsigned char*) ptr - SALLOC_HEADER;
 
-#ifdef SENSITIVE_NON_PAGED
-	munlock((const void*) ptr, len);
-#endif // SENSITIVE_NON_PAGED
-
-	free(ptr);
+	// The arena wipes the memory before releasing it
+	SecureArena::i()->deallocate(start, *((size_t*) start) + SALLOC_HEADER);
 }
-
@@ -34,6 +34,7 @@
 #include <stdio.h>
 #include <cppunit/extensions/HelperMacros.h>
 #include <string>
+#include <utility>
 #include "ByteStringTests.h"
 #include "ByteString.h"
 
@@ -354,3 +355,132 @@ void ByteStringTests::testSerialising()
 	CPPUNIT_ASSERT(d3 == b1);
 }
 
+
+void ByteStringTests::testGrowAndSwap()
+{
+	// Grow a public string from the inline buffer to the heap one byte at a time
+	ByteString b1(ByteString::Public);
+	ByteString b2;
+
+	for (size_t i = 0; i < 3 * ByteString::INLINE_SIZE; i++)
+	{
+		b1 += (unsigned char) i;
+
+		CPPUNIT_ASSERT(b1.size() == i + 1);
+
+		for (size_t j = 0; j <= i; j++)
+		{
+			CPPUNIT_ASSERT(b1[j] == (unsigned char) j);
+		}
+	}
+
+	// Append a string to itself
+	b2 = b1;
+	b2 += b2;
+
+	CPPUNIT_ASSERT(b2.size() == 2 * b1.size());
+	CPPUNIT_ASSERT(b2.substr(0, b1.size()) == b1);
+	CPPUNIT_ASSERT(b2.substr(b1.size()) == b1);
+
+	// Bytes added by resizing are zero, also after shrinking
+	b2.resize(1);
+	b2.resize(ByteString::INLINE_SIZE);
+
+	CPPUNIT_ASSERT(b2[0] == 0x00);
+
+	for (size_t i = 1; i < b2.size(); i++)
+	{
+		CPPUNIT_ASSERT(b2[i] == 0x00);
+	}
+
+	// Swap a heap allocated string with an inline one and back
+	ByteString heap = b1;
+	ByteString small(ByteString("0102030405").const_byte_str(), 5, ByteString::Public);
+	const unsigned char* heapData = b1.const_byte_str();
+
+	b1.swap(small);
+
+	CPPUNIT_ASSERT(b1 == ByteString("0102030405"));
+	CPPUNIT_ASSERT(small == heap);
+	CPPUNIT_ASSERT(small.const_byte_str() == heapData);
+
+	small.swap(b1);
+
+	CPPUNIT_ASSERT(b1 == heap);
+	CPPUNIT_ASSERT(small == ByteString("0102030405"));
+
+	// Swap two inline strings
+	ByteString b3(ByteString("AABB").const_byte_str(), 2, ByteString::Public);
+
+	b3.swap(small);
+
+	CPPUNIT_ASSERT(b3 == ByteString("0102030405"));
+	CPPUNIT_ASSERT(small == ByteString("AABB"));
+
+#if __cplusplus >= 201103L
+	// Moving a heap allocated string takes over its data
+	ByteString moved(std::move(b1));
+
+	CPPUNIT_ASSERT(moved == heap);
+	CPPUNIT_ASSERT(moved.const_byte_str() == heapData);
+	CPPUNIT_ASSERT(b1.size() == 0);
+
+	b3 = std::move(moved);
+
+	CPPUNIT_ASSERT(b3 == heap);
+	CPPUNIT_ASSERT(moved.size() == 0);
+#endif
+}
+
+// Check if the data of a byte string is stored inside the object
+static bool isInline(const ByteString& b)
+{
+	const unsigned char* data = b.const_byte_str();
+	const unsigned char* object = (const unsigned char*) &b;
+
+	return (data >= object) && (data < object + sizeof(ByteString));
+}
+
+void ByteStringTests::testPublicAndSecret()
+{
+	// Strings are secret unless they are created as public
+	ByteString secret("0102030405");
+	ByteString encoded((unsigned long) 0x12345678);
+	ByteString header(ByteString::Public);
+
+	header += encoded;
+
+	CPPUNIT_ASSERT(!secret.isPublic() && !isInline(secret));
+	CPPUNIT_ASSERT(encoded.isPublic() && isInline(encoded));
+	CPPUNIT_ASSERT(header.isPublic() && isInline(header));
+
+	// Copies and substrings keep the kind of the data
+	ByteString secretCopy = secret;
+	ByteString headerCopy = header;
+
+	CPPUNIT_ASSERT(!secretCopy.isPublic() && !isInline(secretCopy));
+	CPPUNIT_ASSERT(headerCopy.isPublic() && isInline(headerCopy));
+	CPPUNIT_ASSERT(!isInline(secret.substr(1, 2)));
+	CPPUNIT_ASSERT(isInline(header.substr(1, 2)));
+
+	// Appending or assigning secret data makes a public string secret
+	header += secret;
+
+	CPPUNIT_ASSERT(!header.isPublic() && !isInline(header));
+	CPPUNIT_ASSERT(header == encoded + secret);
+
+	headerCopy = secret;
+
+	CPPUNIT_ASSERT(!headerCopy.isPublic() && !isInline(headerCopy));
+	CPPUNIT_ASSERT(headerCopy == secret);
+
+	ByteString serialised = secret.serialise();
+
+	CPPUNIT_ASSERT(!serialised.isPublic() && !isInline(serialised));
+
+	// Assigning public data to a secret string keeps it secret
+	secretCopy = encoded;
+
+	CPPUNIT_ASSERT(!secretCopy.isPublic() && !isInline(secretCopy));
+	CPPUNIT_ASSERT(secretCopy == encoded);
+}
@@ -48,6 +48,8 @@ class ByteStringTests : public CppUnit::TestFixture
 	CPPUNIT_TEST(testSplitting);
 	CPPUNIT_TEST(testBits);
 	CPPUNIT_TEST(testSerialising);
+	CPPUNIT_TEST(testGrowAndSwap);
+	CPPUNIT_TEST(testPublicAndSecret);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -61,6 +63,8 @@ public:
 	void testSplitting();
 	void testBits();
 	void testSerialising();
+	void testGrowAndSwap();
+	void testPublicAndSecret();
 
 	void setUp();
 	void tearDown();
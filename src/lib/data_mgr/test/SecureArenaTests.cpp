@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ SecureArenaTests.cpp
+
+ Contains test cases to test the secure arena allocator
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <vector>
+#include <cppunit/extensions/HelperMacros.h>
+#include "SecureArenaTests.h"
+#include "SecureArena.h"
+#include "salloc.h"
+#include "ByteString.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SecureArenaTests);
+
+void SecureArenaTests::setUp()
+{
+}
+
+void SecureArenaTests::tearDown()
+{
+}
+
+void SecureArenaTests::testAllocate()
+{
+	// Allocate blocks of every size class and a few larger ones and
+	// check that they do not overlap
+	std::vector<unsigned char*> blocks;
+	std::vector<size_t> sizes;
+
+	for (size_t len = 1; len <= 4 * SecureArena::MAX_BLOCK; len = len * 3 / 2 + 1)
+	{
+		unsigned char* block = (unsigned char*) SecureArena::i()->allocate(len);
+
+		CPPUNIT_ASSERT(block != NULL);
+
+		memset(block, (int) blocks.size(), len);
+
+		blocks.push_back(block);
+		sizes.push_back(len);
+	}
+
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		for (size_t j = 0; j < sizes[i]; j++)
+		{
+			CPPUNIT_ASSERT(blocks[i][j] == (unsigned char) i);
+		}
+
+		SecureArena::i()->deallocate(blocks[i], sizes[i]);
+	}
+
+	// Memory obtained through salloc is released without its size
+	unsigned char* mem = (unsigned char*) salloc(100);
+
+	CPPUNIT_ASSERT(mem != NULL);
+
+	memset(mem, 0xAA, 100);
+
+	sfree(mem);
+}
+
+void SecureArenaTests::testReuse()
+{
+	// A released block is wiped and handed out again
+	unsigned char* block1 = (unsigned char*) SecureArena::i()->allocate(24);
+
+	CPPUNIT_ASSERT(block1 != NULL);
+
+	memset(block1, 0x55, 24);
+
+	SecureArena::i()->deallocate(block1, 24);
+
+	unsigned char* block2 = (unsigned char*) SecureArena::i()->allocate(32);
+
+	CPPUNIT_ASSERT(block2 == block1);
+
+	for (size_t i = 0; i < 32; i++)
+	{
+		CPPUNIT_ASSERT(block2[i] == 0x00);
+	}
+
+	SecureArena::i()->deallocate(block2, 32);
+
+	// Many more blocks than fit in a thread cache
+	std::vector<void*> blocks;
+
+	for (size_t i = 0; i < 10000; i++)
+	{
+		void* block = SecureArena::i()->allocate(64);
+
+		CPPUNIT_ASSERT(block != NULL);
+
+		blocks.push_back(block);
+	}
+
+	for (size_t i = 0; i < blocks.size(); i++)
+	{
+		SecureArena::i()->deallocate(blocks[i], 64);
+	}
+}
+
+static void* arenaThread(void* arg)
+{
+	long id = (long) arg;
+	bool ok = true;
+
+	for (int n = 0; n < 100; n++)
+	{
+		std::vector<ByteString> strings;
+
+		for (int i = 0; i < 50; i++)
+		{
+			ByteString b;
+
+			b.resize(1 + (i * 37) % 3000);
+			memset(&b[0], (int) id, b.size());
+
+			strings.push_back(b);
+		}
+
+		for (size_t i = 0; i < strings.size(); i++)
+		{
+			for (size_t j = 0; j < strings[i].size(); j++)
+			{
+				ok = ok && (strings[i][j] == (unsigned char) id);
+			}
+		}
+	}
+
+	return ok ? arg : NULL;
+}
+
+void SecureArenaTests::testThreads()
+{
+	// Threads allocating and releasing at the same time must never get the same block
+	pthread_t threads[8];
+
+	for (long i = 0; i < 8; i++)
+	{
+		CPPUNIT_ASSERT(pthread_create(&threads[i], NULL, arenaThread, (void*) (i + 1)) == 0);
+	}
+
+	for (long i = 0; i < 8; i++)
+	{
+		void* result;
+
+		CPPUNIT_ASSERT(pthread_join(threads[i], &result) == 0);
+		CPPUNIT_ASSERT(result == (void*) (i + 1));
+	}
+}
@@ -186,3 +186,74 @@ void SecureDataMgrTests::testSecureDataManager()
 	CPPUNIT_ASSERT(decrypted == emptyPlaintext);
 }
 
+void SecureDataMgrTests::testEncryptionSchemes()
+{
+	ByteString soPIN = "3132333435363738"; // "12345678"
+	ByteString userPIN = "4041424344454647"; // "ABCDEFGH"
+	ByteString plaintext = "010203040506070809";
+	ByteString encrypted, decrypted;
+
+	// Create the key blobs
+	SecureDataManager s1;
+
+	CPPUNIT_ASSERT(s1.setSOPIN(soPIN));
+	CPPUNIT_ASSERT(s1.loginSO(soPIN));
+	CPPUNIT_ASSERT(s1.setUserPIN(userPIN));
+
+	// Tokens without a recorded scheme use AES-CBC
+	SecureDataManager cbc(s1.getSOPINBlob(), s1.getUserPINBlob());
+
+	CPPUNIT_ASSERT(cbc.getEncryptionScheme() == SecureDataManager::AES_CBC);
+	CPPUNIT_ASSERT(cbc.loginUser(userPIN));
+	CPPUNIT_ASSERT(cbc.encrypt(plaintext, encrypted));
+	CPPUNIT_ASSERT(encrypted.size() == 32);
+	CPPUNIT_ASSERT(cbc.decrypt(encrypted, decrypted));
+	CPPUNIT_ASSERT(decrypted == plaintext);
+
+	// Later operations reuse the expanded key; it is gone after a logout
+	for (int i = 0; i < 4; i++)
+	{
+		ByteString encrypted2;
+
+		CPPUNIT_ASSERT(cbc.encrypt(plaintext, encrypted2));
+		CPPUNIT_ASSERT(encrypted2 != encrypted);
+		CPPUNIT_ASSERT(cbc.decrypt(encrypted2, decrypted));
+		CPPUNIT_ASSERT(decrypted == plaintext);
+		CPPUNIT_ASSERT(cbc.decrypt(encrypted, decrypted));
+		CPPUNIT_ASSERT(decrypted == plaintext);
+	}
+
+	cbc.logout();
+	CPPUNIT_ASSERT(!cbc.decrypt(encrypted, decrypted));
+	CPPUNIT_ASSERT(cbc.loginUser(userPIN));
+	CPPUNIT_ASSERT(cbc.decrypt(encrypted, decrypted));
+	CPPUNIT_ASSERT(decrypted == plaintext);
+
+	if (SecureDataManager::getDefaultScheme() != SecureDataManager::AES_GCM) return;
+
+	// AES-GCM adds the IV and the tag but no padding
+	SecureDataManager gcm(s1.getSOPINBlob(), s1.getUserPINBlob(), SecureDataManager::AES_GCM);
+
+	CPPUNIT_ASSERT(gcm.getEncryptionScheme() == SecureDataManager::AES_GCM);
+	CPPUNIT_ASSERT(gcm.loginUser(userPIN));
+	CPPUNIT_ASSERT(gcm.encrypt(plaintext, encrypted));
+	CPPUNIT_ASSERT(encrypted.size() == 12 + plaintext.size() + 16);
+	CPPUNIT_ASSERT(gcm.decrypt(encrypted, decrypted));
+	CPPUNIT_ASSERT(decrypted == plaintext);
+
+	// Empty plaintext only consists of the IV and the tag
+	ByteString emptyEncrypted;
+
+	CPPUNIT_ASSERT(gcm.encrypt(ByteString(), emptyEncrypted));
+	CPPUNIT_ASSERT(emptyEncrypted.size() == 28);
+	CPPUNIT_ASSERT(gcm.decrypt(emptyEncrypted, decrypted));
+	CPPUNIT_ASSERT(decrypted.size() == 0);
+
+	// Modified data is detected
+	encrypted[14] ^= 0x01;
+	CPPUNIT_ASSERT(!gcm.decrypt(encrypted, decrypted));
+	encrypted[14] ^= 0x01;
+	encrypted[encrypted.size() - 1] ^= 0x01;
+	CPPUNIT_ASSERT(!gcm.decrypt(encrypted, decrypted));
+	CPPUNIT_ASSERT(!gcm.decrypt(encrypted.substr(0, 27), decrypted));
+}
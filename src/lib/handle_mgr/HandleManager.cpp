@@ -41,199 +41,432 @@
  use the same handle manager and therefore there will never be e.g. a session
  with the same handle as an object.
 
+ The handles are kept in a table that is indexed directly by the lower bits of
+ the handle value. The upper bits carry the generation of the table entry,
+ which is increased whenever a handle is invalidated, so a stale handle never
+ matches the handle that later reuses its entry. Looking up a handle does not
+ take any locks; the entry is copied and its tag is checked before and after
+ copying it. Changes are made under the mutex of the shard of the slot the
+ handle belongs to, which keeps per-session and per-slot lists of the issued
+ handles so closing sessions and logging out only touches the handles
+ involved.
+
  *****************************************************************************/
 
 #include "HandleManager.h"
 #include "log.h"
+#include <stdlib.h>
+
+#define HANDLE_GENERATION_BITS ((sizeof(CK_ULONG) * 8) - HANDLE_INDEX_BITS)
+#define HANDLE_GENERATION_MASK ((((CK_ULONG) 1) << HANDLE_GENERATION_BITS) - 1)
+#define HANDLE_INDEX_MASK ((((CK_ULONG) 1) << HANDLE_INDEX_BITS) - 1)
+#define HANDLE_CHUNK_SIZE (1UL << HANDLE_CHUNK_BITS)
+#define HANDLE_CHUNK_MASK (HANDLE_CHUNK_SIZE - 1)
+#define HANDLE_MAX_CHUNKS (1UL << (HANDLE_INDEX_BITS - HANDLE_CHUNK_BITS))
+
+// The tag of an entry combines its generation with the kind of handle
+#define HANDLE_TAG(generation, kind) (((generation) << 2) | (kind))
+#define HANDLE_TAG_GENERATION(tag) ((tag) >> 2)
 
 // Constructor
 HandleManager::HandleManager()
 {
-	handlesMutex = MutexFactory::i()->getMutex();
-	handleCounter = 0;
+	chunks = (HandleEntry* volatile*) calloc(HANDLE_MAX_CHUNKS, sizeof(HandleEntry*));
+
+	tableMutex = MutexFactory::i()->getMutex();
+
+	// Index 0 is never used so a handle can never be CK_INVALID_HANDLE
+	nextIndex = 1;
+	freeHead = 0;
+	freeTail = 0;
+	freeCount = 0;
+
+	for (int i = 0; i < HANDLE_SHARDS; i++)
+	{
+		slotShards[i].mutex = MutexFactory::i()->getMutex();
+		objectShards[i].mutex = MutexFactory::i()->getMutex();
+	}
 }
 
 // Destructor
 HandleManager::~HandleManager()
 {
+	for (int i = 0; i < HANDLE_SHARDS; i++)
+	{
+		MutexFactory::i()->recycleMutex(slotShards[i].mutex);
+		MutexFactory::i()->recycleMutex(objectShards[i].mutex);
+	}
+
+	MutexFactory::i()->recycleMutex(tableMutex);
+
+	if (chunks != NULL)
+	{
+		for (CK_ULONG i = 0; i < HANDLE_MAX_CHUNKS; i++)
+		{
+			delete[] chunks[i];
+		}
 
-	MutexFactory::i()->recycleMutex(handlesMutex);
+		free((void*) chunks);
+	}
+}
+
+HandleManager::SlotShard& HandleManager::slotShard(const CK_SLOT_ID slotID)
+{
+	return slotShards[slotID % HANDLE_SHARDS];
+}
+
+HandleManager::ObjectShard& HandleManager::objectShard(const CK_VOID_PTR object)
+{
+	// Objects are heap allocated, so the lowest bits carry no information
+	return objectShards[(((size_t) object) >> 4) % HANDLE_SHARDS];
+}
+
+HandleManager::HandleEntry* HandleManager::entryFor(const CK_ULONG hValue)
+{
+	CK_ULONG index = hValue & HANDLE_INDEX_MASK;
+
+	if (chunks == NULL || index == 0) return NULL;
+
+	HandleEntry* chunk = chunks[index >> HANDLE_CHUNK_BITS];
+
+	if (chunk == NULL) return NULL;
+
+	return &chunk[index & HANDLE_CHUNK_MASK];
+}
+
+bool HandleManager::lookup(const CK_ULONG hValue, const CK_HANDLE_KIND kind, Handle& handle)
+{
+	HandleEntry* entry = entryFor(hValue);
+
+	if (entry == NULL) return false;
+
+	const CK_ULONG expected = HANDLE_TAG(hValue >> HANDLE_INDEX_BITS, kind);
+
+	if (entry->tag != expected) return false;
+
+	__sync_synchronize();
+
+	handle = entry->handle;
+
+	__sync_synchronize();
+
+	// The handle is only valid if the entry did not change while copying it
+	return entry->tag == expected;
+}
+
+CK_ULONG HandleManager::issueHandle(const Handle& handle)
+{
+	CK_ULONG index = 0;
+
+	{
+		MutexLocker lock(tableMutex);
+
+		if (chunks == NULL) return CK_INVALID_HANDLE;
+
+		// Prefer unused entries over released ones until enough entries
+		// have been released; this delays the reuse of handle values
+		if (freeCount < HANDLE_MIN_FREE && nextIndex <= HANDLE_INDEX_MASK)
+		{
+			index = nextIndex;
+
+			if (chunks[index >> HANDLE_CHUNK_BITS] == NULL)
+			{
+				HandleEntry* chunk = new HandleEntry[HANDLE_CHUNK_SIZE];
+
+				// Publish the initialised chunk to lock-free readers
+				__sync_synchronize();
+
+				chunks[index >> HANDLE_CHUNK_BITS] = chunk;
+			}
+
+			nextIndex++;
+		}
+		else if (freeCount > 0)
+		{
+			index = freeHead;
+			freeHead = entryFor(index)->nextFree;
+			if (--freeCount == 0) freeTail = 0;
+		}
+		else
+		{
+			ERROR_MSG("The handle table is full");
+
+			return CK_INVALID_HANDLE;
+		}
+	}
+
+	HandleEntry* entry = entryFor(index);
+	CK_ULONG generation = HANDLE_TAG_GENERATION(entry->tag);
+
+	entry->handle = handle;
+
+	__sync_synchronize();
+
+	entry->tag = HANDLE_TAG(generation, handle.kind);
+
+	return (generation << HANDLE_INDEX_BITS) | index;
+}
+
+void HandleManager::releaseHandle(const CK_ULONG hValue)
+{
+	CK_ULONG index = hValue & HANDLE_INDEX_MASK;
+	HandleEntry* entry = entryFor(index);
+
+	if (entry == NULL) return;
+
+	// Invalidate the handle before the entry is cleared
+	entry->tag = HANDLE_TAG((HANDLE_TAG_GENERATION(entry->tag) + 1) & HANDLE_GENERATION_MASK, CKH_INVALID);
+
+	__sync_synchronize();
+
+	entry->handle = Handle();
+	entry->nextFree = 0;
+
+	MutexLocker lock(tableMutex);
+
+	if (freeTail != 0)
+	{
+		entryFor(freeTail)->nextFree = index;
+	}
+	else
+	{
+		freeHead = index;
+	}
+
+	freeTail = index;
+	freeCount++;
 }
 
 CK_SESSION_HANDLE HandleManager::addSession(CK_SLOT_ID slotID, CK_VOID_PTR session)
 {
-	MutexLocker lock(handlesMutex);
+	SlotShard& shard = slotShard(slotID);
+	MutexLocker lock(shard.mutex);
 
 	Handle h( CKH_SESSION, slotID );
 	h.object = session;
-	handles[++handleCounter] = h;
-	return (CK_SESSION_HANDLE)handleCounter;
+
+	CK_SESSION_HANDLE hSession = issueHandle(h);
+
+	if (hSession != CK_INVALID_HANDLE)
+	{
+		shard.slots[slotID].sessions.insert(hSession);
+	}
+
+	return hSession;
 }
 
 CK_VOID_PTR HandleManager::getSession(const CK_SESSION_HANDLE hSession)
 {
-	MutexLocker lock(handlesMutex);
+	Handle h;
 
-	std::map< CK_ULONG, Handle>::iterator it = handles.find(hSession);
-	if (it == handles.end() || CKH_SESSION != it->second.kind)
+	if (!lookup(hSession, CKH_SESSION, h))
 		return NULL_PTR;
-	return it->second.object;
+	return h.object;
 }
 
 CK_OBJECT_HANDLE HandleManager::addSessionObject(CK_SLOT_ID slotID, CK_SESSION_HANDLE hSession, bool isPrivate, CK_VOID_PTR object)
 {
-	MutexLocker lock(handlesMutex);
-
-	// Return existing handle when the object has already been registered.
-	std::map< CK_VOID_PTR, CK_ULONG>::iterator oit = objects.find(object);
-	if (oit != objects.end()) {
-		std::map< CK_ULONG, Handle>::iterator hit = handles.find(oit->second);
-		if (hit == handles.end() || CKH_OBJECT != hit->second.kind || slotID != hit->second.slotID) {
-			objects.erase(oit);
-			return CK_INVALID_HANDLE;
-		} else
-			return oit->second;
-	}
-
-	Handle h( CKH_OBJECT, slotID, hSession );
-	h.isPrivate = isPrivate;
-	h.object = object;
-	handles[++handleCounter] = h;
-	objects[object] = handleCounter;
-	return (CK_OBJECT_HANDLE)handleCounter;
+	return addObject(slotID, hSession, isPrivate, object);
 }
 
 CK_OBJECT_HANDLE HandleManager::addTokenObject(CK_SLOT_ID slotID, bool isPrivate, CK_VOID_PTR object)
 {
-	MutexLocker lock(handlesMutex);
+	// Token objects are not associated with a specific session.
+	return addObject(slotID, CK_INVALID_HANDLE, isPrivate, object);
+}
+
+CK_OBJECT_HANDLE HandleManager::addObject(CK_SLOT_ID slotID, CK_SESSION_HANDLE hSession, bool isPrivate, CK_VOID_PTR object)
+{
+	SlotShard& shard = slotShard(slotID);
+	MutexLocker lock(shard.mutex);
+
+	ObjectShard& objShard = objectShard(object);
+	MutexLocker objLock(objShard.mutex);
 
 	// Return existing handle when the object has already been registered.
-	std::map< CK_VOID_PTR, CK_ULONG>::iterator oit = objects.find(object);
-	if (oit != objects.end()) {
-		std::map< CK_ULONG, Handle>::iterator hit = handles.find(oit->second);
-		if (hit == handles.end() || CKH_OBJECT != hit->second.kind || slotID != hit->second.slotID) {
-			objects.erase(oit);
+	std::map< CK_VOID_PTR, CK_OBJECT_HANDLE>::iterator oit = objShard.objects.find(object);
+	if (oit != objShard.objects.end()) {
+		Handle h;
+		if (!lookup(oit->second, CKH_OBJECT, h) || slotID != h.slotID)
 			return CK_INVALID_HANDLE;
-		} else
+		else
 			return oit->second;
 	}
 
-	// Token objects are not associated with a specific session.
-	Handle h( CKH_OBJECT, slotID );
+	Handle h( CKH_OBJECT, slotID, hSession );
 	h.isPrivate = isPrivate;
 	h.object = object;
-	handles[++handleCounter] = h;
-	objects[object] = handleCounter;
-	return (CK_OBJECT_HANDLE)handleCounter;
+
+	CK_OBJECT_HANDLE hObject = issueHandle(h);
+
+	if (hObject == CK_INVALID_HANDLE)
+		return CK_INVALID_HANDLE;
+
+	SlotHandles& slot = shard.slots[slotID];
+	if (hSession != CK_INVALID_HANDLE)
+		slot.sessionObjects[hSession].insert(hObject);
+	else
+		slot.tokenObjects.insert(hObject);
+	if (isPrivate)
+		slot.privateObjects.insert(hObject);
+
+	objShard.objects[object] = hObject;
+	return hObject;
 }
 
 CK_VOID_PTR HandleManager::getObject(const CK_OBJECT_HANDLE hObject)
 {
-	MutexLocker lock(handlesMutex);
+	Handle h;
 
-	std::map< CK_ULONG, Handle>::iterator it = handles.find(hObject);
-	if (it == handles.end() || CKH_OBJECT != it->second.kind )
+	if (!lookup(hObject, CKH_OBJECT, h))
 		return NULL_PTR;
-	return it->second.object;
+	return h.object;
 }
 
 CK_OBJECT_HANDLE HandleManager::getObjectHandle(CK_VOID_PTR object)
 {
-	MutexLocker lock(handlesMutex);
+	ObjectShard& objShard = objectShard(object);
+	MutexLocker lock(objShard.mutex);
 
-	std::map< CK_VOID_PTR, CK_ULONG>::iterator it = objects.find(object);
-	if (it == objects.end())
+	std::map< CK_VOID_PTR, CK_OBJECT_HANDLE>::iterator it = objShard.objects.find(object);
+	if (it == objShard.objects.end())
 		return CK_INVALID_HANDLE;
 	return it->second;
 }
 
-void HandleManager::destroyObject(const CK_OBJECT_HANDLE hObject)
+void HandleManager::removeObject(SlotHandles& slot, const CK_OBJECT_HANDLE hObject, bool fromSessionList)
 {
-	MutexLocker lock(handlesMutex);
+	Handle h;
+
+	if (!lookup(hObject, CKH_OBJECT, h))
+		return;
+
+	if (fromSessionList) {
+		if (h.hSession != CK_INVALID_HANDLE) {
+			std::map< CK_SESSION_HANDLE, std::set<CK_OBJECT_HANDLE> >::iterator it = slot.sessionObjects.find(h.hSession);
+			if (it != slot.sessionObjects.end()) {
+				it->second.erase(hObject);
+				if (it->second.empty())
+					slot.sessionObjects.erase(it);
+			}
+		} else
+			slot.tokenObjects.erase(hObject);
+	}
+	if (h.isPrivate)
+		slot.privateObjects.erase(hObject);
 
-	std::map< CK_ULONG, Handle>::iterator it = handles.find(hObject);
-	if (it != handles.end() && CKH_OBJECT == it->second.kind) {
-		objects.erase(it->second.object);
-		handles.erase(it);
+	{
+		ObjectShard& objShard = objectShard(h.object);
+		MutexLocker lock(objShard.mutex);
+
+		std::map< CK_VOID_PTR, CK_OBJECT_HANDLE>::iterator it = objShard.objects.find(h.object);
+		if (it != objShard.objects.end() && it->second == hObject)
+			objShard.objects.erase(it);
 	}
+
+	releaseHandle(hObject);
+}
+
+void HandleManager::destroyObject(const CK_OBJECT_HANDLE hObject)
+{
+	Handle h;
+
+	if (!lookup(hObject, CKH_OBJECT, h))
+		return;
+
+	SlotShard& shard = slotShard(h.slotID);
+	MutexLocker lock(shard.mutex);
+
+	// The handle may have been removed before the lock was obtained
+	std::map< CK_SLOT_ID, SlotHandles>::iterator it = shard.slots.find(h.slotID);
+	if (it != shard.slots.end())
+		removeObject(it->second, hObject, true);
 }
 
 void HandleManager::sessionClosed(const CK_SESSION_HANDLE hSession)
 {
-	CK_SLOT_ID slotID;
-	{
-		MutexLocker lock(handlesMutex);
-
-		std::map< CK_ULONG, Handle>::iterator it = handles.find(hSession);
-		if (it == handles.end() || CKH_SESSION != it->second.kind)
-			return; // Unable to find the specified session.
-
-		slotID = it->second.slotID;
-
-		// session closed, so we can erase information about it.
-		handles.erase(it);
-
-		// Erase all session object handles associated with the given session handle.
-		CK_ULONG openSessionCount = 0;
-		for (it = handles.begin(); it != handles.end(); ) {
-			Handle &h = it->second;
-			if (CKH_SESSION == h.kind && slotID == h.slotID) {
-				++openSessionCount; // another session is open for this slotID.
-			} else {
-				if (CKH_OBJECT == h.kind && hSession == h.hSession) {
-					// A session object is present for the given session, so erase it.
-					objects.erase(it->second.object);
-					// Iterator post-incrementing (it++) will return a copy of the original it (which points to handle to be deleted).
-					handles.erase(it++);
-					continue;
-				}
-			}
-			++it;
-		}
+	Handle h;
 
-		 // We are done when there are still sessions open.
-		if (openSessionCount)
-			return;
+	if (!lookup(hSession, CKH_SESSION, h))
+		return; // Unable to find the specified session.
+
+	SlotShard& shard = slotShard(h.slotID);
+	MutexLocker lock(shard.mutex);
+
+	std::map< CK_SLOT_ID, SlotHandles>::iterator sit = shard.slots.find(h.slotID);
+	if (sit == shard.slots.end())
+		return;
+	SlotHandles& slot = sit->second;
+
+	// The session may have been closed before the lock was obtained
+	if (slot.sessions.erase(hSession) == 0)
+		return;
+
+	// session closed, so we can erase information about it.
+	releaseHandle(hSession);
+
+	// Erase all session object handles associated with the given session handle.
+	std::map< CK_SESSION_HANDLE, std::set<CK_OBJECT_HANDLE> >::iterator it = slot.sessionObjects.find(hSession);
+	if (it != slot.sessionObjects.end()) {
+		std::set<CK_OBJECT_HANDLE>& sessionObjects = it->second;
+		for (std::set<CK_OBJECT_HANDLE>::iterator oit = sessionObjects.begin(); oit != sessionObjects.end(); ++oit)
+			removeObject(slot, *oit, false);
+		slot.sessionObjects.erase(it);
 	}
 
+	// We are done when there are still sessions open.
+	if (!slot.sessions.empty())
+		return;
+
 	// No more sessions open for this token, so remove all object handles that are still valid for the given slotID.
-	allSessionsClosed(slotID);
+	clearSlot(shard, h.slotID);
 }
 
 void HandleManager::allSessionsClosed(const CK_SLOT_ID slotID)
 {
-	MutexLocker lock(handlesMutex);
+	SlotShard& shard = slotShard(slotID);
+	MutexLocker lock(shard.mutex);
+
+	clearSlot(shard, slotID);
+}
+
+void HandleManager::clearSlot(SlotShard& shard, const CK_SLOT_ID slotID)
+{
+	std::map< CK_SLOT_ID, SlotHandles>::iterator sit = shard.slots.find(slotID);
+	if (sit == shard.slots.end())
+		return;
+	SlotHandles& slot = sit->second;
 
 	// Erase all "session", "session object" and "token object" handles for a given slot id.
-	std::map< CK_ULONG, Handle>::iterator it;
-	for (it = handles.begin(); it != handles.end(); ) {
-		Handle &h = it->second;
-		if (slotID == h.slotID) {
-			if (CKH_OBJECT == it->second.kind)
-				objects.erase(it->second.object);
-			// Iterator post-incrementing (it++) will return a copy of the original it (which points to handle to be deleted).
-			handles.erase(it++);
-			continue;
-		}
-		++it;
+	for (std::set<CK_SESSION_HANDLE>::iterator it = slot.sessions.begin(); it != slot.sessions.end(); ++it)
+		releaseHandle(*it);
+
+	std::map< CK_SESSION_HANDLE, std::set<CK_OBJECT_HANDLE> >::iterator it;
+	for (it = slot.sessionObjects.begin(); it != slot.sessionObjects.end(); ++it) {
+		for (std::set<CK_OBJECT_HANDLE>::iterator oit = it->second.begin(); oit != it->second.end(); ++oit)
+			removeObject(slot, *oit, false);
 	}
+
+	for (std::set<CK_OBJECT_HANDLE>::iterator oit = slot.tokenObjects.begin(); oit != slot.tokenObjects.end(); ++oit)
+		removeObject(slot, *oit, false);
+
+	shard.slots.erase(sit);
 }
 
 void HandleManager::tokenLoggedOut(const CK_SLOT_ID slotID)
 {
-	MutexLocker lock(handlesMutex);
+	SlotShard& shard = slotShard(slotID);
+	MutexLocker lock(shard.mutex);
+
+	std::map< CK_SLOT_ID, SlotHandles>::iterator sit = shard.slots.find(slotID);
+	if (sit == shard.slots.end())
+		return;
+	SlotHandles& slot = sit->second;
 
 	// Erase all private "token object" or "session object" handles for a given slot id.
-	std::map< CK_ULONG, Handle>::iterator it;
-	for (it = handles.begin(); it != handles.end(); ) {
-		Handle &h = it->second;
-		if (CKH_OBJECT == h.kind && slotID == h.slotID && h.isPrivate) {
-			// A private object is present for the given slotID so we need to remove it.
-			objects.erase(it->second.object);
-			// Iterator post-incrementing (it++) will return a copy of the original it (which points to handle to be deleted).
-			handles.erase(it++);
-			continue;
-		}
-		++it;
-	}
+	// removeObject() erases the handle from the private objects so work on a copy.
+	std::set<CK_OBJECT_HANDLE> privateObjects;
+	privateObjects.swap(slot.privateObjects);
+	for (std::set<CK_OBJECT_HANDLE>::iterator it = privateObjects.begin(); it != privateObjects.end(); ++it)
+		removeObject(slot, *it, true);
 }
@@ -38,9 +38,21 @@
 #include "cryptoki.h"
 
 #include <map>
+#include <set>
 
 #define CK_INTERNAL_SESSION_HANDLE CK_SESSION_HANDLE
 
+// The lower bits of a handle are an index in the handle table, the upper bits
+// hold the generation of the table entry. A table entry is only reused after
+// HANDLE_MIN_FREE other entries have been released, and every time it is
+// reused it gets a new generation, so stale handles are still recognised.
+#define HANDLE_INDEX_BITS 24
+#define HANDLE_CHUNK_BITS 10
+#define HANDLE_MIN_FREE 1024
+
+// The number of shards the per-slot administration is divided over
+#define HANDLE_SHARDS 16
+
 class HandleManager
 {
 public:
@@ -84,10 +96,84 @@ public:
     void tokenLoggedOut(const CK_SLOT_ID slotID);
 
 private:
-    Mutex* handlesMutex;
-    std::map< CK_ULONG, Handle> handles;
-    std::map< CK_VOID_PTR, CK_ULONG> objects;
-    CK_ULONG handleCounter;
+    // An entry in the handle table. The tag holds the generation of the
+    // entry and the kind of handle it currently represents; it is changed
+    // before and after the handle itself so readers can detect that the
+    // entry changed while they were copying it.
+    struct HandleEntry
+    {
+        HandleEntry() : tag(0), nextFree(0) { }
+
+        volatile CK_ULONG tag;
+        Handle handle;
+        CK_ULONG nextFree;
+    };
+
+    // The handles issued for a single slot
+    struct SlotHandles
+    {
+        std::set<CK_SESSION_HANDLE> sessions;
+        std::map<CK_SESSION_HANDLE, std::set<CK_OBJECT_HANDLE> > sessionObjects;
+        std::set<CK_OBJECT_HANDLE> tokenObjects;
+        std::set<CK_OBJECT_HANDLE> privateObjects;
+    };
+
+    // A shard of the slot administration
+    struct SlotShard
+    {
+        Mutex* mutex;
+        std::map<CK_SLOT_ID, SlotHandles> slots;
+    };
+
+    // A shard of the mapping from object pointers to handles
+    struct ObjectShard
+    {
+        Mutex* mutex;
+        std::map<CK_VOID_PTR, CK_OBJECT_HANDLE> objects;
+    };
+
+    // Copy the handle with the given value if it is valid and of the given
+    // kind; this does not require any locks
+    bool lookup(const CK_ULONG hValue, const CK_HANDLE_KIND kind, Handle& handle);
+
+    // Retrieve the table entry for a handle value, or NULL if the value
+    // is outside the table
+    HandleEntry* entryFor(const CK_ULONG hValue);
+
+    // Issue a new handle; the caller must hold the mutex of the slot shard
+    CK_ULONG issueHandle(const Handle& handle);
+
+    // Invalidate a handle and return its entry to the free list; the caller
+    // must hold the mutex of the slot shard
+    void releaseHandle(const CK_ULONG hValue);
+
+    // Add an object handle
+    CK_OBJECT_HANDLE addObject(CK_SLOT_ID slotID, CK_SESSION_HANDLE hSession, bool isPrivate, CK_VOID_PTR object);
+
+    // Remove an object handle from the administration of the slot and
+    // invalidate it; the caller must hold the mutex of the slot shard
+    void removeObject(SlotHandles& slot, const CK_OBJECT_HANDLE hObject, bool fromSessionList);
+
+    // Invalidate all handles of a slot; the caller must hold the mutex of
+    // the slot shard
+    void clearSlot(SlotShard& shard, const CK_SLOT_ID slotID);
+
+    SlotShard& slotShard(const CK_SLOT_ID slotID);
+    ObjectShard& objectShard(const CK_VOID_PTR object);
+
+    // The handle table consists of chunks that are allocated on demand and
+    // never move, so lookups can index them without taking a lock
+    HandleEntry* volatile* chunks;
+
+    // For the allocation of table entries
+    Mutex* tableMutex;
+    CK_ULONG nextIndex;
+    CK_ULONG freeHead;
+    CK_ULONG freeTail;
+    CK_ULONG freeCount;
+
+    SlotShard slotShards[HANDLE_SHARDS];
+    ObjectShard objectShards[HANDLE_SHARDS];
 };
 
 #endif // !_SOFTHSM_V2_HANDLEMANAGER_H
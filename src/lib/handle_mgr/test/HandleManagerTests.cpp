@@ -32,6 +32,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <set>
 #include <cppunit/extensions/HelperMacros.h>
 #include "HandleManagerTests.h"
 
@@ -176,3 +177,66 @@ void HandleManagerTests::testHandleManager()
 	CPPUNIT_ASSERT(NULL == handleManager->getSession(hSession));
 	CPPUNIT_ASSERT(NULL == handleManager->getSession(hSession2));
 }
+
+void HandleManagerTests::testStaleHandles()
+{
+	CK_SLOT_ID slotID = 1234; // we need a unique value
+	CK_SLOT_ID slotID2 = 1234 + 16; // shares the shard with slotID
+	CK_SESSION_HANDLE hSession;
+	CK_VOID_PTR session = &hSession; // we need a unique value
+	CK_OBJECT_HANDLE hObject;
+	CK_VOID_PTR object = &hObject; // we need a unique value
+	CK_OBJECT_HANDLE hObject2;
+	CK_VOID_PTR object2 = &hObject2; // we need a unique value
+
+	// Handles are not interchangeable between kinds
+	hSession = handleManager->addSession(slotID, session);
+	hObject = handleManager->addSessionObject(slotID, hSession, false, object);
+	CPPUNIT_ASSERT(hSession != CK_INVALID_HANDLE);
+	CPPUNIT_ASSERT(hObject != CK_INVALID_HANDLE);
+	CPPUNIT_ASSERT(NULL == handleManager->getObject(hSession));
+	CPPUNIT_ASSERT(NULL == handleManager->getSession(hObject));
+	CPPUNIT_ASSERT(hObject == handleManager->getObjectHandle(object));
+
+	// Slots sharing a shard do not affect each other
+	hObject2 = handleManager->addTokenObject(slotID2, true, object2);
+	CPPUNIT_ASSERT(hObject2 != CK_INVALID_HANDLE);
+	handleManager->allSessionsClosed(slotID);
+	CPPUNIT_ASSERT(NULL == handleManager->getSession(hSession));
+	CPPUNIT_ASSERT(NULL == handleManager->getObject(hObject));
+	CPPUNIT_ASSERT(CK_INVALID_HANDLE == handleManager->getObjectHandle(object));
+	CPPUNIT_ASSERT(object2 == handleManager->getObject(hObject2));
+	handleManager->tokenLoggedOut(slotID2);
+	CPPUNIT_ASSERT(NULL == handleManager->getObject(hObject2));
+
+	// Handles are never reused, even when the handle table reuses its entries
+	std::set<CK_ULONG> issued;
+	issued.insert(hSession);
+	issued.insert(hObject);
+	issued.insert(hObject2);
+
+	for (int i = 0; i < 5000; i++)
+	{
+		CK_SESSION_HANDLE hNewSession = handleManager->addSession(slotID, session);
+		CK_OBJECT_HANDLE hNewObject = handleManager->addSessionObject(slotID, hNewSession, false, object);
+
+		CPPUNIT_ASSERT(hNewSession != CK_INVALID_HANDLE);
+		CPPUNIT_ASSERT(hNewObject != CK_INVALID_HANDLE);
+		CPPUNIT_ASSERT(issued.insert(hNewSession).second);
+		CPPUNIT_ASSERT(issued.insert(hNewObject).second);
+		CPPUNIT_ASSERT(session == handleManager->getSession(hNewSession));
+		CPPUNIT_ASSERT(object == handleManager->getObject(hNewObject));
+
+		handleManager->sessionClosed(hNewSession);
+
+		CPPUNIT_ASSERT(NULL == handleManager->getSession(hNewSession));
+		CPPUNIT_ASSERT(NULL == handleManager->getObject(hNewObject));
+	}
+
+	// None of the issued handles is valid anymore
+	for (std::set<CK_ULONG>::iterator it = issued.begin(); it != issued.end(); ++it)
+	{
+		CPPUNIT_ASSERT(NULL == handleManager->getSession(*it));
+		CPPUNIT_ASSERT(NULL == handleManager->getObject(*it));
+	}
+}
@@ -41,10 +41,12 @@ class HandleManagerTests : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE(HandleManagerTests);
 	CPPUNIT_TEST(testHandleManager);
+	CPPUNIT_TEST(testStaleHandles);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
 	void testHandleManager();
+	void testStaleHandles();
 
 	void setUp();
 	void tearDown();
@@ -37,6 +37,8 @@
 #include "fatal.h"
 #include "cryptoki.h"
 #include "SoftHSM.h"
+#include "Statistics.h"
+#include <vector>
 
 // PKCS #11 function list
 //
@@ -121,9 +123,11 @@ static CK_FUNCTION_LIST functionList =
 // PKCS #11 initialisation function
 CK_RV C_Initialize(CK_VOID_PTR pInitArgs)
 {
+	StatTimer timer(StatCounter::C_Initialize);
+
 	try
 	{
-		return SoftHSM::i()->C_Initialize(pInitArgs);
+		return timer.result(SoftHSM::i()->C_Initialize(pInitArgs));
 	}
 	catch (...)
 	{
@@ -136,9 +140,11 @@ CK_RV C_Initialize(CK_VOID_PTR pInitArgs)
 // PKCS #11 finalisation function
 CK_RV C_Finalize(CK_VOID_PTR pReserved)
 {
+	StatTimer timer(StatCounter::C_Finalize);
+
 	try
 	{
-		return SoftHSM::i()->C_Finalize(pReserved);
+		return timer.result(SoftHSM::i()->C_Finalize(pReserved));
 	}
 	catch (...)
 	{
@@ -151,9 +157,11 @@ CK_RV C_Finalize(CK_VOID_PTR pReserved)
 // Return information about the PKCS #11 module
 CK_RV C_GetInfo(CK_INFO_PTR pInfo)
 {
+	StatTimer timer(StatCounter::C_GetInfo);
+
 	try
 	{
-		return SoftHSM::i()->C_GetInfo(pInfo);
+		return timer.result(SoftHSM::i()->C_GetInfo(pInfo));
 	}
 	catch (...)
 	{
@@ -166,9 +174,11 @@ CK_RV C_GetInfo(CK_INFO_PTR pInfo)
 // Return the list of PKCS #11 functions
 CK_RV C_GetFunctionList(CK_FUNCTION_LIST_PTR_PTR ppFunctionList)
 {
+	StatTimer timer(StatCounter::C_GetFunctionList);
+
 	try
 	{
-		if (ppFunctionList == NULL_PTR) return CKR_ARGUMENTS_BAD;
+		if (ppFunctionList == NULL_PTR) return timer.result(CKR_ARGUMENTS_BAD);
 
 		*ppFunctionList = &functionList;
 
@@ -185,9 +195,11 @@ CK_RV C_GetFunctionList(CK_FUNCTION_LIST_PTR_PTR ppFunctionList)
 // Return a list of available slots
 CK_RV C_GetSlotList(CK_BBOOL tokenPresent, CK_SLOT_ID_PTR pSlotList, CK_ULONG_PTR pulCount)
 {
+	StatTimer timer(StatCounter::C_GetSlotList);
+
 	try
 	{
-		return SoftHSM::i()->C_GetSlotList(tokenPresent, pSlotList, pulCount);
+		return timer.result(SoftHSM::i()->C_GetSlotList(tokenPresent, pSlotList, pulCount));
 	}
 	catch (...)
 	{
@@ -200,9 +212,11 @@ CK_RV C_GetSlotList(CK_BBOOL tokenPresent, CK_SLOT_ID_PTR pSlotList, CK_ULONG_PT
 // Return information about a slot
 CK_RV C_GetSlotInfo(CK_SLOT_ID slotID, CK_SLOT_INFO_PTR pInfo)
 {
+	StatTimer timer(StatCounter::C_GetSlotInfo);
+
 	try
 	{
-		return SoftHSM::i()->C_GetSlotInfo(slotID, pInfo);
+		return timer.result(SoftHSM::i()->C_GetSlotInfo(slotID, pInfo));
 	}
 	catch (...)
 	{
@@ -215,9 +229,11 @@ CK_RV C_GetSlotInfo(CK_SLOT_ID slotID, CK_SLOT_INFO_PTR pInfo)
 // Return information about a token in a slot
 CK_RV C_GetTokenInfo(CK_SLOT_ID slotID, CK_TOKEN_INFO_PTR pInfo)
 {
+	StatTimer timer(StatCounter::C_GetTokenInfo);
+
 	try
 	{
-		return SoftHSM::i()->C_GetTokenInfo(slotID, pInfo);
+		return timer.result(SoftHSM::i()->C_GetTokenInfo(slotID, pInfo));
 	}
 	catch (...)
 	{
@@ -230,9 +246,11 @@ CK_RV C_GetTokenInfo(CK_SLOT_ID slotID, CK_TOKEN_INFO_PTR pInfo)
 // Return the list of supported mechanisms for a given slot
 CK_RV C_GetMechanismList(CK_SLOT_ID slotID, CK_MECHANISM_TYPE_PTR pMechanismList, CK_ULONG_PTR pulCount)
 {
+	StatTimer timer(StatCounter::C_GetMechanismList);
+
 	try
 	{
-		return SoftHSM::i()->C_GetMechanismList(slotID, pMechanismList, pulCount);
+		return timer.result(SoftHSM::i()->C_GetMechanismList(slotID, pMechanismList, pulCount));
 	}
 	catch (...)
 	{
@@ -245,9 +263,11 @@ CK_RV C_GetMechanismList(CK_SLOT_ID slotID, CK_MECHANISM_TYPE_PTR pMechanismList
 // Return more information about a mechanism for a given slot
 CK_RV C_GetMechanismInfo(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_MECHANISM_INFO_PTR pInfo)
 {
+	StatTimer timer(StatCounter::C_GetMechanismInfo);
+
 	try
 	{
-		return SoftHSM::i()->C_GetMechanismInfo(slotID, type, pInfo);
+		return timer.result(SoftHSM::i()->C_GetMechanismInfo(slotID, type, pInfo));
 	}
 	catch (...)
 	{
@@ -260,9 +280,11 @@ CK_RV C_GetMechanismInfo(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_MECHANISM
 // Initialise the token in the specified slot
 CK_RV C_InitToken(CK_SLOT_ID slotID, CK_UTF8CHAR_PTR pPin, CK_ULONG ulPinLen, CK_UTF8CHAR_PTR pLabel)
 {
+	StatTimer timer(StatCounter::C_InitToken);
+
 	try
 	{
-		return SoftHSM::i()->C_InitToken(slotID, pPin, ulPinLen, pLabel);
+		return timer.result(SoftHSM::i()->C_InitToken(slotID, pPin, ulPinLen, pLabel));
 	}
 	catch (...)
 	{
@@ -275,9 +297,11 @@ CK_RV C_InitToken(CK_SLOT_ID slotID, CK_UTF8CHAR_PTR pPin, CK_ULONG ulPinLen, CK
 // Initialise the user PIN
 CK_RV C_InitPIN(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR pPin, CK_ULONG ulPinLen)
 {
+	StatTimer timer(StatCounter::C_InitPIN);
+
 	try
 	{
-		return SoftHSM::i()->C_InitPIN(hSession, pPin, ulPinLen);
+		return timer.result(SoftHSM::i()->C_InitPIN(hSession, pPin, ulPinLen));
 	}
 	catch (...)
 	{
@@ -290,9 +314,11 @@ CK_RV C_InitPIN(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR pPin, CK_ULONG ulPin
 // Change the PIN
 CK_RV C_SetPIN(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR pOldPin, CK_ULONG ulOldLen, CK_UTF8CHAR_PTR pNewPin, CK_ULONG ulNewLen)
 {
+	StatTimer timer(StatCounter::C_SetPIN);
+
 	try
 	{
-		return SoftHSM::i()->C_SetPIN(hSession, pOldPin, ulOldLen, pNewPin, ulNewLen);
+		return timer.result(SoftHSM::i()->C_SetPIN(hSession, pOldPin, ulOldLen, pNewPin, ulNewLen));
 	}
 	catch (...)
 	{
@@ -305,9 +331,11 @@ CK_RV C_SetPIN(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR pOldPin, CK_ULONG ulO
 // Open a new session to the specified slot
 CK_RV C_OpenSession(CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY notify, CK_SESSION_HANDLE_PTR phSession)
 {
+	StatTimer timer(StatCounter::C_OpenSession);
+
 	try
 	{
-		return SoftHSM::i()->C_OpenSession(slotID, flags, pApplication, notify, phSession);
+		return timer.result(SoftHSM::i()->C_OpenSession(slotID, flags, pApplication, notify, phSession));
 	}
 	catch (...)
 	{
@@ -320,9 +348,11 @@ CK_RV C_OpenSession(CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication,
 // Close the given session
 CK_RV C_CloseSession(CK_SESSION_HANDLE hSession)
 {
+	StatTimer timer(StatCounter::C_CloseSession);
+
 	try
 	{
-		return SoftHSM::i()->C_CloseSession(hSession);
+		return timer.result(SoftHSM::i()->C_CloseSession(hSession));
 	}
 	catch (...)
 	{
@@ -335,9 +365,11 @@ CK_RV C_CloseSession(CK_SESSION_HANDLE hSession)
 // Close all open sessions
 CK_RV C_CloseAllSessions(CK_SLOT_ID slotID)
 {
+	StatTimer timer(StatCounter::C_CloseAllSessions);
+
 	try
 	{
-		return SoftHSM::i()->C_CloseAllSessions(slotID);
+		return timer.result(SoftHSM::i()->C_CloseAllSessions(slotID));
 	}
 	catch (...)
 	{
@@ -350,9 +382,11 @@ CK_RV C_CloseAllSessions(CK_SLOT_ID slotID)
 // Retrieve information about the specified session
 CK_RV C_GetSessionInfo(CK_SESSION_HANDLE hSession, CK_SESSION_INFO_PTR pInfo)
 {
+	StatTimer timer(StatCounter::C_GetSessionInfo);
+
 	try
 	{
-		return SoftHSM::i()->C_GetSessionInfo(hSession, pInfo);
+		return timer.result(SoftHSM::i()->C_GetSessionInfo(hSession, pInfo));
 	}
 	catch (...)
 	{
@@ -365,9 +399,11 @@ CK_RV C_GetSessionInfo(CK_SESSION_HANDLE hSession, CK_SESSION_INFO_PTR pInfo)
 // Determine the state of a running operation in a session
 CK_RV C_GetOperationState(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pOperationState, CK_ULONG_PTR pulOperationStateLen)
 {
+	StatTimer timer(StatCounter::C_GetOperationState);
+
 	try
 	{
-		return SoftHSM::i()->C_GetOperationState(hSession, pOperationState, pulOperationStateLen);
+		return timer.result(SoftHSM::i()->C_GetOperationState(hSession, pOperationState, pulOperationStateLen));
 	}
 	catch (...)
 	{
@@ -380,9 +416,11 @@ CK_RV C_GetOperationState(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pOperationStat
 // Set the operation sate in a session
 CK_RV C_SetOperationState(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pOperationState, CK_ULONG ulOperationStateLen, CK_OBJECT_HANDLE hEncryptionKey, CK_OBJECT_HANDLE hAuthenticationKey)
 {
+	StatTimer timer(StatCounter::C_SetOperationState);
+
 	try
 	{
-		return SoftHSM::i()->C_SetOperationState(hSession, pOperationState, ulOperationStateLen, hEncryptionKey, hAuthenticationKey);
+		return timer.result(SoftHSM::i()->C_SetOperationState(hSession, pOperationState, ulOperationStateLen, hEncryptionKey, hAuthenticationKey));
 	}
 	catch (...)
 	{
@@ -395,9 +433,11 @@ CK_RV C_SetOperationState(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pOperationStat
 // Login on the token in the specified session
 CK_RV C_Login(CK_SESSION_HANDLE hSession, CK_USER_TYPE userType, CK_UTF8CHAR_PTR pPin, CK_ULONG ulPinLen)
 {
+	StatTimer timer(StatCounter::C_Login);
+
 	try
 	{
-		return SoftHSM::i()->C_Login(hSession, userType, pPin, ulPinLen);
+		return timer.result(SoftHSM::i()->C_Login(hSession, userType, pPin, ulPinLen));
 	}
 	catch (...)
 	{
@@ -410,9 +450,11 @@ CK_RV C_Login(CK_SESSION_HANDLE hSession, CK_USER_TYPE userType, CK_UTF8CHAR_PTR
 // Log out of the token in the specified session
 CK_RV C_Logout(CK_SESSION_HANDLE hSession)
 {
+	StatTimer timer(StatCounter::C_Logout);
+
 	try
 	{
-		return SoftHSM::i()->C_Logout(hSession);
+		return timer.result(SoftHSM::i()->C_Logout(hSession));
 	}
 	catch (...)
 	{
@@ -425,9 +467,11 @@ CK_RV C_Logout(CK_SESSION_HANDLE hSession)
 // Create a new object on the token in the specified session using the given attribute template
 CK_RV C_CreateObject(CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, CK_OBJECT_HANDLE_PTR phObject)
 {
+	StatTimer timer(StatCounter::C_CreateObject);
+
 	try
 	{
-		return SoftHSM::i()->C_CreateObject(hSession, pTemplate, ulCount, phObject);
+		return timer.result(SoftHSM::i()->C_CreateObject(hSession, pTemplate, ulCount, phObject));
 	}
 	catch (...)
 	{
@@ -440,9 +484,11 @@ CK_RV C_CreateObject(CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_
 // Create a copy of the object with the specified handle
 CK_RV C_CopyObject(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, CK_OBJECT_HANDLE_PTR phNewObject)
 {
+	StatTimer timer(StatCounter::C_CopyObject);
+
 	try
 	{
-		return SoftHSM::i()->C_CopyObject(hSession, hObject, pTemplate, ulCount, phNewObject);
+		return timer.result(SoftHSM::i()->C_CopyObject(hSession, hObject, pTemplate, ulCount, phNewObject));
 	}
 	catch (...)
 	{
@@ -455,9 +501,11 @@ CK_RV C_CopyObject(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTR
 // Destroy the specified object
 CK_RV C_DestroyObject(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject)
 {
+	StatTimer timer(StatCounter::C_DestroyObject);
+
 	try
 	{
-		return SoftHSM::i()->C_DestroyObject(hSession, hObject);
+		return timer.result(SoftHSM::i()->C_DestroyObject(hSession, hObject));
 	}
 	catch (...)
 	{
@@ -470,9 +518,11 @@ CK_RV C_DestroyObject(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject)
 // Determine the size of the specified object
 CK_RV C_GetObjectSize(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ULONG_PTR pulSize)
 {
+	StatTimer timer(StatCounter::C_GetObjectSize);
+
 	try
 	{
-		return SoftHSM::i()->C_GetObjectSize(hSession, hObject, pulSize);
+		return timer.result(SoftHSM::i()->C_GetObjectSize(hSession, hObject, pulSize));
 	}
 	catch (...)
 	{
@@ -485,9 +535,11 @@ CK_RV C_GetObjectSize(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_U
 // Retrieve the specified attributes for the given object
 CK_RV C_GetAttributeValue(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount)
 {
+	StatTimer timer(StatCounter::C_GetAttributeValue);
+
 	try
 	{
-		return SoftHSM::i()->C_GetAttributeValue(hSession, hObject, pTemplate, ulCount);
+		return timer.result(SoftHSM::i()->C_GetAttributeValue(hSession, hObject, pTemplate, ulCount));
 	}
 	catch (...)
 	{
@@ -500,9 +552,11 @@ CK_RV C_GetAttributeValue(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject,
 // Change or set the value of the specified attributes on the specified object
 CK_RV C_SetAttributeValue(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount)
 {
+	StatTimer timer(StatCounter::C_SetAttributeValue);
+
 	try
 	{
-		return SoftHSM::i()->C_SetAttributeValue(hSession, hObject, pTemplate, ulCount);
+		return timer.result(SoftHSM::i()->C_SetAttributeValue(hSession, hObject, pTemplate, ulCount));
 	}
 	catch (...)
 	{
@@ -515,9 +569,11 @@ CK_RV C_SetAttributeValue(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject,
 // Initialise object search in the specified session using the specified attribute template as search parameters
 CK_RV C_FindObjectsInit(CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount)
 {
+	StatTimer timer(StatCounter::C_FindObjectsInit);
+
 	try
 	{
-		return SoftHSM::i()->C_FindObjectsInit(hSession, pTemplate, ulCount);
+		return timer.result(SoftHSM::i()->C_FindObjectsInit(hSession, pTemplate, ulCount));
 	}
 	catch (...)
 	{
@@ -530,9 +586,11 @@ CK_RV C_FindObjectsInit(CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate,
 // Continue the search for objects in the specified session
 CK_RV C_FindObjects(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE_PTR phObject, CK_ULONG ulMaxObjectCount, CK_ULONG_PTR pulObjectCount)
 {
+	StatTimer timer(StatCounter::C_FindObjects);
+
 	try
 	{
-		return SoftHSM::i()->C_FindObjects(hSession, phObject, ulMaxObjectCount, pulObjectCount);
+		return timer.result(SoftHSM::i()->C_FindObjects(hSession, phObject, ulMaxObjectCount, pulObjectCount));
 	}
 	catch (...)
 	{
@@ -545,9 +603,11 @@ CK_RV C_FindObjects(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE_PTR phObject, C
 // Finish searching for objects
 CK_RV C_FindObjectsFinal(CK_SESSION_HANDLE hSession)
 {
+	StatTimer timer(StatCounter::C_FindObjectsFinal);
+
 	try
 	{
-		return SoftHSM::i()->C_FindObjectsFinal(hSession);
+		return timer.result(SoftHSM::i()->C_FindObjectsFinal(hSession));
 	}
 	catch (...)
 	{
@@ -560,9 +620,11 @@ CK_RV C_FindObjectsFinal(CK_SESSION_HANDLE hSession)
 // Initialise encryption using the specified object and mechanism
 CK_RV C_EncryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hObject)
 {
+	StatTimer timer(StatCounter::C_EncryptInit);
+
 	try
 	{
-		return SoftHSM::i()->C_EncryptInit(hSession, pMechanism, hObject);
+		return timer.result(SoftHSM::i()->C_EncryptInit(hSession, pMechanism, hObject));
 	}
 	catch (...)
 	{
@@ -575,9 +637,11 @@ CK_RV C_EncryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_
 // Perform a single operation encryption operation in the specified session
 CK_RV C_Encrypt(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen)
 {
+	StatTimer timer(StatCounter::C_Encrypt);
+
 	try
 	{
-		return SoftHSM::i()->C_Encrypt(hSession, pData, ulDataLen, pEncryptedData, pulEncryptedDataLen);
+		return timer.result(SoftHSM::i()->C_Encrypt(hSession, pData, ulDataLen, pEncryptedData, pulEncryptedDataLen));
 	}
 	catch (...)
 	{
@@ -590,9 +654,11 @@ CK_RV C_Encrypt(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLe
 // Feed data to the running encryption operation in a session
 CK_RV C_EncryptUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen)
 {
+	StatTimer timer(StatCounter::C_EncryptUpdate);
+
 	try
 	{
-		return SoftHSM::i()->C_EncryptUpdate(hSession, pData, ulDataLen, pEncryptedData, pulEncryptedDataLen);
+		return timer.result(SoftHSM::i()->C_EncryptUpdate(hSession, pData, ulDataLen, pEncryptedData, pulEncryptedDataLen));
 	}
 	catch (...)
 	{
@@ -605,9 +671,11 @@ CK_RV C_EncryptUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ul
 // Finalise the encryption operation
 CK_RV C_EncryptFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData, CK_ULONG_PTR pulEncryptedDataLen)
 {
+	StatTimer timer(StatCounter::C_EncryptFinal);
+
 	try
 	{
-		return SoftHSM::i()->C_EncryptFinal(hSession, pEncryptedData, pulEncryptedDataLen);
+		return timer.result(SoftHSM::i()->C_EncryptFinal(hSession, pEncryptedData, pulEncryptedDataLen));
 	}
 	catch (...)
 	{
@@ -620,9 +688,11 @@ CK_RV C_EncryptFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData, CK_
 // Initialise decryption using the specified object
 CK_RV C_DecryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hObject)
 {
+	StatTimer timer(StatCounter::C_DecryptInit);
+
 	try
 	{
-		return SoftHSM::i()->C_DecryptInit(hSession, pMechanism, hObject);
+		return timer.result(SoftHSM::i()->C_DecryptInit(hSession, pMechanism, hObject));
 	}
 	catch (...)
 	{
@@ -635,9 +705,11 @@ CK_RV C_DecryptInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_
 // Perform a single operation decryption in the given session
 CK_RV C_Decrypt(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData, CK_ULONG ulEncryptedDataLen, CK_BYTE_PTR pData, CK_ULONG_PTR pulDataLen)
 {
+	StatTimer timer(StatCounter::C_Decrypt);
+
 	try
 	{
-		return SoftHSM::i()->C_Decrypt(hSession, pEncryptedData, ulEncryptedDataLen, pData, pulDataLen);
+		return timer.result(SoftHSM::i()->C_Decrypt(hSession, pEncryptedData, ulEncryptedDataLen, pData, pulDataLen));
 	}
 	catch (...)
 	{
@@ -650,9 +722,11 @@ CK_RV C_Decrypt(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData, CK_ULONG
 // Feed data to the running decryption operation in a session
 CK_RV C_DecryptUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData, CK_ULONG ulEncryptedDataLen, CK_BYTE_PTR pData, CK_ULONG_PTR pDataLen)
 {
+	StatTimer timer(StatCounter::C_DecryptUpdate);
+
 	try
 	{
-		return SoftHSM::i()->C_DecryptUpdate(hSession, pEncryptedData, ulEncryptedDataLen, pData, pDataLen);
+		return timer.result(SoftHSM::i()->C_DecryptUpdate(hSession, pEncryptedData, ulEncryptedDataLen, pData, pDataLen));
 	}
 	catch (...)
 	{
@@ -665,9 +739,11 @@ CK_RV C_DecryptUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedData, CK
 // Finalise the decryption operation
 CK_RV C_DecryptFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG_PTR pDataLen)
 {
+	StatTimer timer(StatCounter::C_DecryptFinal);
+
 	try
 	{
-		return SoftHSM::i()->C_DecryptFinal(hSession, pData, pDataLen);
+		return timer.result(SoftHSM::i()->C_DecryptFinal(hSession, pData, pDataLen));
 	}
 	catch (...)
 	{
@@ -680,9 +756,11 @@ CK_RV C_DecryptFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG_PTR
 // Initialise digesting using the specified mechanism in the specified session
 CK_RV C_DigestInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism)
 {
+	StatTimer timer(StatCounter::C_DigestInit);
+
 	try
 	{
-		return SoftHSM::i()->C_DigestInit(hSession, pMechanism);
+		return timer.result(SoftHSM::i()->C_DigestInit(hSession, pMechanism));
 	}
 	catch (...)
 	{
@@ -695,9 +773,11 @@ CK_RV C_DigestInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism)
 // Digest the specified data in a one-pass operation and return the resulting digest
 CK_RV C_Digest(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pDigest, CK_ULONG_PTR pulDigestLen)
 {
+	StatTimer timer(StatCounter::C_Digest);
+
 	try
 	{
-		return SoftHSM::i()->C_Digest(hSession, pData, ulDataLen, pDigest, pulDigestLen);
+		return timer.result(SoftHSM::i()->C_Digest(hSession, pData, ulDataLen, pDigest, pulDigestLen));
 	}
 	catch (...)
 	{
@@ -710,9 +790,11 @@ CK_RV C_Digest(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen
 // Update a running digest operation
 CK_RV C_DigestUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen)
 {
+	StatTimer timer(StatCounter::C_DigestUpdate);
+
 	try
 	{
-		return SoftHSM::i()->C_DigestUpdate(hSession, pPart, ulPartLen);
+		return timer.result(SoftHSM::i()->C_DigestUpdate(hSession, pPart, ulPartLen));
 	}
 	catch (...)
 	{
@@ -725,9 +807,11 @@ CK_RV C_DigestUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulP
 // Update a running digest operation by digesting a secret key with the specified handle
 CK_RV C_DigestKey(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject)
 {
+	StatTimer timer(StatCounter::C_DigestKey);
+
 	try
 	{
-		return SoftHSM::i()->C_DigestKey(hSession, hObject);
+		return timer.result(SoftHSM::i()->C_DigestKey(hSession, hObject));
 	}
 	catch (...)
 	{
@@ -740,9 +824,11 @@ CK_RV C_DigestKey(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject)
 // Finalise the digest operation in the specified session and return the digest
 CK_RV C_DigestFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDigest, CK_ULONG_PTR pulDigestLen)
 {
+	StatTimer timer(StatCounter::C_DigestFinal);
+
 	try
 	{
-		return SoftHSM::i()->C_DigestFinal(hSession, pDigest, pulDigestLen);
+		return timer.result(SoftHSM::i()->C_DigestFinal(hSession, pDigest, pulDigestLen));
 	}
 	catch (...)
 	{
@@ -755,9 +841,11 @@ CK_RV C_DigestFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDigest, CK_ULONG_PT
 // Initialise a signing operation using the specified key and mechanism
 CK_RV C_SignInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
 {
+	StatTimer timer(StatCounter::C_SignInit);
+
 	try
 	{
-		return SoftHSM::i()->C_SignInit(hSession, pMechanism, hKey);
+		return timer.result(SoftHSM::i()->C_SignInit(hSession, pMechanism, hKey));
 	}
 	catch (...)
 	{
@@ -770,9 +858,11 @@ CK_RV C_SignInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJ
 // Sign the data in a single pass operation
 CK_RV C_Sign(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pSignature, CK_ULONG_PTR pulSignatureLen)
 {
+	StatTimer timer(StatCounter::C_Sign);
+
 	try
 	{
-		return SoftHSM::i()->C_Sign(hSession, pData, ulDataLen, pSignature, pulSignatureLen);
+		return timer.result(SoftHSM::i()->C_Sign(hSession, pData, ulDataLen, pSignature, pulSignatureLen));
 	}
 	catch (...)
 	{
@@ -785,9 +875,11 @@ CK_RV C_Sign(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen,
 // Update a running signing operation with additional data
 CK_RV C_SignUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen)
 {
+	StatTimer timer(StatCounter::C_SignUpdate);
+
 	try
 	{
-		return SoftHSM::i()->C_SignUpdate(hSession, pPart, ulPartLen);
+		return timer.result(SoftHSM::i()->C_SignUpdate(hSession, pPart, ulPartLen));
 	}
 	catch (...)
 	{
@@ -800,9 +892,11 @@ CK_RV C_SignUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPar
 // Finalise a running signing operation and return the signature
 CK_RV C_SignFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULONG_PTR pulSignatureLen)
 {
+	StatTimer timer(StatCounter::C_SignFinal);
+
 	try
 	{
-		return SoftHSM::i()->C_SignFinal(hSession, pSignature, pulSignatureLen);
+		return timer.result(SoftHSM::i()->C_SignFinal(hSession, pSignature, pulSignatureLen));
 	}
 	catch (...)
 	{
@@ -815,9 +909,11 @@ CK_RV C_SignFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULONG_P
 // Initialise a signing operation that allows recovery of the signed data
 CK_RV C_SignRecoverInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
 {
+	StatTimer timer(StatCounter::C_SignRecoverInit);
+
 	try
 	{
-		return SoftHSM::i()->C_SignRecoverInit(hSession, pMechanism, hKey);
+		return timer.result(SoftHSM::i()->C_SignRecoverInit(hSession, pMechanism, hKey));
 	}
 	catch (...)
 	{
@@ -830,9 +926,11 @@ CK_RV C_SignRecoverInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism,
 // Perform a single part signing operation that allows recovery of the signed data
 CK_RV C_SignRecover(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pSignature, CK_ULONG_PTR pulSignatureLen)
 {
+	StatTimer timer(StatCounter::C_SignRecover);
+
 	try
 	{
-		return SoftHSM::i()->C_SignRecover(hSession, pData, ulDataLen, pSignature, pulSignatureLen);
+		return timer.result(SoftHSM::i()->C_SignRecover(hSession, pData, ulDataLen, pSignature, pulSignatureLen));
 	}
 	catch (...)
 	{
@@ -845,9 +943,11 @@ CK_RV C_SignRecover(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDa
 // Initialise a verification operation using the specified key and mechanism
 CK_RV C_VerifyInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
 {
+	StatTimer timer(StatCounter::C_VerifyInit);
+
 	try
 	{
-		return SoftHSM::i()->C_VerifyInit(hSession, pMechanism, hKey);
+		return timer.result(SoftHSM::i()->C_VerifyInit(hSession, pMechanism, hKey));
 	}
 	catch (...)
 	{
@@ -860,9 +960,11 @@ CK_RV C_VerifyInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_O
 // Perform a single pass verification operation
 CK_RV C_Verify(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen, CK_BYTE_PTR pSignature, CK_ULONG ulSignatureLen)
 {
+	StatTimer timer(StatCounter::C_Verify);
+
 	try
 	{
-		return SoftHSM::i()->C_Verify(hSession, pData, ulDataLen, pSignature, ulSignatureLen);
+		return timer.result(SoftHSM::i()->C_Verify(hSession, pData, ulDataLen, pSignature, ulSignatureLen));
 	}
 	catch (...)
 	{
@@ -875,9 +977,11 @@ CK_RV C_Verify(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData, CK_ULONG ulDataLen
 // Update a running verification operation with additional data
 CK_RV C_VerifyUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen)
 {
+	StatTimer timer(StatCounter::C_VerifyUpdate);
+
 	try
 	{
-		return SoftHSM::i()->C_VerifyUpdate(hSession, pPart, ulPartLen);
+		return timer.result(SoftHSM::i()->C_VerifyUpdate(hSession, pPart, ulPartLen));
 	}
 	catch (...)
 	{
@@ -890,9 +994,11 @@ CK_RV C_VerifyUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulP
 // Finalise the verification operation and check the signature
 CK_RV C_VerifyFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULONG ulSignatureLen)
 {
+	StatTimer timer(StatCounter::C_VerifyFinal);
+
 	try
 	{
-		return SoftHSM::i()->C_VerifyFinal(hSession, pSignature, ulSignatureLen);
+		return timer.result(SoftHSM::i()->C_VerifyFinal(hSession, pSignature, ulSignatureLen));
 	}
 	catch (...)
 	{
@@ -905,9 +1011,11 @@ CK_RV C_VerifyFinal(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULONG
 // Initialise a verification operation the allows recovery of the signed data from the signature
 CK_RV C_VerifyRecoverInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_OBJECT_HANDLE hKey)
 {
+	StatTimer timer(StatCounter::C_VerifyRecoverInit);
+
 	try
 	{
-		return SoftHSM::i()->C_VerifyRecoverInit(hSession, pMechanism, hKey);
+		return timer.result(SoftHSM::i()->C_VerifyRecoverInit(hSession, pMechanism, hKey));
 	}
 	catch (...)
 	{
@@ -920,9 +1028,11 @@ CK_RV C_VerifyRecoverInit(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanis
 // Perform a single part verification operation and recover the signed data
 CK_RV C_VerifyRecover(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULONG ulSignatureLen, CK_BYTE_PTR pData, CK_ULONG_PTR pulDataLen)
 {
+	StatTimer timer(StatCounter::C_VerifyRecover);
+
 	try
 	{
-		return SoftHSM::i()->C_VerifyRecover(hSession, pSignature, ulSignatureLen, pData, pulDataLen);
+		return timer.result(SoftHSM::i()->C_VerifyRecover(hSession, pSignature, ulSignatureLen, pData, pulDataLen));
 	}
 	catch (...)
 	{
@@ -935,9 +1045,11 @@ CK_RV C_VerifyRecover(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSignature, CK_ULO
 // Update a running multi-part encryption and digesting operation
 CK_RV C_DigestEncryptUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen, CK_BYTE_PTR pEncryptedPart, CK_ULONG_PTR pulEncryptedPartLen)
 {
+	StatTimer timer(StatCounter::C_DigestEncryptUpdate);
+
 	try
 	{
-		return SoftHSM::i()->C_DigestEncryptUpdate(hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen);
+		return timer.result(SoftHSM::i()->C_DigestEncryptUpdate(hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen));
 	}
 	catch (...)
 	{
@@ -950,9 +1062,11 @@ CK_RV C_DigestEncryptUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_UL
 // Update a running multi-part decryption and digesting operation
 CK_RV C_DecryptDigestUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen, CK_BYTE_PTR pDecryptedPart, CK_ULONG_PTR pulDecryptedPartLen)
 {
+	StatTimer timer(StatCounter::C_DecryptDigestUpdate);
+
 	try
 	{
-		return SoftHSM::i()->C_DecryptDigestUpdate(hSession, pPart, ulPartLen, pDecryptedPart, pulDecryptedPartLen);
+		return timer.result(SoftHSM::i()->C_DecryptDigestUpdate(hSession, pPart, ulPartLen, pDecryptedPart, pulDecryptedPartLen));
 	}
 	catch (...)
 	{
@@ -965,9 +1079,11 @@ CK_RV C_DecryptDigestUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_UL
 // Update a running multi-part signing and encryption operation
 CK_RV C_SignEncryptUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen, CK_BYTE_PTR pEncryptedPart, CK_ULONG_PTR pulEncryptedPartLen)
 {
+	StatTimer timer(StatCounter::C_SignEncryptUpdate);
+
 	try
 	{
-		return SoftHSM::i()->C_SignEncryptUpdate(hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen);
+		return timer.result(SoftHSM::i()->C_SignEncryptUpdate(hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen));
 	}
 	catch (...)
 	{
@@ -980,9 +1096,11 @@ CK_RV C_SignEncryptUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULON
 // Update a running multi-part decryption and verification operation
 CK_RV C_DecryptVerifyUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedPart, CK_ULONG ulEncryptedPartLen, CK_BYTE_PTR pPart, CK_ULONG_PTR pulPartLen)
 {
+	StatTimer timer(StatCounter::C_DecryptVerifyUpdate);
+
 	try
 	{
-		return SoftHSM::i()->C_DecryptVerifyUpdate(hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen);
+		return timer.result(SoftHSM::i()->C_DecryptVerifyUpdate(hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen));
 	}
 	catch (...)
 	{
@@ -995,9 +1113,11 @@ CK_RV C_DecryptVerifyUpdate(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEncryptedPa
 // Generate a secret key using the specified mechanism
 CK_RV C_GenerateKey(CK_SESSION_HANDLE hSession, CK_MECHANISM_PTR pMechanism, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, CK_OBJECT_HANDLE_PTR phKey)
 {
+	StatTimer timer(StatCounter::C_GenerateKey);
+
 	try
 	{
-		return SoftHSM::i()->C_GenerateKey(hSession, pMechanism, pTemplate, ulCount, phKey);
+		return timer.result(SoftHSM::i()->C_GenerateKey(hSession, pMechanism, pTemplate, ulCount, phKey));
 	}
 	catch (...)
 	{
@@ -1020,9 +1140,11 @@ CK_RV C_GenerateKeyPair
 	CK_OBJECT_HANDLE_PTR phPrivateKey
 )
 {
+	StatTimer timer(StatCounter::C_GenerateKeyPair);
+
 	try
 	{
-		return SoftHSM::i()->C_GenerateKeyPair(hSession, pMechanism, pPublicKeyTemplate, ulPublicKeyAttributeCount, pPrivateKeyTemplate, ulPrivateKeyAttributeCount, phPublicKey, phPrivateKey);
+		return timer.result(SoftHSM::i()->C_GenerateKeyPair(hSession, pMechanism, pPublicKeyTemplate, ulPublicKeyAttributeCount, pPrivateKeyTemplate, ulPrivateKeyAttributeCount, phPublicKey, phPrivateKey));
 	}
 	catch (...)
 	{
@@ -1043,9 +1165,11 @@ CK_RV C_WrapKey
 	CK_ULONG_PTR pulWrappedKeyLen
 )
 {
+	StatTimer timer(StatCounter::C_WrapKey);
+
 	try
 	{
-		return SoftHSM::i()->C_WrapKey(hSession, pMechanism, hWrappingKey, hKey, pWrappedKey, pulWrappedKeyLen);
+		return timer.result(SoftHSM::i()->C_WrapKey(hSession, pMechanism, hWrappingKey, hKey, pWrappedKey, pulWrappedKeyLen));
 	}
 	catch (...)
 	{
@@ -1068,9 +1192,11 @@ CK_RV C_UnwrapKey
 	CK_OBJECT_HANDLE_PTR phKey
 )
 {
+	StatTimer timer(StatCounter::C_UnwrapKey);
+
 	try
 	{
-		return SoftHSM::i()->C_UnwrapKey(hSession, pMechanism, hUnwrappingKey, pWrappedKey, ulWrappedKeyLen, pTemplate, ulCount, phKey);
+		return timer.result(SoftHSM::i()->C_UnwrapKey(hSession, pMechanism, hUnwrappingKey, pWrappedKey, ulWrappedKeyLen, pTemplate, ulCount, phKey));
 	}
 	catch (...)
 	{
@@ -1091,9 +1217,11 @@ CK_RV C_DeriveKey
 	CK_OBJECT_HANDLE_PTR phKey
 )
 {
+	StatTimer timer(StatCounter::C_DeriveKey);
+
 	try
 	{
-		return SoftHSM::i()->C_DeriveKey(hSession, pMechanism, hBaseKey, pTemplate, ulCount, phKey);
+		return timer.result(SoftHSM::i()->C_DeriveKey(hSession, pMechanism, hBaseKey, pTemplate, ulCount, phKey));
 	}
 	catch (...)
 	{
@@ -1106,9 +1234,11 @@ CK_RV C_DeriveKey
 // Seed the random number generator with new data
 CK_RV C_SeedRandom(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSeed, CK_ULONG ulSeedLen)
 {
+	StatTimer timer(StatCounter::C_SeedRandom);
+
 	try
 	{
-		return SoftHSM::i()->C_SeedRandom(hSession, pSeed, ulSeedLen);
+		return timer.result(SoftHSM::i()->C_SeedRandom(hSession, pSeed, ulSeedLen));
 	}
 	catch (...)
 	{
@@ -1121,9 +1251,11 @@ CK_RV C_SeedRandom(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pSeed, CK_ULONG ulSee
 // Generate the specified amount of random data
 CK_RV C_GenerateRandom(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pRandomData, CK_ULONG ulRandomLen)
 {
+	StatTimer timer(StatCounter::C_GenerateRandom);
+
 	try
 	{
-		return SoftHSM::i()->C_GenerateRandom(hSession, pRandomData, ulRandomLen);
+		return timer.result(SoftHSM::i()->C_GenerateRandom(hSession, pRandomData, ulRandomLen));
 	}
 	catch (...)
 	{
@@ -1136,9 +1268,11 @@ CK_RV C_GenerateRandom(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pRandomData, CK_U
 // Legacy function
 CK_RV C_GetFunctionStatus(CK_SESSION_HANDLE hSession)
 {
+	StatTimer timer(StatCounter::C_GetFunctionStatus);
+
 	try
 	{
-		return SoftHSM::i()->C_GetFunctionStatus(hSession);
+		return timer.result(SoftHSM::i()->C_GetFunctionStatus(hSession));
 	}
 	catch (...)
 	{
@@ -1151,9 +1285,11 @@ CK_RV C_GetFunctionStatus(CK_SESSION_HANDLE hSession)
 // Legacy function
 CK_RV C_CancelFunction(CK_SESSION_HANDLE hSession)
 {
+	StatTimer timer(StatCounter::C_CancelFunction);
+
 	try
 	{
-		return SoftHSM::i()->C_CancelFunction(hSession);
+		return timer.result(SoftHSM::i()->C_CancelFunction(hSession));
 	}
 	catch (...)
 	{
@@ -1166,9 +1302,11 @@ CK_RV C_CancelFunction(CK_SESSION_HANDLE hSession)
 // Wait or poll for a slot even on the specified slot
 CK_RV C_WaitForSlotEvent(CK_FLAGS flags, CK_SLOT_ID_PTR pSlot, CK_VOID_PTR pReserved)
 {
+	StatTimer timer(StatCounter::C_WaitForSlotEvent);
+
 	try
 	{
-		return SoftHSM::i()->C_WaitForSlotEvent(flags, pSlot, pReserved);
+		return timer.result(SoftHSM::i()->C_WaitForSlotEvent(flags, pSlot, pReserved));
 	}
 	catch (...)
 	{
@@ -1178,3 +1316,46 @@ CK_RV C_WaitForSlotEvent(CK_FLAGS flags, CK_SLOT_ID_PTR pSlot, CK_VOID_PTR pRese
 	return CKR_FUNCTION_FAILED;
 }
 
+// Return the call statistics (SoftHSM vendor extension)
+CK_RV C_GetStatistics(CK_STATISTICS_PTR pStatistics, CK_ULONG_PTR pulCount)
+{
+	try
+	{
+		if (pulCount == NULL_PTR) return CKR_ARGUMENTS_BAD;
+
+		std::vector<CK_STATISTICS> statistics;
+
+		Statistics::i()->getStatistics(statistics);
+
+		// Only return the number of entries
+		if (pStatistics == NULL_PTR)
+		{
+			*pulCount = statistics.size();
+
+			return CKR_OK;
+		}
+
+		// Is the buffer large enough?
+		if (*pulCount < statistics.size())
+		{
+			*pulCount = statistics.size();
+
+			return CKR_BUFFER_TOO_SMALL;
+		}
+
+		for (size_t i = 0; i < statistics.size(); i++)
+		{
+			pStatistics[i] = statistics[i];
+		}
+
+		*pulCount = statistics.size();
+
+		return CKR_OK;
+	}
+	catch (...)
+	{
+		FatalException();
+	}
+
+	return CKR_FUNCTION_FAILED;
+}
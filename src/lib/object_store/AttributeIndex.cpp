@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ AttributeIndex.cpp
+
+ An in-memory index on the attributes that are most commonly used to look up
+ objects (CKA_CLASS, CKA_KEY_TYPE, CKA_ID and CKA_LABEL). The index maps a
+ hash of the plaintext attribute value to the set of objects having that
+ value. It is maintained incrementally by its owner (OSToken or the
+ SessionObjectStore), which flags objects as changed or removed; the entries
+ of changed objects are recomputed lazily on the next lookup.
+ *****************************************************************************/
+
+#include "config.h"
+#include "log.h"
+#include "AttributeIndex.h"
+#include "OSAttribute.h"
+
+// The attributes that are indexed
+static const CK_ATTRIBUTE_TYPE indexedTypes[] = { CKA_CLASS, CKA_KEY_TYPE, CKA_ID, CKA_LABEL };
+
+// Constructor
+AttributeIndex::AttributeIndex()
+{
+	generation = 0;
+	indexMutex = MutexFactory::i()->getMutex();
+}
+
+// Destructor
+AttributeIndex::~AttributeIndex()
+{
+	MutexFactory::i()->recycleMutex(indexMutex);
+}
+
+// Check if the attribute type is indexed
+/*static*/ bool AttributeIndex::isIndexed(CK_ATTRIBUTE_TYPE type)
+{
+	for (size_t i = 0; i < sizeof(indexedTypes) / sizeof(indexedTypes[0]); i++)
+	{
+		if (indexedTypes[i] == type) return true;
+	}
+
+	return false;
+}
+
+// Check if the template contains at least one indexed attribute
+/*static*/ bool AttributeIndex::isIndexable(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount)
+{
+	for (CK_ULONG i = 0; i < ulCount; i++)
+	{
+		if (isIndexed(pTemplate[i].type) &&
+		    (pTemplate[i].pValue != NULL_PTR || pTemplate[i].ulValueLen == 0))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Hash an attribute value (64-bit FNV-1a)
+/*static*/ unsigned long long AttributeIndex::hash(const unsigned char* data, size_t len)
+{
+	unsigned long long rv = 0xcbf29ce484222325ULL;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		rv ^= data[i];
+		rv *= 0x100000001b3ULL;
+	}
+
+	return rv;
+}
+
+// Compute the index keys of an object
+/*static*/ bool AttributeIndex::computeKeys(OSObject* object, Decryptor* decryptor, std::set<IndexKey>& keys, bool& isPrivate, bool& partial)
+{
+	partial = false;
+
+	OSAttribute* attr = object->getAttribute(CKA_PRIVATE);
+
+	if (attr == NULL || !attr->isBooleanAttribute())
+	{
+		return false;
+	}
+
+	isPrivate = attr->getBooleanValue();
+
+	for (size_t i = 0; i < sizeof(indexedTypes) / sizeof(indexedTypes[0]); i++)
+	{
+		attr = object->getAttribute(indexedTypes[i]);
+
+		if (attr == NULL)
+		{
+			continue;
+		}
+
+		if (attr->isUnsignedLongAttribute())
+		{
+			unsigned long value = attr->getUnsignedLongValue();
+
+			keys.insert(IndexKey(indexedTypes[i], hash((const unsigned char*) &value, sizeof(value))));
+		}
+		else if (attr->isByteStringAttribute())
+		{
+			ByteString value = attr->getByteStringValue();
+
+			if (isPrivate && value.size() != 0)
+			{
+				ByteString plaintext;
+
+				if ((decryptor == NULL) || !decryptor->decrypt(value, plaintext))
+				{
+					// Only possible when the token is logged in
+					partial = true;
+
+					continue;
+				}
+
+				value = plaintext;
+			}
+
+			keys.insert(IndexKey(indexedTypes[i], hash(value.const_byte_str(), value.size())));
+		}
+	}
+
+	return true;
+}
+
+// Flag an object as new or changed
+void AttributeIndex::objectChanged(OSObject* object)
+{
+	MutexLocker lock(indexMutex);
+
+	dirtyObjects[object] = ++generation;
+}
+
+// Remove an object from the index
+void AttributeIndex::objectRemoved(OSObject* object)
+{
+	MutexLocker lock(indexMutex);
+
+	removeEntries(object);
+	dirtyObjects.erase(object);
+}
+
+// Discard all entries derived from encrypted attribute values
+void AttributeIndex::discardPrivate()
+{
+	MutexLocker lock(indexMutex);
+
+	// The entries of private objects are recomputed when needed; until
+	// then the objects are flagged as changed and returned as candidates
+	std::set<OSObject*> discard = privateObjects;
+
+	for (std::set<OSObject*>::iterator i = discard.begin(); i != discard.end(); i++)
+	{
+		removeEntries(*i);
+		dirtyObjects[*i] = ++generation;
+	}
+}
+
+// Remove all objects from the index
+void AttributeIndex::clear()
+{
+	MutexLocker lock(indexMutex);
+
+	buckets.clear();
+	entries.clear();
+	privateObjects.clear();
+	partialObjects.clear();
+	dirtyObjects.clear();
+}
+
+// Remove the entries of an object from the buckets; the index mutex must be held
+void AttributeIndex::removeEntries(OSObject* object)
+{
+	std::map<OSObject*, std::set<IndexKey> >::iterator entry = entries.find(object);
+
+	if (entry != entries.end())
+	{
+		for (std::set<IndexKey>::iterator i = entry->second.begin(); i != entry->second.end(); i++)
+		{
+			std::map<IndexKey, std::set<OSObject*> >::iterator bucket = buckets.find(*i);
+
+			if (bucket == buckets.end()) continue;
+
+			bucket->second.erase(object);
+
+			if (bucket->second.empty())
+			{
+				buckets.erase(bucket);
+			}
+		}
+
+		entries.erase(entry);
+	}
+
+	privateObjects.erase(object);
+	partialObjects.erase(object);
+}
+
+// Retrieve the objects that may match the template
+bool AttributeIndex::findCandidates(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, Decryptor* decryptor, std::set<OSObject*>& candidates)
+{
+	if (!isIndexable(pTemplate, ulCount))
+	{
+		return false;
+	}
+
+	// Bring the entries of changed objects up to date; the attributes are
+	// read without holding the index mutex since reading them may cause an
+	// object to be flagged as changed again
+	std::map<OSObject*, unsigned long> toUpdate;
+
+	{
+		MutexLocker lock(indexMutex);
+
+		toUpdate = dirtyObjects;
+	}
+
+	for (std::map<OSObject*, unsigned long>::iterator i = toUpdate.begin(); i != toUpdate.end(); i++)
+	{
+		std::set<IndexKey> keys;
+		bool isPrivate, partial;
+
+		// Objects that cannot be indexed stay flagged and are always returned
+		if (!i->first->isValid() || !computeKeys(i->first, decryptor, keys, isPrivate, partial))
+		{
+			continue;
+		}
+
+		MutexLocker lock(indexMutex);
+
+		// Skip the object if it was removed or changed again in the meantime
+		std::map<OSObject*, unsigned long>::iterator dirty = dirtyObjects.find(i->first);
+
+		if ((dirty == dirtyObjects.end()) || (dirty->second != i->second))
+		{
+			continue;
+		}
+
+		removeEntries(i->first);
+
+		for (std::set<IndexKey>::iterator k = keys.begin(); k != keys.end(); k++)
+		{
+			buckets[*k].insert(i->first);
+		}
+
+		entries[i->first] = keys;
+
+		if (isPrivate)
+		{
+			privateObjects.insert(i->first);
+		}
+
+		if (partial)
+		{
+			partialObjects.insert(i->first);
+		}
+
+		dirtyObjects.erase(dirty);
+	}
+
+	MutexLocker lock(indexMutex);
+
+	// Use the most selective indexed attribute in the template
+	const std::set<OSObject*>* bestBucket = NULL;
+	size_t bestSize = 0;
+	bool bestIsByteString = false;
+	bool found = false;
+
+	for (CK_ULONG i = 0; i < ulCount; i++)
+	{
+		if (!isIndexed(pTemplate[i].type) ||
+		    (pTemplate[i].pValue == NULL_PTR && pTemplate[i].ulValueLen != 0))
+		{
+			continue;
+		}
+
+		IndexKey key(pTemplate[i].type, hash((const unsigned char*) pTemplate[i].pValue, pTemplate[i].ulValueLen));
+		std::map<IndexKey, std::set<OSObject*> >::iterator bucket = buckets.find(key);
+
+		// Private objects of which the encrypted values could not be
+		// decrypted may match any CKA_ID or CKA_LABEL
+		bool isByteString = (pTemplate[i].type == CKA_ID) || (pTemplate[i].type == CKA_LABEL);
+		size_t size = (bucket == buckets.end()) ? 0 : bucket->second.size();
+
+		if (isByteString) size += partialObjects.size();
+
+		if (!found || (size < bestSize))
+		{
+			bestBucket = (bucket == buckets.end()) ? NULL : &bucket->second;
+			bestSize = size;
+			bestIsByteString = isByteString;
+			found = true;
+		}
+	}
+
+	if (bestBucket != NULL)
+	{
+		candidates.insert(bestBucket->begin(), bestBucket->end());
+	}
+
+	if (bestIsByteString)
+	{
+		candidates.insert(partialObjects.begin(), partialObjects.end());
+	}
+
+	// Objects of which the entries are not up to date may match anything
+	for (std::map<OSObject*, unsigned long>::iterator i = dirtyObjects.begin(); i != dirtyObjects.end(); i++)
+	{
+		candidates.insert(i->first);
+	}
+
+	return true;
+}
+
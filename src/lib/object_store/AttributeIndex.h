@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ AttributeIndex.h
+
+ An in-memory index on the attributes that are most commonly used to look up
+ objects (CKA_CLASS, CKA_KEY_TYPE, CKA_ID and CKA_LABEL). The index maps a
+ hash of the plaintext attribute value to the set of objects having that
+ value. It is maintained incrementally by its owner (OSToken or the
+ SessionObjectStore), which flags objects as changed or removed; the entries
+ of changed objects are recomputed lazily on the next lookup.
+
+ The index only ever narrows down the set of objects that needs to be matched
+ against a search template; every candidate it returns must still be checked
+ in full by the caller.
+ *****************************************************************************/
+
+#ifndef _SOFTHSM_V2_ATTRIBUTEINDEX_H
+#define _SOFTHSM_V2_ATTRIBUTEINDEX_H
+
+#include "config.h"
+#include "ByteString.h"
+#include "OSObject.h"
+#include "MutexFactory.h"
+#include "cryptoki.h"
+#include <map>
+#include <set>
+
+class AttributeIndex
+{
+public:
+	// Interface used by the index to obtain the plaintext of encrypted
+	// attribute values of private objects
+	class Decryptor
+	{
+	public:
+		virtual ~Decryptor() { }
+
+		// Decrypt the supplied data
+		virtual bool decrypt(const ByteString& encrypted, ByteString& plaintext) = 0;
+	};
+
+	// Constructor
+	AttributeIndex();
+
+	// Destructor
+	virtual ~AttributeIndex();
+
+	// Check if the template contains at least one indexed attribute
+	static bool isIndexable(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount);
+
+	// Flag an object as new or changed; its entries are recomputed on the next lookup
+	void objectChanged(OSObject* object);
+
+	// Remove an object from the index
+	void objectRemoved(OSObject* object);
+
+	// Discard all entries derived from encrypted attribute values; this
+	// is called when the token is logged out
+	void discardPrivate();
+
+	// Remove all objects from the index
+	void clear();
+
+	// Retrieve the objects that may match the template. Returns false if
+	// the template does not contain any indexed attributes, in which case
+	// all objects need to be considered
+	bool findCandidates(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, Decryptor* decryptor, std::set<OSObject*>& candidates);
+
+private:
+	// An index key is the attribute type combined with the hash of its value
+	typedef std::pair<CK_ATTRIBUTE_TYPE, unsigned long long> IndexKey;
+
+	// Check if the attribute type is indexed
+	static bool isIndexed(CK_ATTRIBUTE_TYPE type);
+
+	// Hash an attribute value (64-bit FNV-1a)
+	static unsigned long long hash(const unsigned char* data, size_t len);
+
+	// Compute the index keys of an object; returns false if the object
+	// cannot be indexed at all. The partial flag is set if the object is
+	// private and its encrypted values could not be decrypted
+	static bool computeKeys(OSObject* object, Decryptor* decryptor, std::set<IndexKey>& keys, bool& isPrivate, bool& partial);
+
+	// Remove the entries of an object from the buckets
+	void removeEntries(OSObject* object);
+
+	// The objects having a certain attribute value
+	std::map<IndexKey, std::set<OSObject*> > buckets;
+
+	// The keys under which each indexed object is filed
+	std::map<OSObject*, std::set<IndexKey> > entries;
+
+	// Indexed objects that are private
+	std::set<OSObject*> privateObjects;
+
+	// Private objects of which the encrypted values are not indexed
+	std::set<OSObject*> partialObjects;
+
+	// Objects of which the entries need to be (re)computed along with
+	// the change generation at which they were flagged
+	std::map<OSObject*, unsigned long> dirtyObjects;
+
+	// Change generation counter
+	unsigned long generation;
+
+	// For thread safeness
+	Mutex* indexMutex;
+};
+
+#endif // !_SOFTHSM_V2_ATTRIBUTEINDEX_H
+
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ ChangeJournal.cpp
+
+ An append-only journal of the object files that were created, modified or
+ deleted in a token directory
+ *****************************************************************************/
+
+#include "config.h"
+#include "log.h"
+#include "ChangeJournal.h"
+#include "File.h"
+#include "UUID.h"
+#include <string>
+#include <vector>
+
+// Constructor
+ChangeJournal::ChangeJournal(const std::string path, long maxSize /* = 262144 */)
+{
+	this->path = path;
+	this->maxSize = maxSize;
+	offset = 0;
+	journalMutex = MutexFactory::i()->getMutex();
+	valid = (journalMutex != NULL);
+
+	if (!valid) return;
+
+	File journalFile(path);
+
+	if (!journalFile.isValid())
+	{
+		// Create a new journal; if another instance does the same at the
+		// same time, one of the epochs wins and the other instance rescans
+		File newFile(path, true, true, true);
+
+		valid = newFile.isValid() &&
+		        newFile.lock() &&
+		        newFile.writeString(UUID::newUUID()) &&
+		        newFile.flush();
+
+		if (!valid)
+		{
+			ERROR_MSG("Failed to create journal %s", path.c_str());
+		}
+	}
+}
+
+// Destructor
+ChangeJournal::~ChangeJournal()
+{
+	MutexFactory::i()->recycleMutex(journalMutex);
+}
+
+// Check if the journal is usable
+bool ChangeJournal::isValid()
+{
+	return valid;
+}
+
+// Append a record to the journal
+bool ChangeJournal::append(unsigned long type, const std::string& filename)
+{
+	if (!valid) return false;
+
+	MutexLocker lock(journalMutex);
+
+	// Opening the file for writing takes an exclusive lock
+	File journalFile(path, true, true);
+
+	if (!journalFile.isValid() || !journalFile.lock())
+	{
+		ERROR_MSG("Failed to open journal %s for writing", path.c_str());
+
+		return false;
+	}
+
+	std::string fileEpoch;
+	long size;
+
+	// Start a new epoch if the journal is damaged or has grown too large
+	if (!journalFile.readString(fileEpoch) ||
+	    !journalFile.seek() ||
+	    !journalFile.tell(size) ||
+	    (size >= maxSize))
+	{
+		DEBUG_MSG("Starting a new epoch for journal %s", path.c_str());
+
+		if (!journalFile.truncate() ||
+		    !journalFile.writeString(UUID::newUUID()))
+		{
+			ERROR_MSG("Failed to reset journal %s", path.c_str());
+
+			return false;
+		}
+	}
+
+	// The record is written to disk in one go when the stream is flushed
+	if (!journalFile.writeULong(type) ||
+	    !journalFile.writeString(filename) ||
+	    !journalFile.flush())
+	{
+		ERROR_MSG("Failed to write to journal %s", path.c_str());
+
+		return false;
+	}
+
+	return true;
+}
+
+// Retrieve the records that were appended since the last call
+bool ChangeJournal::readChanges(std::vector<Change>& changes, bool& isReset)
+{
+	if (!valid) return false;
+
+	MutexLocker lock(journalMutex);
+
+	// Opening the file for reading takes a shared lock
+	File journalFile(path);
+
+	if (!journalFile.isValid() || !journalFile.lock())
+	{
+		return false;
+	}
+
+	std::string fileEpoch;
+
+	if (!journalFile.readString(fileEpoch))
+	{
+		return false;
+	}
+
+	// The records of a different epoch are of no use; continue from the
+	// end of the journal after the caller has rescanned the token
+	if (fileEpoch != epoch)
+	{
+		if (!journalFile.seek() || !journalFile.tell(offset))
+		{
+			return false;
+		}
+
+		epoch = fileEpoch;
+		isReset = true;
+
+		return true;
+	}
+
+	isReset = false;
+
+	if (!journalFile.seek(offset))
+	{
+		return false;
+	}
+
+	for (;;)
+	{
+		Change change;
+
+		if (!journalFile.readULong(change.type) ||
+		    !journalFile.readString(change.filename) ||
+		    !journalFile.tell(offset))
+		{
+			break;
+		}
+
+		changes.push_back(change);
+	}
+
+	return true;
+}
+
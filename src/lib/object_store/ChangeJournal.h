@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ ChangeJournal.h
+
+ An append-only journal of the object files that were created, modified or
+ deleted in a token directory. Every instance of SoftHSM that changes the
+ token appends a record to the journal; other instances only read the records
+ that were added since they last looked instead of re-listing the directory.
+
+ The journal starts with a random epoch identifier. When the journal grows
+ beyond its maximum size it is truncated and a new epoch is started; readers
+ that notice the new epoch (or cannot read the journal at all) are told to
+ fall back to a full rescan of the token directory.
+ *****************************************************************************/
+
+#ifndef _SOFTHSM_V2_CHANGEJOURNAL_H
+#define _SOFTHSM_V2_CHANGEJOURNAL_H
+
+#include "config.h"
+#include "MutexFactory.h"
+#include <string>
+#include <vector>
+
+class ChangeJournal
+{
+public:
+	// The types of changes that are recorded
+	enum ChangeType
+	{
+		OBJECT_CREATED = 1,
+		OBJECT_MODIFIED = 2,
+		OBJECT_DELETED = 3
+	};
+
+	// A single journal record
+	struct Change
+	{
+		unsigned long type;
+		std::string filename;
+	};
+
+	// Constructor; the journal file is created if it does not exist
+	ChangeJournal(const std::string path, long maxSize = 262144);
+
+	// Destructor
+	virtual ~ChangeJournal();
+
+	// Check if the journal is usable
+	bool isValid();
+
+	// Append a record to the journal
+	bool append(unsigned long type, const std::string& filename);
+
+	// Retrieve the records that were appended since the last call; isReset
+	// is set if the journal was started over (or is read for the first time),
+	// in which case the records are not returned and the caller must rescan
+	// the whole token
+	bool readChanges(std::vector<Change>& changes, bool& isReset);
+
+private:
+	// The path of the journal file
+	std::string path;
+
+	// The maximum size of the journal before it is started over
+	long maxSize;
+
+	// The epoch and offset up to which this instance has read the journal
+	std::string epoch;
+	long offset;
+
+	// Is the journal usable?
+	bool valid;
+
+	// For thread safeness
+	Mutex* journalMutex;
+};
+
+#endif // !_SOFTHSM_V2_CHANGEJOURNAL_H
+
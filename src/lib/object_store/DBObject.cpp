@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ DBObject.cpp
+
+ This class represents the objects of tokens that are stored in a single
+ database file
+ *****************************************************************************/
+
+#include "config.h"
+#include "DBObject.h"
+#include "DBToken.h"
+#include "log.h"
+
+// Attribute types
+#define BOOLEAN_ATTR			0x1
+#define ULONG_ATTR			0x2
+#define BYTESTR_ATTR			0x3
+
+// Constructor
+DBObject::DBObject(DBToken* parent, const std::string name)
+{
+	this->name = name;
+	token = parent;
+	objectMutex = MutexFactory::i()->getMutex();
+	valid = (objectMutex != NULL);
+	isDecoded = true;
+	isStale = false;
+	generation = 0;
+	inTransaction = false;
+	transactionDepth = 0;
+	transactionAborted = false;
+}
+
+// Destructor
+DBObject::~DBObject()
+{
+	{
+		MutexLocker lock(objectMutex);
+
+		discardAttributes();
+	}
+
+	MutexFactory::i()->recycleMutex(objectMutex);
+}
+
+// Check if the specified attribute exists
+bool DBObject::attributeExists(CK_ATTRIBUTE_TYPE type)
+{
+	refresh();
+
+	MutexLocker lock(objectMutex);
+
+	return valid && decode() && (attributes[type] != NULL);
+}
+
+// Retrieve the specified attribute
+OSAttribute* DBObject::getAttribute(CK_ATTRIBUTE_TYPE type)
+{
+	refresh();
+
+	MutexLocker lock(objectMutex);
+
+	if (!decode())
+	{
+		return NULL;
+	}
+
+	return attributes[type];
+}
+
+// Set the specified attribute
+bool DBObject::setAttribute(CK_ATTRIBUTE_TYPE type, const OSAttribute& attribute)
+{
+	refresh();
+
+	{
+		MutexLocker lock(objectMutex);
+
+		if (!valid || !decode())
+		{
+			DEBUG_MSG("Cannot update invalid object %s", name.c_str());
+
+			return false;
+		}
+
+		if (attributes[type] != NULL)
+		{
+			// Nothing needs to be written back if the value is unchanged
+			if (*attributes[type] == attribute)
+			{
+				return true;
+			}
+
+			delete attributes[type];
+
+			attributes[type] = NULL;
+		}
+
+		attributes[type] = new OSAttribute(attribute);
+		changedAttributes.insert(type);
+
+		generation++;
+	}
+
+	store();
+
+	return isValid();
+}
+
+// The validity state of the object
+bool DBObject::isValid()
+{
+	return valid;
+}
+
+// Retrieve the generation of the object
+unsigned long DBObject::getGeneration()
+{
+	refresh();
+
+	MutexLocker lock(objectMutex);
+
+	return generation;
+}
+
+// Invalidate the object
+void DBObject::invalidate()
+{
+	MutexLocker lock(objectMutex);
+
+	valid = false;
+
+	discardAttributes();
+}
+
+// Returns the name under which the object is stored in the database
+std::string DBObject::getName() const
+{
+	return name;
+}
+
+// Start an attribute set transaction
+bool DBObject::startTransaction()
+{
+	MutexLocker lock(objectMutex);
+
+	if (inTransaction)
+	{
+		transactionDepth++;
+
+		return true;
+	}
+
+	inTransaction = true;
+	transactionDepth = 1;
+	transactionAborted = false;
+
+	return true;
+}
+
+// Commit an attribute transaction
+bool DBObject::commitTransaction()
+{
+	{
+		MutexLocker lock(objectMutex);
+
+		if (!inTransaction)
+		{
+			return false;
+		}
+
+		// Nested transactions are committed by the outermost one
+		if (--transactionDepth > 0)
+		{
+			return true;
+		}
+	}
+
+	// Changes of an aborted nested transaction must not be written back
+	if (transactionAborted)
+	{
+		abortTransaction();
+
+		return false;
+	}
+
+	{
+		MutexLocker lock(objectMutex);
+
+		inTransaction = false;
+
+		// Pick up the changes that other instances made during the transaction
+		if (isStale)
+		{
+			merge();
+		}
+	}
+
+	store();
+
+	return isValid();
+}
+
+// Abort an attribute transaction
+bool DBObject::abortTransaction()
+{
+	{
+		MutexLocker lock(objectMutex);
+
+		if (!inTransaction)
+		{
+			return false;
+		}
+
+		// Nested transactions are aborted by the outermost one
+		if (transactionDepth > 1)
+		{
+			transactionDepth--;
+			transactionAborted = true;
+
+			return true;
+		}
+
+		inTransaction = false;
+		transactionDepth = 0;
+
+		// Go back to the version that was last written to the database
+		discardAttributes();
+		changedAttributes.clear();
+
+		isDecoded = false;
+		isStale = false;
+		generation++;
+	}
+
+	// Attributes set during the transaction may have been indexed
+	if (token != NULL)
+	{
+		token->objectChanged(this);
+	}
+
+	return true;
+}
+
+// Destroy the object; WARNING: pointers to the object become invalid after this call
+bool DBObject::destroyObject()
+{
+	if (token == NULL)
+	{
+		ERROR_MSG("Cannot destroy an object that is not associated with a token");
+
+		return false;
+	}
+
+	return token->deleteObject(this);
+}
+
+// Load the object from a serialised record
+bool DBObject::load(const ByteString& record)
+{
+	MutexLocker lock(objectMutex);
+
+	if (this->record == record)
+	{
+		return false;
+	}
+
+	this->record = record;
+
+	// Changes made during a transaction take precedence until it ends
+	if (inTransaction)
+	{
+		isStale = true;
+
+		return true;
+	}
+
+	merge();
+
+	return true;
+}
+
+// Rebuild the attributes from the record, keeping unwritten changes
+void DBObject::merge()
+{
+	std::map<CK_ATTRIBUTE_TYPE, OSAttribute*> unwritten;
+
+	for (std::set<CK_ATTRIBUTE_TYPE>::iterator i = changedAttributes.begin(); i != changedAttributes.end(); i++)
+	{
+		unwritten[*i] = attributes[*i];
+		attributes[*i] = NULL;
+	}
+
+	discardAttributes();
+
+	isDecoded = false;
+	isStale = false;
+	generation++;
+
+	if (unwritten.empty())
+	{
+		return;
+	}
+
+	// The record is decoded right away to put the changes on top of it
+	bool decoded = decode();
+
+	for (std::map<CK_ATTRIBUTE_TYPE, OSAttribute*>::iterator i = unwritten.begin(); i != unwritten.end(); i++)
+	{
+		if (!decoded)
+		{
+			delete i->second;
+
+			continue;
+		}
+
+		if (attributes[i->first] != NULL)
+		{
+			delete attributes[i->first];
+		}
+
+		attributes[i->first] = i->second;
+	}
+}
+
+// Retrieve the serialised record that was last written to the database
+ByteString DBObject::getRecord()
+{
+	MutexLocker lock(objectMutex);
+
+	return record;
+}
+
+// Serialise the attributes for writing them to the database
+bool DBObject::prepareRecord(ByteString& record)
+{
+	if (!valid)
+	{
+		DEBUG_MSG("Cannot write back an invalid object %s", name.c_str());
+
+		return false;
+	}
+
+	return serialise(record);
+}
+
+// Remember the serialised record that was written to the database
+void DBObject::recordWritten(const ByteString& record)
+{
+	this->record = record;
+
+	changedAttributes.clear();
+}
+
+// Refresh the object if necessary
+void DBObject::refresh()
+{
+	// Check if we're in the middle of a transaction
+	if (inTransaction)
+	{
+		return;
+	}
+
+	// Changes are picked up by the token; this may cause this instance to become invalid
+	if (token != NULL)
+	{
+		token->index();
+	}
+}
+
+// Write the object to the database
+void DBObject::store()
+{
+	{
+		MutexLocker lock(objectMutex);
+
+		// Check if we're in the middle of a transaction
+		if (inTransaction)
+		{
+			return;
+		}
+
+		if (!valid)
+		{
+			DEBUG_MSG("Cannot write back an invalid object %s", name.c_str());
+
+			return;
+		}
+	}
+
+	// The token serialises the object once it has caught up with the
+	// changes of other instances
+	if ((token != NULL) && !token->storeObject(this))
+	{
+		DEBUG_MSG("Failed to write object %s", name.c_str());
+
+		valid = false;
+	}
+}
+
+// Decode the serialised record
+bool DBObject::decode()
+{
+	if (isDecoded)
+	{
+		return true;
+	}
+
+	const unsigned char* data = record.const_byte_str();
+	size_t len = record.size();
+	size_t pos = 0;
+
+	while (pos < len)
+	{
+		if (len - pos < 16)
+		{
+			DEBUG_MSG("Corrupt record for object %s", name.c_str());
+
+			valid = false;
+
+			return false;
+		}
+
+		CK_ATTRIBUTE_TYPE p11AttrType = ByteString::decodeULong(data + pos);
+		unsigned long osAttrType = ByteString::decodeULong(data + pos + 8);
+		OSAttribute* attribute = NULL;
+
+		pos += 16;
+
+		if ((osAttrType == BOOLEAN_ATTR) && (len - pos >= 1))
+		{
+			attribute = new OSAttribute(data[pos] ? true : false);
+
+			pos += 1;
+		}
+		else if ((osAttrType == ULONG_ATTR) && (len - pos >= 8))
+		{
+			attribute = new OSAttribute(ByteString::decodeULong(data + pos));
+
+			pos += 8;
+		}
+		else if ((osAttrType == BYTESTR_ATTR) && (len - pos >= 8) &&
+			 (ByteString::decodeULong(data + pos) <= len - pos - 8))
+		{
+			size_t valueLen = ByteString::decodeULong(data + pos);
+
+			attribute = new OSAttribute(ByteString(data + pos + 8, valueLen));
+
+			pos += 8 + valueLen;
+		}
+		else
+		{
+			DEBUG_MSG("Corrupt record for object %s", name.c_str());
+
+			valid = false;
+
+			return false;
+		}
+
+		if (attributes[p11AttrType] != NULL)
+		{
+			delete attributes[p11AttrType];
+		}
+
+		attributes[p11AttrType] = attribute;
+	}
+
+	isDecoded = true;
+
+	return true;
+}
+
+// Serialise the attributes
+bool DBObject::serialise(ByteString& serialised)
+{
+	if (!decode())
+	{
+		return false;
+	}
+
+	for (std::map<CK_ATTRIBUTE_TYPE, OSAttribute*>::iterator i = attributes.begin(); i != attributes.end(); i++)
+	{
+		if (i->second == NULL)
+		{
+			continue;
+		}
+
+		serialised += ByteString((unsigned long) i->first);
+
+		if (i->second->isBooleanAttribute())
+		{
+			serialised += ByteString((unsigned long) BOOLEAN_ATTR);
+			serialised += (unsigned char) (i->second->getBooleanValue() ? 0xFF : 0x00);
+		}
+		else if (i->second->isUnsignedLongAttribute())
+		{
+			serialised += ByteString((unsigned long) ULONG_ATTR);
+			serialised += ByteString(i->second->getUnsignedLongValue());
+		}
+		else if (i->second->isByteStringAttribute())
+		{
+			serialised += ByteString((unsigned long) BYTESTR_ATTR);
+			serialised += i->second->getByteStringValue().serialise();
+		}
+		else
+		{
+			DEBUG_MSG("Unknown attribute type for object %s", name.c_str());
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Discard the decoded attributes
+void DBObject::discardAttributes()
+{
+	for (std::map<CK_ATTRIBUTE_TYPE, OSAttribute*>::iterator i = attributes.begin(); i != attributes.end(); i++)
+	{
+		if (i->second != NULL)
+		{
+			delete i->second;
+		}
+	}
+
+	attributes.clear();
+}
+
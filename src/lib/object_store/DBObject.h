@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ DBObject.h
+
+ This class represents the objects of tokens that are stored in a single
+ database file (see DBToken.h). The attributes of an object are kept in
+ serialised form as they were last written to the database and are only
+ decoded when they are first accessed.
+ *****************************************************************************/
+
+#ifndef _SOFTHSM_V2_DBOBJECT_H
+#define _SOFTHSM_V2_DBOBJECT_H
+
+#include "config.h"
+#include "ByteString.h"
+#include "OSAttribute.h"
+#include "MutexFactory.h"
+#include <string>
+#include <map>
+#include <set>
+#include "cryptoki.h"
+#include "OSObject.h"
+
+// DBToken forward declaration
+class DBToken;
+
+class DBObject : public OSObject
+{
+public:
+	// Constructor
+	DBObject(DBToken* parent, const std::string name);
+
+	// Destructor
+	virtual ~DBObject();
+
+	// Check if the specified attribute exists
+	virtual bool attributeExists(CK_ATTRIBUTE_TYPE type);
+
+	// Retrieve the specified attribute
+	virtual OSAttribute* getAttribute(CK_ATTRIBUTE_TYPE type);
+
+	// Set the specified attribute
+	virtual bool setAttribute(CK_ATTRIBUTE_TYPE type, const OSAttribute& attribute);
+
+	// The validity state of the object
+	virtual bool isValid();
+
+	// Retrieve the generation of the object
+	virtual unsigned long getGeneration();
+
+	// Invalidate the object; this method is normally only called by
+	// the DBToken class in case the object has been deleted.
+	void invalidate();
+
+	// Returns the name under which the object is stored in the database
+	std::string getName() const;
+
+	// Start an attribute set transaction; the changes are kept in memory
+	// and are written to the database in one go when the outermost
+	// transaction is committed. Changes that other instances made to the
+	// object in the meantime are merged at that point; attributes that
+	// were set during the transaction take precedence
+	virtual bool startTransaction();
+
+	// Commit an attribute transaction; returns false if no transaction is in progress
+	virtual bool commitTransaction();
+
+	// Abort an attribute transaction; restores the version of the object that
+	// was last written to the database; returns false if no transaction was in progress
+	virtual bool abortTransaction();
+
+	// Destroys the object; WARNING: pointers to the object become invalid after this
+	// call!
+	virtual bool destroyObject();
+
+private:
+	// DBToken instances can load and serialise objects
+	friend class DBToken;
+
+	// Load the object from a serialised record; returns false if the record is unchanged
+	bool load(const ByteString& record);
+
+	// Retrieve the serialised record that was last written to the database
+	ByteString getRecord();
+
+	// Serialise the attributes for writing them to the database; the
+	// object mutex must be held
+	bool prepareRecord(ByteString& record);
+
+	// Remember the serialised record that was written to the database; the
+	// object mutex must be held
+	void recordWritten(const ByteString& record);
+
+	// Rebuild the attributes from the record, keeping the attributes that
+	// were changed but not written yet; the object mutex must be held
+	void merge();
+
+	// Refresh the object if necessary
+	void refresh();
+
+	// Write the object to the database
+	void store();
+
+	// Decode the serialised record; the object mutex must be held
+	bool decode();
+
+	// Serialise the attributes; the object mutex must be held
+	bool serialise(ByteString& serialised);
+
+	// Discard the decoded attributes; the object mutex must be held
+	void discardAttributes();
+
+	// The name of the object in the database
+	std::string name;
+
+	// The object's decoded attributes
+	std::map<CK_ATTRIBUTE_TYPE, OSAttribute*> attributes;
+
+	// The serialised record and whether the attributes were decoded from it
+	ByteString record;
+	bool isDecoded;
+
+	// The attributes that were changed but not written to the database yet,
+	// and whether the record changed during a transaction
+	std::set<CK_ATTRIBUTE_TYPE> changedAttributes;
+	bool isStale;
+
+	// The object's validity state
+	bool valid;
+
+	// The generation of the object; incremented on every change
+	unsigned long generation;
+
+	// The token this object is associated with
+	DBToken* token;
+
+	// Mutex object for thread-safeness
+	Mutex* objectMutex;
+
+	// The transaction state
+	bool inTransaction;
+	unsigned long transactionDepth;
+	bool transactionAborted;
+};
+
+#endif // !_SOFTHSM_V2_DBOBJECT_H
+
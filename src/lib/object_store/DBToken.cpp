@@ -0,0 +1,1049 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ DBToken.cpp
+
+ A token that is stored in a single database file
+ *****************************************************************************/
+
+#include "config.h"
+#include "log.h"
+#include "OSAttributes.h"
+#include "OSAttribute.h"
+#include "DBToken.h"
+#include "DBObject.h"
+#include "Directory.h"
+#include "File.h"
+#include "UUID.h"
+#include "OSPathSep.h"
+#include "Configuration.h"
+#include <vector>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// The database file in the token directory
+#define DB_FILENAME			"token.db"
+
+// The name of the token object in the database
+#define DB_TOKENOBJECT			"tokenObject"
+
+// The database header consists of the magic, the format version and the epoch
+static const unsigned char DB_MAGIC[8] = { 'S', 'H', 'S', 'M', '-', 'T', 'D', 'B' };
+#define DB_VERSION			0x1
+#define DB_HEADER_LEN			24
+
+// Record types
+#define PUT_RECORD			0x1
+#define DELETE_RECORD			0x2
+
+// Compact the database once it holds this many more records than objects
+#define DB_COMPACT_THRESHOLD		1024
+
+// Checksum over the body of a record (32-bit FNV-1a)
+static unsigned long checksum(const unsigned char* data, size_t len)
+{
+	unsigned long rv = 0x811c9dc5UL;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		rv ^= data[i];
+		rv = (rv * 0x01000193UL) & 0xffffffffUL;
+	}
+
+	return rv;
+}
+
+// Construct the header of a database with the specified epoch
+static ByteString encodeHeader(const std::string& epoch)
+{
+	ByteString header(DB_MAGIC, sizeof(DB_MAGIC));
+
+	header += ByteString((unsigned long) DB_VERSION);
+	header += ByteString((unsigned long) epoch.size());
+	header += ByteString((const unsigned char*) epoch.c_str(), epoch.size());
+
+	return header;
+}
+
+// Construct a record; this consists of the length of the body, the body
+// itself and a checksum over the body
+static ByteString encodeRecord(unsigned long type, const std::string& name, const ByteString& record)
+{
+	ByteString body((unsigned long) type);
+
+	body += ByteString((const unsigned char*) name.c_str(), name.size()).serialise();
+	body += record;
+
+	ByteString encoded((unsigned long) body.size());
+
+	encoded += body;
+	encoded += ByteString(checksum(body.const_byte_str(), body.size()));
+
+	return encoded;
+}
+
+// Constructor
+DBToken::DBToken(const std::string tokenPath)
+{
+	this->tokenPath = tokenPath;
+	dbPath = tokenPath + OS_PATHSEP + DB_FILENAME;
+	offset = 0;
+	recordCount = 0;
+	attributeIndex = new AttributeIndex();
+	tokenObject = new DBObject(this, DB_TOKENOBJECT);
+	sync = IPCSignal::create(tokenPath);
+	tokenMutex = MutexFactory::i()->getMutex();
+	syncOnStore = Configuration::i()->getBool("objectstore.fsync", false);
+	valid = (sync != NULL) && (tokenMutex != NULL);
+
+	DEBUG_MSG("Opened token %s", tokenPath.c_str());
+
+	// The token object must be present in the database
+	valid = valid && index(true) && (tokenObject->getRecord().size() > 0);
+}
+
+// Create a new token
+/*static*/ DBToken* DBToken::createToken(const std::string basePath, const std::string tokenDir, const ByteString& label, const ByteString& serial)
+{
+	Directory baseDir(basePath);
+
+	if (!baseDir.isValid())
+	{
+		return NULL;
+	}
+
+	// Create the token directory
+	if (!baseDir.mkdir(tokenDir))
+	{
+		return NULL;
+	}
+
+	// Set the initial attributes
+	CK_ULONG flags = 
+		CKF_RNG |
+		CKF_LOGIN_REQUIRED | // FIXME: check
+		CKF_RESTORE_KEY_NOT_NEEDED |
+		CKF_TOKEN_INITIALIZED |
+		CKF_SO_PIN_LOCKED |
+		CKF_SO_PIN_TO_BE_CHANGED;
+
+	OSAttribute tokenLabel(label);
+	OSAttribute tokenSerial(serial);
+	OSAttribute tokenFlags(flags);
+
+	DBObject tokenObject(NULL, DB_TOKENOBJECT);
+	ByteString record;
+
+	tokenObject.setAttribute(CKA_OS_TOKENLABEL, tokenLabel);
+	tokenObject.setAttribute(CKA_OS_TOKENSERIAL, tokenSerial);
+	tokenObject.setAttribute(CKA_OS_TOKENFLAGS, tokenFlags);
+
+	{
+		MutexLocker lock(tokenObject.objectMutex);
+
+		tokenObject.serialise(record);
+	}
+
+	// Write the database with the token object as its first record
+	ByteString database = encodeHeader(UUID::newUUID()) + encodeRecord(PUT_RECORD, DB_TOKENOBJECT, record);
+
+	if (!File::writeAtomically(basePath + OS_PATHSEP + tokenDir + OS_PATHSEP + DB_FILENAME, database, Configuration::i()->getBool("objectstore.fsync", false)))
+	{
+		baseDir.remove(tokenDir);
+
+		return NULL;
+	}
+
+	DEBUG_MSG("Created new token database %s", tokenDir.c_str());
+
+	return new DBToken(basePath + OS_PATHSEP + tokenDir);
+}
+
+// Check if the specified token directory contains a token database
+/*static*/ bool DBToken::isDBToken(const std::string tokenPath)
+{
+	struct stat dbStat;
+
+	return !stat((tokenPath + OS_PATHSEP + DB_FILENAME).c_str(), &dbStat);
+}
+
+// Destructor
+DBToken::~DBToken()
+{
+	// Clean up
+	std::set<DBObject*> cleanUp = allObjects;
+	allObjects.clear();
+
+	for (std::set<DBObject*>::iterator i = cleanUp.begin(); i != cleanUp.end(); i++)
+	{
+		delete *i;
+	}
+
+	if (sync != NULL) delete sync;
+	MutexFactory::i()->recycleMutex(tokenMutex);
+	delete tokenObject;
+	delete attributeIndex;
+}
+
+// Set the SO PIN
+bool DBToken::setSOPIN(const ByteString& soPINBlob)
+{
+	if (!valid) return false;
+
+	OSAttribute soPIN(soPINBlob);
+
+	CK_ULONG flags;
+
+	if (tokenObject->setAttribute(CKA_OS_SOPIN, soPIN) &&
+	    getTokenFlags(flags))
+	{
+		flags &= ~CKF_SO_PIN_COUNT_LOW;
+		flags &= ~CKF_SO_PIN_FINAL_TRY;
+		flags &= ~CKF_SO_PIN_LOCKED;
+		flags &= ~CKF_SO_PIN_TO_BE_CHANGED;
+
+		return setTokenFlags(flags);
+	}
+
+	return false;
+}
+
+// Get the SO PIN
+bool DBToken::getSOPIN(ByteString& soPINBlob)
+{
+	if (!valid || !tokenObject->isValid())
+	{
+		return false;
+	}
+
+	OSAttribute* soPIN = tokenObject->getAttribute(CKA_OS_SOPIN);
+
+	if (soPIN != NULL)
+	{
+		soPINBlob = soPIN->getByteStringValue();
+
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+// Set the user PIN
+bool DBToken::setUserPIN(ByteString userPINBlob)
+{
+	if (!valid) return false;
+
+	OSAttribute userPIN(userPINBlob);
+
+	CK_ULONG flags;
+
+	if (tokenObject->setAttribute(CKA_OS_USERPIN, userPIN) &&
+	    getTokenFlags(flags))
+	{
+		flags |= CKF_USER_PIN_INITIALIZED;
+		flags &= ~CKF_USER_PIN_COUNT_LOW;
+		flags &= ~CKF_USER_PIN_FINAL_TRY;
+		flags &= ~CKF_USER_PIN_LOCKED;
+		flags &= ~CKF_USER_PIN_TO_BE_CHANGED;
+
+		return setTokenFlags(flags);
+	}
+
+	return false;
+}
+
+// Get the user PIN
+bool DBToken::getUserPIN(ByteString& userPINBlob)
+{
+	if (!valid || !tokenObject->isValid())
+	{
+		return false;
+	}
+
+	OSAttribute* userPIN = tokenObject->getAttribute(CKA_OS_USERPIN);
+
+	if (userPIN != NULL)
+	{
+		userPINBlob = userPIN->getByteStringValue();
+
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+// Retrieve the token label
+bool DBToken::getTokenLabel(ByteString& label)
+{
+	if (!valid || !tokenObject->isValid())
+	{
+		return false;
+	}
+
+	OSAttribute* tokenLabel = tokenObject->getAttribute(CKA_OS_TOKENLABEL);
+
+	if (tokenLabel != NULL)
+	{
+		label = tokenLabel->getByteStringValue();
+
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+// Retrieve the token serial
+bool DBToken::getTokenSerial(ByteString& serial)
+{
+	if (!valid || !tokenObject->isValid())
+	{
+		return false;
+	}
+
+	OSAttribute* tokenSerial = tokenObject->getAttribute(CKA_OS_TOKENSERIAL);
+
+	if (tokenSerial != NULL)
+	{
+		serial = tokenSerial->getByteStringValue();
+
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+// Get the token flags
+bool DBToken::getTokenFlags(CK_ULONG& flags)
+{
+	if (!valid || !tokenObject->isValid())
+	{
+		return false;
+	}
+
+	OSAttribute* tokenFlags = tokenObject->getAttribute(CKA_OS_TOKENFLAGS);
+
+	if (tokenFlags != NULL)
+	{
+		flags = tokenFlags->getUnsignedLongValue();
+
+		// Check if the user PIN is initialised
+		if (tokenObject->attributeExists(CKA_OS_USERPIN))
+		{
+			flags |= CKF_USER_PIN_INITIALIZED;
+		}
+
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+// Set the token flags
+bool DBToken::setTokenFlags(const CK_ULONG flags)
+{
+	if (!valid) return false;
+
+	OSAttribute tokenFlags(flags);
+
+	return tokenObject->setAttribute(CKA_OS_TOKENFLAGS, tokenFlags);
+}
+
+// Get the scheme used to encrypt sensitive attributes
+bool DBToken::getEncryptionScheme(CK_ULONG& scheme)
+{
+	if (!valid || !tokenObject->isValid())
+	{
+		return false;
+	}
+
+	OSAttribute* encryption = tokenObject->getAttribute(CKA_OS_ENCRYPTION);
+
+	// Tokens created before the scheme was recorded use the first scheme
+	scheme = (encryption != NULL) ? encryption->getUnsignedLongValue() : 0;
+
+	return true;
+}
+
+// Set the scheme used to encrypt sensitive attributes
+bool DBToken::setEncryptionScheme(const CK_ULONG scheme)
+{
+	if (!valid) return false;
+
+	OSAttribute encryption(scheme);
+
+	return tokenObject->setAttribute(CKA_OS_ENCRYPTION, encryption);
+}
+
+// Insert objects into the given set
+void DBToken::getObjects(std::set<OSObject*> &objects)
+{
+	index();
+
+	// Make sure that no other thread is in the process of changing
+	// the object list when we return it
+	MutexLocker lock(tokenMutex);
+
+	objects.insert(this->objects.begin(), this->objects.end());
+}
+
+// Insert the objects that may match the template into the given set
+bool DBToken::findObjects(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, AttributeIndex::Decryptor* decryptor, std::set<OSObject*> &objects)
+{
+	if (!AttributeIndex::isIndexable(pTemplate, ulCount))
+	{
+		return false;
+	}
+
+	// Indexing the token flags the objects that other instances changed
+	index();
+
+	std::set<OSObject*> candidates;
+
+	if (!attributeIndex->findCandidates(pTemplate, ulCount, decryptor, candidates))
+	{
+		return false;
+	}
+
+	MutexLocker lock(tokenMutex);
+
+	for (std::set<OSObject*>::iterator i = candidates.begin(); i != candidates.end(); i++)
+	{
+		// The index only contains objects of this token
+		if (this->objects.find((DBObject*) *i) != this->objects.end())
+		{
+			objects.insert(*i);
+		}
+	}
+
+	return true;
+}
+
+// Discard the attribute index entries derived from private attribute values
+void DBToken::discardPrivateIndex()
+{
+	attributeIndex->discardPrivate();
+}
+
+// Create a new object
+DBObject* DBToken::createObject()
+{
+	if (!valid) return NULL;
+
+	std::string name = UUID::newUUID();
+
+	DBObject* newObject = new DBObject(this, name);
+
+	{
+		MutexLocker lock(tokenMutex);
+
+		objects.insert(newObject);
+		allObjects.insert(newObject);
+		currentObjects[name] = newObject;
+	}
+
+	// Write the empty object so other instances know about it
+	if (!storeObject(newObject))
+	{
+		ERROR_MSG("Failed to create new object %s", name.c_str());
+
+		MutexLocker lock(tokenMutex);
+
+		removeObject(name);
+
+		return NULL;
+	}
+
+	DEBUG_MSG("(0x%08X) Created new object %s (0x%08X)", this, name.c_str(), newObject);
+
+	return newObject;
+}
+
+// Delete an object
+bool DBToken::deleteObject(OSObject* osobject)
+{
+	if (!valid) return false;
+
+	// Only objects of this token can be deleted
+	DBObject* object = (DBObject*) osobject;
+
+	MutexLocker lock(tokenMutex);
+
+	if (objects.find(object) == objects.end())
+	{
+		ERROR_MSG("Cannot delete non-existent object 0x%08X", object);
+
+		return false;
+	}
+
+	std::string name = object->getName();
+
+	int fd = openDatabase(true);
+
+	if (fd == -1)
+	{
+		return false;
+	}
+
+	off_t fileSize;
+
+	if (!readRecords(fd, NULL, fileSize) || !appendRecord(fd, fileSize, DELETE_RECORD, name, ByteString()))
+	{
+		ERROR_MSG("Failed to delete object %s", name.c_str());
+
+		close(fd);
+
+		return false;
+	}
+
+	removeObject(name);
+
+	compact();
+
+	close(fd);
+
+	DEBUG_MSG("Deleted object %s", name.c_str());
+
+	sync->trigger();
+
+	return true;
+}
+
+// Checks if the token is consistent
+bool DBToken::isValid()
+{
+	return valid;
+}
+
+// Invalidate the token (for instance if it is deleted)
+void DBToken::invalidate()
+{
+	valid = false;
+}
+
+// Return the path of the token
+std::string DBToken::getTokenPath()
+{
+	return tokenPath;
+}
+
+// Delete the token
+bool DBToken::clearToken()
+{
+	MutexLocker lock(tokenMutex);
+
+	// Invalidate the token
+	invalidate();
+
+	// First, clear out all objects
+	objects.clear();
+	currentObjects.clear();
+	attributeIndex->clear();
+
+	// Now, delete all files in the token directory
+	Directory tokenDir(tokenPath);
+
+	if (!tokenDir.isValid())
+	{
+		return false;
+	}
+
+	std::vector<std::string> tokenFiles = tokenDir.getFiles();
+
+	for (std::vector<std::string>::iterator i = tokenFiles.begin(); i != tokenFiles.end(); i++)
+	{
+		if (!tokenDir.remove(*i))
+		{
+			ERROR_MSG("Failed to remove %s from token directory %s", i->c_str(), tokenPath.c_str());
+
+			return false;
+		}
+	}
+
+	// Now remove the token directory
+	if (remove(tokenPath.c_str()))
+	{
+		ERROR_MSG("Failed to remove the token directory %s", tokenPath.c_str());
+
+		return false;
+	}
+
+	DEBUG_MSG("Token instance %s was succesfully cleared", tokenPath.c_str());
+
+	return true;
+}
+
+// Read the changes that other instances made to the database
+bool DBToken::index(bool isFirstTime /* = false */)
+{
+	// Check if re-indexing is required
+	if (!isFirstTime && (!valid || !sync->wasTriggered()))
+	{
+		return true;
+	}
+
+	MutexLocker lock(tokenMutex);
+
+	int fd = openDatabase(false);
+
+	if (fd == -1)
+	{
+		valid = false;
+
+		return false;
+	}
+
+	off_t fileSize;
+
+	if (!readRecords(fd, NULL, fileSize))
+	{
+		valid = false;
+	}
+
+	close(fd);
+
+	DEBUG_MSG("The token now contains %d objects", objects.size());
+
+	return valid;
+}
+
+// Write the attributes of an object to the database
+bool DBToken::storeObject(DBObject* object)
+{
+	MutexLocker lock(tokenMutex);
+
+	if (!valid) return false;
+
+	int fd = openDatabase(true);
+
+	if (fd == -1)
+	{
+		return false;
+	}
+
+	off_t fileSize;
+
+	// Catch up with other instances first; this merges their changes to
+	// the object, which may also have been deleted
+	bool rv = readRecords(fd, object, fileSize) &&
+		  ((object == tokenObject) || (currentObjects.find(object->getName()) != currentObjects.end()));
+
+	if (rv)
+	{
+		// The object stays locked until its record has been written, so
+		// that changes made in the meantime are not taken as written
+		MutexLocker objectLock(object->objectMutex);
+		ByteString record;
+
+		rv = object->prepareRecord(record) &&
+		     appendRecord(fd, fileSize, PUT_RECORD, object->getName(), record);
+
+		if (rv)
+		{
+			object->recordWritten(record);
+		}
+	}
+
+	if (rv)
+	{
+		if (object != tokenObject)
+		{
+			attributeIndex->objectChanged(object);
+		}
+
+		compact();
+	}
+
+	close(fd);
+
+	if (rv)
+	{
+		sync->trigger();
+	}
+
+	return rv;
+}
+
+// Called by an object when its attributes have changed in memory
+void DBToken::objectChanged(DBObject* object)
+{
+	// The token object is not part of the index
+	if (object == tokenObject)
+	{
+		return;
+	}
+
+	attributeIndex->objectChanged(object);
+}
+
+// Open and lock the database file
+int DBToken::openDatabase(bool forWrite)
+{
+	for (;;)
+	{
+		int fd = open(dbPath.c_str(), forWrite ? O_RDWR : O_RDONLY);
+
+		if (fd == -1)
+		{
+			ERROR_MSG("Could not open token database %s: %s", dbPath.c_str(), strerror(errno));
+
+			return -1;
+		}
+
+		struct flock fl;
+		fl.l_type = forWrite ? F_WRLCK : F_RDLCK;
+		fl.l_whence = SEEK_SET;
+		fl.l_start = 0;
+		fl.l_len = 0;
+		fl.l_pid = 0;
+
+		if (fcntl(fd, F_SETLKW, &fl) != 0)
+		{
+			ERROR_MSG("Could not lock token database %s: %s", dbPath.c_str(), strerror(errno));
+
+			close(fd);
+
+			return -1;
+		}
+
+		// The database may have been compacted while waiting for the lock,
+		// in which case the new file needs to be opened instead
+		struct stat fdStat;
+		struct stat pathStat;
+
+		if (fstat(fd, &fdStat) || stat(dbPath.c_str(), &pathStat))
+		{
+			close(fd);
+
+			return -1;
+		}
+
+		if ((fdStat.st_dev == pathStat.st_dev) && (fdStat.st_ino == pathStat.st_ino))
+		{
+			return fd;
+		}
+
+		close(fd);
+	}
+}
+
+// Apply the records that were added since the last time the database was read
+bool DBToken::readRecords(int fd, DBObject* keep, off_t& fileSize)
+{
+	struct stat dbStat;
+
+	if (fstat(fd, &dbStat))
+	{
+		return false;
+	}
+
+	fileSize = dbStat.st_size;
+
+	// Check the header
+	unsigned char header[DB_HEADER_LEN];
+
+	if ((pread(fd, header, DB_HEADER_LEN, 0) != DB_HEADER_LEN) ||
+	    memcmp(header, DB_MAGIC, sizeof(DB_MAGIC)) ||
+	    (ByteString::decodeULong(header + 8) != DB_VERSION))
+	{
+		ERROR_MSG("Token database %s is corrupt or has an unsupported version", dbPath.c_str());
+
+		return false;
+	}
+
+	unsigned long epochLen = ByteString::decodeULong(header + 16);
+
+	if (epochLen > (unsigned long) (fileSize - DB_HEADER_LEN))
+	{
+		return false;
+	}
+
+	std::string dbEpoch;
+
+	dbEpoch.resize(epochLen);
+
+	if ((epochLen > 0) && (pread(fd, &dbEpoch[0], epochLen, DB_HEADER_LEN) != (ssize_t) epochLen))
+	{
+		return false;
+	}
+
+	// The whole database is read again if it was compacted in the meantime
+	bool isReset = (dbEpoch != epoch);
+
+	if (isReset)
+	{
+		DEBUG_MSG("Reading token database %s", dbPath.c_str());
+
+		epoch = dbEpoch;
+		offset = DB_HEADER_LEN + epochLen;
+		recordCount = 0;
+	}
+
+	// Read all new records in one go
+	std::vector<unsigned char> records;
+
+	if (fileSize > offset)
+	{
+		records.resize(fileSize - offset);
+
+		size_t done = 0;
+
+		while (done < records.size())
+		{
+			ssize_t rv = pread(fd, &records[done], records.size() - done, offset + done);
+
+			if (rv <= 0)
+			{
+				if ((rv == -1) && (errno == EINTR)) continue;
+
+				return false;
+			}
+
+			done += rv;
+		}
+	}
+
+	std::set<std::string> seen;
+	const unsigned char* data = records.empty() ? NULL : &records[0];
+	size_t len = records.size();
+	size_t pos = 0;
+
+	// An incomplete record at the end is left for the writer to discard
+	while (len - pos >= 16)
+	{
+		unsigned long bodyLen = ByteString::decodeULong(data + pos);
+
+		if ((bodyLen < 16) || (bodyLen > len - pos - 16))
+		{
+			break;
+		}
+
+		const unsigned char* body = data + pos + 8;
+
+		if (ByteString::decodeULong(body + bodyLen) != checksum(body, bodyLen))
+		{
+			DEBUG_MSG("Discarding a damaged record in token database %s", dbPath.c_str());
+
+			break;
+		}
+
+		unsigned long type = ByteString::decodeULong(body);
+		unsigned long nameLen = ByteString::decodeULong(body + 8);
+
+		if (nameLen > bodyLen - 16)
+		{
+			break;
+		}
+
+		std::string name((const char*) body + 16, nameLen);
+		ByteString record(body + 16 + nameLen, bodyLen - 16 - nameLen);
+
+		if (type == PUT_RECORD)
+		{
+			seen.insert(name);
+
+			putObject(name, record);
+		}
+		else if (type == DELETE_RECORD)
+		{
+			seen.erase(name);
+
+			removeObject(name);
+		}
+		else
+		{
+			DEBUG_MSG("Ignored unknown record for %s", name.c_str());
+		}
+
+		pos += bodyLen + 16;
+		recordCount++;
+	}
+
+	offset += pos;
+
+	// After a reset, objects that are no longer in the database were removed
+	if (isReset)
+	{
+		std::set<std::string> removed;
+
+		for (std::map<std::string, DBObject*>::iterator i = currentObjects.begin(); i != currentObjects.end(); i++)
+		{
+			if ((seen.find(i->first) == seen.end()) && (i->second != keep))
+			{
+				removed.insert(i->first);
+			}
+		}
+
+		for (std::set<std::string>::iterator i = removed.begin(); i != removed.end(); i++)
+		{
+			removeObject(*i);
+		}
+	}
+
+	return true;
+}
+
+// Append a record to the database
+bool DBToken::appendRecord(int fd, off_t fileSize, unsigned long type, const std::string& name, const ByteString& record)
+{
+	// Discard an incomplete record left behind by an instance that died
+	if ((fileSize > offset) && ftruncate(fd, offset))
+	{
+		ERROR_MSG("Could not truncate token database %s: %s", dbPath.c_str(), strerror(errno));
+
+		return false;
+	}
+
+	ByteString encoded = encodeRecord(type, name, record);
+	size_t done = 0;
+
+	while (done < encoded.size())
+	{
+		ssize_t rv = pwrite(fd, encoded.const_byte_str() + done, encoded.size() - done, offset + done);
+
+		if (rv == -1)
+		{
+			if (errno == EINTR) continue;
+
+			ERROR_MSG("Could not write to token database %s: %s", dbPath.c_str(), strerror(errno));
+
+			return false;
+		}
+
+		done += rv;
+	}
+
+	if (syncOnStore && fsync(fd))
+	{
+		ERROR_MSG("Could not synchronise token database %s: %s", dbPath.c_str(), strerror(errno));
+
+		return false;
+	}
+
+	offset += encoded.size();
+	recordCount++;
+
+	return true;
+}
+
+// Compact the database if it contains many outdated records
+void DBToken::compact()
+{
+	if ((recordCount < DB_COMPACT_THRESHOLD) || (recordCount < 2 * (currentObjects.size() + 1)))
+	{
+		return;
+	}
+
+	DEBUG_MSG("Compacting token database %s", dbPath.c_str());
+
+	std::string newEpoch = UUID::newUUID();
+	ByteString database = encodeHeader(newEpoch);
+
+	database += encodeRecord(PUT_RECORD, DB_TOKENOBJECT, tokenObject->getRecord());
+
+	for (std::map<std::string, DBObject*>::iterator i = currentObjects.begin(); i != currentObjects.end(); i++)
+	{
+		database += encodeRecord(PUT_RECORD, i->first, i->second->getRecord());
+	}
+
+	// The old database remains in use if this fails
+	if (!File::writeAtomically(dbPath, database, syncOnStore))
+	{
+		return;
+	}
+
+	epoch = newEpoch;
+	offset = database.size();
+	recordCount = currentObjects.size() + 1;
+}
+
+// Add or update an object
+void DBToken::putObject(const std::string& name, const ByteString& record)
+{
+	if (name == DB_TOKENOBJECT)
+	{
+		tokenObject->load(record);
+
+		return;
+	}
+
+	std::map<std::string, DBObject*>::iterator i = currentObjects.find(name);
+
+	if (i != currentObjects.end())
+	{
+		if (i->second->load(record))
+		{
+			attributeIndex->objectChanged(i->second);
+		}
+
+		return;
+	}
+
+	DBObject* newObject = new DBObject(this, name);
+
+	newObject->load(record);
+
+	objects.insert(newObject);
+	allObjects.insert(newObject);
+	currentObjects[name] = newObject;
+
+	attributeIndex->objectChanged(newObject);
+}
+
+// Remove an object
+void DBToken::removeObject(const std::string& name)
+{
+	std::map<std::string, DBObject*>::iterator i = currentObjects.find(name);
+
+	if (i == currentObjects.end())
+	{
+		return;
+	}
+
+	DEBUG_MSG("Object %s (0x%08X) removed", name.c_str(), i->second);
+
+	i->second->invalidate();
+
+	objects.erase(i->second);
+	attributeIndex->objectRemoved(i->second);
+
+	currentObjects.erase(i);
+}
+
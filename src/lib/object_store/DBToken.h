@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ DBToken.h
+
+ A token that is stored in a single database file instead of a directory
+ with a file per object. This avoids opening and locking a file for every
+ object when a token with many objects is loaded.
+
+ The database file starts with a header containing an epoch identifier and
+ is followed by a log of records; each record either stores the serialised
+ attributes of an object or deletes an object. Records are only ever
+ appended, which makes them the journal of the database: a record that was
+ not completely written when the process died fails its checksum and is
+ discarded. When the log has grown to well beyond the number of live
+ objects it is compacted into a new database file with a new epoch that is
+ renamed into place. Other instances read the records that were appended
+ since they last looked and reload the whole database if the epoch changed.
+ *****************************************************************************/
+
+#ifndef _SOFTHSM_V2_DBTOKEN_H
+#define _SOFTHSM_V2_DBTOKEN_H
+
+#include "config.h"
+#include "ObjectStoreToken.h"
+#include "DBObject.h"
+#include "AttributeIndex.h"
+#include "IPCSignal.h"
+#include "MutexFactory.h"
+#include "cryptoki.h"
+#include <string>
+#include <set>
+#include <map>
+#include <sys/types.h>
+
+class DBToken : public ObjectStoreToken
+{
+public:
+	// Constructor
+	DBToken(const std::string tokenPath);
+
+	// Create a new token
+	static DBToken* createToken(const std::string basePath, const std::string tokenDir, const ByteString& label, const ByteString& serial);
+
+	// Check if the specified token directory contains a token database
+	static bool isDBToken(const std::string tokenPath);
+
+	// Set the SO PIN
+	virtual bool setSOPIN(const ByteString& soPINBlob);
+
+	// Get the SO PIN
+	virtual bool getSOPIN(ByteString& soPINBlob);
+
+	// Set the user PIN
+	virtual bool setUserPIN(ByteString userPINBlob);
+
+	// Get the user PIN
+	virtual bool getUserPIN(ByteString& userPINBlob);
+
+	// Get the token flags
+	virtual bool getTokenFlags(CK_ULONG& flags);
+
+	// Set the token flags
+	virtual bool setTokenFlags(const CK_ULONG flags);
+
+	// Get the scheme used to encrypt sensitive attributes
+	virtual bool getEncryptionScheme(CK_ULONG& scheme);
+
+	// Set the scheme used to encrypt sensitive attributes
+	virtual bool setEncryptionScheme(const CK_ULONG scheme);
+
+	// Retrieve the token label
+	virtual bool getTokenLabel(ByteString& label);
+
+	// Retrieve the token serial
+	virtual bool getTokenSerial(ByteString& serial);
+
+	// Insert objects into the given set
+	virtual void getObjects(std::set<OSObject*> &objects);
+
+	// Insert the objects that may match the template into the given set
+	virtual bool findObjects(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, AttributeIndex::Decryptor* decryptor, std::set<OSObject*> &objects);
+
+	// Discard the attribute index entries derived from private attribute values
+	virtual void discardPrivateIndex();
+
+	// Create a new object
+	virtual DBObject* createObject();
+
+	// Delete an object
+	virtual bool deleteObject(OSObject* object);
+
+	// Destructor
+	virtual ~DBToken();
+
+	// Checks if the token is consistent
+	virtual bool isValid();
+
+	// Invalidate the token (for instance if it is deleted)
+	virtual void invalidate();
+
+	// Delete the token
+	virtual bool clearToken();
+
+	// Return the path of the token
+	virtual std::string getTokenPath();
+
+private:
+	// DBObject instances can read and write the database
+	friend class DBObject;
+
+	// Read the changes that other instances made to the database
+	bool index(bool isFirstTime = false);
+
+	// Write the attributes of an object to the database; changes that
+	// other instances made to the object are merged first
+	bool storeObject(DBObject* object);
+
+	// Called by an object when its attributes have changed in memory
+	void objectChanged(DBObject* object);
+
+	// Open and lock the database file; returns -1 on failure
+	int openDatabase(bool forWrite);
+
+	// Apply the records that were added since the last time the database
+	// was read; the specified object is kept even if a compacted database
+	// no longer contains it, since it is about to be written. tokenMutex
+	// must be held
+	bool readRecords(int fd, DBObject* keep, off_t& fileSize);
+
+	// Append a record to the database, discarding any incomplete record
+	// at the end of the file; tokenMutex must be held
+	bool appendRecord(int fd, off_t fileSize, unsigned long type, const std::string& name, const ByteString& record);
+
+	// Compact the database if it contains many outdated records; tokenMutex
+	// and the write lock on the database must be held
+	void compact();
+
+	// Add, update or remove an object; tokenMutex must be held
+	void putObject(const std::string& name, const ByteString& record);
+	void removeObject(const std::string& name);
+
+	// Is the token consistent and valid?
+	bool valid;
+
+	// The token path and the path to the database file
+	std::string tokenPath;
+	std::string dbPath;
+
+	// The epoch of the database and the offset up to which it was read
+	std::string epoch;
+	off_t offset;
+
+	// The number of records since the start of the epoch
+	unsigned long recordCount;
+
+	// The current objects of the token
+	std::set<DBObject*> objects;
+
+	// All the objects ever associated with this token; see OSToken.h
+	std::set<DBObject*> allObjects;
+
+	// The current objects by name
+	std::map<std::string, DBObject*> currentObjects;
+
+	// The token object
+	DBObject* tokenObject;
+
+	// Inter-process synchronisation
+	IPCSignal* sync;
+
+	// The attribute index on the objects of this token
+	AttributeIndex* attributeIndex;
+
+	// Should the database be synchronised to disk on every change?
+	bool syncOnStore;
+
+	// For thread safeness
+	Mutex* tokenMutex;
+};
+
+#endif // !_SOFTHSM_V2_DBTOKEN_H
+
@@ -33,12 +33,15 @@
 #include "config.h"
 #include "File.h"
 #include "log.h"
+#include "OSPathSep.h"
 #include <string>
 #include <stdio.h>
 #include <string.h>
 #include <sys/file.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sstream>
 
 // Constructor
 //
@@ -110,7 +113,7 @@ bool File::readULong(unsigned long& value)
 {
 	if (!valid) return false;
 
-	ByteString ulongVal;
+	ByteString ulongVal(ByteString::Public);
 
 	ulongVal.resize(8);
 
@@ -279,6 +282,33 @@ bool File::seek(long offset /* = -1 */)
 	}
 }
 
+// Retrieve the current position relative to the start of the file
+bool File::tell(long& offset)
+{
+	if (!valid) return false;
+
+	offset = ftell(stream);
+
+	return (offset != -1);
+}
+
+// Truncate the file to zero length and rewind it
+bool File::truncate()
+{
+	if (!valid || !isWritable) return false;
+
+	if (fflush(stream) || ftruncate(fileno(stream), 0))
+	{
+		ERROR_MSG("Could not truncate the file: %s", strerror(errno));
+
+		return false;
+	}
+
+	::rewind(stream);
+
+	return true;
+}
+
 // Lock the file
 bool File::lock(bool block /* = true */)
 {
@@ -333,3 +363,85 @@ bool File::flush()
 	return valid && !fflush(stream);
 }
 
+// Replace the contents of the file at the specified path in one go
+bool File::writeAtomically(const std::string& path, const ByteString& data, bool sync /* = false */)
+{
+	// The temporary file is specific to this process so concurrent writers
+	// in other processes cannot interfere with it
+	std::ostringstream tmpName;
+	tmpName << path << "." << getpid() << ".tmp";
+	std::string tmpPath = tmpName.str();
+
+	int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	if (fd == -1)
+	{
+		ERROR_MSG("Could not create %s: %s", tmpPath.c_str(), strerror(errno));
+
+		return false;
+	}
+
+	// Write the data in a single call, continuing where a short write left off
+	size_t written = 0;
+
+	while (written < data.size())
+	{
+		ssize_t rv = write(fd, data.const_byte_str() + written, data.size() - written);
+
+		if (rv == -1)
+		{
+			if (errno == EINTR) continue;
+
+			ERROR_MSG("Could not write %s: %s", tmpPath.c_str(), strerror(errno));
+
+			close(fd);
+			unlink(tmpPath.c_str());
+
+			return false;
+		}
+
+		written += rv;
+	}
+
+	bool synced = !sync || !fsync(fd);
+
+	if (close(fd) || !synced)
+	{
+		ERROR_MSG("Could not write %s: %s", tmpPath.c_str(), strerror(errno));
+
+		unlink(tmpPath.c_str());
+
+		return false;
+	}
+
+	if (rename(tmpPath.c_str(), path.c_str()))
+	{
+		ERROR_MSG("Could not rename %s to %s: %s", tmpPath.c_str(), path.c_str(), strerror(errno));
+
+		unlink(tmpPath.c_str());
+
+		return false;
+	}
+
+	// Make sure the rename itself is durable as well
+	if (sync)
+	{
+		std::string dirPath = ".";
+		size_t pos = path.find_last_of(OS_PATHSEP);
+
+		if (pos != std::string::npos)
+		{
+			dirPath = path.substr(0, pos);
+		}
+
+		int dirFd = open(dirPath.c_str(), O_RDONLY);
+
+		if (dirFd != -1)
+		{
+			fsync(dirFd);
+			close(dirFd);
+		}
+	}
+
+	return true;
+}
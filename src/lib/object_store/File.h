@@ -90,6 +90,12 @@ public:
 	// argument is specified this operation seeks to the end of the file
 	bool seek(long offset = -1);
 
+	// Retrieve the current position relative to the start of the file
+	bool tell(long& offset);
+
+	// Truncate the file to zero length and rewind it
+	bool truncate();
+
 	// Lock the file
 	bool lock(bool block = true);
 
@@ -99,6 +105,11 @@ public:
 	// Flush the buffered stream to background storage
 	bool flush();
 
+	// Replace the contents of the file at the specified path in one go; the
+	// data is written to a temporary file with a single write, optionally
+	// synchronised to disk and then renamed into place
+	static bool writeAtomically(const std::string& path, const ByteString& data, bool sync = false);
+
 private:
 	// The file path
 	std::string path;
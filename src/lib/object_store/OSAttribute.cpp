@@ -95,6 +95,25 @@ const ByteString& OSAttribute::getByteStringValue() const
 	return byteStrValue;
 }
 
+// Compare the type and value of two attributes
+bool OSAttribute::operator==(const OSAttribute& compareTo) const
+{
+	if (attributeType != compareTo.attributeType)
+	{
+		return false;
+	}
+
+	switch (attributeType)
+	{
+		case BOOL:
+			return (boolValue == compareTo.boolValue);
+		case ULONG:
+			return (ulongValue == compareTo.ulongValue);
+		default:
+			return (byteStrValue == compareTo.byteStrValue);
+	}
+}
+
 // Set the attribute value
 void OSAttribute::setBooleanValue(const bool value)
 {
@@ -64,6 +64,9 @@ public:
 	const unsigned long getUnsignedLongValue() const;
 	const ByteString& getByteStringValue() const;
 
+	// Compare the type and value of two attributes
+	bool operator==(const OSAttribute& compareTo) const;
+
 	// Set the attribute value
 	void setBooleanValue(const bool value);
 	void setUnsignedLongValue(const unsigned long value);
@@ -54,13 +54,19 @@ public:
 	// The validity state of the object
 	virtual bool isValid() = 0;
 
+	// Retrieve the generation of the object; the generation changes every
+	// time the object is modified, also if this happens in another process
+	virtual unsigned long getGeneration() = 0;
+
 	// Start an attribute set transaction; this method is used when - for
 	// example - a key is generated and all its attributes need to be
 	// persisted in one go.
 	//
 	// N.B.: Starting a transaction locks the object!
 	//
-	// Function returns false in case a transaction is already in progress
+	// Transactions may be nested; only committing the outermost transaction
+	// writes the object back, and aborting a nested transaction causes the
+	// outermost commit to fail
 	virtual bool startTransaction() = 0;
 
 	// Commit an attribute transaction; returns false if no transaction is in progress
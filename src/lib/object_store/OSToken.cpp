@@ -40,22 +40,31 @@
 #include "Directory.h"
 #include "UUID.h"
 #include "IPCSignal.h"
+#include "ChangeJournal.h"
 #include "cryptoki.h"
 #include "OSToken.h"
 #include "OSPathSep.h"
+#include "WorkerPool.h"
+#include "Statistics.h"
 #include <vector>
 #include <string>
 #include <set>
 #include <map>
 #include <list>
 #include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
 
 // Constructor
 OSToken::OSToken(const std::string tokenPath)
 {
+	attributeIndex = new AttributeIndex();
 	tokenDir = new Directory(tokenPath);
 	tokenObject = new ObjectFile(this, tokenPath + OS_PATHSEP + "tokenObject");
 	sync = IPCSignal::create(tokenPath);
+	journal = new ChangeJournal(tokenPath + OS_PATHSEP + "journal");
 	tokenMutex = MutexFactory::i()->getMutex();
 	this->tokenPath = tokenPath;
 	valid = (sync != NULL) && (tokenMutex != NULL) && tokenDir->isValid() && tokenObject->isValid();
@@ -133,8 +142,10 @@ OSToken::~OSToken()
 
 	delete tokenDir;
 	if (sync != NULL) delete sync;
+	delete journal;
 	MutexFactory::i()->recycleMutex(tokenMutex);
 	delete tokenObject;
+	delete attributeIndex;
 }
 
 // Set the SO PIN
@@ -310,11 +321,40 @@ bool OSToken::setTokenFlags(const CK_ULONG flags)
 	return tokenObject->setAttribute(CKA_OS_TOKENFLAGS, tokenFlags);
 }
 
+// Get the scheme used to encrypt sensitive attributes
+bool OSToken::getEncryptionScheme(CK_ULONG& scheme)
+{
+	if (!valid || !tokenObject->isValid())
+	{
+		return false;
+	}
+
+	OSAttribute* encryption = tokenObject->getAttribute(CKA_OS_ENCRYPTION);
+
+	// Tokens created before the scheme was recorded use the first scheme
+	scheme = (encryption != NULL) ? encryption->getUnsignedLongValue() : 0;
+
+	return true;
+}
+
+// Set the scheme used to encrypt sensitive attributes
+bool OSToken::setEncryptionScheme(const CK_ULONG scheme)
+{
+	if (!valid) return false;
+
+	OSAttribute encryption(scheme);
+
+	return tokenObject->setAttribute(CKA_OS_ENCRYPTION, encryption);
+}
+
 // Retrieve objects
 std::set<ObjectFile*> OSToken::getObjects()
 {
 	index();
 
+	// The caller is likely to look at all objects
+	loadObjects();
+
 	// Make sure that no other thread is in the process of changing
 	// the object list when we return it
 	MutexLocker lock(tokenMutex);
@@ -326,6 +366,9 @@ void OSToken::getObjects(std::set<OSObject*> &objects)
 {
     index();
 
+    // The caller is likely to look at all objects
+    loadObjects();
+
     // Make sure that no other thread is in the process of changing
     // the object list when we return it
     MutexLocker lock(tokenMutex);
@@ -333,6 +376,68 @@ void OSToken::getObjects(std::set<OSObject*> &objects)
     objects.insert(this->objects.begin(),this->objects.end());
 }
 
+// Insert the objects that may match the template into the given set
+bool OSToken::findObjects(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, AttributeIndex::Decryptor* decryptor, std::set<OSObject*> &objects)
+{
+	if (!AttributeIndex::isIndexable(pTemplate, ulCount))
+	{
+		return false;
+	}
+
+	// Indexing the token flags the objects that other instances changed
+	index();
+
+	// Objects that are new to the index are read in parallel first
+	loadObjects();
+
+	std::set<OSObject*> candidates;
+
+	if (!attributeIndex->findCandidates(pTemplate, ulCount, decryptor, candidates))
+	{
+		return false;
+	}
+
+	// Make sure that no other thread is in the process of changing
+	// the object list when we filter the candidates
+	MutexLocker lock(tokenMutex);
+
+	for (std::set<OSObject*>::iterator i = candidates.begin(); i != candidates.end(); i++)
+	{
+		// The index only contains object files of this token
+		if (this->objects.find((ObjectFile*) *i) != this->objects.end())
+		{
+			objects.insert(*i);
+		}
+	}
+
+	return true;
+}
+
+// Discard the attribute index entries derived from private attribute values
+void OSToken::discardPrivateIndex()
+{
+	attributeIndex->discardPrivate();
+}
+
+// Called by an object when it has changed
+void OSToken::objectChanged(ObjectFile* object, bool isWritten)
+{
+	// The token object is not part of the index
+	if (object == tokenObject)
+	{
+		return;
+	}
+
+	attributeIndex->objectChanged(object);
+
+	if (isWritten)
+	{
+		journal->append(ChangeJournal::OBJECT_MODIFIED, object->getFilename());
+
+		sync->trigger();
+	}
+}
+
 // Create a new object
 ObjectFile* OSToken::createObject()
 {
@@ -358,20 +463,27 @@ ObjectFile* OSToken::createObject()
 
 	objects.insert(newObject);
 	allObjects.insert(newObject);
-	currentFiles.insert(newObject->getFilename());
+	currentFiles[newObject->getFilename()] = newObject;
+
+	attributeIndex->objectChanged(newObject);
 
 	DEBUG_MSG("(0x%08X) Created new object %s (0x%08X)", this, objectPath.c_str(), newObject);
 
+	journal->append(ChangeJournal::OBJECT_CREATED, newObject->getFilename());
+
 	sync->trigger();
 
 	return newObject;
 }
 
 // Delete an object
-bool OSToken::deleteObject(ObjectFile* object)
+bool OSToken::deleteObject(OSObject* osobject)
 {
 	if (!valid) return false;
 
+	// Only object files of this token can be deleted
+	ObjectFile* object = (ObjectFile*) osobject;
+
 	if (objects.find(object) == objects.end())
 	{
 		ERROR_MSG("Cannot delete non-existent object 0x%08X", object);
@@ -396,9 +508,16 @@ bool OSToken::deleteObject(ObjectFile* object)
 	}
 
 	objects.erase(object);
+	currentFiles.erase(objectFilename);
+	attributeIndex->objectRemoved(object);
+
+	// The lock file is no longer needed either
+	tokenDir->remove(object->getLockFilename());
 
 	DEBUG_MSG("Deleted object %s", objectFilename.c_str());
 
+	journal->append(ChangeJournal::OBJECT_DELETED, objectFilename);
+
 	sync->trigger();
 
 	return true;
@@ -416,6 +535,12 @@ void OSToken::invalidate()
 	valid = false;
 }
 
+// Return the path of the token
+std::string OSToken::getTokenPath()
+{
+	return tokenPath;
+}
+
 // Delete the token
 bool OSToken::clearToken()
 {
@@ -426,6 +551,8 @@ bool OSToken::clearToken()
 
 	// First, clear out all objects
 	objects.clear();
+	currentFiles.clear();
+	attributeIndex->clear();
 	
 	// Now, delete all files in the token directory
 	if (!tokenDir->refresh())
@@ -461,6 +588,8 @@ bool OSToken::clearToken()
 // Index the token
 bool OSToken::index(bool isFirstTime /* = false */)
 {
+	StatTimer timer(StatCounter::OSTokenIndex);
+
 	// Check if re-indexing is required
 	if (!isFirstTime && (!valid || !sync->wasTriggered()))
 	{
@@ -468,14 +597,101 @@ bool OSToken::index(bool isFirstTime /* = false */)
 	}
 
 	// Check the integrity
-	if (!tokenDir->refresh() || !tokenObject->isValid())
+	if (!tokenObject->isValid())
+	{
+		valid = false;
+
+		return false;
+	}
+
+	MutexLocker lock(tokenMutex);
+
+	// Retrieve the changes that other instances recorded in the journal;
+	// the whole directory is only rescanned if the journal cannot tell
+	std::vector<ChangeJournal::Change> changes;
+	bool isReset = true;
+
+	if (!journal->readChanges(changes, isReset) || isReset || isFirstTime)
+	{
+		return rescan(isFirstTime);
+	}
+
+	DEBUG_MSG("Token %s has %lu journalled changes", tokenPath.c_str(), (unsigned long) changes.size());
+
+	for (std::vector<ChangeJournal::Change>::iterator i = changes.begin(); i != changes.end(); i++)
+	{
+		switch (i->type)
+		{
+			case ChangeJournal::OBJECT_CREATED:
+				addObjectFile(i->filename);
+				break;
+			case ChangeJournal::OBJECT_DELETED:
+				removeObjectFile(i->filename);
+				break;
+			case ChangeJournal::OBJECT_MODIFIED:
+				if (currentFiles.find(i->filename) != currentFiles.end())
+				{
+					attributeIndex->objectChanged(currentFiles[i->filename]);
+				}
+				break;
+			default:
+				DEBUG_MSG("Ignored unknown journal record for %s", i->filename.c_str());
+				break;
+		}
+	}
+
+	DEBUG_MSG("The token now contains %lu objects", (unsigned long) objects.size());
+
+	return true;
+}
+
+// Check if a file is a temporary file that was left behind by an instance
+// of SoftHSM that died while writing an object; these files are named
+// <object file>.<pid>.tmp
+bool OSToken::isStaleTempFile(const std::string& name)
+{
+	if ((name.size() <= 4) || name.compare(name.size() - 4, 4, ".tmp"))
+	{
+		return false;
+	}
+
+	std::string::size_type dot = name.find_last_of('.', name.size() - 5);
+
+	if ((dot == std::string::npos) || (dot + 1 >= name.size() - 4))
+	{
+		return false;
+	}
+
+	std::string pidString = name.substr(dot + 1, name.size() - 5 - dot);
+
+	if (pidString.find_first_not_of("0123456789") != std::string::npos)
+	{
+		return false;
+	}
+
+	pid_t pid = (pid_t) strtol(pidString.c_str(), NULL, 10);
+
+	// Files of running processes may still be renamed into place
+	if ((pid <= 0) || (pid == getpid()))
+	{
+		return false;
+	}
+
+	return (kill(pid, 0) == -1) && (errno == ESRCH);
+}
+
+// Rescan the token directory
+bool OSToken::rescan(bool isFirstTime)
+{
+	// Check the integrity
+	if (!tokenDir->refresh())
 	{
 		valid = false;
 
 		return false;
 	}
 
-	DEBUG_MSG("Token %s has changed", tokenPath.c_str());
+	DEBUG_MSG("Rescanning token %s", tokenPath.c_str());
 
 	// Retrieve the directory listing
 	std::vector<std::string> tokenFiles = tokenDir->getFiles();
@@ -489,6 +705,12 @@ bool OSToken::index(bool isFirstTime /* = false */)
 		{
 			newSet.insert(*i);
 		}
+		else if (isStaleTempFile(*i))
+		{
+			DEBUG_MSG("Removing stale temporary file %s", i->c_str());
+
+			tokenDir->remove(*i);
+		}
 		else
 		{
 			DEBUG_MSG("Ignored file %s", i->c_str());
@@ -496,78 +718,130 @@ bool OSToken::index(bool isFirstTime /* = false */)
 	}
 
 	// Compute the changes compared to the last list of files
-	std::set<std::string> addedFiles;
 	std::set<std::string> removedFiles;
 
-	if (!isFirstTime)
+	for (std::map<std::string, ObjectFile*>::iterator i = currentFiles.begin(); i != currentFiles.end(); i++)
 	{
-		// First compute which files were added
-		for (std::set<std::string>::iterator i = newSet.begin(); i != newSet.end(); i++)
+		if (newSet.find(i->first) == newSet.end())
 		{
-			if (currentFiles.find(*i) == currentFiles.end())
-			{
-				addedFiles.insert(*i);
-			}
+			removedFiles.insert(i->first);
 		}
+	}
 
-		// Now compute which files were removed
-		for (std::set<std::string>::iterator i = currentFiles.begin(); i != currentFiles.end(); i++)
+	DEBUG_MSG("%lu objects were removed", (unsigned long) removedFiles.size());
+
+	// Remove deleted objects
+	for (std::set<std::string>::iterator i = removedFiles.begin(); i != removedFiles.end(); i++)
+	{
+		removeObjectFile(*i);
+	}
+
+	// Changes to the remaining objects may not have been noticed
+	if (!isFirstTime)
+	{
+		for (std::set<ObjectFile*>::iterator i = objects.begin(); i != objects.end(); i++)
 		{
-			if (newSet.find(*i) == newSet.end())
-			{
-				removedFiles.insert(*i);
-			}
+			attributeIndex->objectChanged(*i);
 		}
 	}
-	else
+
+	// Add new objects
+	for (std::set<std::string>::iterator i = newSet.begin(); i != newSet.end(); i++)
 	{
-		addedFiles = newSet;
+		addObjectFile(*i);
 	}
 
-	currentFiles = newSet;
-
-	DEBUG_MSG("%d objects were added and %d objects were removed", addedFiles.size(), removedFiles.size());
-	DEBUG_MSG("Current directory set contains %d objects", currentFiles.size());
+	DEBUG_MSG("The token now contains %lu objects", (unsigned long) objects.size());
 
-	// Now update the set of objects
-	MutexLocker lock(tokenMutex);
+	return true;
+}
 
-	// Add new objects
-	for (std::set<std::string>::iterator i = addedFiles.begin(); i != addedFiles.end(); i++)
+// Add the object stored in the specified file
+void OSToken::addObjectFile(const std::string& filename)
+{
+	if (currentFiles.find(filename) != currentFiles.end())
 	{
-		// Create a new token object for the added file
-		ObjectFile* newObject = new ObjectFile(this, tokenPath + OS_PATHSEP + *i);
+		return;
+	}
+
+	// Create a new token object for the added file
+	ObjectFile* newObject = new ObjectFile(this, tokenPath + OS_PATHSEP + filename);
+
+	DEBUG_MSG("(0x%08X) New object %s (0x%08X) added", this, newObject->getFilename().c_str(), newObject);
 
-		DEBUG_MSG("(0x%08X) New object %s (0x%08X) added", this, newObject->getFilename().c_str(), newObject);
+	objects.insert(newObject);
+	allObjects.insert(newObject);
+	currentFiles[filename] = newObject;
+
+	attributeIndex->objectChanged(newObject);
+}
 
-		objects.insert(newObject);
-		allObjects.insert(newObject);
+// Reads a single object from disk
+class LoadObjectTask : public WorkerTask
+{
+public:
+	LoadObjectTask(ObjectFile* object) : object(object)
+	{
 	}
 
-	// Remove deleted objects
-	std::set<ObjectFile*> newObjects;
+	virtual void run()
+	{
+		object->load();
+	}
+
+	ObjectFile* object;
+};
+
+// Read the objects that have not been used yet from disk in parallel
+void OSToken::loadObjects()
+{
+	std::vector<LoadObjectTask> loadTasks;
 
-	for (std::set<ObjectFile*>::iterator i = objects.begin(); i != objects.end(); i++)
 	{
-		DEBUG_MSG("Processing %s (0x%08X)", (*i)->getFilename().c_str(), *i);
+		MutexLocker lock(tokenMutex);
 
-		if (removedFiles.find((*i)->getFilename()) == removedFiles.end())
-		{
-			DEBUG_MSG("Adding object %s", (*i)->getFilename().c_str());
-			// This object gets to stay in the set
-			newObjects.insert(*i);
-		}
-		else
+		for (std::set<ObjectFile*>::iterator i = objects.begin(); i != objects.end(); i++)
 		{
-			(*i)->invalidate();
+			if (!(*i)->isLoaded())
+			{
+				loadTasks.push_back(LoadObjectTask(*i));
+			}
 		}
 	}
 
-	// Set the new objects
-	objects = newObjects;
+	if (loadTasks.empty()) return;
 
-	DEBUG_MSG("The token now contains %d objects", objects.size());
+	DEBUG_MSG("Loading %lu objects of token %s", (unsigned long) loadTasks.size(), tokenPath.c_str());
 
-	return true;
+	// The objects are never deleted while the token exists, so they can
+	// be loaded without holding the token mutex
+	std::vector<WorkerTask*> tasks;
+
+	for (std::vector<LoadObjectTask>::iterator i = loadTasks.begin(); i != loadTasks.end(); i++)
+	{
+		tasks.push_back(&*i);
+	}
+
+	WorkerPool::i()->runTasks(tasks);
+}
+
+// Remove the object stored in the specified file
+void OSToken::removeObjectFile(const std::string& filename)
+{
+	std::map<std::string, ObjectFile*>::iterator i = currentFiles.find(filename);
+
+	if (i == currentFiles.end())
+	{
+		return;
+	}
+
+	DEBUG_MSG("Object %s (0x%08X) removed", filename.c_str(), i->second);
+
+	i->second->invalidate();
+
+	objects.erase(i->second);
+	attributeIndex->objectRemoved(i->second);
+
+	currentFiles.erase(i);
 }
 
@@ -27,17 +27,20 @@
 /*****************************************************************************
  OSToken.h
 
- The token class; a token is stored in a directory containing several files.
- Each object is stored in a separate file and a token object is present that
- has the token specific attributes
+ The file backed token class; a token is stored in a directory containing
+ several files. Each object is stored in a separate file and a token object is
+ present that has the token specific attributes
  *****************************************************************************/
 
 #ifndef _SOFTHSM_V2_OSTOKEN_H
 #define _SOFTHSM_V2_OSTOKEN_H
 
 #include "config.h"
+#include "ObjectStoreToken.h"
 #include "OSAttribute.h"
 #include "ObjectFile.h"
+#include "AttributeIndex.h"
+#include "ChangeJournal.h"
 #include "Directory.h"
 #include "UUID.h"
 #include "IPCSignal.h"
@@ -48,7 +51,7 @@
 #include <map>
 #include <list>
 
-class OSToken
+class OSToken : public ObjectStoreToken
 {
 public:
 	// Constructor
@@ -58,52 +61,70 @@ public:
 	static OSToken* createToken(const std::string basePath, const std::string tokenDir, const ByteString& label, const ByteString& serial);
 
 	// Set the SO PIN
-	bool setSOPIN(const ByteString& soPINBlob);
+	virtual bool setSOPIN(const ByteString& soPINBlob);
 
 	// Get the SO PIN
-	bool getSOPIN(ByteString& soPINBlob);
+	virtual bool getSOPIN(ByteString& soPINBlob);
 
 	// Set the user PIN
-	bool setUserPIN(ByteString userPINBlob);
+	virtual bool setUserPIN(ByteString userPINBlob);
 
 	// Get the user PIN
-	bool getUserPIN(ByteString& userPINBlob);
+	virtual bool getUserPIN(ByteString& userPINBlob);
 
 	// Get the token flags
-	bool getTokenFlags(CK_ULONG& flags);
+	virtual bool getTokenFlags(CK_ULONG& flags);
 
 	// Set the token flags
-	bool setTokenFlags(const CK_ULONG flags);
+	virtual bool setTokenFlags(const CK_ULONG flags);
+
+	// Get the scheme used to encrypt sensitive attributes
+	virtual bool getEncryptionScheme(CK_ULONG& scheme);
+
+	// Set the scheme used to encrypt sensitive attributes
+	virtual bool setEncryptionScheme(const CK_ULONG scheme);
 
 	// Retrieve the token label
-	bool getTokenLabel(ByteString& label);
+	virtual bool getTokenLabel(ByteString& label);
 
 	// Retrieve the token serial
-	bool getTokenSerial(ByteString& serial);
+	virtual bool getTokenSerial(ByteString& serial);
 
 	// Retrieve objects
 	std::set<ObjectFile*> getObjects();
 
 	// Insert objects into the given set
-	void getObjects(std::set<OSObject*> &objects);
+	virtual void getObjects(std::set<OSObject*> &objects);
+
+	// Insert the objects that may match the template into the given set;
+	// returns false if the template cannot be resolved using the attribute
+	// index, in which case all objects need to be considered
+	virtual bool findObjects(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, AttributeIndex::Decryptor* decryptor, std::set<OSObject*> &objects);
+
+	// Discard the attribute index entries derived from private attribute
+	// values; called whenever the login state of the token changes
+	virtual void discardPrivateIndex();
 
 	// Create a new object
-	ObjectFile* createObject();
+	virtual ObjectFile* createObject();
 
 	// Delete an object
-	bool deleteObject(ObjectFile* object);
+	virtual bool deleteObject(OSObject* object);
 
 	// Destructor
 	virtual ~OSToken();
 
 	// Checks if the token is consistent
-	bool isValid();
+	virtual bool isValid();
 
 	// Invalidate the token (for instance if it is deleted)
-	void invalidate();
+	virtual void invalidate();
 
 	// Delete the token
-	bool clearToken();
+	virtual bool clearToken();
+
+	// Return the path of the token
+	virtual std::string getTokenPath();
 
 private:
 	// ObjectFile instances can call the index() function
@@ -112,6 +133,23 @@ private:
 	// Index the token
 	bool index(bool isFirstTime = false);
 
+	// Rescan the token directory; tokenMutex must be held
+	bool rescan(bool isFirstTime);
+
+	// Is this a temporary file that was left behind by a crashed writer?
+	static bool isStaleTempFile(const std::string& name);
+
+	// Add or remove the object stored in the specified file; tokenMutex must be held
+	void addObjectFile(const std::string& filename);
+	void removeObjectFile(const std::string& filename);
+
+	// Read the objects that have not been used yet from disk in parallel
+	void loadObjects();
+
+	// Called by an object when it has changed; changes that were written
+	// by this instance are recorded in the journal
+	void objectChanged(ObjectFile* object, bool isWritten);
+
 	// Is the token consistent and valid?
 	bool valid;
 
@@ -130,8 +168,8 @@ private:
 	// object outside of this class.
 	std::set<ObjectFile*> allObjects;
 
-	// The current list of files
-	std::set<std::string> currentFiles;
+	// The current list of files and the objects stored in them
+	std::map<std::string, ObjectFile*> currentFiles;
 
 	// The token object
 	ObjectFile* tokenObject;
@@ -139,6 +177,12 @@ private:
 	// Inter-process synchronisation
 	IPCSignal* sync;
 
+	// The journal of changes to the objects of this token
+	ChangeJournal* journal;
+
+	// The attribute index on the objects of this token
+	AttributeIndex* attributeIndex;
+
 	// The directory object for this token
 	Directory* tokenDir;
 
@@ -34,7 +34,12 @@
 #include "ObjectFile.h"
 #include "OSToken.h"
 #include "OSPathSep.h"
+#include "Configuration.h"
+#include "Statistics.h"
 #include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -43,31 +48,74 @@
 #define ULONG_ATTR			0x2
 #define BYTESTR_ATTR			0x3
 
+// Object files are written in an indexed format that can be read without
+// parsing the whole file. It starts with a header consisting of the magic
+// below, a version number and the number of attributes, followed by a table
+// with the PKCS #11 type, the attribute type, the offset and the length of
+// each attribute value. All numbers are stored as 8 byte big-endian values.
+//
+// Files in the original format - a plain sequence of attributes - do not
+// start with this magic; they are still read and are converted to the
+// indexed format when the object is written back.
+static const unsigned char OBJECT_MAGIC[8] = { 'S', 'H', 'S', 'M', '-', 'O', 'B', 'J' };
+#define OBJECT_VERSION			0x1
+#define OBJECT_HEADER_LEN		24
+#define OBJECT_ENTRY_LEN		32
+
+// Get the change signal of an object file; it is kept in the change counters
+// of the token directory that holds the file
+static IPCSignal* createSignal(const std::string& path)
+{
+	size_t pos = path.find_last_of(OS_PATHSEP);
+
+	if (pos == std::string::npos)
+	{
+		return IPCSignal::create(".", path);
+	}
+
+	return IPCSignal::create(path.substr(0, pos), path.substr(pos + 1));
+}
+
 // Constructor
 ObjectFile::ObjectFile(OSToken* parent, std::string path, bool isNew /* = false */)
 {
 	this->path = path;
-	ipcSignal = IPCSignal::create(path);
+	lockPath = path;
+	if ((lockPath.size() > 7) && !lockPath.compare(lockPath.size() - 7, 7, ".object"))
+	{
+		lockPath.erase(lockPath.size() - 7);
+	}
+	lockPath += ".lock";
+	ipcSignal = NULL;
 	objectMutex = MutexFactory::i()->getMutex();
-	valid = (ipcSignal != NULL) && (objectMutex != NULL);
+	loadMutex = MutexFactory::i()->getMutex();
+	valid = (objectMutex != NULL) && (loadMutex != NULL);
+	loaded = false;
+	generation = 0;
 	token = parent;
 	inTransaction = false;
 	transactionLockFile = NULL;
+	transactionDepth = 0;
+	transactionAborted = false;
+	syncOnStore = Configuration::i()->getBool("objectstore.fsync", false);
 
 	if (!valid) return;
 
 	if (!isNew)
 	{
-		DEBUG_MSG("Opened existing object %s", path.c_str());
-
-		refresh(true);
+		// The object is read from disk when it is first used
+		DEBUG_MSG("Registered existing object %s", path.c_str());
 	}
 	else
 	{
 		DEBUG_MSG("Created new object %s", path.c_str());
 
+		ipcSignal = createSignal(path);
+		valid = (ipcSignal != NULL);
+		loaded = true;
+
 		// Create an empty object file
-		store();
+		if (valid) store();
 	}
 
 }
@@ -83,6 +131,7 @@ ObjectFile::~ObjectFile()
 	}
 
 	MutexFactory::i()->recycleMutex(objectMutex);
+	MutexFactory::i()->recycleMutex(loadMutex);
 }
 
 // Check if the specified attribute exists
@@ -92,7 +141,7 @@ bool ObjectFile::attributeExists(CK_ATTRIBUTE_TYPE type)
 
 	MutexLocker lock(objectMutex);
 
-	return valid && (attributes[type] != NULL);
+	return valid && ((attributes[type] != NULL) || (indexedAttributes.find(type) != indexedAttributes.end()));
 }
 
 // Retrieve the specified attribute
@@ -102,6 +151,11 @@ OSAttribute* ObjectFile::getAttribute(CK_ATTRIBUTE_TYPE type)
 
 	MutexLocker lock(objectMutex);
 
+	if (attributes[type] == NULL)
+	{
+		return decodeAttribute(type);
+	}
+
 	return attributes[type];
 }
 
@@ -120,8 +174,14 @@ bool ObjectFile::setAttribute(CK_ATTRIBUTE_TYPE type, const OSAttribute& attribu
 	{
 		MutexLocker lock(objectMutex);
 
-		if (attributes[type] != NULL)
+		if ((attributes[type] != NULL) || (decodeAttribute(type) != NULL))
 		{
+			// Nothing needs to be written back if the value is unchanged
+			if (*attributes[type] == attribute)
+			{
+				return true;
+			}
+
 			delete attributes[type];
 
 			attributes[type] = NULL;
@@ -138,9 +198,21 @@ bool ObjectFile::setAttribute(CK_ATTRIBUTE_TYPE type, const OSAttribute& attribu
 // The validity state of the object
 bool ObjectFile::isValid()
 {
+	load();
+
 	return valid;
 }
 
+// Retrieve the generation of the object
+unsigned long ObjectFile::getGeneration()
+{
+	refresh();
+
+	MutexLocker lock(objectMutex);
+
+	return generation;
+}
+
 // Invalidate the object file externally; this method is normally
 // only called by the OSToken class in case an object file has
 // been deleted.
@@ -151,9 +223,57 @@ void ObjectFile::invalidate()
 	discardAttributes();
 }
 
+// Read the object from disk if this has not been done yet; objects are
+// registered by their file name only so opening a token is cheap
+void ObjectFile::load()
+{
+	if (loaded) return;
+
+	MutexLocker lock(loadMutex);
+
+	if (loaded) return;
+
+	// The object may have been deleted before it was ever used
+	if (valid)
+	{
+		DEBUG_MSG("Loading object %s", path.c_str());
+
+		ipcSignal = createSignal(path);
+
+		if (ipcSignal == NULL)
+		{
+			valid = false;
+		}
+		else
+		{
+			refresh(true);
+		}
+	}
+
+	// Make sure the object is complete before other threads use it
+	__sync_synchronize();
+
+	loaded = true;
+}
+
+// Check if the object has been read from disk
+bool ObjectFile::isLoaded()
+{
+	return loaded;
+}
+
 // Refresh the object if necessary
 void ObjectFile::refresh(bool isFirstTime /* = false */)
 {
+	StatTimer timer(StatCounter::ObjectFileRefresh);
+
+	if (!isFirstTime && !loaded)
+	{
+		load();
+
+		return;
+	}
+
 	// Check if we're in the middle of a transaction
 	if (inTransaction)
 	{
@@ -173,9 +293,9 @@ void ObjectFile::refresh(bool isFirstTime /* = false */)
 		return;
 	}
 
-	File objectFile(path);
+	int fd = open(path.c_str(), O_RDONLY);
 
-	if (!objectFile.isValid())
+	if (fd == -1)
 	{
 		valid = false;
 
@@ -187,11 +307,199 @@ void ObjectFile::refresh(bool isFirstTime /* = false */)
 	// Discard the existing set of attributes
 	discardAttributes();
 
-	objectFile.lock();
-
 	MutexLocker lock(objectMutex);
 
-	// Read back the attributes
+	generation++;
+
+	// Only files in the indexed format start with the magic
+	unsigned char magic[sizeof(OBJECT_MAGIC)];
+
+	bool isIndexed = (pread(fd, magic, sizeof(magic), 0) == sizeof(magic)) &&
+	                 !memcmp(magic, OBJECT_MAGIC, sizeof(magic));
+
+	bool rv = isIndexed ? readIndex(fd) : readAttributes();
+
+	close(fd);
+
+	if (!rv)
+	{
+		DEBUG_MSG("Corrupt object file %s", path.c_str());
+
+		releaseIndex();
+
+		valid = false;
+
+		return;
+	}
+
+	valid = true;
+
+	// Let the token know that the object was changed by another instance
+	if (!isFirstTime && (token != NULL))
+	{
+		token->objectChanged(this, false);
+	}
+}
+
+// Write the object to background storage; the object is serialised into a
+// single buffer that replaces the object file in one go, so other instances
+// never see a partially written object
+void ObjectFile::store()
+{
+	StatTimer timer(StatCounter::ObjectFileStore);
+
+	// Check if we're in the middle of a transaction
+	if (inTransaction)
+	{
+		return;
+	}
+
+	if (!valid)
+	{
+		DEBUG_MSG("Cannot write back an invalid object %s", path.c_str());
+
+		return;
+	}
+
+	// Lock the object to keep writers in other processes out; a transaction
+	// that is being committed already holds the lock
+	File* lockFile = NULL;
+
+	if (transactionLockFile == NULL)
+	{
+		lockFile = new File(lockPath, true, true, true);
+
+		if (!lockFile->isValid() || !lockFile->lock())
+		{
+			DEBUG_MSG("Cannot lock object %s for writing", path.c_str());
+
+			delete lockFile;
+
+			valid = false;
+
+			return;
+		}
+	}
+
+	{
+		MutexLocker lock(objectMutex);
+
+		ByteString serialised;
+
+		if (!serialise(serialised) || !File::writeAtomically(path, serialised, syncOnStore))
+		{
+			DEBUG_MSG("Failed to write object %s", path.c_str());
+
+			valid = false;
+
+			delete lockFile;
+
+			return;
+		}
+
+		generation++;
+	}
+
+	delete lockFile;
+
+	// Trigger the IPC signal
+	ipcSignal->trigger();
+
+	valid = true;
+
+	// Let the token know that the object has changed
+	if (token != NULL)
+	{
+		token->objectChanged(this, true);
+	}
+}
+
+// Serialise the attributes of the object into a single buffer in the indexed
+// format; the object mutex must be held
+bool ObjectFile::serialise(ByteString& serialised)
+{
+	// All attributes need to be decoded before the file contents are replaced
+	while (!indexedAttributes.empty())
+	{
+		if (decodeAttribute(indexedAttributes.begin()->first) == NULL)
+		{
+			return false;
+		}
+	}
+
+	unsigned long count = 0;
+
+	for (std::map<CK_ATTRIBUTE_TYPE, OSAttribute*>::iterator i = attributes.begin(); i != attributes.end(); i++)
+	{
+		if (i->second != NULL) count++;
+	}
+
+	ByteString table(ByteString::Public);
+	ByteString values;
+	size_t offset = OBJECT_HEADER_LEN + count * OBJECT_ENTRY_LEN;
+
+	for (std::map<CK_ATTRIBUTE_TYPE, OSAttribute*>::iterator i = attributes.begin(); i != attributes.end(); i++)
+	{
+		if (i->second == NULL)
+		{
+			continue;
+		}
+
+		unsigned long osAttrType;
+		ByteString value(ByteString::Public);
+
+		if (i->second->isBooleanAttribute())
+		{
+			osAttrType = BOOLEAN_ATTR;
+			value += (unsigned char) (i->second->getBooleanValue() ? 0xFF : 0x00);
+		}
+		else if (i->second->isUnsignedLongAttribute())
+		{
+			osAttrType = ULONG_ATTR;
+			value = ByteString(i->second->getUnsignedLongValue());
+		}
+		else if (i->second->isByteStringAttribute())
+		{
+			osAttrType = BYTESTR_ATTR;
+			value = i->second->getByteStringValue();
+		}
+		else
+		{
+			DEBUG_MSG("Unknown attribute type for object %s", path.c_str());
+
+			return false;
+		}
+
+		table += ByteString((unsigned long) i->first);
+		table += ByteString(osAttrType);
+		table += ByteString((unsigned long) (offset + values.size()));
+		table += ByteString((unsigned long) value.size());
+
+		values += value;
+	}
+
+	serialised = ByteString(OBJECT_MAGIC, sizeof(OBJECT_MAGIC), ByteString::Public);
+	serialised += ByteString((unsigned long) OBJECT_VERSION);
+	serialised += ByteString(count);
+	serialised += table;
+	serialised += values;
+
+	return true;
+}
+
+// Read back all attributes from an object file in the original format; the
+// object mutex must be held
+bool ObjectFile::readAttributes()
+{
+	File objectFile(path);
+
+	if (!objectFile.isValid())
+	{
+		return false;
+	}
+
+	objectFile.lock();
+
 	do
 	{
 		unsigned long p11AttrType;
@@ -204,44 +512,27 @@ void ObjectFile::refresh(bool isFirstTime /* = false */)
 				break;
 			}
 
-			DEBUG_MSG("Corrupt object file %s", path.c_str());
-
-			valid = false;
-
-			objectFile.unlock();
-
-			return;
+			return false;
 		}
-			
+
 		if (!objectFile.readULong(osAttrType))
 		{
-			DEBUG_MSG("Corrupt object file %s", path.c_str());
-
-			valid = false;
-
-			return;
+			return false;
 		}
 
 		// Depending on the type, read back the actual value
+		OSAttribute* attribute = NULL;
+
 		if (osAttrType == BOOLEAN_ATTR)
 		{
 			bool value;
 
 			if (!objectFile.readBool(value))
 			{
-				DEBUG_MSG("Corrupt object file %s", path.c_str());
-
-				valid = false;
-
-				return;
-			}
-
-			if (attributes[p11AttrType] != NULL)
-			{
-				delete attributes[p11AttrType];
+				return false;
 			}
 
-			attributes[p11AttrType] = new OSAttribute(value);
+			attribute = new OSAttribute(value);
 		}
 		else if (osAttrType == ULONG_ATTR)
 		{
@@ -249,19 +540,10 @@ void ObjectFile::refresh(bool isFirstTime /* = false */)
 
 			if (!objectFile.readULong(value))
 			{
-				DEBUG_MSG("Corrupt object file %s", path.c_str());
-
-				valid = false;
-
-				return;
+				return false;
 			}
 
-			if (attributes[p11AttrType] != NULL)
-			{
-				delete attributes[p11AttrType];
-			}
-			
-			attributes[p11AttrType] = new OSAttribute(value);
+			attribute = new OSAttribute(value);
 		}
 		else if (osAttrType == BYTESTR_ATTR)
 		{
@@ -269,153 +551,165 @@ void ObjectFile::refresh(bool isFirstTime /* = false */)
 
 			if (!objectFile.readByteString(value))
 			{
-				DEBUG_MSG("Corrupt object file %s", path.c_str());
-
-				valid = false;
-
-				return;
+				return false;
 			}
 
-			if (attributes[p11AttrType] != NULL)
-			{
-				delete attributes[p11AttrType];
-			}
-			
-			attributes[p11AttrType] = new OSAttribute(value);
+			attribute = new OSAttribute(value);
 		}
 		else
 		{
 			DEBUG_MSG("Corrupt object file %s with unknown attribute of type %d", path.c_str(), osAttrType);
 
-			valid = false;
+			return false;
+		}
 
-			return;
+		if (attributes[p11AttrType] != NULL)
+		{
+			delete attributes[p11AttrType];
 		}
+
+		attributes[p11AttrType] = attribute;
 	}
 	while (!objectFile.isEOF());
 
 	objectFile.unlock();
 
-	valid = true;
+	return true;
 }
 
-// Write the object to background storage
-void ObjectFile::store()
+// Read an object file in the indexed format and its attribute table; the
+// values themselves are only decoded when they are requested. The file is
+// read into process memory in one go, so that no file mapping or descriptor
+// has to be kept for every object of a large token. The object mutex must
+// be held
+bool ObjectFile::readIndex(int fd)
 {
-	// Check if we're in the middle of a transaction
-	if (inTransaction)
-	{
-		return;
-	}
+	struct stat fileStat;
 
-	if (!valid)
+	if (fstat(fd, &fileStat) || (fileStat.st_size < OBJECT_HEADER_LEN))
 	{
-		DEBUG_MSG("Cannot write back an invalid object %s", path.c_str());
-
-		return;
+		return false;
 	}
 
-	File objectFile(path, false, true, true);
-
-	if (!objectFile.isValid())
-	{
-		DEBUG_MSG("Cannot open object %s for writing", path.c_str());
-
-		valid = false;
+	fileData.resize(fileStat.st_size);
 
-		return;
-	}
+	size_t offset = 0;
 
-	objectFile.lock();
+	while (offset < fileData.size())
+	{
+		ssize_t rv = pread(fd, &fileData[offset], fileData.size() - offset, offset);
 
-	MutexLocker lock(objectMutex);
+		if ((rv == -1) && (errno == EINTR)) continue;
 
-	for (std::map<CK_ATTRIBUTE_TYPE, OSAttribute*>::iterator i = attributes.begin(); i != attributes.end(); i++)
-	{
-		if (i->second == NULL)
+		if (rv <= 0)
 		{
-			continue;
+			ERROR_MSG("Could not read object file %s: %s", path.c_str(), (rv == 0) ? "file truncated" : strerror(errno));
+
+			return false;
 		}
 
-		unsigned long p11AttrType = i->first;
+		offset += rv;
+	}
 
-		if (!objectFile.writeULong(p11AttrType))
-		{
-			DEBUG_MSG("Failed to write PKCS #11 attribute type to object %s", path.c_str());
+	const unsigned char* data = &fileData[0];
+	size_t dataSize = fileData.size();
 
-			valid = false;
+	if (ByteString::decodeULong(data + sizeof(OBJECT_MAGIC)) != OBJECT_VERSION)
+	{
+		DEBUG_MSG("Unsupported version of object file %s", path.c_str());
 
-			objectFile.unlock();
+		return false;
+	}
 
-			return;
-		}
+	unsigned long count = ByteString::decodeULong(data + sizeof(OBJECT_MAGIC) + 8);
 
-		if (i->second->isBooleanAttribute())
-		{
-			unsigned long osAttrType = BOOLEAN_ATTR;
-			bool value = i->second->getBooleanValue();
+	if (count > (dataSize - OBJECT_HEADER_LEN) / OBJECT_ENTRY_LEN)
+	{
+		return false;
+	}
 
-			if (!objectFile.writeULong(osAttrType) || !objectFile.writeBool(value))
-			{
-				DEBUG_MSG("Failed to write attribute to object %s", path.c_str());
+	for (unsigned long i = 0; i < count; i++)
+	{
+		const unsigned char* entry = data + OBJECT_HEADER_LEN + i * OBJECT_ENTRY_LEN;
 
-				valid = false;
+		CK_ATTRIBUTE_TYPE p11AttrType = ByteString::decodeULong(entry);
+		IndexedAttribute attribute;
 
-				objectFile.unlock();
+		attribute.osAttrType = ByteString::decodeULong(entry + 8);
+		attribute.offset = ByteString::decodeULong(entry + 16);
+		attribute.length = ByteString::decodeULong(entry + 24);
 
-				return;
-			}
+		// Check that the value lies within the file
+		if ((attribute.offset > dataSize) || (attribute.length > dataSize - attribute.offset))
+		{
+			return false;
 		}
-		else if (i->second->isUnsignedLongAttribute())
+
+		if (((attribute.osAttrType == BOOLEAN_ATTR) && (attribute.length != 1)) ||
+		    ((attribute.osAttrType == ULONG_ATTR) && (attribute.length != 8)) ||
+		    ((attribute.osAttrType != BOOLEAN_ATTR) && (attribute.osAttrType != ULONG_ATTR) && (attribute.osAttrType != BYTESTR_ATTR)))
 		{
-			unsigned long osAttrType = ULONG_ATTR;
-			unsigned long value = i->second->getUnsignedLongValue();
+			DEBUG_MSG("Corrupt object file %s with unknown attribute of type %d", path.c_str(), attribute.osAttrType);
 
-			if (!objectFile.writeULong(osAttrType) || !objectFile.writeULong(value))
-			{
-				DEBUG_MSG("Failed to write attribute to object %s", path.c_str());
+			return false;
+		}
 
-				valid = false;
+		indexedAttributes[p11AttrType] = attribute;
+	}
 
-				objectFile.unlock();
+	return true;
+}
 
-				return;
-			}
-		}
-		else if (i->second->isByteStringAttribute())
-		{
-			unsigned long osAttrType = BYTESTR_ATTR;
-			const ByteString& value = i->second->getByteStringValue();
+// Decode an indexed attribute on demand; the object mutex must be held
+OSAttribute* ObjectFile::decodeAttribute(CK_ATTRIBUTE_TYPE type)
+{
+	std::map<CK_ATTRIBUTE_TYPE, IndexedAttribute>::iterator i = indexedAttributes.find(type);
 
-			if (!objectFile.writeULong(osAttrType) || !objectFile.writeByteString(value))
-			{
-				DEBUG_MSG("Failed to write attribute to object %s", path.c_str());
+	if (i == indexedAttributes.end())
+	{
+		return NULL;
+	}
 
-				valid = false;
+	const unsigned char* value = &fileData[i->second.offset];
+	OSAttribute* attribute;
 
-				objectFile.unlock();
+	if (i->second.osAttrType == BOOLEAN_ATTR)
+	{
+		attribute = new OSAttribute(value[0] ? true : false);
+	}
+	else if (i->second.osAttrType == ULONG_ATTR)
+	{
+		attribute = new OSAttribute(ByteString::decodeULong(value));
+	}
+	else
+	{
+		attribute = new OSAttribute(ByteString(value, i->second.length));
+	}
 
-				return;
-			}
-		}
-		else
-		{
-			DEBUG_MSG("Unknown attribute type for object %s", path.c_str());
+	indexedAttributes.erase(i);
 
-			valid = false;
+	if (attributes[type] != NULL)
+	{
+		delete attributes[type];
+	}
 
-			objectFile.unlock();
+	attributes[type] = attribute;
 
-			return;
-		}
+	// The file contents are no longer needed once everything has been decoded
+	if (indexedAttributes.empty())
+	{
+		releaseIndex();
 	}
 
-	objectFile.unlock();
+	return attribute;
+}
 
-	// Trigger the IPC signal
-	ipcSignal->trigger();
+// Release the contents of the object file; the object mutex must be held
+void ObjectFile::releaseIndex()
+{
+	indexedAttributes.clear();
 
-	valid = true;
+	std::vector<unsigned char>().swap(fileData);
 }
 
 // Discard the cached attributes
@@ -423,6 +717,8 @@ void ObjectFile::discardAttributes()
 {
 	MutexLocker lock(objectMutex);
 
+	releaseIndex();
+
 	std::map<CK_ATTRIBUTE_TYPE, OSAttribute*> cleanUp = attributes;
 	attributes.clear();
 
@@ -453,21 +749,41 @@ std::string ObjectFile::getFilename() const
 	}
 }
 
+// Returns the file name of the lock file of the object
+std::string ObjectFile::getLockFilename() const
+{
+	if ((lockPath.find_last_of(OS_PATHSEP) != std::string::npos) &&
+	    (lockPath.find_last_of(OS_PATHSEP) < lockPath.size()))
+	{
+		return lockPath.substr(lockPath.find_last_of(OS_PATHSEP) + 1);
+	}
+	else
+	{
+		return lockPath;
+	}
+}
+
 // Start an attribute set transaction; this method is used when - for
 // example - a key is generated and all its attributes need to be
-// persisted in one go.
+// persisted in one go. Transactions may be nested, in which case the
+// object is only written back when the outermost transaction commits.
 //
 // N.B.: Starting a transaction locks the object!
 bool ObjectFile::startTransaction()
 {
+	// The attributes must be known before they can be changed
+	load();
+
 	MutexLocker lock(objectMutex);
 
 	if (inTransaction)
 	{
-		return false;
+		transactionDepth++;
+
+		return true;
 	}
 
-	transactionLockFile = new File(path);
+	transactionLockFile = new File(lockPath, true, true, true);
 
 	if (!transactionLockFile->isValid() || !transactionLockFile->lock())
 	{
@@ -480,6 +796,8 @@ bool ObjectFile::startTransaction()
 	}
 
 	inTransaction = true;
+	transactionDepth = 1;
+	transactionAborted = false;
 
 	return true;
 }
@@ -494,28 +812,49 @@ bool ObjectFile::commitTransaction()
 		{
 			return false;
 		}
-	
-		// Unlock the file; theoretically, this can mean that another instance
-		// of SoftHSM now gets the lock and writes back attributes that will be
-		// overwritten when this transaction is committed. The chances of this
-		// are deemed to be so small that we do nothing to prevent this...
+
+		// Nested transactions are committed by the outermost one
+		if (--transactionDepth > 0)
+		{
+			return true;
+		}
+	}
+
+	// Changes of an aborted nested transaction must not be written back
+	if (transactionAborted)
+	{
+		abortTransaction();
+
+		return false;
+	}
+
+	{
+		MutexLocker lock(objectMutex);
+
 		if (transactionLockFile == NULL)
 		{
 			ERROR_MSG("Transaction lock file instance invalid!");
 	
 			return false;
 		}
-	
+
+		inTransaction = false;
+	}
+
+	// The object is written back while the lock is still held, so no other
+	// instance of SoftHSM can write the object in between
+	store();
+
+	{
+		MutexLocker lock(objectMutex);
+
 		transactionLockFile->unlock();
 	
 		delete transactionLockFile;
 		transactionLockFile = NULL;
-		inTransaction = false;
 	}
 
-	store();
-	
-	return true;
+	return isValid();
 }
 
 // Abort an attribute transaction; loads back the previous version of the object from disk
@@ -529,6 +868,15 @@ bool ObjectFile::abortTransaction()
 			return false;
 		}
 
+		// Nested transactions are aborted by the outermost one
+		if (transactionDepth > 1)
+		{
+			transactionDepth--;
+			transactionAborted = true;
+
+			return true;
+		}
+
 		if (transactionLockFile == NULL)
 		{
 			ERROR_MSG("Transaction lock file instance invalid!");
@@ -541,11 +889,18 @@ bool ObjectFile::abortTransaction()
 		delete transactionLockFile;
 		transactionLockFile = NULL;
 		inTransaction = false;
+		transactionDepth = 0;
 	}
 
 	// Force reload from disk
 	refresh(true);
 
+	// Attributes set during the transaction may have been indexed
+	if (token != NULL)
+	{
+		token->objectChanged(this, false);
+	}
+
 	return true;
 }
 
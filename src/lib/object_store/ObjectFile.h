@@ -41,6 +41,7 @@
 #include "MutexFactory.h"
 #include <string>
 #include <map>
+#include <vector>
 #include <time.h>
 #include "cryptoki.h"
 #include "OSObject.h"
@@ -69,6 +70,9 @@ public:
 	// The validity state of the object
 	virtual bool isValid();
 
+	// Retrieve the generation of the object
+	virtual unsigned long getGeneration();
+
 	// Invalidate the object file externally; this method is normally
 	// only called by the OSToken class in case an object file has
 	// been deleted.
@@ -77,13 +81,18 @@ public:
 	// Returns the file name of the object
 	std::string getFilename() const;
 
+	// Returns the file name of the lock file that serialises writers of the object
+	std::string getLockFilename() const;
+
 	// Start an attribute set transaction; this method is used when - for
 	// example - a key is generated and all its attributes need to be
 	// persisted in one go.
 	//
 	// N.B.: Starting a transaction locks the object!
 	//
-	// Function returns false in case a transaction is already in progress
+	// Transactions may be nested; only committing the outermost transaction
+	// writes the object back, and aborting a nested transaction causes the
+	// outermost commit to fail
 	virtual bool startTransaction();
 
 	// Commit an attribute transaction; returns false if no transaction is in progress
@@ -97,38 +106,95 @@ public:
 	// call!
 	virtual bool destroyObject();
 
+	// Read the object from disk if this has not been done yet
+	void load();
+
+	// Check if the object has been read from disk
+	bool isLoaded();
+
 private:
+	// OSToken instances can call the refresh() function
+	friend class OSToken;
+
 	// Refresh the object if necessary
 	void refresh(bool isFirstTime = false);
 
 	// Write the object to background storage
 	void store();
 
+	// Serialise the attributes of the object into a single buffer
+	bool serialise(ByteString& serialised);
+
+	// Read back all attributes from an object file in the original format
+	bool readAttributes();
+
+	// Read an object file in the indexed format and its attribute table
+	bool readIndex(int fd);
+
+	// Decode an indexed attribute on demand; the object mutex must be held
+	OSAttribute* decodeAttribute(CK_ATTRIBUTE_TYPE type);
+
+	// Release the contents of the object file
+	void releaseIndex();
+
 	// Discard the cached attributes
 	void discardAttributes();
 
+	// The location of an attribute value in the object file
+	struct IndexedAttribute
+	{
+		unsigned long osAttrType;
+		size_t offset;
+		size_t length;
+	};
+
 	// The path to the file
 	std::string path;
 
+	// The path to the lock file; object files are replaced on every write,
+	// so writers in different processes lock this stable file instead
+	std::string lockPath;
+
 	// The IPC object that is used to signal changes in the object file
 	// to other SoftHSM instances
 	IPCSignal* ipcSignal;
 
-	// The object's raw attributes
+	// The object's raw attributes; these take precedence over indexed attributes
 	std::map<CK_ATTRIBUTE_TYPE, OSAttribute*> attributes;
 
+	// The contents of the object file and the attributes in it that have not
+	// been decoded yet; the file only holds encrypted values of sensitive
+	// attributes, so it is kept in ordinary memory
+	std::vector<unsigned char> fileData;
+	std::map<CK_ATTRIBUTE_TYPE, IndexedAttribute> indexedAttributes;
+
 	// The object's validity state
 	bool valid;
 
+	// The generation of the object; incremented on every change
+	unsigned long generation;
+
 	// The token this object is associated with
 	OSToken* token;
 
 	// Mutex object for thread-safeness
 	Mutex* objectMutex;
 
+	// Existing objects are only read from disk when they are first used
+	volatile bool loaded;
+	Mutex* loadMutex;
+
 	// Is the object undergoing an attribute transaction?
 	bool inTransaction;
 	File* transactionLockFile;
+
+	// The nesting depth of the current transaction and whether one of
+	// the nested transactions was aborted
+	unsigned long transactionDepth;
+	bool transactionAborted;
+
+	// Should changes be synchronised to disk before they are renamed into place?
+	bool syncOnStore;
 };
 
 #endif // !_SOFTHSM_V2_OBJECTFILE_H
@@ -36,11 +36,32 @@
 #include "config.h"
 #include "log.h"
 #include "ObjectStore.h"
+#include "WorkerPool.h"
 #include "Directory.h"
-#include "OSToken.h"
+#include "ObjectStoreToken.h"
+#include "SharedCounters.h"
 #include "UUID.h"
 #include <stdio.h>
 
+// Opens a single token
+class OpenTokenTask : public WorkerTask
+{
+public:
+	OpenTokenTask(const std::string& storePath, const std::string& tokenDir)
+		: storePath(storePath), tokenDir(tokenDir), token(NULL)
+	{
+	}
+
+	virtual void run()
+	{
+		token = ObjectStoreToken::accessToken(storePath, tokenDir);
+	}
+
+	std::string storePath;
+	std::string tokenDir;
+	ObjectStoreToken* token;
+};
+
 // Constructor
 ObjectStore::ObjectStore(std::string storePath)
 {
@@ -63,14 +84,29 @@ ObjectStore::ObjectStore(std::string storePath)
 	// Assume that all subdirectories are tokens
 	std::vector<std::string> dirs = storeDir.getSubDirs();
 
+	// Open the tokens in parallel
+	std::vector<OpenTokenTask> openTasks;
+	std::vector<WorkerTask*> tasks;
+
 	for (std::vector<std::string>::iterator i = dirs.begin(); i != dirs.end(); i++)
 	{
-		// Create a token instance
-		OSToken* token = new OSToken(storePath + "/" + *i);
+		openTasks.push_back(OpenTokenTask(storePath, *i));
+	}
+
+	for (std::vector<OpenTokenTask>::iterator i = openTasks.begin(); i != openTasks.end(); i++)
+	{
+		tasks.push_back(&*i);
+	}
+
+	WorkerPool::i()->runTasks(tasks);
+
+	for (std::vector<OpenTokenTask>::iterator i = openTasks.begin(); i != openTasks.end(); i++)
+	{
+		ObjectStoreToken* token = i->token;
 
 		if (!token->isValid())
 		{
-			ERROR_MSG("Failed to open token %s", i->c_str());
+			ERROR_MSG("Failed to open token %s", i->tokenDir.c_str());
 
 			delete token;
 
@@ -93,7 +129,7 @@ ObjectStore::~ObjectStore()
 		// Clean up
 		tokens.clear();
 
-		for (std::vector<OSToken*>::iterator i = allTokens.begin(); i != allTokens.end(); i++)
+		for (std::vector<ObjectStoreToken*>::iterator i = allTokens.begin(); i != allTokens.end(); i++)
 		{
 			delete *i;
 		}
@@ -117,7 +153,7 @@ size_t ObjectStore::getTokenCount()
 }
 
 // Return a pointer to the n-th token (counting starts at 0)
-OSToken* ObjectStore::getToken(size_t whichToken)
+ObjectStoreToken* ObjectStore::getToken(size_t whichToken)
 {
 	MutexLocker lock(storeMutex);
 
@@ -130,7 +166,7 @@ OSToken* ObjectStore::getToken(size_t whichToken)
 }
 
 // Create a new token
-OSToken* ObjectStore::newToken(const ByteString& label)
+ObjectStoreToken* ObjectStore::newToken(const ByteString& label)
 {
 	MutexLocker lock(storeMutex);
 
@@ -142,7 +178,7 @@ OSToken* ObjectStore::newToken(const ByteString& label)
 	ByteString serial((const unsigned char*) serialNumber.c_str(), serialNumber.size());
 
 	// Create the token
-	OSToken* newToken = OSToken::createToken(storePath, tokenUUID, label, serial);
+	ObjectStoreToken* newToken = ObjectStoreToken::createToken(storePath, tokenUUID, label, serial);
 
 	if (newToken != NULL)
 	{
@@ -154,12 +190,12 @@ OSToken* ObjectStore::newToken(const ByteString& label)
 }
 
 // Destroy a token
-bool ObjectStore::destroyToken(OSToken* token)
+bool ObjectStore::destroyToken(ObjectStoreToken* token)
 {
 	MutexLocker lock(storeMutex);
 
 	// Find the token
-	for (std::vector<OSToken*>::iterator i = tokens.begin(); i != tokens.end(); i++)
+	for (std::vector<ObjectStoreToken*>::iterator i = tokens.begin(); i != tokens.end(); i++)
 	{
 		if (*i == token)
 		{
@@ -171,6 +207,9 @@ bool ObjectStore::destroyToken(OSToken* token)
 				return false;
 			}
 
+			// The change counters of the token are no longer needed
+			SharedCounters::remove(token->getTokenPath());
+
 			// And remove it from the vector
 			tokens.erase(i);
 
@@ -38,7 +38,7 @@
 
 #include "config.h"
 #include "ByteString.h"
-#include "OSToken.h"
+#include "ObjectStoreToken.h"
 #include "MutexFactory.h"
 #include <string>
 #include <vector>
@@ -56,23 +56,23 @@ public:
 	size_t getTokenCount();
 
 	// Return a pointer to the n-th token (counting starts at 0)
-	OSToken* getToken(size_t whichToken);
+	ObjectStoreToken* getToken(size_t whichToken);
 
 	// Create a new token
-	OSToken* newToken(const ByteString& label);
+	ObjectStoreToken* newToken(const ByteString& label);
 	
 	// Destroy a token
-	bool destroyToken(OSToken* token);
+	bool destroyToken(ObjectStoreToken* token);
 
 	// Check if the object store is valid
 	bool isValid();
 
 private:
 	// The tokens
-	std::vector<OSToken*> tokens;
+	std::vector<ObjectStoreToken*> tokens;
 
 	// All tokens
-	std::vector<OSToken*> allTokens;
+	std::vector<ObjectStoreToken*> allTokens;
 
 	// The object store root directory
 	std::string storePath;
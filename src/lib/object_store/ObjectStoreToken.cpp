@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ ObjectStoreToken.cpp
+
+ The interface to a token in the object store
+ *****************************************************************************/
+
+#include "config.h"
+#include "log.h"
+#include "ObjectStoreToken.h"
+#include "OSToken.h"
+#include "DBToken.h"
+#include "OSPathSep.h"
+#include "Configuration.h"
+
+// Create a new token using the configured backend
+/*static*/ ObjectStoreToken* ObjectStoreToken::createToken(const std::string basePath, const std::string tokenDir, const ByteString& label, const ByteString& serial)
+{
+	std::string backend = Configuration::i()->getString("objectstore.backend", "file");
+
+	if (backend == "file")
+	{
+		return OSToken::createToken(basePath, tokenDir, label, serial);
+	}
+	else if (backend == "db")
+	{
+		return DBToken::createToken(basePath, tokenDir, label, serial);
+	}
+
+	ERROR_MSG("Unknown object store backend %s", backend.c_str());
+
+	return NULL;
+}
+
+// Open an existing token using the backend it was created with
+/*static*/ ObjectStoreToken* ObjectStoreToken::accessToken(const std::string basePath, const std::string tokenDir)
+{
+	std::string tokenPath = basePath + OS_PATHSEP + tokenDir;
+
+	if (DBToken::isDBToken(tokenPath))
+	{
+		return new DBToken(tokenPath);
+	}
+
+	return new OSToken(tokenPath);
+}
+
@@ -42,6 +42,7 @@ SessionObject::SessionObject(SessionObjectStore* parent, CK_SLOT_ID slotID, CK_S
 	this->isPrivate = isPrivate;
 	objectMutex = MutexFactory::i()->getMutex();
 	valid = (objectMutex != NULL);
+	generation = 0;
 	this->parent = parent;
 }
 
@@ -72,23 +73,33 @@ OSAttribute* SessionObject::getAttribute(CK_ATTRIBUTE_TYPE type)
 // Set the specified attribute
 bool SessionObject::setAttribute(CK_ATTRIBUTE_TYPE type, const OSAttribute& attribute)
 {
-	MutexLocker lock(objectMutex);
-
-	if (!valid)
 	{
-		DEBUG_MSG("Cannot update invalid session object 0x%08X", this);
+		MutexLocker lock(objectMutex);
 
-		return false;
-	}
+		if (!valid)
+		{
+			DEBUG_MSG("Cannot update invalid session object 0x%08X", this);
 
-	if (attributes[type] != NULL)
-	{
-		delete attributes[type];
+			return false;
+		}
 
-		attributes[type] = NULL;
+		if (attributes[type] != NULL)
+		{
+			delete attributes[type];
+
+			attributes[type] = NULL;
+		}
+
+		attributes[type] = new OSAttribute(attribute);
+
+		generation++;
 	}
 
-	attributes[type] = new OSAttribute(attribute);
+	// Let the store know that the object has changed
+	if (parent != NULL)
+	{
+		parent->objectChanged(slotID, this);
+	}
 
 	return true;
 }
@@ -99,6 +110,14 @@ bool SessionObject::isValid()
 	return valid;
 }
 
+// Retrieve the generation of the object
+unsigned long SessionObject::getGeneration()
+{
+	MutexLocker lock(objectMutex);
+
+	return generation;
+}
+
 bool SessionObject::hasSlotID(CK_SLOT_ID slotID)
 {
 	return this->slotID == slotID;
@@ -66,6 +66,9 @@ public:
 	// The validity state of the object
 	virtual bool isValid();
 
+	// Retrieve the generation of the object
+	virtual unsigned long getGeneration();
+
     bool hasSlotID(CK_SLOT_ID slotID);
 
 	// Called by the session object store when a session is closed. If it's the
@@ -103,6 +106,9 @@ private:
 	// The object's validity state
 	bool valid;
 
+	// The generation of the object; incremented on every change
+	unsigned long generation;
+
 	// Mutex object for thread-safeness
 	Mutex* objectMutex;
 
@@ -84,6 +84,11 @@ SessionObjectStore::~SessionObjectStore()
 		delete that;
 	}
 
+	for (std::map<CK_SLOT_ID, AttributeIndex*>::iterator i = attributeIndices.begin(); i != attributeIndices.end(); i++)
+	{
+		delete i->second;
+	}
+
 	MutexFactory::i()->recycleMutex(storeMutex);
 }
 
@@ -110,6 +115,75 @@ void SessionObjectStore::getObjects(CK_SLOT_ID slotID, std::set<OSObject*> &obje
     }
 }
 
+// Insert the session objects for the given slotID that may match the template
+bool SessionObjectStore::findObjects(CK_SLOT_ID slotID, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, AttributeIndex::Decryptor* decryptor, std::set<OSObject*> &objects)
+{
+	AttributeIndex* attributeIndex;
+
+	{
+		MutexLocker lock(storeMutex);
+
+		attributeIndex = getAttributeIndex(slotID);
+	}
+
+	// The store mutex cannot be held while the index reads object attributes
+	std::set<OSObject*> candidates;
+
+	if (!attributeIndex->findCandidates(pTemplate, ulCount, decryptor, candidates))
+	{
+		return false;
+	}
+
+	// Make sure that no other thread is in the process of changing
+	// the object list when we filter the candidates
+	MutexLocker lock(storeMutex);
+
+	for (std::set<OSObject*>::iterator i = candidates.begin(); i != candidates.end(); i++)
+	{
+		// The index only contains session objects of this store
+		if (this->objects.find((SessionObject*) *i) != this->objects.end())
+		{
+			objects.insert(*i);
+		}
+	}
+
+	return true;
+}
+
+// Called by an object when it has changed
+void SessionObjectStore::objectChanged(CK_SLOT_ID slotID, SessionObject* object)
+{
+	MutexLocker lock(storeMutex);
+
+	getAttributeIndex(slotID)->objectChanged(object);
+}
+
+// Retrieve the attribute index for the given slotID; the store mutex must be held
+AttributeIndex* SessionObjectStore::getAttributeIndex(CK_SLOT_ID slotID)
+{
+	std::map<CK_SLOT_ID, AttributeIndex*>::iterator i = attributeIndices.find(slotID);
+
+	if (i != attributeIndices.end())
+	{
+		return i->second;
+	}
+
+	AttributeIndex* attributeIndex = new AttributeIndex();
+
+	attributeIndices[slotID] = attributeIndex;
+
+	return attributeIndex;
+}
+
+// Remove an object from the attribute indices; the store mutex must be held
+void SessionObjectStore::removeFromIndex(SessionObject* object)
+{
+	for (std::map<CK_SLOT_ID, AttributeIndex*>::iterator i = attributeIndices.begin(); i != attributeIndices.end(); i++)
+	{
+		i->second->objectRemoved(object);
+	}
+}
+
 // Create a new object
 SessionObject* SessionObjectStore::createObject(CK_SLOT_ID slotID, CK_SESSION_HANDLE hSession, bool isPrivate)
 {
@@ -131,6 +205,8 @@ SessionObject* SessionObjectStore::createObject(CK_SLOT_ID slotID, CK_SESSION_HA
 	objects.insert(newObject);
 	allObjects.insert(newObject);
 
+	getAttributeIndex(slotID)->objectChanged(newObject);
+
 	DEBUG_MSG("(0x%08X) Created new object (0x%08X)", this, newObject);
 
 	return newObject;
@@ -152,6 +228,7 @@ bool SessionObjectStore::deleteObject(SessionObject* object)
 	object->invalidate();
 
 	objects.erase(object);
+	removeFromIndex(object);
 
 	return true;
 }
@@ -172,6 +249,7 @@ void SessionObjectStore::sessionClosed(CK_SESSION_HANDLE hSession)
 			// remain valid but it will no longer be returned when the set of objects
 			// is requested
 			objects.erase(*i);
+			removeFromIndex(*i);
 		}
     }
 }
@@ -190,6 +268,7 @@ void SessionObjectStore::allSessionsClosed(CK_SLOT_ID slotID)
             // remain valid but it will no longer be returned when the set of objects
             // is requested
             objects.erase(*i);
+            removeFromIndex(*i);
         }
     }
 }
@@ -208,6 +287,7 @@ void SessionObjectStore::tokenLoggedOut(CK_SLOT_ID slotID)
             // remain valid but it will no longer be returned when the set of objects
             // is requested
             objects.erase(*i);
+            removeFromIndex(*i);
         }
     }
 }
@@ -221,6 +301,11 @@ void SessionObjectStore::clearStore()
 	std::set<SessionObject*> clearObjects = allObjects;
 	allObjects.clear();
 
+	for (std::map<CK_SLOT_ID, AttributeIndex*>::iterator i = attributeIndices.begin(); i != attributeIndices.end(); i++)
+	{
+		i->second->clear();
+	}
+
 	for (std::set<SessionObject*>::iterator i = clearObjects.begin(); i != clearObjects.end(); i++)
 	{
 		delete *i;
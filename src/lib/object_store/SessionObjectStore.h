@@ -38,6 +38,7 @@
 #include "config.h"
 #include "OSAttribute.h"
 #include "SessionObject.h"
+#include "AttributeIndex.h"
 #include "MutexFactory.h"
 #include "cryptoki.h"
 #include <string>
@@ -63,6 +64,11 @@ public:
     // Insert the session objects for the given slotID into the given OSObject set
     void getObjects(CK_SLOT_ID slotID, std::set<OSObject*> &objects);
 
+    // Insert the session objects for the given slotID that may match the template
+    // into the given OSObject set; returns false if the template cannot be resolved
+    // using the attribute index, in which case all objects need to be considered
+    bool findObjects(CK_SLOT_ID slotID, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, AttributeIndex::Decryptor* decryptor, std::set<OSObject*> &objects);
+
 	// Create a new object
     SessionObject* createObject(CK_SLOT_ID slotID, CK_SESSION_HANDLE hSession, bool isPrivate = false);
 
@@ -88,6 +94,18 @@ public:
 	void clearStore();
 
 private:
+    // SessionObject instances can call the objectChanged() function
+    friend class SessionObject;
+
+    // Called by an object when it has changed
+    void objectChanged(CK_SLOT_ID slotID, SessionObject* object);
+
+    // Retrieve the attribute index for the given slotID
+    AttributeIndex* getAttributeIndex(CK_SLOT_ID slotID);
+
+    // Remove an object from the attribute indices
+    void removeFromIndex(SessionObject* object);
+
 #if HAVE_SOS_SINGLETON
     // Constructor
     SessionObjectStore();
@@ -105,6 +123,10 @@ private:
 	// The current list of files
 	std::set<std::string> currentFiles;
 
+	// The attribute indices on the objects; objects are indexed per slot
+	// since private attribute values are encrypted with the token key
+	std::map<CK_SLOT_ID, AttributeIndex*> attributeIndices;
+
 	// For thread safeness
 	Mutex* storeMutex;
 };
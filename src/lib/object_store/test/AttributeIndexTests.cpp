@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ AttributeIndexTests.cpp
+
+ Contains test cases to test the attribute index implementation
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <memory>
+#include "AttributeIndexTests.h"
+#include "AttributeIndex.h"
+#include "SessionObjectStore.h"
+#include "SessionObject.h"
+#include "OSAttribute.h"
+#include "cryptoki.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AttributeIndexTests);
+
+// "Decrypts" values by stripping off the first byte
+class TestDecryptor : public AttributeIndex::Decryptor
+{
+public:
+	virtual bool decrypt(const ByteString& encrypted, ByteString& plaintext)
+	{
+		plaintext = encrypted.substr(1);
+
+		return true;
+	}
+};
+
+static CK_ATTRIBUTE ulongAttribute(CK_ATTRIBUTE_TYPE type, CK_ULONG& value)
+{
+	CK_ATTRIBUTE attr = { type, &value, sizeof(value) };
+	return attr;
+}
+
+static CK_ATTRIBUTE bsAttribute(CK_ATTRIBUTE_TYPE type, ByteString& value)
+{
+	CK_ATTRIBUTE attr = { type, value.byte_str(), value.size() };
+	return attr;
+}
+
+void AttributeIndexTests::setUp()
+{
+}
+
+void AttributeIndexTests::tearDown()
+{
+}
+
+void AttributeIndexTests::testFindObjects()
+{
+	ByteString id1 = "112233445566";
+	ByteString id2 = "AABBCCDDEEFF";
+	CK_ULONG keyClass = CKO_SECRET_KEY;
+	CK_ULONG dataClass = CKO_DATA;
+	CK_BBOOL isToken = CK_FALSE;
+
+	std::auto_ptr<SessionObjectStore> testStore(new SessionObjectStore());
+
+	// Create three public objects
+	SessionObject* obj1 = testStore->createObject(1, 1);
+	SessionObject* obj2 = testStore->createObject(1, 1);
+	SessionObject* obj3 = testStore->createObject(1, 1);
+	CPPUNIT_ASSERT(obj1 != NULL && obj2 != NULL && obj3 != NULL);
+
+	CPPUNIT_ASSERT(obj1->setAttribute(CKA_PRIVATE, false));
+	CPPUNIT_ASSERT(obj1->setAttribute(CKA_CLASS, keyClass));
+	CPPUNIT_ASSERT(obj1->setAttribute(CKA_ID, id1));
+	CPPUNIT_ASSERT(obj2->setAttribute(CKA_PRIVATE, false));
+	CPPUNIT_ASSERT(obj2->setAttribute(CKA_CLASS, keyClass));
+	CPPUNIT_ASSERT(obj2->setAttribute(CKA_ID, id2));
+	CPPUNIT_ASSERT(obj3->setAttribute(CKA_PRIVATE, false));
+	CPPUNIT_ASSERT(obj3->setAttribute(CKA_CLASS, dataClass));
+
+	// Templates without indexed attributes cannot be resolved
+	std::set<OSObject*> objects;
+	CK_ATTRIBUTE tokenTemplate[] = { { CKA_TOKEN, &isToken, sizeof(isToken) } };
+	CPPUNIT_ASSERT(!testStore->findObjects(1, tokenTemplate, 1, NULL, objects));
+
+	// Find by class
+	CK_ATTRIBUTE classTemplate[] = { ulongAttribute(CKA_CLASS, keyClass) };
+	CPPUNIT_ASSERT(testStore->findObjects(1, classTemplate, 1, NULL, objects));
+	CPPUNIT_ASSERT(objects.size() == 2);
+	CPPUNIT_ASSERT(objects.count(obj1) == 1);
+	CPPUNIT_ASSERT(objects.count(obj2) == 1);
+
+	// Find by class and ID
+	objects.clear();
+	CK_ATTRIBUTE idTemplate[] = { ulongAttribute(CKA_CLASS, keyClass), bsAttribute(CKA_ID, id2) };
+	CPPUNIT_ASSERT(testStore->findObjects(1, idTemplate, 2, NULL, objects));
+	CPPUNIT_ASSERT(objects.size() == 1);
+	CPPUNIT_ASSERT(objects.count(obj2) == 1);
+
+	// Objects of other slots are not found
+	objects.clear();
+	CPPUNIT_ASSERT(testStore->findObjects(2, classTemplate, 1, NULL, objects));
+	CPPUNIT_ASSERT(objects.empty());
+
+	// Deleted objects are not found
+	CPPUNIT_ASSERT(testStore->deleteObject(obj2));
+	objects.clear();
+	CPPUNIT_ASSERT(testStore->findObjects(1, idTemplate, 2, NULL, objects));
+	CPPUNIT_ASSERT(objects.empty());
+}
+
+void AttributeIndexTests::testChangedObjects()
+{
+	ByteString label1 = "AABBCC";
+	ByteString label2 = "DDEEFF";
+
+	std::auto_ptr<SessionObjectStore> testStore(new SessionObjectStore());
+
+	SessionObject* obj = testStore->createObject(1, 1);
+	CPPUNIT_ASSERT(obj != NULL);
+	CPPUNIT_ASSERT(obj->setAttribute(CKA_PRIVATE, false));
+	CPPUNIT_ASSERT(obj->setAttribute(CKA_LABEL, label1));
+
+	std::set<OSObject*> objects;
+	CK_ATTRIBUTE template1[] = { bsAttribute(CKA_LABEL, label1) };
+	CK_ATTRIBUTE template2[] = { bsAttribute(CKA_LABEL, label2) };
+
+	CPPUNIT_ASSERT(testStore->findObjects(1, template1, 1, NULL, objects));
+	CPPUNIT_ASSERT(objects.size() == 1);
+
+	// Change the label
+	CPPUNIT_ASSERT(obj->setAttribute(CKA_LABEL, label2));
+
+	objects.clear();
+	CPPUNIT_ASSERT(testStore->findObjects(1, template1, 1, NULL, objects));
+	CPPUNIT_ASSERT(objects.empty());
+
+	CPPUNIT_ASSERT(testStore->findObjects(1, template2, 1, NULL, objects));
+	CPPUNIT_ASSERT(objects.size() == 1);
+	CPPUNIT_ASSERT(objects.count(obj) == 1);
+}
+
+void AttributeIndexTests::testPrivateObjects()
+{
+	ByteString id = "112233";
+	ByteString otherId = "445566";
+	ByteString encryptedId = "00112233";
+	CK_ULONG keyClass = CKO_PRIVATE_KEY;
+	CK_ULONG dataClass = CKO_DATA;
+	TestDecryptor decryptor;
+
+	std::auto_ptr<SessionObjectStore> testStore(new SessionObjectStore());
+
+	SessionObject* obj = testStore->createObject(1, 1, true);
+	CPPUNIT_ASSERT(obj != NULL);
+	CPPUNIT_ASSERT(obj->setAttribute(CKA_PRIVATE, true));
+	CPPUNIT_ASSERT(obj->setAttribute(CKA_CLASS, keyClass));
+	CPPUNIT_ASSERT(obj->setAttribute(CKA_ID, encryptedId));
+
+	std::set<OSObject*> objects;
+	CK_ATTRIBUTE idTemplate[] = { bsAttribute(CKA_ID, id) };
+	CK_ATTRIBUTE otherIdTemplate[] = { bsAttribute(CKA_ID, otherId) };
+	CK_ATTRIBUTE classTemplate[] = { ulongAttribute(CKA_CLASS, dataClass) };
+
+	// Without decryption the object may match any ID, but not any class
+	CPPUNIT_ASSERT(testStore->findObjects(1, otherIdTemplate, 1, NULL, objects));
+	CPPUNIT_ASSERT(objects.size() == 1);
+
+	objects.clear();
+	CPPUNIT_ASSERT(testStore->findObjects(1, classTemplate, 1, NULL, objects));
+	CPPUNIT_ASSERT(objects.empty());
+
+	// Once the object has changed, the plaintext value is indexed
+	CPPUNIT_ASSERT(obj->setAttribute(CKA_ID, encryptedId));
+
+	CPPUNIT_ASSERT(testStore->findObjects(1, otherIdTemplate, 1, &decryptor, objects));
+	CPPUNIT_ASSERT(objects.empty());
+
+	CPPUNIT_ASSERT(testStore->findObjects(1, idTemplate, 1, &decryptor, objects));
+	CPPUNIT_ASSERT(objects.size() == 1);
+	CPPUNIT_ASSERT(objects.count(obj) == 1);
+}
+
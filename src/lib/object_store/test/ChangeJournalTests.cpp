@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ ChangeJournalTests.cpp
+
+ Contains test cases to test the change journal implementation
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "ChangeJournalTests.h"
+#include "ChangeJournal.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ChangeJournalTests);
+
+// FIXME: all pathnames in this file are *NIX/BSD specific
+
+void ChangeJournalTests::setUp()
+{
+	// FIXME: this only works on *NIX/BSD, not on other platforms
+	CPPUNIT_ASSERT(!system("mkdir testdir"));
+}
+
+void ChangeJournalTests::tearDown()
+{
+	// FIXME: this only works on *NIX/BSD, not on other platforms
+	CPPUNIT_ASSERT(!system("rm -rf testdir"));
+}
+
+void ChangeJournalTests::testAppendRead()
+{
+	ChangeJournal writer("testdir/journal");
+	ChangeJournal reader("testdir/journal");
+
+	CPPUNIT_ASSERT(writer.isValid());
+	CPPUNIT_ASSERT(reader.isValid());
+
+	std::vector<ChangeJournal::Change> changes;
+	bool isReset = false;
+
+	// The first read always requires a rescan
+	CPPUNIT_ASSERT(reader.readChanges(changes, isReset));
+	CPPUNIT_ASSERT(isReset);
+	CPPUNIT_ASSERT(changes.empty());
+
+	// Nothing has changed since
+	CPPUNIT_ASSERT(reader.readChanges(changes, isReset));
+	CPPUNIT_ASSERT(!isReset);
+	CPPUNIT_ASSERT(changes.empty());
+
+	// Record some changes
+	CPPUNIT_ASSERT(writer.append(ChangeJournal::OBJECT_CREATED, "1.object"));
+	CPPUNIT_ASSERT(writer.append(ChangeJournal::OBJECT_MODIFIED, "1.object"));
+	CPPUNIT_ASSERT(writer.append(ChangeJournal::OBJECT_DELETED, "2.object"));
+
+	CPPUNIT_ASSERT(reader.readChanges(changes, isReset));
+	CPPUNIT_ASSERT(!isReset);
+	CPPUNIT_ASSERT(changes.size() == 3);
+	CPPUNIT_ASSERT(changes[0].type == ChangeJournal::OBJECT_CREATED);
+	CPPUNIT_ASSERT(changes[0].filename == "1.object");
+	CPPUNIT_ASSERT(changes[1].type == ChangeJournal::OBJECT_MODIFIED);
+	CPPUNIT_ASSERT(changes[1].filename == "1.object");
+	CPPUNIT_ASSERT(changes[2].type == ChangeJournal::OBJECT_DELETED);
+	CPPUNIT_ASSERT(changes[2].filename == "2.object");
+
+	// Only new records are returned
+	changes.clear();
+
+	CPPUNIT_ASSERT(writer.append(ChangeJournal::OBJECT_CREATED, "3.object"));
+
+	CPPUNIT_ASSERT(reader.readChanges(changes, isReset));
+	CPPUNIT_ASSERT(!isReset);
+	CPPUNIT_ASSERT(changes.size() == 1);
+	CPPUNIT_ASSERT(changes[0].filename == "3.object");
+}
+
+void ChangeJournalTests::testReset()
+{
+	// Use a very small maximum size so that the journal is started over
+	ChangeJournal writer("testdir/journal", 64);
+	ChangeJournal reader("testdir/journal");
+
+	std::vector<ChangeJournal::Change> changes;
+	bool isReset = false;
+
+	CPPUNIT_ASSERT(reader.readChanges(changes, isReset));
+	CPPUNIT_ASSERT(isReset);
+
+	CPPUNIT_ASSERT(writer.append(ChangeJournal::OBJECT_CREATED, "1.object"));
+
+	CPPUNIT_ASSERT(reader.readChanges(changes, isReset));
+	CPPUNIT_ASSERT(!isReset);
+	CPPUNIT_ASSERT(changes.size() == 1);
+
+	// This record no longer fits and starts a new epoch
+	changes.clear();
+
+	CPPUNIT_ASSERT(writer.append(ChangeJournal::OBJECT_CREATED, "2.object"));
+
+	CPPUNIT_ASSERT(reader.readChanges(changes, isReset));
+	CPPUNIT_ASSERT(isReset);
+	CPPUNIT_ASSERT(changes.empty());
+
+	// The reader continues from the new epoch
+	CPPUNIT_ASSERT(reader.readChanges(changes, isReset));
+	CPPUNIT_ASSERT(!isReset);
+	CPPUNIT_ASSERT(changes.empty());
+}
+
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ DBTokenTests.cpp
+
+ Contains test cases to test the single-file token database implementation
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "DBTokenTests.h"
+#include "DBToken.h"
+#include "DBObject.h"
+#include "ObjectStoreToken.h"
+#include "OSAttribute.h"
+#include "OSAttributes.h"
+#include "cryptoki.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DBTokenTests);
+
+// FIXME: all pathnames in this file are *NIX/BSD specific
+
+void DBTokenTests::setUp()
+{
+	CPPUNIT_ASSERT(!system("mkdir testdir"));
+}
+
+void DBTokenTests::tearDown()
+{
+	CPPUNIT_ASSERT(!system("rm -rf testdir"));
+}
+
+void DBTokenTests::testNewToken()
+{
+	ByteString label = "40414243"; // ABCD
+	ByteString serial = "0102030405060708";
+
+	DBToken* newToken = DBToken::createToken("./testdir", "newToken", label, serial);
+
+	CPPUNIT_ASSERT(newToken != NULL);
+	CPPUNIT_ASSERT(newToken->isValid());
+
+	// Check the flags
+	CK_ULONG flags;
+	CPPUNIT_ASSERT(newToken->getTokenFlags(flags));
+	CPPUNIT_ASSERT(flags == (CKF_RNG | CKF_LOGIN_REQUIRED | CKF_RESTORE_KEY_NOT_NEEDED | CKF_TOKEN_INITIALIZED | CKF_SO_PIN_LOCKED | CKF_SO_PIN_TO_BE_CHANGED));
+
+	// Set the PINs
+	ByteString soPIN = "3132333435363738"; // 12345678
+	ByteString userPIN = "31323334"; // 1234
+
+	CPPUNIT_ASSERT(newToken->setSOPIN(soPIN));
+	CPPUNIT_ASSERT(newToken->setUserPIN(userPIN));
+
+	delete newToken;
+
+	// The token is opened using the backend it was created with
+	CPPUNIT_ASSERT(DBToken::isDBToken("./testdir/newToken"));
+
+	ObjectStoreToken* reopenedToken = ObjectStoreToken::accessToken("./testdir", "newToken");
+
+	CPPUNIT_ASSERT(reopenedToken != NULL);
+	CPPUNIT_ASSERT(reopenedToken->isValid());
+
+	ByteString retrievedLabel, retrievedSerial, retrievedSOPIN, retrievedUserPIN;
+
+	CPPUNIT_ASSERT(reopenedToken->getTokenLabel(retrievedLabel));
+	CPPUNIT_ASSERT(reopenedToken->getTokenSerial(retrievedSerial));
+	CPPUNIT_ASSERT(reopenedToken->getSOPIN(retrievedSOPIN));
+	CPPUNIT_ASSERT(reopenedToken->getUserPIN(retrievedUserPIN));
+	CPPUNIT_ASSERT(reopenedToken->getTokenFlags(flags));
+
+	CPPUNIT_ASSERT(retrievedLabel == label);
+	CPPUNIT_ASSERT(retrievedSerial == serial);
+	CPPUNIT_ASSERT(retrievedSOPIN == soPIN);
+	CPPUNIT_ASSERT(retrievedUserPIN == userPIN);
+	CPPUNIT_ASSERT(flags == (CKF_RNG | CKF_LOGIN_REQUIRED | CKF_RESTORE_KEY_NOT_NEEDED | CKF_TOKEN_INITIALIZED | CKF_USER_PIN_INITIALIZED));
+
+	delete reopenedToken;
+}
+
+void DBTokenTests::testCreateDeleteObjects()
+{
+	ByteString label = "40414243"; // ABCD
+	ByteString serial = "0102030405060708";
+	ByteString id1 = "ABCDEF";
+	ByteString id2 = "FEDCBA";
+	ByteString id3 = "AABBCC";
+
+	DBToken* testToken = DBToken::createToken("./testdir", "testToken", label, serial);
+
+	CPPUNIT_ASSERT(testToken != NULL);
+
+	// Open a second instance of the same token
+	DBToken sameToken("./testdir/testToken");
+
+	CPPUNIT_ASSERT(sameToken.isValid());
+
+	// Create objects in one transaction each
+	DBObject* obj1 = testToken->createObject();
+	DBObject* obj2 = testToken->createObject();
+	DBObject* obj3 = testToken->createObject();
+
+	CPPUNIT_ASSERT((obj1 != NULL) && (obj2 != NULL) && (obj3 != NULL));
+
+	OSAttribute idAtt1(id1), idAtt2(id2), idAtt3(id3);
+	bool value = true;
+	OSAttribute tokenAtt(value);
+
+	CPPUNIT_ASSERT(obj1->startTransaction());
+	CPPUNIT_ASSERT(obj1->setAttribute(CKA_ID, idAtt1));
+	CPPUNIT_ASSERT(obj1->setAttribute(CKA_TOKEN, tokenAtt));
+	CPPUNIT_ASSERT(obj1->commitTransaction());
+	CPPUNIT_ASSERT(obj2->setAttribute(CKA_ID, idAtt2));
+	CPPUNIT_ASSERT(obj3->setAttribute(CKA_ID, idAtt3));
+
+	// Check that the other instance sees the objects
+	std::set<OSObject*> objects;
+
+	sameToken.getObjects(objects);
+
+	CPPUNIT_ASSERT(objects.size() == 3);
+
+	bool found1 = false, found2 = false, found3 = false;
+
+	for (std::set<OSObject*>::iterator i = objects.begin(); i != objects.end(); i++)
+	{
+		CPPUNIT_ASSERT((*i)->isValid());
+
+		ByteString id = (*i)->getAttribute(CKA_ID)->getByteStringValue();
+
+		if (id == id1) found1 = true;
+		if (id == id2) found2 = true;
+		if (id == id3) found3 = true;
+	}
+
+	CPPUNIT_ASSERT(found1 && found2 && found3);
+
+	// Modify and delete objects on the first instance
+	CPPUNIT_ASSERT(obj1->setAttribute(CKA_ID, idAtt3));
+	CPPUNIT_ASSERT(testToken->deleteObject(obj3));
+
+	// Check that the other instance sees the changes
+	objects.clear();
+	sameToken.getObjects(objects);
+
+	CPPUNIT_ASSERT(objects.size() == 2);
+
+	for (std::set<OSObject*>::iterator i = objects.begin(); i != objects.end(); i++)
+	{
+		if ((*i)->attributeExists(CKA_TOKEN))
+		{
+			CPPUNIT_ASSERT((*i)->getAttribute(CKA_ID)->getByteStringValue() == id3);
+		}
+		else
+		{
+			CPPUNIT_ASSERT((*i)->getAttribute(CKA_ID)->getByteStringValue() == id2);
+		}
+	}
+
+	// Aborting a transaction restores the stored version
+	CPPUNIT_ASSERT(obj2->startTransaction());
+	CPPUNIT_ASSERT(obj2->setAttribute(CKA_ID, idAtt1));
+	CPPUNIT_ASSERT(obj2->abortTransaction());
+	CPPUNIT_ASSERT(obj2->getAttribute(CKA_ID)->getByteStringValue() == id2);
+
+	delete testToken;
+
+	// A reopened token contains the same objects
+	DBToken reopenedToken("./testdir/testToken");
+
+	objects.clear();
+	reopenedToken.getObjects(objects);
+
+	CPPUNIT_ASSERT(objects.size() == 2);
+}
+
+void DBTokenTests::testCompaction()
+{
+	ByteString label = "40414243"; // ABCD
+	ByteString serial = "0102030405060708";
+
+	DBToken* testToken = DBToken::createToken("./testdir", "testToken", label, serial);
+
+	CPPUNIT_ASSERT(testToken != NULL);
+
+	DBToken sameToken("./testdir/testToken");
+
+	DBObject* obj = testToken->createObject();
+
+	CPPUNIT_ASSERT(obj != NULL);
+
+	// Update the object often enough for the database to be compacted
+	struct stat dbStat;
+	off_t maxSize = 0;
+
+	for (unsigned long i = 0; i < 3000; i++)
+	{
+		OSAttribute valueAtt(i);
+
+		CPPUNIT_ASSERT(obj->setAttribute(CKA_VALUE_LEN, valueAtt));
+
+		CPPUNIT_ASSERT(!stat("./testdir/testToken/token.db", &dbStat));
+
+		if (dbStat.st_size > maxSize) maxSize = dbStat.st_size;
+	}
+
+	CPPUNIT_ASSERT(dbStat.st_size < maxSize);
+
+	// The other instance picks up the compacted database
+	std::set<OSObject*> objects;
+
+	sameToken.getObjects(objects);
+
+	CPPUNIT_ASSERT(objects.size() == 1);
+	CPPUNIT_ASSERT((*objects.begin())->getAttribute(CKA_VALUE_LEN)->getUnsignedLongValue() == 2999);
+
+	ByteString retrievedLabel;
+
+	CPPUNIT_ASSERT(sameToken.getTokenLabel(retrievedLabel));
+	CPPUNIT_ASSERT(retrievedLabel == label);
+
+	delete testToken;
+}
+
+void DBTokenTests::testDamagedRecord()
+{
+	ByteString label = "40414243"; // ABCD
+	ByteString serial = "0102030405060708";
+	ByteString id = "ABCDEF";
+
+	DBToken* testToken = DBToken::createToken("./testdir", "testToken", label, serial);
+
+	CPPUNIT_ASSERT(testToken != NULL);
+
+	DBObject* obj = testToken->createObject();
+	OSAttribute idAtt(id);
+
+	CPPUNIT_ASSERT(obj != NULL);
+	CPPUNIT_ASSERT(obj->setAttribute(CKA_ID, idAtt));
+
+	delete testToken;
+
+	// Simulate an incompletely written record
+	CPPUNIT_ASSERT(!system("printf '\\000\\000\\000\\000\\000\\000\\001\\000garbage' >> testdir/testToken/token.db"));
+
+	DBToken reopenedToken("./testdir/testToken");
+
+	CPPUNIT_ASSERT(reopenedToken.isValid());
+
+	std::set<OSObject*> objects;
+
+	reopenedToken.getObjects(objects);
+
+	CPPUNIT_ASSERT(objects.size() == 1);
+	CPPUNIT_ASSERT((*objects.begin())->getAttribute(CKA_ID)->getByteStringValue() == id);
+
+	// New records replace the damaged one
+	CPPUNIT_ASSERT(reopenedToken.createObject() != NULL);
+
+	DBToken sameToken("./testdir/testToken");
+
+	objects.clear();
+	sameToken.getObjects(objects);
+
+	CPPUNIT_ASSERT(objects.size() == 2);
+}
+
+void DBTokenTests::testClearToken()
+{
+	ByteString label = "40414243"; // ABCD
+	ByteString serial = "0102030405060708";
+
+	DBToken* testToken = DBToken::createToken("./testdir", "testToken", label, serial);
+
+	CPPUNIT_ASSERT(testToken != NULL);
+	CPPUNIT_ASSERT(testToken->createObject() != NULL);
+
+	CPPUNIT_ASSERT(testToken->clearToken());
+	CPPUNIT_ASSERT(!testToken->isValid());
+
+	struct stat dirStat;
+
+	CPPUNIT_ASSERT(stat("./testdir/testToken", &dirStat));
+
+	delete testToken;
+}
+
+
+void DBTokenTests::testConcurrentTransaction()
+{
+	ByteString label = "40414243"; // ABCD
+	ByteString serial = "0102030405060708";
+	ByteString id = "ABCDEF";
+	ByteString objectLabel = "414243"; // ABC
+
+	DBToken* testToken = DBToken::createToken("./testdir", "testToken", label, serial);
+
+	CPPUNIT_ASSERT(testToken != NULL);
+
+	DBObject* obj = testToken->createObject();
+
+	CPPUNIT_ASSERT(obj != NULL);
+
+	// Open a second instance of the same token
+	DBToken sameToken("./testdir/testToken");
+
+	std::set<OSObject*> objects;
+	sameToken.getObjects(objects);
+
+	CPPUNIT_ASSERT(objects.size() == 1);
+
+	DBObject* sameObj = (DBObject*) *objects.begin();
+
+	// Change the object in a transaction while the other instance changes it
+	OSAttribute idAtt(id), labelAtt(objectLabel);
+	OSAttribute trueAtt(true), falseAtt(false);
+
+	CPPUNIT_ASSERT(obj->startTransaction());
+	CPPUNIT_ASSERT(obj->setAttribute(CKA_ID, idAtt));
+	CPPUNIT_ASSERT(obj->setAttribute(CKA_TOKEN, trueAtt));
+
+	CPPUNIT_ASSERT(sameObj->setAttribute(CKA_LABEL, labelAtt));
+	CPPUNIT_ASSERT(sameObj->setAttribute(CKA_TOKEN, falseAtt));
+
+	CPPUNIT_ASSERT(obj->commitTransaction());
+
+	// The changes of the other instance are kept, except where the
+	// transaction set the same attribute
+	CPPUNIT_ASSERT(obj->attributeExists(CKA_LABEL));
+	CPPUNIT_ASSERT(obj->getAttribute(CKA_LABEL)->getByteStringValue() == objectLabel);
+
+	delete testToken;
+
+	DBToken reopenedToken("./testdir/testToken");
+
+	objects.clear();
+	reopenedToken.getObjects(objects);
+
+	CPPUNIT_ASSERT(objects.size() == 1);
+
+	OSObject* reopenedObj = *objects.begin();
+
+	CPPUNIT_ASSERT(reopenedObj->getAttribute(CKA_ID)->getByteStringValue() == id);
+	CPPUNIT_ASSERT(reopenedObj->getAttribute(CKA_LABEL)->getByteStringValue() == objectLabel);
+	CPPUNIT_ASSERT(reopenedObj->getAttribute(CKA_TOKEN)->getBooleanValue());
+}
@@ -32,6 +32,8 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sstream>
 #include <cppunit/extensions/HelperMacros.h>
 #include "OSTokenTests.h"
 #include "OSToken.h"
@@ -40,6 +42,7 @@
 #include "Directory.h"
 #include "OSAttribute.h"
 #include "OSAttributes.h"
+#include "WorkerPool.h"
 #include "cryptoki.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(OSTokenTests);
@@ -440,3 +443,111 @@ void OSTokenTests::testClearToken()
 	CPPUNIT_ASSERT(!clearedToken.isValid());
 }
 
+void OSTokenTests::testLazyLoading()
+{
+	ByteString label = "40414243"; // ABCD
+	ByteString serial = "0102030405060708";
+
+	OSToken* testToken = OSToken::createToken("./testdir", "testToken", label, serial);
+
+	CPPUNIT_ASSERT(testToken != NULL);
+
+	// Create a number of objects with a distinct value each
+	for (unsigned long i = 0; i < 64; i++)
+	{
+		ObjectFile* obj = testToken->createObject();
+		OSAttribute valueAtt(i);
+
+		CPPUNIT_ASSERT(obj != NULL);
+		CPPUNIT_ASSERT(obj->setAttribute(CKA_VALUE_LEN, valueAtt));
+	}
+
+	delete testToken;
+
+	// Load the objects using worker threads
+	WorkerPool::i()->setMaxThreads(4);
+	WorkerPool::i()->enable();
+
+	OSToken reopenedToken("./testdir/testToken");
+
+	CPPUNIT_ASSERT(reopenedToken.isValid());
+
+	// Retrieving all objects reads them in parallel
+	std::set<ObjectFile*> objects = reopenedToken.getObjects();
+
+	WorkerPool::i()->disable();
+
+	CPPUNIT_ASSERT(objects.size() == 64);
+
+	std::set<unsigned long> values;
+
+	for (std::set<ObjectFile*>::iterator i = objects.begin(); i != objects.end(); i++)
+	{
+		CPPUNIT_ASSERT((*i)->isLoaded());
+		CPPUNIT_ASSERT((*i)->isValid());
+		CPPUNIT_ASSERT((*i)->attributeExists(CKA_VALUE_LEN));
+
+		values.insert((*i)->getAttribute(CKA_VALUE_LEN)->getUnsignedLongValue());
+	}
+
+	CPPUNIT_ASSERT(values.size() == 64);
+	CPPUNIT_ASSERT(*values.rbegin() == 63);
+}
+
+static bool fileExists(Directory& dir, const std::string& name)
+{
+	CPPUNIT_ASSERT(dir.refresh());
+
+	std::vector<std::string> files = dir.getFiles();
+
+	for (std::vector<std::string>::iterator i = files.begin(); i != files.end(); i++)
+	{
+		if (!i->compare(name))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void OSTokenTests::testTemporaryFiles()
+{
+	ByteString label = "40414243"; // ABCD
+	ByteString serial = "0102030405060708";
+
+	OSToken* testToken = OSToken::createToken("./testdir", "testToken", label, serial);
+
+	CPPUNIT_ASSERT(testToken != NULL);
+
+	ObjectFile* obj = testToken->createObject();
+
+	CPPUNIT_ASSERT(obj != NULL);
+
+	std::string lockFilename = obj->getLockFilename();
+
+	delete testToken;
+
+	Directory tokenDir("./testdir/testToken");
+
+	CPPUNIT_ASSERT(fileExists(tokenDir, lockFilename));
+
+	// Leave temporary files behind for a process that no longer exists and
+	// for this process, which may still be writing
+	std::ostringstream liveName;
+	liveName << "live.object." << getpid() << ".tmp";
+
+	CPPUNIT_ASSERT(!system("touch testdir/testToken/dead.object.999999999.tmp"));
+	CPPUNIT_ASSERT(!system(("touch testdir/testToken/" + liveName.str()).c_str()));
+
+	OSToken reopenedToken("./testdir/testToken");
+
+	CPPUNIT_ASSERT(reopenedToken.isValid());
+	CPPUNIT_ASSERT(reopenedToken.getObjects().size() == 1);
+	CPPUNIT_ASSERT(!fileExists(tokenDir, "dead.object.999999999.tmp"));
+	CPPUNIT_ASSERT(fileExists(tokenDir, liveName.str()));
+
+	// Deleting the object also removes its lock file
+	CPPUNIT_ASSERT(reopenedToken.deleteObject(*reopenedToken.getObjects().begin()));
+	CPPUNIT_ASSERT(!fileExists(tokenDir, lockFilename));
+}
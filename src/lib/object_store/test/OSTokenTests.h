@@ -43,6 +43,8 @@ class OSTokenTests : public CppUnit::TestFixture
 	CPPUNIT_TEST(testNonExistentToken);
 	CPPUNIT_TEST(testCreateDeleteObjects);
 	CPPUNIT_TEST(testClearToken);
+	CPPUNIT_TEST(testLazyLoading);
+	CPPUNIT_TEST(testTemporaryFiles);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -51,6 +53,8 @@ public:
 	void testNonExistentToken();
 	void testCreateDeleteObjects();
 	void testClearToken();
+	void testLazyLoading();
+	void testTemporaryFiles();
 
 	void setUp();
 	void tearDown();
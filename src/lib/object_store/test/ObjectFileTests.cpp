@@ -31,6 +31,7 @@
  *****************************************************************************/
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <cppunit/extensions/HelperMacros.h>
 #include "ObjectFileTests.h"
@@ -493,6 +494,65 @@ void ObjectFileTests::testCorruptFile()
 	CPPUNIT_ASSERT(!testObject.isValid());
 }
 
+void ObjectFileTests::testOriginalFormat()
+{
+	ByteString value3 = "0102030405060708090A0B0C0D0E0F";
+
+	// Write an object file in the original format
+	{
+		File objectFile("testdir/testobject", false, true, true);
+
+		CPPUNIT_ASSERT(objectFile.isValid());
+
+		CPPUNIT_ASSERT(objectFile.writeULong(CKA_TOKEN));
+		CPPUNIT_ASSERT(objectFile.writeULong(0x1));
+		CPPUNIT_ASSERT(objectFile.writeBool(true));
+		CPPUNIT_ASSERT(objectFile.writeULong(CKA_PRIME_BITS));
+		CPPUNIT_ASSERT(objectFile.writeULong(0x2));
+		CPPUNIT_ASSERT(objectFile.writeULong(0x12345678));
+		CPPUNIT_ASSERT(objectFile.writeULong(CKA_VALUE_BITS));
+		CPPUNIT_ASSERT(objectFile.writeULong(0x3));
+		CPPUNIT_ASSERT(objectFile.writeByteString(value3));
+	}
+
+	// Check that it can still be read
+	{
+		ObjectFile testObject(NULL, "testdir/testobject");
+
+		// The file is only read when the object is first used
+		CPPUNIT_ASSERT(!testObject.isLoaded());
+		CPPUNIT_ASSERT(testObject.isValid());
+		CPPUNIT_ASSERT(testObject.isLoaded());
+		CPPUNIT_ASSERT(testObject.getAttribute(CKA_TOKEN)->getBooleanValue());
+		CPPUNIT_ASSERT(testObject.getAttribute(CKA_PRIME_BITS)->getUnsignedLongValue() == 0x12345678);
+		CPPUNIT_ASSERT(testObject.getAttribute(CKA_VALUE_BITS)->getByteStringValue() == value3);
+
+		// Writing the object back converts it to the indexed format
+		OSAttribute attr(false);
+
+		CPPUNIT_ASSERT(testObject.setAttribute(CKA_TOKEN, attr));
+	}
+
+	FILE* stream = fopen("testdir/testobject", "r");
+	char magic[8];
+
+	CPPUNIT_ASSERT(stream != NULL);
+	CPPUNIT_ASSERT(fread(magic, 1, 8, stream) == 8);
+	CPPUNIT_ASSERT(!memcmp(magic, "SHSM-OBJ", 8));
+
+	fclose(stream);
+
+	// Check that the converted object holds the same attributes
+	ObjectFile testObject(NULL, "testdir/testobject");
+
+	CPPUNIT_ASSERT(testObject.isValid());
+	CPPUNIT_ASSERT(testObject.attributeExists(CKA_VALUE_BITS));
+	CPPUNIT_ASSERT(!testObject.attributeExists(CKA_LABEL));
+	CPPUNIT_ASSERT(!testObject.getAttribute(CKA_TOKEN)->getBooleanValue());
+	CPPUNIT_ASSERT(testObject.getAttribute(CKA_PRIME_BITS)->getUnsignedLongValue() == 0x12345678);
+	CPPUNIT_ASSERT(testObject.getAttribute(CKA_VALUE_BITS)->getByteStringValue() == value3);
+}
+
 void ObjectFileTests::testTransactions()
 {
 	// Create test object instance
@@ -620,6 +680,59 @@ void ObjectFileTests::testTransactions()
 	CPPUNIT_ASSERT(testObject2.getAttribute(CKA_VALUE_BITS)->getByteStringValue() == value3a);
 }
 
+void ObjectFileTests::testNestedTransactions()
+{
+	// Create test object instance
+	ObjectFile testObject(NULL, "testdir/testobject", true);
+
+	CPPUNIT_ASSERT(testObject.isValid());
+
+	unsigned long value1 = 0x12345678;
+	unsigned long value2 = 0x87654321;
+
+	OSAttribute attr1(value1);
+	OSAttribute attr2(value2);
+
+	CPPUNIT_ASSERT(testObject.setAttribute(CKA_PRIME_BITS, attr1));
+
+	// Create secondary instance for the same object
+	ObjectFile testObject2(NULL, "testdir/testobject");
+
+	CPPUNIT_ASSERT(testObject2.isValid());
+	CPPUNIT_ASSERT(testObject2.getAttribute(CKA_PRIME_BITS)->getUnsignedLongValue() == value1);
+
+	// Changes are only written back when the outermost transaction commits
+	CPPUNIT_ASSERT(testObject.startTransaction());
+	CPPUNIT_ASSERT(testObject.setAttribute(CKA_PRIME_BITS, attr2));
+	CPPUNIT_ASSERT(testObject.startTransaction());
+	CPPUNIT_ASSERT(testObject.setAttribute(CKA_VALUE_BITS, attr2));
+	CPPUNIT_ASSERT(testObject.commitTransaction());
+
+	CPPUNIT_ASSERT(testObject2.getAttribute(CKA_PRIME_BITS)->getUnsignedLongValue() == value1);
+	CPPUNIT_ASSERT(!testObject2.attributeExists(CKA_VALUE_BITS));
+
+	CPPUNIT_ASSERT(testObject.commitTransaction());
+
+	CPPUNIT_ASSERT(testObject2.getAttribute(CKA_PRIME_BITS)->getUnsignedLongValue() == value2);
+	CPPUNIT_ASSERT(testObject2.getAttribute(CKA_VALUE_BITS)->getUnsignedLongValue() == value2);
+
+	// Aborting a nested transaction fails the outermost commit
+	CPPUNIT_ASSERT(testObject.startTransaction());
+	CPPUNIT_ASSERT(testObject.setAttribute(CKA_PRIME_BITS, attr1));
+	CPPUNIT_ASSERT(testObject.startTransaction());
+	CPPUNIT_ASSERT(testObject.abortTransaction());
+	CPPUNIT_ASSERT(!testObject.commitTransaction());
+
+	CPPUNIT_ASSERT(testObject.getAttribute(CKA_PRIME_BITS)->getUnsignedLongValue() == value2);
+	CPPUNIT_ASSERT(testObject2.getAttribute(CKA_PRIME_BITS)->getUnsignedLongValue() == value2);
+
+	// Setting an unchanged value does not rewrite the object
+	unsigned long generation = testObject.getGeneration();
+
+	CPPUNIT_ASSERT(testObject.setAttribute(CKA_PRIME_BITS, attr2));
+	CPPUNIT_ASSERT(testObject.getGeneration() == generation);
+}
+
 void ObjectFileTests::testDestroyObjectFails()
 {
 	// Create test object instance
@@ -45,7 +45,9 @@ class ObjectFileTests : public CppUnit::TestFixture
 	CPPUNIT_TEST(testDoubleAttr);
 	CPPUNIT_TEST(testRefresh);
 	CPPUNIT_TEST(testCorruptFile);
+	CPPUNIT_TEST(testOriginalFormat);
 	CPPUNIT_TEST(testTransactions);
+	CPPUNIT_TEST(testNestedTransactions);
 	CPPUNIT_TEST(testDestroyObjectFails);
 	CPPUNIT_TEST_SUITE_END();
 
@@ -57,7 +59,9 @@ public:
 	void testDoubleAttr();
 	void testRefresh();
 	void testCorruptFile();
+	void testOriginalFormat();
 	void testTransactions();
+	void testNestedTransactions();
 	void testDestroyObjectFails();
 
 	void setUp();
@@ -47,8 +47,11 @@ Session::Session(Slot* slot, bool isReadWrite, CK_VOID_PTR pApplication, CK_NOTI
 	digestOp = NULL;
 	macOp = NULL;
 	asymmetricCryptoOp = NULL;
+	symmetricCryptoOp = NULL;
 	publicKey = NULL;
 	privateKey = NULL;
+	keyObject = NULL;
+	keyGeneration = 0;
 	symmetricKey = NULL;
 }
 
@@ -66,8 +69,11 @@ Session::Session()
 	digestOp = NULL;
 	macOp = NULL;
 	asymmetricCryptoOp = NULL;
+	symmetricCryptoOp = NULL;
 	publicKey = NULL;
 	privateKey = NULL;
+	keyObject = NULL;
+	keyGeneration = 0;
 	symmetricKey = NULL;
 }
 
@@ -180,16 +186,26 @@ void Session::resetOp()
 	}
 	else if (asymmetricCryptoOp != NULL)
 	{
+		// Keys built from an object go back to the key cache if possible
 		if (publicKey != NULL)
 		{
-			asymmetricCryptoOp->recyclePublicKey(publicKey);
+			if (keyObject == NULL || token == NULL ||
+			    !token->cachePublicKey(keyObject, keyGeneration, keyAlgorithm, publicKey))
+			{
+				asymmetricCryptoOp->recyclePublicKey(publicKey);
+			}
 			publicKey = NULL;
 		}
 		if (privateKey != NULL)
 		{
-			asymmetricCryptoOp->recyclePrivateKey(privateKey);
+			if (keyObject == NULL || token == NULL ||
+			    !token->cachePrivateKey(keyObject, keyGeneration, keyAlgorithm, privateKey))
+			{
+				asymmetricCryptoOp->recyclePrivateKey(privateKey);
+			}
 			privateKey = NULL;
 		}
+		keyObject = NULL;
 		CryptoFactory::i()->recycleAsymmetricAlgorithm(asymmetricCryptoOp);
 		asymmetricCryptoOp = NULL;
 	}
@@ -203,6 +219,16 @@ void Session::resetOp()
 		CryptoFactory::i()->recycleMacAlgorithm(macOp);
 		macOp = NULL;
 	}
+	else if (symmetricCryptoOp != NULL)
+	{
+		if (symmetricKey != NULL)
+		{
+			symmetricCryptoOp->recycleKey(symmetricKey);
+			symmetricKey = NULL;
+		}
+		CryptoFactory::i()->recycleSymmetricAlgorithm(symmetricCryptoOp);
+		symmetricCryptoOp = NULL;
+	}
 
 	operation = SESSION_OP_NONE;
 }
@@ -272,6 +298,22 @@ AsymmetricAlgorithm *Session::getAsymmetricCryptoOp()
 	return asymmetricCryptoOp;
 }
 
+void Session::setSymmetricCryptoOp(SymmetricAlgorithm *symmetricCryptoOp)
+{
+	if (this->symmetricCryptoOp != NULL)
+	{
+		setSymmetricKey(NULL);
+		CryptoFactory::i()->recycleSymmetricAlgorithm(this->symmetricCryptoOp);
+	}
+
+	this->symmetricCryptoOp = symmetricCryptoOp;
+}
+
+SymmetricAlgorithm *Session::getSymmetricCryptoOp()
+{
+	return symmetricCryptoOp;
+}
+
 void Session::setMechanism(const char *mechanism)
 {
 	this->mechanism = mechanism;
@@ -338,14 +380,24 @@ PrivateKey* Session::getPrivateKey()
 	return privateKey;
 }
 
+void Session::setKeyOrigin(OSObject* object, unsigned long generation, const std::string& algorithm)
+{
+	keyObject = object;
+	keyGeneration = generation;
+	keyAlgorithm = algorithm;
+}
+
 void Session::setSymmetricKey(SymmetricKey* symmetricKey)
 {
-	if (macOp == NULL)
+	if (macOp == NULL && symmetricCryptoOp == NULL)
 		return;
 
 	if (this->symmetricKey != NULL)
 	{
-		macOp->recycleKey(symmetricKey);
+		if (macOp != NULL)
+			macOp->recycleKey(this->symmetricKey);
+		else
+			symmetricCryptoOp->recycleKey(this->symmetricKey);
 	}
 
 	this->symmetricKey = symmetricKey;
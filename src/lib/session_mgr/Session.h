@@ -94,6 +94,10 @@ public:
 	void setAsymmetricCryptoOp(AsymmetricAlgorithm* asymmetricCryptoOp);
 	AsymmetricAlgorithm* getAsymmetricCryptoOp();
 
+	// Symmetric Crypto
+	void setSymmetricCryptoOp(SymmetricAlgorithm* symmetricCryptoOp);
+	SymmetricAlgorithm* getSymmetricCryptoOp();
+
 	void setMechanism(const char *mechanism);
 	const char *getMechanism();
 
@@ -109,6 +113,10 @@ public:
 	void setPrivateKey(PrivateKey* privateKey);
 	PrivateKey* getPrivateKey();
 
+	// Remember the object the key of the operation was built from; the
+	// key is handed back to the key cache of the token when the operation ends
+	void setKeyOrigin(OSObject* object, unsigned long generation, const std::string& algorithm);
+
 	void setSymmetricKey(SymmetricKey* symmetricKey);
 	SymmetricKey* getSymmetricKey();
 
@@ -147,8 +155,12 @@ private:
 	bool allowSinglePartOp;
 	PublicKey* publicKey;
 	PrivateKey* privateKey;
+	OSObject* keyObject;
+	unsigned long keyGeneration;
+	std::string keyAlgorithm;
 
 	// Symmetric Crypto
+	SymmetricAlgorithm* symmetricCryptoOp;
 	SymmetricKey* symmetricKey;
 };
 
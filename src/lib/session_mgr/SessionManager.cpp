@@ -30,8 +30,10 @@
  Keeps track of the sessions within SoftHSM. The sessions are stored in a 
  vector. When a session is closed, its spot in the vector will be replaced
  with NULL. Because we want to keep track of the session ID which is 
- equal to its location in the vector. New sessions will first fill up the NULL
- locations and if there is no empty spots, then they are added to the end.
+ equal to its location in the vector. The empty spots are kept on a free
+ list and are reused by new sessions; if there are no empty spots, new
+ sessions are added to the end. The number of open (read-only) sessions is
+ counted per slot, so closing a session does not need to look at the others.
  *****************************************************************************/
 
 #include "SessionManager.h"
@@ -89,24 +91,23 @@ CK_RV SessionManager::openSession
 	bool rwSession = ((flags & CKF_RW_SESSION) == CKF_RW_SESSION) ? true : false;
 	Session* session = new Session(slot, rwSession, pApplication, notify);
 
-	// First fill any empty spot in the list
-	for (size_t i = 0; i < sessions.size(); i++)
+	// First fill an empty spot in the list
+	if (!freeSessions.empty())
 	{
-		if (sessions[i] != NULL)
-		{
-			continue;
-		}
+		size_t i = freeSessions.back();
+		freeSessions.pop_back();
 
 		sessions[i] = session;
 		session->setHandle(i + 1);
-		*phSession = session->getHandle();
-
-		return CKR_OK;
+	}
+	else
+	{
+		// Or add it to the end
+		sessions.push_back(session);
+		session->setHandle(sessions.size());
 	}
 
-	// Or add it to the end
-	sessions.push_back(session);
-	session->setHandle(sessions.size());
+	addToSlot(session);
 	*phSession = session->getHandle();
 
 	return CKR_OK;
@@ -127,22 +128,8 @@ CK_RV SessionManager::closeSession(CK_SESSION_HANDLE hSession)
 	unsigned long sessionID = hSession - 1;
 	if (sessions[sessionID] == NULL) return CKR_SESSION_HANDLE_INVALID;
 
-	// Check if this is the last session on the token
-	bool lastSession = true;
-	CK_ULONG slotID = sessions[sessionID]->getSlot()->getSlotID();
-	for (size_t i = 0; i < sessions.size(); i++)
-	{
-		if (sessions[i] == NULL) continue;
-
-		if (sessions[i]->getSlot()->getSlotID() == slotID && i != sessionID)
-		{
-			lastSession = false;
-			break;
-		}
-	}
-
 	// Logout if this is the last session on the token
-	if (lastSession)
+	if (removeFromSlot(sessions[sessionID]))
 	{
 		sessions[sessionID]->getSlot()->getToken()->logout();
 	}
@@ -150,6 +137,7 @@ CK_RV SessionManager::closeSession(CK_SESSION_HANDLE hSession)
 	// Close the session
 	delete sessions[sessionID];
 	sessions[sessionID] = NULL;
+	freeSessions.push_back(sessionID);
 
 	return CKR_OK;
 }
@@ -168,15 +156,24 @@ CK_RV SessionManager::closeAllSessions(Slot* slot)
 
 	// Close all sessions on this slot
 	CK_ULONG slotID = slot->getSlotID();
-	for (std::vector<Session*>::iterator i = sessions.begin(); i != sessions.end(); i++)
+	std::map<CK_ULONG, SlotSessions>::iterator it = slotSessions.find(slotID);
+	if (it != slotSessions.end())
 	{
-		if (*i == NULL) continue;
-
-		if ((*i)->getSlot()->getSlotID() == slotID)
+		for (size_t i = 0; i < sessions.size() && it->second.sessionCount > 0; i++)
 		{
-			delete *i;
-			*i = NULL;
+			if (sessions[i] == NULL) continue;
+
+			if (sessions[i]->getSlot()->getSlotID() == slotID)
+			{
+				removeFromSlot(sessions[i]);
+
+				delete sessions[i];
+				sessions[i] = NULL;
+				freeSessions.push_back(i);
+			}
 		}
+
+		slotSessions.erase(it);
 	}
 
 	// Logout from the token
@@ -215,17 +212,9 @@ bool SessionManager::haveSession(size_t slotID)
 	// Lock access to the vector
 	MutexLocker lock(sessionsMutex);
 
-	for (std::vector<Session*>::iterator i = sessions.begin(); i != sessions.end(); i++)
-	{
-		if (*i == NULL) continue;
+	std::map<CK_ULONG, SlotSessions>::iterator it = slotSessions.find(slotID);
 
-		if ((*i)->getSlot()->getSlotID() == slotID)
-		{
-			return true;
-		}
-	}
-
-	return false;
+	return (it != slotSessions.end()) && (it->second.sessionCount > 0);
 }
 
 bool SessionManager::haveROSession(size_t slotID)
@@ -233,14 +222,27 @@ bool SessionManager::haveROSession(size_t slotID)
 	// Lock access to the vector
 	MutexLocker lock(sessionsMutex);
 
-	for (std::vector<Session*>::iterator i = sessions.begin(); i != sessions.end(); i++)
-	{
-		if (*i == NULL) continue;
+	std::map<CK_ULONG, SlotSessions>::iterator it = slotSessions.find(slotID);
+
+	return (it != slotSessions.end()) && (it->second.roSessionCount > 0);
+}
 
-		if ((*i)->getSlot()->getSlotID() != slotID) continue;
+// Count a new session on its slot
+void SessionManager::addToSlot(Session* session)
+{
+	SlotSessions& counts = slotSessions[session->getSlot()->getSlotID()];
 
-		if ((*i)->isRW() == false) return true;
-	}
+	counts.sessionCount++;
+	if (!session->isRW()) counts.roSessionCount++;
+}
+
+// Stop counting a session on its slot; returns true if it was the last one
+bool SessionManager::removeFromSlot(Session* session)
+{
+	SlotSessions& counts = slotSessions[session->getSlot()->getSlotID()];
+
+	if (counts.sessionCount > 0) counts.sessionCount--;
+	if (!session->isRW() && counts.roSessionCount > 0) counts.roSessionCount--;
 
-	return false;
+	return counts.sessionCount == 0;
 }
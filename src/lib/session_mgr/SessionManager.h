@@ -40,6 +40,7 @@
 #include "cryptoki.h"
 #include <memory>
 #include <vector>
+#include <map>
 
 class SessionManager
 {
@@ -57,8 +58,28 @@ public:
 	bool haveROSession(size_t slotID);
 
 private:
+	// The number of open sessions on a slot
+	struct SlotSessions
+	{
+		SlotSessions() : sessionCount(0), roSessionCount(0) { }
+
+		size_t sessionCount;
+		size_t roSessionCount;
+	};
+
+	// Administer a session that is added or removed; the mutex must be held
+	void addToSlot(Session* session);
+	bool removeFromSlot(Session* session);
+
 	// The sessions
 	std::vector<Session*> sessions;
+
+	// The indices of closed sessions that can be reused
+	std::vector<size_t> freeSessions;
+
+	// The open sessions per slot
+	std::map<CK_ULONG, SlotSessions> slotSessions;
+
 	Mutex* sessionsMutex;
 };
 
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ KeyCache.cpp
+
+ A cache of ready-to-use PrivateKey and PublicKey instances
+ *****************************************************************************/
+
+#include "config.h"
+#include "log.h"
+#include "KeyCache.h"
+#include "CryptoFactory.h"
+#include "AsymmetricAlgorithm.h"
+
+// Constructor
+KeyCache::KeyCache(size_t maxKeys)
+{
+	this->maxKeys = maxKeys;
+	cacheMutex = MutexFactory::i()->getMutex();
+}
+
+// Destructor
+KeyCache::~KeyCache()
+{
+	clear();
+
+	MutexFactory::i()->recycleMutex(cacheMutex);
+}
+
+// Take a private key out of the cache
+PrivateKey* KeyCache::getPrivateKey(OSObject* object, unsigned long generation, const std::string& algorithm)
+{
+	CachedKey key;
+
+	if (!take(object, generation, algorithm, true, key))
+	{
+		return NULL;
+	}
+
+	return key.privateKey;
+}
+
+// Take a public key out of the cache
+PublicKey* KeyCache::getPublicKey(OSObject* object, unsigned long generation, const std::string& algorithm)
+{
+	CachedKey key;
+
+	if (!take(object, generation, algorithm, false, key))
+	{
+		return NULL;
+	}
+
+	return key.publicKey;
+}
+
+// Hand a private key to the cache
+bool KeyCache::putPrivateKey(OSObject* object, unsigned long generation, const std::string& algorithm, PrivateKey* privateKey)
+{
+	CachedKey key;
+
+	key.object = object;
+	key.generation = generation;
+	key.algorithm = algorithm;
+	key.privateKey = privateKey;
+	key.publicKey = NULL;
+
+	return put(key);
+}
+
+// Hand a public key to the cache
+bool KeyCache::putPublicKey(OSObject* object, unsigned long generation, const std::string& algorithm, PublicKey* publicKey)
+{
+	CachedKey key;
+
+	key.object = object;
+	key.generation = generation;
+	key.algorithm = algorithm;
+	key.privateKey = NULL;
+	key.publicKey = publicKey;
+
+	return put(key);
+}
+
+// Discard the cached keys of the specified object
+void KeyCache::discard(OSObject* object)
+{
+	MutexLocker lock(cacheMutex);
+
+	std::pair<KeyMap::iterator, KeyMap::iterator> range = keysByObject.equal_range(object);
+
+	while (range.first != range.second)
+	{
+		remove(range.first++);
+	}
+}
+
+// Discard all cached keys
+void KeyCache::clear()
+{
+	MutexLocker lock(cacheMutex);
+
+	while (!keysByObject.empty())
+	{
+		remove(keysByObject.begin());
+	}
+}
+
+// Take a matching key out of the cache
+bool KeyCache::take(OSObject* object, unsigned long generation, const std::string& algorithm, bool isPrivate, CachedKey& key)
+{
+	if (maxKeys == 0) return false;
+
+	MutexLocker lock(cacheMutex);
+
+	std::pair<KeyMap::iterator, KeyMap::iterator> range = keysByObject.equal_range(object);
+
+	while (range.first != range.second)
+	{
+		KeyMap::iterator entry = range.first++;
+		CachedKey& cached = *entry->second;
+
+		// Keys built from another version of the object are of no use
+		if (cached.generation != generation)
+		{
+			remove(entry);
+
+			continue;
+		}
+
+		if ((cached.algorithm == algorithm) &&
+		    ((isPrivate && (cached.privateKey != NULL)) ||
+		     (!isPrivate && (cached.publicKey != NULL))))
+		{
+			key = cached;
+
+			keys.erase(entry->second);
+			keysByObject.erase(entry);
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Insert a key into the cache
+bool KeyCache::put(CachedKey& key)
+{
+	if (maxKeys == 0) return false;
+
+	// Do not keep keys of objects that were deleted or changed in the meantime
+	if (!key.object->isValid() || (key.object->getGeneration() != key.generation))
+	{
+		return false;
+	}
+
+	MutexLocker lock(cacheMutex);
+
+	keys.push_front(key);
+	keysByObject.insert(std::make_pair(key.object, keys.begin()));
+
+	// Evict the least recently used keys
+	while (keysByObject.size() > maxKeys)
+	{
+		KeyList::iterator last = keys.end();
+		last--;
+
+		std::pair<KeyMap::iterator, KeyMap::iterator> range = keysByObject.equal_range(last->object);
+
+		for (KeyMap::iterator i = range.first; i != range.second; i++)
+		{
+			if (i->second == last)
+			{
+				remove(i);
+
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Remove a key from the cache and recycle it
+void KeyCache::remove(KeyMap::iterator entry)
+{
+	recycle(*entry->second);
+
+	keys.erase(entry->second);
+	keysByObject.erase(entry);
+}
+
+// Recycle the key instance
+/*static*/ void KeyCache::recycle(CachedKey& key)
+{
+	AsymmetricAlgorithm* asymCrypto = CryptoFactory::i()->getAsymmetricAlgorithm(key.algorithm);
+
+	if (asymCrypto == NULL)
+	{
+		ERROR_MSG("Could not recycle cached %s key", key.algorithm.c_str());
+
+		return;
+	}
+
+	if (key.privateKey != NULL) asymCrypto->recyclePrivateKey(key.privateKey);
+	if (key.publicKey != NULL) asymCrypto->recyclePublicKey(key.publicKey);
+
+	CryptoFactory::i()->recycleAsymmetricAlgorithm(asymCrypto);
+}
+
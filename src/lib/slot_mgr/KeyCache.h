@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ KeyCache.h
+
+ A cache of ready-to-use PrivateKey and PublicKey instances, built from the
+ key objects of a token. Building a key requires decrypting all of its
+ components and converting them to the representation of the crypto library,
+ which for a single-shot signature costs as much as the signature itself.
+
+ Keys are checked out of the cache when an operation is initialised and are
+ handed back when the operation finishes, so a key instance is never used by
+ more than one operation at the same time. Every key is tagged with the
+ generation of the object it was built from; keys of objects that have since
+ been changed (in this or in another process) are discarded. The number of
+ cached keys is bounded; the least recently used keys are evicted first.
+ *****************************************************************************/
+
+#ifndef _SOFTHSM_V2_KEYCACHE_H
+#define _SOFTHSM_V2_KEYCACHE_H
+
+#include "config.h"
+#include "OSObject.h"
+#include "PrivateKey.h"
+#include "PublicKey.h"
+#include "SecureAllocator.h"
+#include "MutexFactory.h"
+#include <string>
+#include <list>
+#include <map>
+
+class KeyCache
+{
+public:
+	// Constructor
+	KeyCache(size_t maxKeys);
+
+	// Destructor
+	virtual ~KeyCache();
+
+	// Take a key that was built from the specified generation of the object
+	// out of the cache; returns NULL if no such key is cached
+	PrivateKey* getPrivateKey(OSObject* object, unsigned long generation, const std::string& algorithm);
+	PublicKey* getPublicKey(OSObject* object, unsigned long generation, const std::string& algorithm);
+
+	// Hand a key that was built from the specified generation of the object
+	// to the cache; returns false if the cache did not take the key, in which
+	// case the caller must recycle it
+	bool putPrivateKey(OSObject* object, unsigned long generation, const std::string& algorithm, PrivateKey* privateKey);
+	bool putPublicKey(OSObject* object, unsigned long generation, const std::string& algorithm, PublicKey* publicKey);
+
+	// Discard the cached keys of the specified object
+	void discard(OSObject* object);
+
+	// Discard all cached keys
+	void clear();
+
+private:
+	// A cached key; exactly one of privateKey and publicKey is set
+	struct CachedKey
+	{
+		OSObject* object;
+		unsigned long generation;
+		std::string algorithm;
+		PrivateKey* privateKey;
+		PublicKey* publicKey;
+	};
+
+	typedef std::list<CachedKey, SecureAllocator<CachedKey> > KeyList;
+	typedef std::multimap<OSObject*, KeyList::iterator, std::less<OSObject*>, SecureAllocator<std::pair<OSObject* const, KeyList::iterator> > > KeyMap;
+
+	// Take a matching key out of the cache
+	bool take(OSObject* object, unsigned long generation, const std::string& algorithm, bool isPrivate, CachedKey& key);
+
+	// Insert a key into the cache
+	bool put(CachedKey& key);
+
+	// Remove a key from the cache and recycle it; cacheMutex must be held
+	void remove(KeyMap::iterator entry);
+
+	// Recycle the key instance
+	static void recycle(CachedKey& key);
+
+	// The cached keys, most recently used first
+	KeyList keys;
+
+	// The cached keys by object
+	KeyMap keysByObject;
+
+	// The maximum number of cached keys
+	size_t maxKeys;
+
+	// For thread safeness
+	Mutex* cacheMutex;
+};
+
+#endif // !_SOFTHSM_V2_KEYCACHE_H
+
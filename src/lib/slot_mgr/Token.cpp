@@ -26,12 +26,17 @@
 
 #include "config.h"
 #include "log.h"
+#include "Statistics.h"
 #include "ObjectStore.h"
 #include "Token.h"
 #include "OSAttribute.h"
 #include "ByteString.h"
 #include "SecureDataManager.h"
+#include "KeyCache.h"
+#include "Configuration.h"
 
+#include <stdio.h>
+#include <time.h>
 #include <sys/time.h>
 
 // Constructor
@@ -42,27 +47,47 @@ Token::Token()
 	token = NULL;
 	sdm = NULL;
 	valid = false;
+
+	keyCache = new KeyCache(Configuration::i()->getInt("keycache.size", 64));
 }
 
 // Constructor
-Token::Token(OSToken* token)
+Token::Token(ObjectStoreToken* token)
 {
 	tokenMutex = MutexFactory::i()->getMutex();
 
 	this->token = token;
 
 	ByteString soPINBlob, userPINBlob;
+	CK_ULONG scheme = SecureDataManager::AES_CBC;
 
 	valid = token->getSOPIN(soPINBlob) && token->getUserPIN(userPINBlob);
 
-	sdm = new SecureDataManager(soPINBlob, userPINBlob);
+	if (!token->getEncryptionScheme(scheme) || scheme > SecureDataManager::AES_GCM)
+	{
+		ERROR_MSG("Unknown encryption scheme %lu", scheme);
+
+		valid = false;
+		scheme = SecureDataManager::AES_CBC;
+	}
+
+	sdm = new SecureDataManager(soPINBlob, userPINBlob, (SecureDataManager::EncryptionScheme) scheme);
+
+	keyCache = new KeyCache(Configuration::i()->getInt("keycache.size", 64));
 }
 
 // Destructor
 Token::~Token()
 {
+	delete keyCache;
+
 	if (sdm != NULL) delete sdm;
 
+	for (std::set<SecureDataManager*>::iterator i = retiredSdms.begin(); i != retiredSdms.end(); i++)
+	{
+		delete *i;
+	}
+
 	MutexFactory::i()->recycleMutex(tokenMutex);
 }
 
@@ -138,6 +163,10 @@ CK_RV Token::loginSO(ByteString& pin)
 
 	flags &= ~CKF_SO_PIN_COUNT_LOW;
 	token->setTokenFlags(flags);
+
+	// Private objects can now be fully indexed
+	token->discardPrivateIndex();
+
 	return CKR_OK;
 }
 
@@ -177,6 +206,10 @@ CK_RV Token::loginUser(ByteString& pin)
 
 	flags &= ~CKF_USER_PIN_COUNT_LOW;
 	token->setTokenFlags(flags);
+
+	// Private objects can now be fully indexed
+	token->discardPrivateIndex();
+
 	return CKR_OK;
 }
 
@@ -189,6 +222,11 @@ void Token::logout()
 	if (sdm == NULL) return;
 
 	sdm->logout();
+
+	// Do not keep anything derived from private values
+	if (token != NULL) token->discardPrivateIndex();
+
+	keyCache->clear();
 }
 
 // Change SO PIN
@@ -254,7 +292,7 @@ CK_RV Token::setUserPIN(ByteString& oldPIN, ByteString& newPIN)
 	}
 
 	// Verify oldPIN
-	SecureDataManager* newSdm = new SecureDataManager(sdm->getSOPINBlob(), sdm->getUserPINBlob());
+	SecureDataManager* newSdm = new SecureDataManager(sdm->getSOPINBlob(), sdm->getUserPINBlob(), sdm->getEncryptionScheme());
 	if (newSdm->loginUser(oldPIN) == false)
 	{
 		flags |= CKF_USER_PIN_COUNT_LOW;
@@ -281,8 +319,7 @@ CK_RV Token::setUserPIN(ByteString& oldPIN, ByteString& newPIN)
 	if (!stayLoggedIn) newSdm->logout();
 
 	// Switch sdm
-	delete sdm;
-	sdm = newSdm;
+	setSecureDataManager(newSdm);
 
 	ByteString soPINBlob, userPINBlob;
 	valid = token->getSOPIN(soPINBlob) && token->getUserPIN(userPINBlob);
@@ -349,6 +386,8 @@ CK_RV Token::createToken(ObjectStore* objectStore, ByteString& soPIN, CK_UTF8CHA
 		}
 
 		token = NULL;
+
+		keyCache->clear();
 	}
 
 	// Generate the SO PIN blob
@@ -363,7 +402,7 @@ CK_RV Token::createToken(ObjectStore* objectStore, ByteString& soPIN, CK_UTF8CHA
 	ByteString labelByteStr((const unsigned char*) label, 32);
 
 	// Create the token
-	OSToken* newToken = objectStore->newToken(labelByteStr);
+	ObjectStoreToken* newToken = objectStore->newToken(labelByteStr);
 
 	if (newToken == NULL)
 	{
@@ -383,14 +422,28 @@ CK_RV Token::createToken(ObjectStore* objectStore, ByteString& soPIN, CK_UTF8CHA
 		return CKR_DEVICE_ERROR;
 	}
 
+	// New tokens use the strongest scheme the backend supports
+	SecureDataManager::EncryptionScheme scheme = SecureDataManager::getDefaultScheme();
+
+	if (!newToken->setEncryptionScheme(scheme))
+	{
+		ERROR_MSG("Failed to set the encryption scheme on new token");
+
+		if (!objectStore->destroyToken(newToken))
+		{
+			ERROR_MSG("Failed to destroy incomplete token");
+		}
+
+		return CKR_DEVICE_ERROR;
+	}
+
 	token = newToken;
 
 	ByteString soPINBlob, userPINBlob;
 
 	valid = token->getSOPIN(soPINBlob) && token->getUserPIN(userPINBlob);
 
-	if (sdm != NULL) delete sdm;
-	sdm = new SecureDataManager(soPINBlob, userPINBlob);
+	setSecureDataManager(new SecureDataManager(soPINBlob, userPINBlob, scheme));
 
 	return CKR_OK;
 }
@@ -479,7 +532,7 @@ CK_RV Token::getTokenInfo(CK_TOKEN_INFO_PTR info)
 }
 
 // Create an object
-ObjectFile* Token::createObject()
+OSObject* Token::createObject()
 {
 	return token->createObject();
 }
@@ -489,22 +542,129 @@ void Token::getObjects(std::set<OSObject *> &objects)
 	token->getObjects(objects);
 }
 
+bool Token::findObjects(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, std::set<OSObject *> &objects)
+{
+	return token->findObjects(pTemplate, ulCount, this, objects);
+}
+
 bool Token::decrypt(const ByteString &encrypted, ByteString &plaintext)
 {
-	// Lock access to the token
-	MutexLocker lock(tokenMutex);
+	StatTimer timer(StatCounter::TokenDecrypt);
 
-	if (sdm == NULL) return false;
+	// The secure data manager does its own locking, so the token
+	// only needs to be locked to retrieve and release it
+	SecureDataManager* dataMgr = acquireSecureDataManager();
+
+	if (dataMgr == NULL)
+	{
+		timer.failed();
+
+		return false;
+	}
+
+	bool rv = dataMgr->decrypt(encrypted,plaintext);
 
-	return sdm->decrypt(encrypted,plaintext);
+	releaseSecureDataManager(dataMgr);
+
+	if (!rv) timer.failed();
+
+	return rv;
 }
 
 bool Token::encrypt(const ByteString &plaintext, ByteString &encrypted)
+{
+	// The secure data manager does its own locking, so the token
+	// only needs to be locked to retrieve and release it
+	SecureDataManager* dataMgr = acquireSecureDataManager();
+
+	if (dataMgr == NULL) return false;
+
+	bool rv = dataMgr->encrypt(plaintext,encrypted);
+
+	releaseSecureDataManager(dataMgr);
+
+	return rv;
+}
+
+// Get the secure data manager for a decrypt() or encrypt()
+SecureDataManager* Token::acquireSecureDataManager()
+{
+	MutexLocker lock(tokenMutex);
+
+	if (sdm != NULL) sdmUsers[sdm]++;
+
+	return sdm;
+}
+
+// Give back a secure data manager obtained with acquireSecureDataManager();
+// a replaced one is deleted when it is no longer in use
+void Token::releaseSecureDataManager(SecureDataManager* dataMgr)
+{
+	MutexLocker lock(tokenMutex);
+
+	std::map<SecureDataManager*, unsigned long>::iterator i = sdmUsers.find(dataMgr);
+
+	if (i == sdmUsers.end() || --i->second > 0) return;
+
+	sdmUsers.erase(i);
+
+	if (retiredSdms.erase(dataMgr) > 0)
+	{
+		delete dataMgr;
+	}
+}
+
+// Replace the secure data manager; tokenMutex must be held
+void Token::setSecureDataManager(SecureDataManager* newSdm)
+{
+	if (sdm != NULL)
+	{
+		// Do not leave the key of the old instance in memory
+		sdm->logout();
+
+		// An instance that is still used by a concurrent decrypt() or
+		// encrypt() is deleted when that call is done
+		if (sdmUsers.find(sdm) == sdmUsers.end())
+		{
+			delete sdm;
+		}
+		else
+		{
+			retiredSdms.insert(sdm);
+		}
+	}
+
+	sdm = newSdm;
+}
+
+PrivateKey* Token::getCachedPrivateKey(OSObject* object, unsigned long generation, const std::string& algorithm)
+{
+	return keyCache->getPrivateKey(object, generation, algorithm);
+}
+
+PublicKey* Token::getCachedPublicKey(OSObject* object, unsigned long generation, const std::string& algorithm)
+{
+	return keyCache->getPublicKey(object, generation, algorithm);
+}
+
+bool Token::cachePrivateKey(OSObject* object, unsigned long generation, const std::string& algorithm, PrivateKey* privateKey)
 {
 	// Lock access to the token
 	MutexLocker lock(tokenMutex);
 
-	if (sdm == NULL) return false;
+	// Private keys are only kept while someone is logged in; holding the
+	// lock makes sure that the cache cannot be refilled after a logout
+	if (sdm == NULL || (!sdm->isUserLoggedIn() && !sdm->isSOLoggedIn())) return false;
 
-	return sdm->encrypt(plaintext,encrypted);
+	return keyCache->putPrivateKey(object, generation, algorithm, privateKey);
+}
+
+bool Token::cachePublicKey(OSObject* object, unsigned long generation, const std::string& algorithm, PublicKey* publicKey)
+{
+	return keyCache->putPublicKey(object, generation, algorithm, publicKey);
+}
+
+void Token::discardCachedKeys(OSObject* object)
+{
+	keyCache->discard(object);
 }
@@ -36,18 +36,22 @@
 #include "config.h"
 #include "ByteString.h"
 #include "ObjectStore.h"
-#include "OSToken.h"
+#include "ObjectStoreToken.h"
+#include "AttributeIndex.h"
 #include "SecureDataManager.h"
+#include "KeyCache.h"
 #include "cryptoki.h"
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
 
-class Token
+class Token : public AttributeIndex::Decryptor
 {
 public:
 	// Constructor
 	Token();
-	Token(OSToken* token);
+	Token(ObjectStoreToken* token);
 
 	// Destructor
 	virtual ~Token();
@@ -81,27 +85,61 @@ public:
 	CK_RV getTokenInfo(CK_TOKEN_INFO_PTR info);
 
 	// Create object
-	ObjectFile* createObject();
+	OSObject* createObject();
 
 	// Insert all token objects into the given set.
 	void getObjects(std::set<OSObject *> &objects);
 
+	// Insert the token objects that may match the template into the given set;
+	// returns false if all token objects need to be considered.
+	bool findObjects(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, std::set<OSObject *> &objects);
+
 	// Decrypt the supplied data
-	bool decrypt(const ByteString& encrypted, ByteString& plaintext);
+	virtual bool decrypt(const ByteString& encrypted, ByteString& plaintext);
 
 	// Encrypt the supplied data
 	bool encrypt(const ByteString& plaintext, ByteString& encrypted);
 
+	// Take a ready-to-use key that was built from the specified generation
+	// of the object out of the key cache; returns NULL if none is cached
+	PrivateKey* getCachedPrivateKey(OSObject* object, unsigned long generation, const std::string& algorithm);
+	PublicKey* getCachedPublicKey(OSObject* object, unsigned long generation, const std::string& algorithm);
+
+	// Hand a key back to the key cache after use; returns false if the
+	// cache did not take the key, in which case it must be recycled
+	bool cachePrivateKey(OSObject* object, unsigned long generation, const std::string& algorithm, PrivateKey* privateKey);
+	bool cachePublicKey(OSObject* object, unsigned long generation, const std::string& algorithm, PublicKey* publicKey);
+
+	// Discard the cached keys of an object
+	void discardCachedKeys(OSObject* object);
+
 private:
+	// Replace the secure data manager; tokenMutex must be held
+	void setSecureDataManager(SecureDataManager* newSdm);
+
+	// Get the secure data manager for a decrypt() or encrypt() and give it
+	// back when the operation is done
+	SecureDataManager* acquireSecureDataManager();
+	void releaseSecureDataManager(SecureDataManager* dataMgr);
+
 	// Token validity
 	bool valid;
 
 	// A reference to the object store token
-	OSToken* token;
+	ObjectStoreToken* token;
 
 	// The secure data manager for this token
 	SecureDataManager* sdm;
 
+	// The number of decrypt() and encrypt() calls that use each secure
+	// data manager, and the replaced secure data managers that are still
+	// in use; these are deleted when the last call is done
+	std::map<SecureDataManager*, unsigned long> sdmUsers;
+	std::set<SecureDataManager*> retiredSdms;
+
+	// The cache of keys built from the objects of this token
+	KeyCache* keyCache;
+
 	Mutex* tokenMutex;
 };
 
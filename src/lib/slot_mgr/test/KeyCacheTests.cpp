@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ KeyCacheTests.cpp
+
+ Contains test cases to test the key cache
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "KeyCacheTests.h"
+#include "KeyCache.h"
+#include "SessionObject.h"
+#include "CryptoFactory.h"
+#include "AsymmetricAlgorithm.h"
+#include "OSAttribute.h"
+#include "cryptoki.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(KeyCacheTests);
+
+void KeyCacheTests::setUp()
+{
+}
+
+void KeyCacheTests::tearDown()
+{
+}
+
+void KeyCacheTests::testGetPut()
+{
+	SessionObject object(NULL, 1, 1);
+	KeyCache cache(4);
+
+	AsymmetricAlgorithm* rsa = CryptoFactory::i()->getAsymmetricAlgorithm("rsa");
+	CPPUNIT_ASSERT(rsa != NULL);
+
+	PrivateKey* privateKey = rsa->newPrivateKey();
+	PublicKey* publicKey = rsa->newPublicKey();
+	unsigned long generation = object.getGeneration();
+
+	// Nothing is cached yet
+	CPPUNIT_ASSERT(cache.getPrivateKey(&object, generation, "rsa") == NULL);
+
+	// Hand the keys to the cache
+	CPPUNIT_ASSERT(cache.putPrivateKey(&object, generation, "rsa", privateKey));
+	CPPUNIT_ASSERT(cache.putPublicKey(&object, generation, "rsa", publicKey));
+
+	// Keys are only returned for the same algorithm
+	CPPUNIT_ASSERT(cache.getPrivateKey(&object, generation, "dsa") == NULL);
+
+	// Take the keys out; a key can only be taken once
+	CPPUNIT_ASSERT(cache.getPrivateKey(&object, generation, "rsa") == privateKey);
+	CPPUNIT_ASSERT(cache.getPrivateKey(&object, generation, "rsa") == NULL);
+	CPPUNIT_ASSERT(cache.getPublicKey(&object, generation, "rsa") == publicKey);
+	CPPUNIT_ASSERT(cache.getPublicKey(&object, generation, "rsa") == NULL);
+
+	// A cache without room does not take keys
+	KeyCache noCache(0);
+
+	CPPUNIT_ASSERT(!noCache.putPrivateKey(&object, generation, "rsa", privateKey));
+
+	rsa->recyclePrivateKey(privateKey);
+	rsa->recyclePublicKey(publicKey);
+	CryptoFactory::i()->recycleAsymmetricAlgorithm(rsa);
+}
+
+void KeyCacheTests::testChangedObject()
+{
+	SessionObject object(NULL, 1, 1);
+	KeyCache cache(4);
+	ByteString label = "AABBCC";
+
+	AsymmetricAlgorithm* rsa = CryptoFactory::i()->getAsymmetricAlgorithm("rsa");
+	CPPUNIT_ASSERT(rsa != NULL);
+
+	PrivateKey* privateKey = rsa->newPrivateKey();
+	unsigned long generation = object.getGeneration();
+
+	CPPUNIT_ASSERT(cache.putPrivateKey(&object, generation, "rsa", privateKey));
+
+	// Change the object
+	CPPUNIT_ASSERT(object.setAttribute(CKA_LABEL, label));
+	CPPUNIT_ASSERT(object.getGeneration() != generation);
+
+	// The cached key no longer matches
+	CPPUNIT_ASSERT(cache.getPrivateKey(&object, object.getGeneration(), "rsa") == NULL);
+
+	// Keys built from an old version of the object are not taken
+	privateKey = rsa->newPrivateKey();
+
+	CPPUNIT_ASSERT(!cache.putPrivateKey(&object, generation, "rsa", privateKey));
+
+	rsa->recyclePrivateKey(privateKey);
+	CryptoFactory::i()->recycleAsymmetricAlgorithm(rsa);
+}
+
+void KeyCacheTests::testEviction()
+{
+	SessionObject object1(NULL, 1, 1);
+	SessionObject object2(NULL, 1, 1);
+	KeyCache cache(1);
+
+	AsymmetricAlgorithm* rsa = CryptoFactory::i()->getAsymmetricAlgorithm("rsa");
+	CPPUNIT_ASSERT(rsa != NULL);
+
+	PrivateKey* privateKey1 = rsa->newPrivateKey();
+	PrivateKey* privateKey2 = rsa->newPrivateKey();
+
+	CPPUNIT_ASSERT(cache.putPrivateKey(&object1, object1.getGeneration(), "rsa", privateKey1));
+	CPPUNIT_ASSERT(cache.putPrivateKey(&object2, object2.getGeneration(), "rsa", privateKey2));
+
+	// The least recently used key was evicted
+	CPPUNIT_ASSERT(cache.getPrivateKey(&object1, object1.getGeneration(), "rsa") == NULL);
+	CPPUNIT_ASSERT(cache.getPrivateKey(&object2, object2.getGeneration(), "rsa") == privateKey2);
+
+	rsa->recyclePrivateKey(privateKey2);
+	CryptoFactory::i()->recycleAsymmetricAlgorithm(rsa);
+}
+
+void KeyCacheTests::testDiscard()
+{
+	SessionObject object1(NULL, 1, 1);
+	SessionObject object2(NULL, 1, 1);
+	KeyCache cache(4);
+
+	AsymmetricAlgorithm* rsa = CryptoFactory::i()->getAsymmetricAlgorithm("rsa");
+	CPPUNIT_ASSERT(rsa != NULL);
+
+	CPPUNIT_ASSERT(cache.putPrivateKey(&object1, object1.getGeneration(), "rsa", rsa->newPrivateKey()));
+	CPPUNIT_ASSERT(cache.putPrivateKey(&object2, object2.getGeneration(), "rsa", rsa->newPrivateKey()));
+
+	// Discard the keys of one object
+	cache.discard(&object1);
+
+	CPPUNIT_ASSERT(cache.getPrivateKey(&object1, object1.getGeneration(), "rsa") == NULL);
+
+	// Discard all keys
+	cache.clear();
+
+	CPPUNIT_ASSERT(cache.getPrivateKey(&object2, object2.getGeneration(), "rsa") == NULL);
+
+	CryptoFactory::i()->recycleAsymmetricAlgorithm(rsa);
+}
+
@@ -30,14 +30,19 @@
  Contains test cases for:
 	 C_EncryptInit
 	 C_Encrypt
+	 C_EncryptUpdate
+	 C_EncryptFinal
 	 C_DecryptInit
 	 C_Decrypt
+	 C_DecryptUpdate
+	 C_DecryptFinal
 
  *****************************************************************************/
 
 #include <stdlib.h>
 #include <string.h>
 #include <cppunit/extensions/HelperMacros.h>
+#include "config.h"
 #include "EncryptDecryptTests.h"
 #include "testconfig.h"
 
@@ -208,3 +213,426 @@ void EncryptDecryptTests::testRsaEncryptDecrypt()
 	rsaEncryptDecrypt(CKM_RSA_X_509,hSessionRO,hPublicKey,hPrivateKey);
 	rsaEncryptDecrypt(CKM_RSA_PKCS_OAEP,hSessionRO,hPublicKey,hPrivateKey);
 }
+
+CK_RV EncryptDecryptTests::generateSecretKey(CK_SESSION_HANDLE hSession, CK_KEY_TYPE keyType, CK_ULONG keyLen, CK_OBJECT_HANDLE &hKey)
+{
+	CK_RV rv;
+	CK_OBJECT_CLASS keyClass = CKO_SECRET_KEY;
+	CK_BYTE val[32];
+	CK_BBOOL bFalse = CK_FALSE;
+	CK_BBOOL bTrue = CK_TRUE;
+	CK_ATTRIBUTE kAttribs[] = {
+		{ CKA_CLASS, &keyClass, sizeof(keyClass) },
+		{ CKA_KEY_TYPE, &keyType, sizeof(keyType) },
+		{ CKA_TOKEN, &bFalse, sizeof(bFalse) },
+		{ CKA_PRIVATE, &bTrue, sizeof(bTrue) },
+		{ CKA_SENSITIVE, &bTrue, sizeof(bTrue) },
+		{ CKA_ENCRYPT, &bTrue, sizeof(bTrue) },
+		{ CKA_DECRYPT, &bTrue, sizeof(bTrue) },
+		{ CKA_VALUE, &val[0], keyLen }
+	};
+
+	rv = C_GenerateRandom(hSession, val, keyLen);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	hKey = CK_INVALID_HANDLE;
+	return C_CreateObject(hSession, kAttribs, sizeof(kAttribs)/sizeof(CK_ATTRIBUTE), &hKey);
+}
+
+void EncryptDecryptTests::symEncryptDecrypt(CK_MECHANISM_TYPE mechanismType, CK_ULONG blockSize, CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hKey)
+{
+	CK_BYTE iv[16] = { 0x0F, 0x0E, 0x0D, 0x0C, 0x0B, 0x0A, 0x09, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00 };
+	CK_MECHANISM mechanism = { mechanismType, NULL_PTR, 0 };
+	CK_BYTE plainText[256];
+	CK_BYTE cipherText[256 + 16];
+	CK_ULONG ulCipherTextLen;
+	CK_BYTE streamText[256 + 16];
+	CK_ULONG ulStreamTextLen;
+	CK_BYTE recoveredText[256 + 16];
+	CK_ULONG ulRecoveredTextLen;
+	CK_ULONG ulPartLen;
+	CK_RV rv;
+
+	bool isPadded = (mechanismType == CKM_AES_CBC_PAD || mechanismType == CKM_DES_CBC_PAD || mechanismType == CKM_DES3_CBC_PAD);
+
+	if (mechanismType != CKM_AES_ECB && mechanismType != CKM_DES_ECB && mechanismType != CKM_DES3_ECB)
+	{
+		mechanism.pParameter = iv;
+		mechanism.ulParameterLen = blockSize;
+	}
+
+	// Padded mechanisms take any length, the others whole blocks only
+	CK_ULONG ulPlainTextLen = isPadded ? sizeof(plainText) - 3 : sizeof(plainText);
+	for (CK_ULONG i = 0; i < sizeof(plainText); i++)
+	{
+		plainText[i] = (CK_BYTE) i;
+	}
+
+	// Single-part encryption
+	rv = C_EncryptInit(hSession,&mechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	rv = C_Encrypt(hSession,plainText,ulPlainTextLen,NULL_PTR,&ulCipherTextLen);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	CPPUNIT_ASSERT(ulCipherTextLen <= sizeof(cipherText));
+
+	rv = C_Encrypt(hSession,plainText,ulPlainTextLen,cipherText,&ulCipherTextLen);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	CPPUNIT_ASSERT(ulCipherTextLen == (isPadded ? (ulPlainTextLen / blockSize + 1) * blockSize : ulPlainTextLen));
+
+	// Multi-part encryption in chunks that are not aligned to the block size
+	// must give the same result
+	rv = C_EncryptInit(hSession,&mechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	ulStreamTextLen = 0;
+	for (CK_ULONG offset = 0; offset < ulPlainTextLen; offset += 13)
+	{
+		CK_ULONG ulChunkLen = ulPlainTextLen - offset < 13 ? ulPlainTextLen - offset : 13;
+
+		ulPartLen = sizeof(streamText) - ulStreamTextLen;
+		rv = C_EncryptUpdate(hSession,&plainText[offset],ulChunkLen,&streamText[ulStreamTextLen],&ulPartLen);
+		CPPUNIT_ASSERT(rv==CKR_OK);
+		ulStreamTextLen += ulPartLen;
+	}
+
+	ulPartLen = sizeof(streamText) - ulStreamTextLen;
+	rv = C_EncryptFinal(hSession,&streamText[ulStreamTextLen],&ulPartLen);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	ulStreamTextLen += ulPartLen;
+
+	CPPUNIT_ASSERT(ulStreamTextLen == ulCipherTextLen);
+	CPPUNIT_ASSERT(memcmp(cipherText, streamText, ulCipherTextLen) == 0);
+
+	// Single-part decryption
+	rv = C_DecryptInit(hSession,&mechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	ulRecoveredTextLen = sizeof(recoveredText);
+	rv = C_Decrypt(hSession,cipherText,ulCipherTextLen,recoveredText,&ulRecoveredTextLen);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	CPPUNIT_ASSERT(ulRecoveredTextLen == ulPlainTextLen);
+	CPPUNIT_ASSERT(memcmp(plainText, recoveredText, ulPlainTextLen) == 0);
+
+	// Multi-part decryption in block-sized chunks with output buffers of
+	// exactly the size of the input
+	rv = C_DecryptInit(hSession,&mechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	ulRecoveredTextLen = 0;
+	for (CK_ULONG offset = 0; offset < ulCipherTextLen; offset += blockSize)
+	{
+		ulPartLen = blockSize;
+		rv = C_DecryptUpdate(hSession,&cipherText[offset],blockSize,&recoveredText[ulRecoveredTextLen],&ulPartLen);
+		CPPUNIT_ASSERT(rv==CKR_OK);
+		ulRecoveredTextLen += ulPartLen;
+	}
+
+	ulPartLen = sizeof(recoveredText) - ulRecoveredTextLen;
+	rv = C_DecryptFinal(hSession,&recoveredText[ulRecoveredTextLen],&ulPartLen);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	ulRecoveredTextLen += ulPartLen;
+
+	CPPUNIT_ASSERT(ulRecoveredTextLen == ulPlainTextLen);
+	CPPUNIT_ASSERT(memcmp(plainText, recoveredText, ulPlainTextLen) == 0);
+
+	// Unpadded mechanisms only take whole blocks
+	if (!isPadded)
+	{
+		rv = C_EncryptInit(hSession,&mechanism,hKey);
+		CPPUNIT_ASSERT(rv==CKR_OK);
+
+		ulCipherTextLen = sizeof(cipherText);
+		rv = C_Encrypt(hSession,plainText,blockSize - 1,cipherText,&ulCipherTextLen);
+		CPPUNIT_ASSERT(rv==CKR_DATA_LEN_RANGE);
+	}
+}
+
+void EncryptDecryptTests::streamEncryptDecrypt(CK_MECHANISM_PTR pMechanism, CK_ULONG tagLen, CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hKey)
+{
+	CK_BYTE plainText[253];
+	CK_BYTE cipherText[253 + 16];
+	CK_ULONG ulCipherTextLen;
+	CK_BYTE streamText[253 + 16];
+	CK_ULONG ulStreamTextLen;
+	CK_BYTE recoveredText[253 + 16];
+	CK_ULONG ulRecoveredTextLen;
+	CK_ULONG ulPartLen;
+	CK_RV rv;
+
+	for (CK_ULONG i = 0; i < sizeof(plainText); i++)
+	{
+		plainText[i] = (CK_BYTE) i;
+	}
+
+	// Single-part encryption; the output is as long as the input plus the tag
+	rv = C_EncryptInit(hSession,pMechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	rv = C_Encrypt(hSession,plainText,sizeof(plainText),NULL_PTR,&ulCipherTextLen);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	CPPUNIT_ASSERT(ulCipherTextLen == sizeof(plainText) + tagLen);
+
+	rv = C_Encrypt(hSession,plainText,sizeof(plainText),cipherText,&ulCipherTextLen);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	CPPUNIT_ASSERT(ulCipherTextLen == sizeof(plainText) + tagLen);
+
+	// Multi-part encryption must give the same result
+	rv = C_EncryptInit(hSession,pMechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	ulStreamTextLen = 0;
+	for (CK_ULONG offset = 0; offset < sizeof(plainText); offset += 13)
+	{
+		CK_ULONG ulChunkLen = sizeof(plainText) - offset < 13 ? sizeof(plainText) - offset : 13;
+
+		ulPartLen = ulChunkLen;
+		rv = C_EncryptUpdate(hSession,&plainText[offset],ulChunkLen,&streamText[ulStreamTextLen],&ulPartLen);
+		CPPUNIT_ASSERT(rv==CKR_OK);
+		ulStreamTextLen += ulPartLen;
+	}
+
+	ulPartLen = sizeof(streamText) - ulStreamTextLen;
+	rv = C_EncryptFinal(hSession,&streamText[ulStreamTextLen],&ulPartLen);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	ulStreamTextLen += ulPartLen;
+
+	CPPUNIT_ASSERT(ulStreamTextLen == ulCipherTextLen);
+	CPPUNIT_ASSERT(memcmp(cipherText, streamText, ulCipherTextLen) == 0);
+
+	// Single-part decryption
+	rv = C_DecryptInit(hSession,pMechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	ulRecoveredTextLen = sizeof(recoveredText);
+	rv = C_Decrypt(hSession,cipherText,ulCipherTextLen,recoveredText,&ulRecoveredTextLen);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	CPPUNIT_ASSERT(ulRecoveredTextLen == sizeof(plainText));
+	CPPUNIT_ASSERT(memcmp(plainText, recoveredText, sizeof(plainText)) == 0);
+
+	// Multi-part decryption; with a tag the data is only returned by
+	// C_DecryptFinal once the tag has been checked
+	rv = C_DecryptInit(hSession,pMechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	ulRecoveredTextLen = 0;
+	for (CK_ULONG offset = 0; offset < ulCipherTextLen; offset += 13)
+	{
+		CK_ULONG ulChunkLen = ulCipherTextLen - offset < 13 ? ulCipherTextLen - offset : 13;
+
+		ulPartLen = sizeof(recoveredText) - ulRecoveredTextLen;
+		rv = C_DecryptUpdate(hSession,&cipherText[offset],ulChunkLen,&recoveredText[ulRecoveredTextLen],&ulPartLen);
+		CPPUNIT_ASSERT(rv==CKR_OK);
+		CPPUNIT_ASSERT(tagLen == 0 || ulPartLen == 0);
+		ulRecoveredTextLen += ulPartLen;
+	}
+
+	ulPartLen = sizeof(recoveredText) - ulRecoveredTextLen;
+	rv = C_DecryptFinal(hSession,&recoveredText[ulRecoveredTextLen],&ulPartLen);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	ulRecoveredTextLen += ulPartLen;
+
+	CPPUNIT_ASSERT(ulRecoveredTextLen == sizeof(plainText));
+	CPPUNIT_ASSERT(memcmp(plainText, recoveredText, sizeof(plainText)) == 0);
+
+	// A modified tag must be rejected
+	if (tagLen > 0)
+	{
+		cipherText[ulCipherTextLen - 1] ^= 0x01;
+
+		rv = C_DecryptInit(hSession,pMechanism,hKey);
+		CPPUNIT_ASSERT(rv==CKR_OK);
+
+		ulRecoveredTextLen = sizeof(recoveredText);
+		rv = C_Decrypt(hSession,cipherText,ulCipherTextLen,recoveredText,&ulRecoveredTextLen);
+		CPPUNIT_ASSERT(rv==CKR_ENCRYPTED_DATA_INVALID);
+	}
+}
+
+void EncryptDecryptTests::testAesEncryptDecrypt()
+{
+	CK_RV rv;
+	CK_UTF8CHAR pin[] = SLOT_0_USER1_PIN;
+	CK_ULONG pinLength = sizeof(pin) - 1;
+	CK_SESSION_HANDLE hSessionRO;
+	CK_SESSION_HANDLE hSessionRW;
+
+	// Just make sure that we finalize any previous tests
+	C_Finalize(NULL_PTR);
+
+	// Initialize the library and start the test.
+	rv = C_Initialize(NULL_PTR);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	// Open read-only session
+	rv = C_OpenSession(SLOT_INIT_TOKEN, CKF_SERIAL_SESSION, NULL_PTR, NULL_PTR, &hSessionRO);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	// Open read-write session
+	rv = C_OpenSession(SLOT_INIT_TOKEN, CKF_SERIAL_SESSION | CKF_RW_SESSION, NULL_PTR, NULL_PTR, &hSessionRW);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	// Login USER into the sessions so we can create a private objects
+	rv = C_Login(hSessionRO,CKU_USER,pin,pinLength);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	CK_OBJECT_HANDLE hKey = CK_INVALID_HANDLE;
+
+	CK_ULONG keyLens[] = { 16, 24, 32 };
+	for (size_t i = 0; i < sizeof(keyLens)/sizeof(CK_ULONG); i++)
+	{
+		rv = generateSecretKey(hSessionRW,CKK_AES,keyLens[i],hKey);
+		CPPUNIT_ASSERT(rv == CKR_OK);
+
+		symEncryptDecrypt(CKM_AES_ECB,16,hSessionRO,hKey);
+		symEncryptDecrypt(CKM_AES_CBC,16,hSessionRO,hKey);
+		symEncryptDecrypt(CKM_AES_CBC_PAD,16,hSessionRO,hKey);
+	}
+
+	// The key type must match the mechanism
+	rv = generateSecretKey(hSessionRW,CKK_DES3,24,hKey);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	CK_MECHANISM mechanism = { CKM_AES_ECB, NULL_PTR, 0 };
+	rv = C_EncryptInit(hSessionRO,&mechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_KEY_TYPE_INCONSISTENT);
+}
+
+void EncryptDecryptTests::testAesCtrGcmEncryptDecrypt()
+{
+	CK_RV rv;
+	CK_UTF8CHAR pin[] = SLOT_0_USER1_PIN;
+	CK_ULONG pinLength = sizeof(pin) - 1;
+	CK_SESSION_HANDLE hSessionRO;
+	CK_SESSION_HANDLE hSessionRW;
+
+	// Just make sure that we finalize any previous tests
+	C_Finalize(NULL_PTR);
+
+	// Initialize the library and start the test.
+	rv = C_Initialize(NULL_PTR);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	// Open read-only session
+	rv = C_OpenSession(SLOT_INIT_TOKEN, CKF_SERIAL_SESSION, NULL_PTR, NULL_PTR, &hSessionRO);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	// Open read-write session
+	rv = C_OpenSession(SLOT_INIT_TOKEN, CKF_SERIAL_SESSION | CKF_RW_SESSION, NULL_PTR, NULL_PTR, &hSessionRW);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	// Login USER into the sessions so we can create a private objects
+	rv = C_Login(hSessionRO,CKU_USER,pin,pinLength);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	CK_OBJECT_HANDLE hKey = CK_INVALID_HANDLE;
+
+	// The low 32 bits of the counter overflow into the rest of the counter
+	// within the data
+	CK_AES_CTR_PARAMS ctrParams;
+	ctrParams.ulCounterBits = 64;
+	memset(ctrParams.cb, 0x5A, sizeof(ctrParams.cb));
+	memset(&ctrParams.cb[12], 0xFF, 3);
+	ctrParams.cb[15] = 0xFA;
+	CK_MECHANISM ctrMechanism = { CKM_AES_CTR, &ctrParams, sizeof(ctrParams) };
+
+	CK_BYTE gcmIV[12] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C };
+	CK_BYTE gcmAAD[] = "additional authenticated data";
+	CK_GCM_PARAMS gcmParams;
+	gcmParams.pIv = gcmIV;
+	gcmParams.ulIvLen = sizeof(gcmIV);
+	gcmParams.ulIvBits = sizeof(gcmIV) * 8;
+	gcmParams.pAAD = gcmAAD;
+	gcmParams.ulAADLen = sizeof(gcmAAD) - 1;
+	gcmParams.ulTagBits = 128;
+	CK_MECHANISM gcmMechanism = { CKM_AES_GCM, &gcmParams, sizeof(gcmParams) };
+
+	CK_ULONG keyLens[] = { 16, 24, 32 };
+	for (size_t i = 0; i < sizeof(keyLens)/sizeof(CK_ULONG); i++)
+	{
+		rv = generateSecretKey(hSessionRW,CKK_AES,keyLens[i],hKey);
+		CPPUNIT_ASSERT(rv == CKR_OK);
+
+		streamEncryptDecrypt(&ctrMechanism,0,hSessionRO,hKey);
+#ifndef WITH_BOTAN
+		gcmParams.ulTagBits = 128;
+		streamEncryptDecrypt(&gcmMechanism,16,hSessionRO,hKey);
+		gcmParams.ulTagBits = 96;
+		streamEncryptDecrypt(&gcmMechanism,12,hSessionRO,hKey);
+#endif
+	}
+
+	// The counter must not wrap within one operation
+	ctrParams.ulCounterBits = 8;
+	CK_BYTE data[16 * 16];
+	CK_BYTE encryptedData[16 * 16];
+	CK_ULONG ulEncryptedDataLen = sizeof(encryptedData);
+	memset(data, 0, sizeof(data));
+	rv = C_EncryptInit(hSessionRO,&ctrMechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+	rv = C_Encrypt(hSessionRO,data,sizeof(data),encryptedData,&ulEncryptedDataLen);
+	CPPUNIT_ASSERT(rv==CKR_DATA_LEN_RANGE);
+
+	// Invalid parameters
+	ctrParams.ulCounterBits = 0;
+	rv = C_EncryptInit(hSessionRO,&ctrMechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_MECHANISM_PARAM_INVALID);
+
+	gcmParams.ulTagBits = 20;
+	rv = C_EncryptInit(hSessionRO,&gcmMechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_MECHANISM_PARAM_INVALID);
+
+	gcmParams.ulTagBits = 128;
+	gcmParams.pIv = NULL_PTR;
+	rv = C_EncryptInit(hSessionRO,&gcmMechanism,hKey);
+	CPPUNIT_ASSERT(rv==CKR_MECHANISM_PARAM_INVALID);
+}
+
+void EncryptDecryptTests::testDesEncryptDecrypt()
+{
+	CK_RV rv;
+	CK_UTF8CHAR pin[] = SLOT_0_USER1_PIN;
+	CK_ULONG pinLength = sizeof(pin) - 1;
+	CK_SESSION_HANDLE hSessionRO;
+	CK_SESSION_HANDLE hSessionRW;
+
+	// Just make sure that we finalize any previous tests
+	C_Finalize(NULL_PTR);
+
+	// Initialize the library and start the test.
+	rv = C_Initialize(NULL_PTR);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	// Open read-only session
+	rv = C_OpenSession(SLOT_INIT_TOKEN, CKF_SERIAL_SESSION, NULL_PTR, NULL_PTR, &hSessionRO);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	// Open read-write session
+	rv = C_OpenSession(SLOT_INIT_TOKEN, CKF_SERIAL_SESSION | CKF_RW_SESSION, NULL_PTR, NULL_PTR, &hSessionRW);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	// Login USER into the sessions so we can create a private objects
+	rv = C_Login(hSessionRO,CKU_USER,pin,pinLength);
+	CPPUNIT_ASSERT(rv==CKR_OK);
+
+	CK_OBJECT_HANDLE hKey = CK_INVALID_HANDLE;
+
+	rv = generateSecretKey(hSessionRW,CKK_DES,8,hKey);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	symEncryptDecrypt(CKM_DES_ECB,8,hSessionRO,hKey);
+	symEncryptDecrypt(CKM_DES_CBC,8,hSessionRO,hKey);
+	symEncryptDecrypt(CKM_DES_CBC_PAD,8,hSessionRO,hKey);
+
+	rv = generateSecretKey(hSessionRW,CKK_DES2,16,hKey);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	symEncryptDecrypt(CKM_DES3_CBC,8,hSessionRO,hKey);
+
+	rv = generateSecretKey(hSessionRW,CKK_DES3,24,hKey);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	symEncryptDecrypt(CKM_DES3_ECB,8,hSessionRO,hKey);
+	symEncryptDecrypt(CKM_DES3_CBC,8,hSessionRO,hKey);
+	symEncryptDecrypt(CKM_DES3_CBC_PAD,8,hSessionRO,hKey);
+}
@@ -27,7 +27,8 @@
 /*****************************************************************************
  EncryptDecryptTests.h
 
- Contains test cases to C_EncryptInit, C_Encrypt, C_DecryptInit, C_Decrypt
+ Contains test cases to C_EncryptInit, C_Encrypt, C_EncryptUpdate,
+ C_EncryptFinal, C_DecryptInit, C_Decrypt, C_DecryptUpdate, C_DecryptFinal
  *****************************************************************************/
 
 #ifndef _SOFTHSM_V2_ENCRYPTDECRYPTTESTS_H
@@ -40,10 +41,16 @@ class EncryptDecryptTests : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE(EncryptDecryptTests);
 	CPPUNIT_TEST(testRsaEncryptDecrypt);
+	CPPUNIT_TEST(testAesEncryptDecrypt);
+	CPPUNIT_TEST(testAesCtrGcmEncryptDecrypt);
+	CPPUNIT_TEST(testDesEncryptDecrypt);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
 	void testRsaEncryptDecrypt();
+	void testAesEncryptDecrypt();
+	void testAesCtrGcmEncryptDecrypt();
+	void testDesEncryptDecrypt();
 
 	void setUp();
 	void tearDown();
@@ -51,6 +58,9 @@ public:
 protected:
 	CK_RV generateRsaKeyPair(CK_SESSION_HANDLE hSession, CK_BBOOL bTokenPuk, CK_BBOOL bPrivatePuk, CK_BBOOL bTokenPrk, CK_BBOOL bPrivatePrk, CK_OBJECT_HANDLE &hPuk, CK_OBJECT_HANDLE &hPrk);
 	void rsaEncryptDecrypt(CK_MECHANISM_TYPE mechanismType, CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hPublicKey, CK_OBJECT_HANDLE hPrivateKey);
+	CK_RV generateSecretKey(CK_SESSION_HANDLE hSession, CK_KEY_TYPE keyType, CK_ULONG keyLen, CK_OBJECT_HANDLE &hKey);
+	void symEncryptDecrypt(CK_MECHANISM_TYPE mechanismType, CK_ULONG blockSize, CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hKey);
+	void streamEncryptDecrypt(CK_MECHANISM_PTR pMechanism, CK_ULONG tagLen, CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hKey);
 };
 
 #endif // !_SOFTHSM_V2_ENCRYPTDECRYPTTESTS_H
@@ -28,7 +28,8 @@
  InfoTests.cpp
 
  Contains test cases to C_GetInfo, C_GetFunctionList, C_GetSlotList, 
- C_GetSlotInfo, C_GetTokenInfo, C_GetMechanismList, and C_GetMechanismInfo
+ C_GetSlotInfo, C_GetTokenInfo, C_GetMechanismList, C_GetMechanismInfo, and
+ C_GetStatistics
  *****************************************************************************/
 
 #include <stdlib.h>
@@ -292,3 +293,69 @@ void InfoTests::testGetMechanismInfo()
 
 	C_Finalize(NULL_PTR);
 }
+
+void InfoTests::testGetStatistics()
+{
+	CK_RV rv;
+	CK_INFO ckInfo;
+	CK_ULONG ulCount = 0;
+	CK_STATISTICS_PTR pStatistics;
+
+	// Just make sure that we finalize any previous failed tests
+	C_Finalize(NULL_PTR);
+
+	rv = C_Initialize(NULL_PTR);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	rv = C_GetStatistics(NULL_PTR, NULL_PTR);
+	CPPUNIT_ASSERT(rv == CKR_ARGUMENTS_BAD);
+
+	// Get the size of the buffer
+	rv = C_GetStatistics(NULL_PTR, &ulCount);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+	CPPUNIT_ASSERT(ulCount > 0);
+	pStatistics = (CK_STATISTICS_PTR)malloc(ulCount * sizeof(CK_STATISTICS));
+
+	// Count the calls of C_GetInfo
+	rv = C_GetStatistics(pStatistics, &ulCount);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+
+	CK_ULONG calls = 0, errors = 0;
+	CK_ULONG i;
+
+	for (i = 0; i < ulCount; i++)
+	{
+		if (!strcmp((char*)pStatistics[i].name, "C_GetInfo")) break;
+	}
+	CPPUNIT_ASSERT(i < ulCount);
+	calls = pStatistics[i].calls;
+	errors = pStatistics[i].errors;
+
+	rv = C_GetInfo(&ckInfo);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+	rv = C_GetInfo(NULL_PTR);
+	CPPUNIT_ASSERT(rv == CKR_ARGUMENTS_BAD);
+
+	// Check if we have a too small buffer
+	CK_ULONG ulSmallCount = 0;
+	rv = C_GetStatistics(pStatistics, &ulSmallCount);
+	CPPUNIT_ASSERT(rv == CKR_BUFFER_TOO_SMALL);
+	CPPUNIT_ASSERT(ulSmallCount == ulCount);
+
+	// Both calls are counted, one of them as an error
+	rv = C_GetStatistics(pStatistics, &ulCount);
+	CPPUNIT_ASSERT(rv == CKR_OK);
+	CPPUNIT_ASSERT(pStatistics[i].calls == calls + 2);
+	CPPUNIT_ASSERT(pStatistics[i].errors == errors + 1);
+
+	CK_ULONG inBuckets = 0;
+	for (int b = 0; b < CK_STATISTICS_BUCKETS; b++)
+	{
+		inBuckets += pStatistics[i].buckets[b];
+	}
+	CPPUNIT_ASSERT(inBuckets == pStatistics[i].calls);
+
+	free(pStatistics);
+
+	C_Finalize(NULL_PTR);
+}
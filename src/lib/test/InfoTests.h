@@ -28,7 +28,8 @@
  InfoTests.h
 
  Contains test cases to C_GetInfo, C_GetFunctionList, C_GetSlotList, 
- C_GetSlotInfo, C_GetTokenInfo, C_GetMechanismList, and C_GetMechanismInfo
+ C_GetSlotInfo, C_GetTokenInfo, C_GetMechanismList, C_GetMechanismInfo, and
+ C_GetStatistics
  *****************************************************************************/
 
 #ifndef _SOFTHSM_V2_INFOTESTS_H
@@ -36,6 +37,7 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 #include "cryptoki.h"
+#include "softhsm_statistics.h"
 
 class InfoTests : public CppUnit::TestFixture
 {
@@ -47,6 +49,7 @@ class InfoTests : public CppUnit::TestFixture
 	CPPUNIT_TEST(testGetTokenInfo);
 	CPPUNIT_TEST(testGetMechanismList);
 	CPPUNIT_TEST(testGetMechanismInfo);
+	CPPUNIT_TEST(testGetStatistics);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -57,6 +60,7 @@ public:
 	void testGetTokenInfo();
 	void testGetMechanismList();
 	void testGetMechanismInfo();
+	void testGetStatistics();
 
 	void setUp();
 	void tearDown();
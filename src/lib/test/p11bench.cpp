@@ -0,0 +1,898 @@
+/*
+ * Copyright (c) 2013 SURFnet bv
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*****************************************************************************
+ p11bench.cpp
+
+ Micro-benchmarks for the PKCS#11 interface of SoftHSM v2. Each benchmark
+ runs a single PKCS#11 operation a number of times on a number of threads,
+ every thread using its own session, and reports the throughput and the
+ latency percentiles of the operation.
+
+ The benchmarks use the slot that the functional tests use as well; the
+ token in that slot is (re)initialised before the benchmarks run.
+ *****************************************************************************/
+
+#include <config.h>
+#include "cryptoki.h"
+#include "testconfig.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// The options of a run
+struct BenchOptions
+{
+	std::string benchmarks;
+	int threads;
+	int iterations;
+	int loadRuns;
+	std::string key;
+	std::string keyType;
+	CK_ULONG keyBits;
+	CK_ULONG aesBits;
+	CK_ULONG payloadSize;
+	int objects;
+	CK_SLOT_ID slotID;
+	const char* jsonPath;
+};
+
+// The objects and data that the benchmarks operate on
+struct BenchContext
+{
+	BenchOptions* options;
+	CK_MECHANISM_TYPE signMechanism;
+	CK_OBJECT_HANDLE hPublicKey;
+	CK_OBJECT_HANDLE hPrivateKey;
+	CK_OBJECT_HANDLE hSecretKey;
+	std::vector<CK_BYTE> payload;
+	std::vector<CK_BYTE> signData;
+	std::vector<CK_BYTE> signature;
+};
+
+// A single benchmark operation; returns the result of the PKCS#11 call
+typedef CK_RV (*BenchOperation)(BenchContext* context, CK_SESSION_HANDLE hSession, int iteration);
+
+// The state of a thread that runs a benchmark
+struct BenchThread
+{
+	BenchContext* context;
+	BenchOperation operation;
+	int iterations;
+	std::vector<double> latencies;
+	unsigned long errors;
+	bool sessionFailed;
+};
+
+// The outcome of a benchmark
+struct BenchResult
+{
+	std::string name;
+	int threads;
+	unsigned long operations;
+	unsigned long errors;
+	double seconds;
+	double opsPerSecond;
+	double p50;
+	double p90;
+	double p99;
+	double max;
+};
+
+// Display the usage
+void usage()
+{
+	printf("Micro-benchmarks for the PKCS#11 interface of SoftHSM\n");
+	printf("Usage: p11bench [OPTIONS]\n");
+	printf("Options:\n");
+	printf("  --bench <list>       Comma-separated list of the benchmarks to run:\n");
+	printf("                       digest, sign, verify, encrypt, find, session\n");
+	printf("                       and load. Runs all of them by default.\n");
+	printf("  --threads <n>        The number of threads (default 1).\n");
+	printf("  --iterations <n>     The number of operations per thread (default 1000).\n");
+	printf("  --key <type>         The key pair for sign and verify: rsa:<bits>,\n");
+	printf("                       ec:p256 or ec:p384 (default rsa:2048).\n");
+	printf("  --aes-bits <n>       The size of the AES key for encrypt (default 128).\n");
+	printf("  --payload <bytes>    The size of the data to digest, sign and encrypt\n");
+	printf("                       (default 1024). ECDSA signs at most the size\n");
+	printf("                       of the curve order.\n");
+	printf("  --objects <n>        The number of objects on the token for find and\n");
+	printf("                       load (default 100).\n");
+	printf("  --load-runs <n>      The number of times the token is loaded (default 5).\n");
+	printf("  --slot <number>      The slot to use (default %d).\n", SLOT_INIT_TOKEN);
+	printf("  --json <path>        Write the results as JSON to the path, or to\n");
+	printf("                       standard output if the path is -.\n");
+	printf("  -h, --help           Shows this help screen.\n");
+}
+
+// Enumeration of the long options
+enum {
+	OPT_AES_BITS = 0x100,
+	OPT_BENCH,
+	OPT_HELP,
+	OPT_ITERATIONS,
+	OPT_JSON,
+	OPT_KEY,
+	OPT_LOAD_RUNS,
+	OPT_OBJECTS,
+	OPT_PAYLOAD,
+	OPT_SLOT,
+	OPT_THREADS
+};
+
+// Text representation of the long options
+static const struct option long_options[] = {
+	{ "aes-bits",        1, NULL, OPT_AES_BITS },
+	{ "bench",           1, NULL, OPT_BENCH },
+	{ "help",            0, NULL, OPT_HELP },
+	{ "iterations",      1, NULL, OPT_ITERATIONS },
+	{ "json",            1, NULL, OPT_JSON },
+	{ "key",             1, NULL, OPT_KEY },
+	{ "load-runs",       1, NULL, OPT_LOAD_RUNS },
+	{ "objects",         1, NULL, OPT_OBJECTS },
+	{ "payload",         1, NULL, OPT_PAYLOAD },
+	{ "slot",            1, NULL, OPT_SLOT },
+	{ "threads",         1, NULL, OPT_THREADS },
+	{ NULL,              0, NULL, 0 }
+};
+
+// Get the time in microseconds
+static double now()
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+	{
+		return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+	}
+#endif
+
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+// Get a percentile of sorted latencies
+static double percentile(const std::vector<double>& sorted, double fraction)
+{
+	if (sorted.empty()) return 0.0;
+
+	size_t index = (size_t) (fraction * (sorted.size() - 1) + 0.5);
+
+	return sorted[index];
+}
+
+// The label of a data object that is created for the find and load benchmarks
+static std::string objectLabel(int index)
+{
+	char label[32];
+
+	snprintf(label, sizeof(label), "p11bench-%d", index);
+
+	return label;
+}
+
+/*****************************************************************************
+ Benchmark operations
+ *****************************************************************************/
+
+static CK_RV benchDigest(BenchContext* context, CK_SESSION_HANDLE hSession, int)
+{
+	CK_MECHANISM mechanism = { CKM_SHA256, NULL_PTR, 0 };
+	CK_BYTE digest[32];
+	CK_ULONG digestLen = sizeof(digest);
+
+	CK_RV rv = C_DigestInit(hSession, &mechanism);
+	if (rv != CKR_OK) return rv;
+
+	return C_Digest(hSession, &context->payload[0], context->payload.size(), digest, &digestLen);
+}
+
+static CK_RV benchSign(BenchContext* context, CK_SESSION_HANDLE hSession, int)
+{
+	CK_MECHANISM mechanism = { context->signMechanism, NULL_PTR, 0 };
+	std::vector<CK_BYTE> signature(context->signature.size());
+	CK_ULONG signatureLen = signature.size();
+
+	CK_RV rv = C_SignInit(hSession, &mechanism, context->hPrivateKey);
+	if (rv != CKR_OK) return rv;
+
+	return C_Sign(hSession, &context->signData[0], context->signData.size(), &signature[0], &signatureLen);
+}
+
+static CK_RV benchVerify(BenchContext* context, CK_SESSION_HANDLE hSession, int)
+{
+	CK_MECHANISM mechanism = { context->signMechanism, NULL_PTR, 0 };
+
+	CK_RV rv = C_VerifyInit(hSession, &mechanism, context->hPublicKey);
+	if (rv != CKR_OK) return rv;
+
+	return C_Verify(hSession, &context->signData[0], context->signData.size(), &context->signature[0], context->signature.size());
+}
+
+static CK_RV benchEncrypt(BenchContext* context, CK_SESSION_HANDLE hSession, int)
+{
+	CK_BYTE iv[16];
+	CK_MECHANISM mechanism = { CKM_AES_CBC_PAD, iv, sizeof(iv) };
+	std::vector<CK_BYTE> encrypted(context->payload.size() + 16);
+	CK_ULONG encryptedLen = encrypted.size();
+
+	memset(iv, 0, sizeof(iv));
+
+	CK_RV rv = C_EncryptInit(hSession, &mechanism, context->hSecretKey);
+	if (rv != CKR_OK) return rv;
+
+	return C_Encrypt(hSession, &context->payload[0], context->payload.size(), &encrypted[0], &encryptedLen);
+}
+
+static CK_RV benchFind(BenchContext* context, CK_SESSION_HANDLE hSession, int iteration)
+{
+	CK_OBJECT_CLASS dataClass = CKO_DATA;
+	std::string label = objectLabel(iteration % context->options->objects);
+	CK_ATTRIBUTE findTemplate[] = {
+		{ CKA_CLASS, &dataClass, sizeof(dataClass) },
+		{ CKA_LABEL, (CK_VOID_PTR) label.c_str(), label.size() }
+	};
+	CK_OBJECT_HANDLE hObject;
+	CK_ULONG ulObjectCount;
+
+	CK_RV rv = C_FindObjectsInit(hSession, findTemplate, sizeof(findTemplate)/sizeof(CK_ATTRIBUTE));
+	if (rv != CKR_OK) return rv;
+
+	rv = C_FindObjects(hSession, &hObject, 1, &ulObjectCount);
+	if (rv == CKR_OK && ulObjectCount != 1) rv = CKR_GENERAL_ERROR;
+
+	CK_RV rvFinal = C_FindObjectsFinal(hSession);
+
+	return (rv != CKR_OK) ? rv : rvFinal;
+}
+
+static CK_RV benchSession(BenchContext* context, CK_SESSION_HANDLE, int)
+{
+	CK_SESSION_HANDLE hSession;
+
+	CK_RV rv = C_OpenSession(context->options->slotID, CKF_SERIAL_SESSION, NULL_PTR, NULL_PTR, &hSession);
+	if (rv != CKR_OK) return rv;
+
+	return C_CloseSession(hSession);
+}
+
+/*****************************************************************************
+ Running the benchmarks
+ *****************************************************************************/
+
+// Fill in the statistics of a result from the latencies of all threads
+static void summarise(BenchResult& result, std::vector<double>& latencies, double seconds)
+{
+	std::sort(latencies.begin(), latencies.end());
+
+	result.operations = latencies.size();
+	result.seconds = seconds;
+	result.opsPerSecond = (seconds > 0) ? latencies.size() / seconds : 0.0;
+	result.p50 = percentile(latencies, 0.50);
+	result.p90 = percentile(latencies, 0.90);
+	result.p99 = percentile(latencies, 0.99);
+	result.max = latencies.empty() ? 0.0 : latencies.back();
+}
+
+// Run the operations of a single thread
+static void* runThread(void* arg)
+{
+	BenchThread* thread = (BenchThread*) arg;
+	CK_SESSION_HANDLE hSession;
+
+	if (C_OpenSession(thread->context->options->slotID, CKF_SERIAL_SESSION | CKF_RW_SESSION, NULL_PTR, NULL_PTR, &hSession) != CKR_OK)
+	{
+		thread->sessionFailed = true;
+
+		return NULL;
+	}
+
+	thread->latencies.reserve(thread->iterations);
+
+	for (int i = 0; i < thread->iterations; i++)
+	{
+		double start = now();
+		CK_RV rv = thread->operation(thread->context, hSession, i);
+
+		thread->latencies.push_back(now() - start);
+
+		if (rv != CKR_OK) thread->errors++;
+	}
+
+	C_CloseSession(hSession);
+
+	return NULL;
+}
+
+// Run a benchmark on all threads
+static bool runBenchmark(const char* name, BenchOperation operation, BenchContext* context, std::vector<BenchResult>& results)
+{
+	int threadCount = context->options->threads;
+	std::vector<BenchThread> threads(threadCount);
+	std::vector<pthread_t> handles(threadCount);
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		threads[i].context = context;
+		threads[i].operation = operation;
+		threads[i].iterations = context->options->iterations;
+		threads[i].errors = 0;
+		threads[i].sessionFailed = false;
+	}
+
+	double start = now();
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		if (pthread_create(&handles[i], NULL, runThread, &threads[i]))
+		{
+			fprintf(stderr, "ERROR: Could not start a thread.\n");
+			exit(1);
+		}
+	}
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		pthread_join(handles[i], NULL);
+	}
+
+	double seconds = (now() - start) / 1000000.0;
+
+	BenchResult result;
+	std::vector<double> latencies;
+
+	result.name = name;
+	result.threads = threadCount;
+	result.errors = 0;
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		if (threads[i].sessionFailed)
+		{
+			fprintf(stderr, "ERROR: Could not open a session for %s.\n", name);
+			return false;
+		}
+
+		latencies.insert(latencies.end(), threads[i].latencies.begin(), threads[i].latencies.end());
+		result.errors += threads[i].errors;
+	}
+
+	summarise(result, latencies, seconds);
+	results.push_back(result);
+
+	return true;
+}
+
+// Initialise the library such that it may be used by multiple threads
+static CK_RV initialize()
+{
+	CK_C_INITIALIZE_ARGS args;
+
+	memset(&args, 0, sizeof(args));
+	args.flags = CKF_OS_LOCKING_OK;
+
+	return C_Initialize(&args);
+}
+
+// Log in as the normal user on a new session
+static CK_RV login(CK_SLOT_ID slotID, CK_SESSION_HANDLE& hSession)
+{
+	CK_UTF8CHAR pin[] = SLOT_0_USER1_PIN;
+
+	CK_RV rv = C_OpenSession(slotID, CKF_SERIAL_SESSION | CKF_RW_SESSION, NULL_PTR, NULL_PTR, &hSession);
+	if (rv != CKR_OK) return rv;
+
+	return C_Login(hSession, CKU_USER, pin, sizeof(pin) - 1);
+}
+
+// Measure how long it takes to initialise the library and read all objects
+// on the token; runs on a single thread with the library finalised
+static bool runLoad(BenchContext* context, std::vector<BenchResult>& results)
+{
+	std::vector<double> latencies;
+	BenchResult result;
+
+	result.name = "load";
+	result.threads = 1;
+	result.errors = 0;
+
+	double total = 0.0;
+
+	for (int i = 0; i < context->options->loadRuns; i++)
+	{
+		CK_SESSION_HANDLE hSession;
+		CK_OBJECT_HANDLE hObjects[64];
+		CK_ULONG ulObjectCount;
+		CK_OBJECT_CLASS dataClass = CKO_DATA;
+		CK_ATTRIBUTE findTemplate[] = {
+			{ CKA_CLASS, &dataClass, sizeof(dataClass) }
+		};
+
+		C_Finalize(NULL_PTR);
+
+		double start = now();
+
+		CK_RV rv = initialize();
+		if (rv == CKR_OK) rv = login(context->options->slotID, hSession);
+		if (rv == CKR_OK) rv = C_FindObjectsInit(hSession, findTemplate, 1);
+
+		// Searching needs all objects, so they are all read from disk
+		while (rv == CKR_OK)
+		{
+			rv = C_FindObjects(hSession, hObjects, 64, &ulObjectCount);
+
+			if (rv != CKR_OK || ulObjectCount == 0) break;
+		}
+
+		if (rv == CKR_OK) rv = C_FindObjectsFinal(hSession);
+
+		double latency = now() - start;
+
+		latencies.push_back(latency);
+		total += latency;
+
+		if (rv != CKR_OK) result.errors++;
+	}
+
+	C_Finalize(NULL_PTR);
+
+	summarise(result, latencies, total / 1000000.0);
+	results.push_back(result);
+
+	return true;
+}
+
+/*****************************************************************************
+ Preparing the token
+ *****************************************************************************/
+
+// (Re)initialise the token and set the user PIN
+static bool prepareToken(CK_SLOT_ID slotID)
+{
+	CK_UTF8CHAR soPIN[] = SLOT_0_SO1_PIN;
+	CK_UTF8CHAR pin[] = SLOT_0_USER1_PIN;
+	CK_UTF8CHAR label[32];
+	CK_SESSION_HANDLE hSession;
+
+	memset(label, ' ', sizeof(label));
+	memcpy(label, "p11bench", strlen("p11bench"));
+
+	if (C_InitToken(slotID, soPIN, sizeof(soPIN) - 1, label) != CKR_OK) return false;
+	if (C_OpenSession(slotID, CKF_SERIAL_SESSION | CKF_RW_SESSION, NULL_PTR, NULL_PTR, &hSession) != CKR_OK) return false;
+	if (C_Login(hSession, CKU_SO, soPIN, sizeof(soPIN) - 1) != CKR_OK) return false;
+	if (C_InitPIN(hSession, pin, sizeof(pin) - 1) != CKR_OK) return false;
+
+	C_CloseSession(hSession);
+
+	return true;
+}
+
+// Generate the key pair for sign and verify
+static CK_RV generateKeyPair(BenchContext* context, CK_SESSION_HANDLE hSession)
+{
+	CK_BBOOL bFalse = CK_FALSE;
+	CK_BBOOL bTrue = CK_TRUE;
+	CK_BYTE pubExp[] = { 0x01, 0x00, 0x01 };
+	CK_BYTE p256[] = { 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07 };
+	CK_BYTE p384[] = { 0x06, 0x05, 0x2b, 0x81, 0x04, 0x00, 0x22 };
+	CK_ULONG bits = context->options->keyBits;
+	CK_MECHANISM mechanism = { CKM_RSA_PKCS_KEY_PAIR_GEN, NULL_PTR, 0 };
+	CK_ATTRIBUTE pukAttribs[] = {
+		{ CKA_TOKEN, &bFalse, sizeof(bFalse) },
+		{ CKA_VERIFY, &bTrue, sizeof(bTrue) },
+		{ CKA_MODULUS_BITS, &bits, sizeof(bits) },
+		{ CKA_PUBLIC_EXPONENT, &pubExp[0], sizeof(pubExp) }
+	};
+	CK_ULONG pukCount = 4;
+	CK_ATTRIBUTE prkAttribs[] = {
+		{ CKA_TOKEN, &bFalse, sizeof(bFalse) },
+		{ CKA_PRIVATE, &bTrue, sizeof(bTrue) },
+		{ CKA_SENSITIVE, &bTrue, sizeof(bTrue) },
+		{ CKA_SIGN, &bTrue, sizeof(bTrue) }
+	};
+
+	if (context->options->keyType == "rsa")
+	{
+		context->signMechanism = CKM_SHA256_RSA_PKCS;
+		context->signData = context->payload;
+	}
+	else
+	{
+		// ECDSA signs a hash, so at most the size of the order is used
+		mechanism.mechanism = CKM_EC_KEY_PAIR_GEN;
+		context->signMechanism = CKM_ECDSA;
+		context->signData.assign(context->payload.begin(),
+					 context->payload.begin() + std::min<size_t>(context->payload.size(), bits / 8));
+
+		pukAttribs[2].type = CKA_EC_PARAMS;
+		pukAttribs[2].pValue = (bits == 384) ? p384 : p256;
+		pukAttribs[2].ulValueLen = (bits == 384) ? sizeof(p384) : sizeof(p256);
+		pukCount = 3;
+	}
+
+	return C_GenerateKeyPair(hSession, &mechanism,
+				 pukAttribs, pukCount,
+				 prkAttribs, sizeof(prkAttribs)/sizeof(CK_ATTRIBUTE),
+				 &context->hPublicKey, &context->hPrivateKey);
+}
+
+// Create the signature for verify; its size also sizes the buffer of sign
+static CK_RV createSignature(BenchContext* context, CK_SESSION_HANDLE hSession)
+{
+	CK_MECHANISM mechanism = { context->signMechanism, NULL_PTR, 0 };
+	CK_ULONG signatureLen = 0;
+
+	CK_RV rv = C_SignInit(hSession, &mechanism, context->hPrivateKey);
+	if (rv != CKR_OK) return rv;
+
+	rv = C_Sign(hSession, &context->signData[0], context->signData.size(), NULL_PTR, &signatureLen);
+	if (rv != CKR_OK) return rv;
+
+	context->signature.resize(signatureLen);
+
+	rv = C_Sign(hSession, &context->signData[0], context->signData.size(), &context->signature[0], &signatureLen);
+	if (rv != CKR_OK) return rv;
+
+	context->signature.resize(signatureLen);
+
+	return CKR_OK;
+}
+
+// Create the AES key for encrypt from random data
+static CK_RV generateSecretKey(BenchContext* context, CK_SESSION_HANDLE hSession)
+{
+	CK_OBJECT_CLASS keyClass = CKO_SECRET_KEY;
+	CK_KEY_TYPE keyType = CKK_AES;
+	CK_BYTE value[32];
+	CK_ULONG bytes = context->options->aesBits / 8;
+	CK_BBOOL bFalse = CK_FALSE;
+	CK_BBOOL bTrue = CK_TRUE;
+	CK_ATTRIBUTE keyAttribs[] = {
+		{ CKA_CLASS, &keyClass, sizeof(keyClass) },
+		{ CKA_KEY_TYPE, &keyType, sizeof(keyType) },
+		{ CKA_TOKEN, &bFalse, sizeof(bFalse) },
+		{ CKA_PRIVATE, &bTrue, sizeof(bTrue) },
+		{ CKA_SENSITIVE, &bTrue, sizeof(bTrue) },
+		{ CKA_ENCRYPT, &bTrue, sizeof(bTrue) },
+		{ CKA_VALUE, value, bytes }
+	};
+
+	CK_RV rv = C_GenerateRandom(hSession, value, bytes);
+	if (rv != CKR_OK) return rv;
+
+	return C_CreateObject(hSession, keyAttribs, sizeof(keyAttribs)/sizeof(CK_ATTRIBUTE), &context->hSecretKey);
+}
+
+// Create the data objects for find and load
+static CK_RV createObjects(BenchContext* context, CK_SESSION_HANDLE hSession)
+{
+	CK_OBJECT_CLASS dataClass = CKO_DATA;
+	CK_BBOOL bTrue = CK_TRUE;
+	CK_BYTE value[64];
+
+	memset(value, 0x5a, sizeof(value));
+
+	for (int i = 0; i < context->options->objects; i++)
+	{
+		std::string label = objectLabel(i);
+		CK_ATTRIBUTE objAttribs[] = {
+			{ CKA_CLASS, &dataClass, sizeof(dataClass) },
+			{ CKA_TOKEN, &bTrue, sizeof(bTrue) },
+			{ CKA_PRIVATE, &bTrue, sizeof(bTrue) },
+			{ CKA_LABEL, (CK_VOID_PTR) label.c_str(), label.size() },
+			{ CKA_VALUE, value, sizeof(value) }
+		};
+		CK_OBJECT_HANDLE hObject;
+
+		CK_RV rv = C_CreateObject(hSession, objAttribs, sizeof(objAttribs)/sizeof(CK_ATTRIBUTE), &hObject);
+		if (rv != CKR_OK) return rv;
+	}
+
+	return CKR_OK;
+}
+
+/*****************************************************************************
+ Reporting
+ *****************************************************************************/
+
+// Print the results as a table
+static void printResults(const std::vector<BenchResult>& results)
+{
+	printf("%-10s %8s %10s %8s %12s %10s %10s %10s %10s\n", "Benchmark", "Threads", "Ops", "Errors",
+		"Ops/sec", "p50 (us)", "p90 (us)", "p99 (us)", "max (us)");
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& r = results[i];
+
+		printf("%-10s %8d %10lu %8lu %12.1f %10.1f %10.1f %10.1f %10.1f\n", r.name.c_str(), r.threads,
+			r.operations, r.errors, r.opsPerSecond, r.p50, r.p90, r.p99, r.max);
+	}
+}
+
+// Write the results as JSON
+static bool writeJSON(const char* path, const BenchOptions& options, const std::vector<BenchResult>& results)
+{
+	FILE* out = strcmp(path, "-") ? fopen(path, "w") : stdout;
+
+	if (out == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not open %s.\n", path);
+		return false;
+	}
+
+	fprintf(out, "{\n");
+	fprintf(out, "  \"version\": \"%s\",\n", PACKAGE_VERSION);
+	fprintf(out, "  \"config\": {\n");
+	fprintf(out, "    \"threads\": %d,\n", options.threads);
+	fprintf(out, "    \"iterations\": %d,\n", options.iterations);
+	fprintf(out, "    \"key\": \"%s\",\n", options.key.c_str());
+	fprintf(out, "    \"aes_bits\": %lu,\n", options.aesBits);
+	fprintf(out, "    \"payload\": %lu,\n", options.payloadSize);
+	fprintf(out, "    \"objects\": %d,\n", options.objects);
+	fprintf(out, "    \"load_runs\": %d\n", options.loadRuns);
+	fprintf(out, "  },\n");
+	fprintf(out, "  \"results\": [");
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& r = results[i];
+
+		fprintf(out, "%s\n    {\n", i ? "," : "");
+		fprintf(out, "      \"name\": \"%s\",\n", r.name.c_str());
+		fprintf(out, "      \"threads\": %d,\n", r.threads);
+		fprintf(out, "      \"operations\": %lu,\n", r.operations);
+		fprintf(out, "      \"errors\": %lu,\n", r.errors);
+		fprintf(out, "      \"seconds\": %.6f,\n", r.seconds);
+		fprintf(out, "      \"ops_per_sec\": %.1f,\n", r.opsPerSecond);
+		fprintf(out, "      \"latency_us\": { \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f }\n",
+			r.p50, r.p90, r.p99, r.max);
+		fprintf(out, "    }");
+	}
+
+	fprintf(out, "\n  ]\n}\n");
+
+	if (out != stdout) fclose(out);
+
+	return true;
+}
+
+/*****************************************************************************
+ Main
+ *****************************************************************************/
+
+// Check if a benchmark was selected
+static bool selected(const BenchOptions& options, const char* name)
+{
+	if (options.benchmarks.empty()) return true;
+
+	std::string list = "," + options.benchmarks + ",";
+
+	return list.find("," + std::string(name) + ",") != std::string::npos;
+}
+
+// Parse the key type
+static bool parseKey(BenchOptions& options, const char* key)
+{
+	std::string value = key;
+	size_t colon = value.find(':');
+
+	options.key = value;
+	options.keyType = value.substr(0, colon);
+
+	if (options.keyType == "rsa")
+	{
+		options.keyBits = (colon == std::string::npos) ? 2048 : strtoul(value.c_str() + colon + 1, NULL, 10);
+
+		return options.keyBits >= 512;
+	}
+
+	if (options.keyType == "ec")
+	{
+		std::string curve = (colon == std::string::npos) ? "p256" : value.substr(colon + 1);
+
+		if (curve == "p256") options.keyBits = 256;
+		else if (curve == "p384") options.keyBits = 384;
+		else return false;
+
+		return true;
+	}
+
+	return false;
+}
+
+int main(int argc, char* argv[])
+{
+	int option_index = 0;
+	int opt;
+
+	BenchOptions options;
+	options.threads = 1;
+	options.iterations = 1000;
+	options.loadRuns = 5;
+	options.key = "rsa:2048";
+	options.keyType = "rsa";
+	options.keyBits = 2048;
+	options.aesBits = 128;
+	options.payloadSize = 1024;
+	options.objects = 100;
+	options.slotID = SLOT_INIT_TOKEN;
+	options.jsonPath = NULL;
+
+	while ((opt = getopt_long(argc, argv, "h", long_options, &option_index)) != -1)
+	{
+		switch (opt)
+		{
+			case OPT_AES_BITS:
+				options.aesBits = strtoul(optarg, NULL, 10);
+				break;
+			case OPT_BENCH:
+				options.benchmarks = optarg;
+				break;
+			case OPT_ITERATIONS:
+				options.iterations = atoi(optarg);
+				break;
+			case OPT_JSON:
+				options.jsonPath = optarg;
+				break;
+			case OPT_KEY:
+				if (!parseKey(options, optarg))
+				{
+					fprintf(stderr, "ERROR: Unknown key type %s.\n", optarg);
+					exit(1);
+				}
+				break;
+			case OPT_LOAD_RUNS:
+				options.loadRuns = atoi(optarg);
+				break;
+			case OPT_OBJECTS:
+				options.objects = atoi(optarg);
+				break;
+			case OPT_PAYLOAD:
+				options.payloadSize = strtoul(optarg, NULL, 10);
+				break;
+			case OPT_SLOT:
+				options.slotID = atoi(optarg);
+				break;
+			case OPT_THREADS:
+				options.threads = atoi(optarg);
+				break;
+			case OPT_HELP:
+			case 'h':
+			default:
+				usage();
+				exit(0);
+				break;
+		}
+	}
+
+	if (options.threads < 1 || options.iterations < 1 || options.objects < 1 ||
+	    options.payloadSize < 1 || options.loadRuns < 1 ||
+	    (options.aesBits != 128 && options.aesBits != 192 && options.aesBits != 256))
+	{
+		fprintf(stderr, "ERROR: Invalid option value.\n");
+		exit(1);
+	}
+
+	// Use the configuration of the functional tests unless told otherwise
+	setenv("SOFTHSM2_CONF", "./softhsm2.conf", 0);
+
+	BenchContext context;
+	context.options = &options;
+	context.payload.resize(options.payloadSize, 0xa5);
+
+	// Prepare the token, keys and objects
+	CK_SESSION_HANDLE hSession;
+
+	if (initialize() != CKR_OK)
+	{
+		fprintf(stderr, "ERROR: Could not initialize the library.\n");
+		exit(1);
+	}
+
+	if (!prepareToken(options.slotID) || login(options.slotID, hSession) != CKR_OK)
+	{
+		fprintf(stderr, "ERROR: Could not initialize the token in slot %lu.\n", options.slotID);
+		exit(1);
+	}
+
+	if ((selected(options, "sign") || selected(options, "verify")) &&
+	    generateKeyPair(&context, hSession) != CKR_OK)
+	{
+		fprintf(stderr, "ERROR: Could not generate the key pair.\n");
+		exit(1);
+	}
+
+	if ((selected(options, "sign") || selected(options, "verify")) &&
+	    createSignature(&context, hSession) != CKR_OK)
+	{
+		fprintf(stderr, "ERROR: Could not create the signature.\n");
+		exit(1);
+	}
+
+	if (selected(options, "encrypt") && generateSecretKey(&context, hSession) != CKR_OK)
+	{
+		fprintf(stderr, "ERROR: Could not create the AES key.\n");
+		exit(1);
+	}
+
+	if ((selected(options, "find") || selected(options, "load")) &&
+	    createObjects(&context, hSession) != CKR_OK)
+	{
+		fprintf(stderr, "ERROR: Could not create the objects.\n");
+		exit(1);
+	}
+
+	// Run the benchmarks
+	std::vector<BenchResult> results;
+	bool success = true;
+
+	if (selected(options, "digest")) success &= runBenchmark("digest", benchDigest, &context, results);
+	if (selected(options, "sign")) success &= runBenchmark("sign", benchSign, &context, results);
+	if (selected(options, "verify")) success &= runBenchmark("verify", benchVerify, &context, results);
+	if (selected(options, "encrypt")) success &= runBenchmark("encrypt", benchEncrypt, &context, results);
+	if (selected(options, "find")) success &= runBenchmark("find", benchFind, &context, results);
+	if (selected(options, "session")) success &= runBenchmark("session", benchSession, &context, results);
+
+	// Loading the token finalises the library, so it goes last
+	if (selected(options, "load"))
+	{
+		success &= runLoad(&context, results);
+	}
+	else
+	{
+		C_Finalize(NULL_PTR);
+	}
+
+	if (!options.jsonPath || strcmp(options.jsonPath, "-"))
+	{
+		printResults(results);
+	}
+
+	if (options.jsonPath && !writeJSON(options.jsonPath, options, results))
+	{
+		success = false;
+	}
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		if (results[i].errors) success = false;
+	}
+
+	return success ? 0 : 1;
+}